@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Common definitions
  *
- * @copyright Copyright © 1991-2023 Christian Schenk
+ * @copyright Copyright © 1991-2024 Christian Schenk
  *
  * This file is part of C4P.
  *
@@ -199,6 +199,7 @@ pascal_type coerce(pascal_type, pascal_type);
 void open_name_file();
 void close_name_file();
 void begin_routine(prototype_node *, unsigned);
+void generate_procedure_names();
 void end_routine(unsigned);
 void add_loner(const char*);
 void begin_new_c_file(const char*, int);
@@ -237,6 +238,8 @@ extern std::string h_file_name;
 extern std::string include_filename;
 extern std::string c_ext;
 extern bool one_c_file;
+extern bool profile_flag;
+extern std::vector<std::string> procedure_names;
 extern bool dll_flag;
 extern std::string class_name;
 extern std::string class_name_scope;
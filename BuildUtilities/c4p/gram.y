@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Parser specification
  *
- * @copyright Copyright © 1991-2023 Christian Schenk
+ * @copyright Copyright © 1991-2024 Christian Schenk
  *
  * This file is part of C4P.
  *
@@ -202,6 +202,10 @@ program_block:
                 cppout.redir_file(H_FILE_NUM);
                 cppout.out_s("int Run(int argc, char* argv[]);\n");
                 cppout.redir_file(C_FILE_NUM);
+                if (profile_flag)
+                {
+                    generate_procedure_names();
+                }
                 cppout.out_s("\nint " + class_name + "::Run(int argc, char* argv[])\n\n");
             }
         }
@@ -262,6 +266,10 @@ function_declaration:
         symbol_t* result_type = reinterpret_cast<prototype_node*>($<type_ptr>1)->result_type;
         cppout.out_s("\n" + std::string(result_type->s_translated_type != nullptr ? result_type->s_translated_type : result_type->s_repr) + " c4p_result;\n\n");
         cppout.out_s("C4P_PROC_ENTRY (" + std::to_string(routine_handle) + ");\n");
+        if (profile_flag)
+        {
+            cppout.out_s("C4P_PROC_PROFILE (" + std::to_string(routine_handle) + ");\n");
+        }
     }
     statement_sequence END ';'
     {
@@ -343,6 +351,10 @@ procedure_declaration:
     BEGIn
     {
         cppout.out_s("C4P_PROC_ENTRY (" + std::to_string(routine_handle) + ");\n");
+        if (profile_flag)
+        {
+            cppout.out_s("C4P_PROC_PROFILE (" + std::to_string(routine_handle) + ");\n");
+        }
     }
     statement_sequence END ';'
     {
@@ -1009,6 +1021,10 @@ compound_statement:
         if (routine_handle == 0 && curly_brace_level == 1)
         {
             cppout.out_s("C4P_BEGIN_PROGRAM(\"" + std::string(prog_symbol->s_repr) + "\", argc, argv);\n");
+            if (profile_flag)
+            {
+                cppout.out_s("this->StartProcedureProfiler(c4p_procedure_names, sizeof(c4p_procedure_names) / sizeof(c4p_procedure_names[0]));\n");
+            }
         }
     }
     statement_sequence END
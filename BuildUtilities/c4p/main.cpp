@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Pascal-to-C Translator
  *
- * @copyright Copyright © 1991-2022 Christian Schenk
+ * @copyright Copyright © 1991-2024 Christian Schenk
  *
  * This file is part of C4P.
  *
@@ -39,6 +39,7 @@ bool chars_are_unsigned;
 bool dll_flag;
 bool macroizing;
 bool one_c_file;
+bool profile_flag;
 bool verbose_flag;
 int auto_exit_label;
 string base_class_name;
@@ -128,6 +129,7 @@ void usage()
         << "  -i, --include-filename FILENAME" << "\n"
         << "  -l NUM, --lines NUM" << "\n"
         << "  -p FILENAME, --output-prefix FILENAME" << "\n"
+        << "  --profile" << "\n"
         << "  -r NAME, --rename NAME" << "\n"
         << "  -V, --version" << endl;
 }
@@ -150,6 +152,7 @@ void usage()
 #define OPT_NAMESPACE 16
 #define OPT_EMIT_OPTIMIZE_PRAGMAS 17
 #define OPT_CONSTANT 18
+#define OPT_PROFILE 19
 
 namespace
 {
@@ -174,6 +177,7 @@ namespace
       "namespace", required_argument, nullptr, OPT_NAMESPACE,
       "one", optional_argument, nullptr, '1',
       "output-prefix", required_argument, nullptr, 'p',
+      "profile", no_argument, nullptr, OPT_PROFILE,
       "rename", required_argument, nullptr, 'r',
       "using-namespace", required_argument, nullptr, OPT_USING_NAMESPACE,
       "var-name-prefix", required_argument, nullptr, OPT_VAR_NAME_PREFIX,
@@ -282,6 +286,9 @@ void option_handler(int argc, char** argv)
         case OPT_NAMESPACE:
             name_space = optarg;
             break;
+        case OPT_PROFILE:
+            profile_flag = true;
+            break;
         case 'C':
             c_ext = ".cc";
             break;
@@ -331,6 +338,12 @@ void option_handler(int argc, char** argv)
         pascal_file_name = argv[optind];
     }
 
+    if (profile_flag && class_name.empty())
+    {
+        cerr << fmt::format(T_("{0}: --profile requires --class"), myname) << endl;
+        exit(1);
+    }
+
     if (legacy_flag)
     {
         integer_literal_suffix = "l";
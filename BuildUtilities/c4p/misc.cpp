@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief C4P utilities 
  *
- * @copyright Copyright © 1991-2022 Christian Schenk
+ * @copyright Copyright © 1991-2024 Christian Schenk
  *
  * This file is part of C4P.
  *
@@ -33,6 +33,8 @@ namespace
 
 const size_t MY_PATH_MAX = 8192;
 
+vector<string> procedure_names;
+
 void generate_file_header()
 {
     cppout.out_s("/* generated from " + pascal_file_name + " by C4P version " + MIKTEX_COMPONENT_VERSION_STR + " */\n");
@@ -259,6 +261,14 @@ void begin_routine(prototype_node* proto, unsigned handle)
     cppout.redir_file(DEF_FILE_NUM);
     cppout.out_s("#define C4P_HANDLE_" + std::string(proto->name->s_repr) + " " + std::to_string(handle) + "\n");
     cppout.redir_file(C_FILE_NUM);
+    if (profile_flag)
+    {
+        if (procedure_names.size() <= handle)
+        {
+            procedure_names.resize(handle + 1);
+        }
+        procedure_names[handle] = proto->name->s_repr;
+    }
     check_c_file_size();
     cppout.out_s("\n");
     ++block_level;
@@ -306,6 +316,20 @@ void end_routine(unsigned handle)
     }
 }
 
+void generate_procedure_names()
+{
+    if (procedure_names.empty())
+    {
+        procedure_names.resize(1);
+    }
+    cppout.out_s("\nstatic const char* const c4p_procedure_names[] = {\n");
+    for (const string& name : procedure_names)
+    {
+        cppout.out_s("  \"" + name + "\",\n");
+    }
+    cppout.out_s("};\n");
+}
+
 char* strcpye(char* s1, const char* s2)
 {
     while ((*s1++ = *s2++) != 0)
@@ -17,16 +17,21 @@
 #include <cstdlib>
 #include <ctime>
 
+#include <chrono>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <set>
+#include <utility>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <log4cxx/basicconfigurator.h>
 #include <log4cxx/logger.h>
+#include <log4cxx/logmanager.h>
 #if LOG4CXX_VERSION_MAJOR > 0
 #include <log4cxx/rolling/rollingfileappender.h> 
 #else
@@ -42,6 +47,7 @@
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Cfg>
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/Directory>
 #include <miktex/Core/Exceptions>
 #include <miktex/Core/File>
 #include <miktex/Core/FileType>
@@ -78,6 +84,53 @@ using namespace MiKTeX::Util;
 static Application* instance = nullptr;
 
 static bool initUiFrameworkDone = false;
+
+/// The most verbose log4cxx level a program logs trace messages with. The
+/// record is valid as long as the logging configuration file did not change.
+struct LogThreshold
+{
+    string configFile;
+    time_t configFileTime = 0;
+    int level = log4cxx::Level::ALL_INT;
+};
+
+/// What the last maintenance check and the last diagnosis found out. The record
+/// is valid as long as the maintenance timestamps did not change.
+struct MaintenanceState
+{
+    time_t lastAdminMaintenance = 0;
+    time_t lastUserMaintenance = 0;
+    time_t lastAdminUpdateDb = 0;
+    time_t userLanguagesIniTime = 0;
+    time_t issuesJsonTime = 0;
+    bool upToDate = false;
+    bool noIssues = false;
+    // indexed by program name
+    map<string, LogThreshold> logThresholds;
+};
+
+constexpr int MAINTENANCE_STATE_VERSION = 2;
+
+static int ToLog4cxxLevel(TraceLevel level)
+{
+    switch (level)
+    {
+    case TraceLevel::Fatal:
+        return log4cxx::Level::FATAL_INT;
+    case TraceLevel::Error:
+        return log4cxx::Level::ERROR_INT;
+    case TraceLevel::Warning:
+        return log4cxx::Level::WARN_INT;
+    case TraceLevel::Info:
+        return log4cxx::Level::INFO_INT;
+    case TraceLevel::Trace:
+        return log4cxx::Level::TRACE_INT;
+    case TraceLevel::Debug:
+    default:
+        return log4cxx::Level::DEBUG_INT;
+    }
+}
+
 static bool isLog4cxxConfigured = false;
 static volatile sig_atomic_t cancelled;
 
@@ -117,8 +170,27 @@ public:
         return translator->Translate(msgId);
     }
 
+    log4cxx::LoggerPtr Logger()
+    {
+        if (logger == nullptr && session != nullptr && !configuringLogging)
+        {
+            AutoRestore<bool> restore(configuringLogging);
+            configuringLogging = true;
+            ConfigureLogging();
+        }
+        return logger;
+    }
+
+    void ConfigureLogging();
+    bool IsLogged(TraceLevel level);
+    void LogStartup();
+    MaintenanceState& GetMaintenanceState();
+    void SaveMaintenanceState();
+    void PrintStartupTimes(const string& title);
+
     bool beQuiet = false;
     string commandLine;
+    bool configuringLogging = false;
     TriState enableDiagnose = TriState::Undetermined;
     TriState enableInstaller = TriState::Undetermined;
     TriState enableMaintenance = TriState::Undetermined;
@@ -126,10 +198,18 @@ public:
     bool initialized = false;
     shared_ptr<PackageInstaller> installer;
     log4cxx::LoggerPtr logger;
+    int logThreshold = log4cxx::Level::ALL_INT;
+    bool logThresholdLoaded = false;
+    MaintenanceState maintenanceState;
+    bool maintenanceStateChanged = false;
+    bool maintenanceStateLoaded = false;
     TriState mpmAutoAdmin = TriState::Undetermined;
     shared_ptr<PackageManager> packageManager;
     vector<TraceCallback::TraceMessage> pendingTraceMessages;
+    bool printStartupTimes = false;
     shared_ptr<Session> session;
+    PathName startupDirectory;
+    vector<pair<string, chrono::steady_clock::duration>> startupPhases;
     unique_ptr<Translator> translator;
 
     static AppResources resources;
@@ -144,6 +224,60 @@ class Application::impl :
 
 #define T_(x) this->pimpl->Translate(x)
 
+class PhaseStopwatch
+{
+
+public:
+
+    PhaseStopwatch(Impl* pimpl, const char* name) :
+        pimpl(pimpl),
+        name(name)
+    {
+        if (pimpl->printStartupTimes)
+        {
+            start = chrono::steady_clock::now();
+        }
+    }
+
+    ~PhaseStopwatch()
+    {
+        Stop();
+    }
+
+    void Stop()
+    {
+        if (pimpl->printStartupTimes && !stopped)
+        {
+            pimpl->startupPhases.push_back({ name, chrono::steady_clock::now() - start });
+        }
+        stopped = true;
+    }
+
+private:
+
+    Impl* pimpl;
+    const char* name;
+    chrono::steady_clock::time_point start;
+    bool stopped = false;
+};
+
+void Impl::PrintStartupTimes(const string& title)
+{
+    if (!printStartupTimes || startupPhases.empty())
+    {
+        return;
+    }
+    chrono::steady_clock::duration total(0);
+    cerr << Utils::GetExeName() << ": " << title << ":";
+    for (const auto& phase : startupPhases)
+    {
+        cerr << fmt::format(" {0} {1:.1f}ms", phase.first, chrono::duration<double, milli>(phase.second).count());
+        total += phase.second;
+    }
+    cerr << fmt::format(" (total {0:.1f}ms)", chrono::duration<double, milli>(total).count()) << endl;
+    startupPhases.clear();
+}
+
 void Application::CheckCancel()
 {
     if (Cancelled())
@@ -225,6 +359,10 @@ template<typename T> void ExamineArgs(vector<T>& args, Session::InitInfo& initIn
         {
             pimpl->enableDiagnose = TriState::True;
         }
+        else if (strcmp(*it, "--miktex-print-startup-times") == 0)
+        {
+            pimpl->printStartupTimes = true;
+        }
         else
         {
             keepArgument = true;
@@ -269,16 +407,19 @@ void Application::Init(const Session::InitInfo& initInfoArg, vector<char*>& args
     Init(initInfo);
 }
 
-void Application::ConfigureLogging()
+// logging is configured on demand, i.e., when the first message is to be
+// logged: most runs do not log anything noteworthy
+void Impl::ConfigureLogging()
 {
+    PhaseStopwatch stopwatch(this, "logging");
     string myName = Utils::GetExeName();
     PathName xmlFileName;
-    if (pimpl->session->FindFile(myName + "." + MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName)
-        || pimpl->session->FindFile(MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName))
+    if (session->FindFile(myName + "." + MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName)
+        || session->FindFile(MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName))
     {
-        PathName logDir = pimpl->session->GetSpecialPath(SpecialPath::LogDirectory);
+        PathName logDir = session->GetSpecialPath(SpecialPath::LogDirectory);
         string logName = myName;
-        if (pimpl->session->IsAdminMode())
+        if (session->IsAdminMode())
         {
             logName += MIKTEX_ADMIN_SUFFIX;
         }
@@ -291,7 +432,155 @@ void Application::ConfigureLogging()
         log4cxx::BasicConfigurator::configure();
     }
     isLog4cxxConfigured = true;
-    pimpl->logger = log4cxx::Logger::getLogger(myName);
+    logger = log4cxx::Logger::getLogger(myName);
+    // remember the threshold, so that the next run can skip the
+    // configuration as long as nothing is logged
+    string traceLoggerName = "trace." + myName;
+    int level = log4cxx::Logger::getLogger(traceLoggerName)->getEffectiveLevel()->toInt();
+    for (const log4cxx::LoggerPtr& l : log4cxx::LogManager::getCurrentLoggers())
+    {
+        string name;
+        l->getName(name);
+        if (name.compare(0, traceLoggerName.length() + 1, traceLoggerName + ".") == 0)
+        {
+            level = std::min(level, l->getEffectiveLevel()->toInt());
+        }
+    }
+    level = std::max(level, log4cxx::LogManager::getLoggerRepository()->getThreshold()->toInt());
+    LogThreshold& threshold = GetMaintenanceState().logThresholds[myName];
+    if (threshold.configFile != xmlFileName.ToString() || threshold.level != level)
+    {
+        threshold.configFile = xmlFileName.ToString();
+        threshold.configFileTime = xmlFileName.Empty() ? 0 : File::GetLastWriteTime(xmlFileName);
+        threshold.level = level;
+        maintenanceStateChanged = true;
+    }
+    LogStartup();
+}
+
+// decides whether a trace message makes it into the log without
+// configuring the logging system
+bool Impl::IsLogged(TraceLevel level)
+{
+    if (session == nullptr)
+    {
+        return true;
+    }
+    if (!logThresholdLoaded)
+    {
+        logThresholdLoaded = true;
+        // drop the messages traced while looking at the configuration file
+        logThreshold = log4cxx::Level::OFF_INT;
+        int cachedLevel = log4cxx::Level::ALL_INT;
+        const MaintenanceState& state = GetMaintenanceState();
+        auto it = state.logThresholds.find(Utils::GetExeName());
+        if (it != state.logThresholds.end() && !it->second.configFile.empty())
+        {
+            PathName configFile(it->second.configFile);
+            if (File::Exists(configFile) && File::GetLastWriteTime(configFile) == it->second.configFileTime)
+            {
+                cachedLevel = it->second.level;
+            }
+        }
+        logThreshold = cachedLevel;
+    }
+    return ToLog4cxxLevel(level) >= logThreshold;
+}
+
+void Impl::LogStartup()
+{
+    if (commandLine.empty())
+    {
+        return;
+    }
+    auto thisProcess = Process::GetCurrentProcess();
+    auto parentProcess = thisProcess->get_Parent();
+    string invokerName;
+    if (parentProcess != nullptr)
+    {
+        invokerName = parentProcess->get_ProcessName();
+    }
+    if (invokerName.empty())
+    {
+        invokerName = "unknown process";
+    }
+    LOG4CXX_INFO(logger, fmt::format("this process ({0}) started by {1} in directory {2} with command line: {3}", thisProcess->GetSystemId(), Q_(invokerName), startupDirectory.ToDisplayString(), commandLine));
+#if defined(MIKTEX_WINDOWS)
+    LOG4CXX_INFO(logger, fmt::format("running on Windows {0}", WindowsVersion::GetMajorMinorBuildString()));
+#endif
+}
+
+MaintenanceState& Impl::GetMaintenanceState()
+{
+    if (maintenanceStateLoaded)
+    {
+        return maintenanceState;
+    }
+    maintenanceStateLoaded = true;
+    PathName path = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_MAINTENANCE_STATE;
+    if (!File::Exists(path))
+    {
+        return maintenanceState;
+    }
+    try
+    {
+        ifstream stream = File::CreateInputStream(path);
+        int version;
+        MaintenanceState state;
+        if (stream >> version
+            && version == MAINTENANCE_STATE_VERSION
+            && stream
+                >> state.lastAdminMaintenance >> state.lastUserMaintenance >> state.lastAdminUpdateDb
+                >> state.userLanguagesIniTime >> state.issuesJsonTime
+                >> state.upToDate >> state.noIssues)
+        {
+            size_t n;
+            stream >> n;
+            for (size_t i = 0; stream && i < n; ++i)
+            {
+                string name;
+                LogThreshold threshold;
+                if (stream >> std::quoted(name) >> std::quoted(threshold.configFile) >> threshold.configFileTime >> threshold.level)
+                {
+                    state.logThresholds[name] = threshold;
+                }
+            }
+            maintenanceState = state;
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+    }
+    return maintenanceState;
+}
+
+void Impl::SaveMaintenanceState()
+{
+    if (!maintenanceStateChanged)
+    {
+        return;
+    }
+    maintenanceStateChanged = false;
+    PathName path = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_MAINTENANCE_STATE;
+    try
+    {
+        Directory::Create(PathName(path).RemoveFileSpec());
+        const MaintenanceState& state = maintenanceState;
+        ofstream stream = File::CreateOutputStream(path);
+        stream
+            << MAINTENANCE_STATE_VERSION << "\n"
+            << state.lastAdminMaintenance << " " << state.lastUserMaintenance << " " << state.lastAdminUpdateDb << "\n"
+            << state.userLanguagesIniTime << " " << state.issuesJsonTime << "\n"
+            << state.upToDate << " " << state.noIssues << "\n"
+            << state.logThresholds.size() << "\n";
+        for (const auto& [name, threshold] : state.logThresholds)
+        {
+            stream << std::quoted(name) << " " << std::quoted(threshold.configFile) << " " << threshold.configFileTime << " " << threshold.level << "\n";
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+    }
 }
 
 inline bool IsNewer(const PathName& path1, const PathName& path2)
@@ -321,10 +610,26 @@ void Application::AutoMaintenance()
         throw 1;
     }
 
+    time_t lastAdminUpdateDb = pimpl->session->IsAdminMode() ? 0 : pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_DB, ConfigValue("0")).GetTimeT();
+    PathName userLanguagesIni = pimpl->session->IsAdminMode() ? PathName() : pimpl->session->GetSpecialPath(SpecialPath::UserConfigRoot) / MIKTEX_PATH_LANGUAGES_INI;
+    time_t userLanguagesIniTime = !pimpl->session->IsAdminMode() && File::Exists(userLanguagesIni) ? File::GetLastWriteTime(userLanguagesIni) : 0;
+    PathName mpmDatabasePath(pimpl->session->GetMpmDatabasePathName());
+
+    // nothing to do, if nothing happened since the last check
+    MaintenanceState& state = pimpl->GetMaintenanceState();
+    if (state.upToDate
+        && state.lastAdminMaintenance == lastAdminMaintenance
+        && state.lastUserMaintenance == lastUserMaintenance
+        && state.lastAdminUpdateDb == lastAdminUpdateDb
+        && state.userLanguagesIniTime == userLanguagesIniTime
+        && File::Exists(mpmDatabasePath))
+    {
+        return;
+    }
+
     // must refresh FNDB if:
     //   (1) it doesn't exist
     //   (2) in user mode and an admin just modified the MiKTeX configuration
-    PathName mpmDatabasePath(pimpl->session->GetMpmDatabasePathName());
     bool mustRefreshFndb = !File::Exists(mpmDatabasePath) || (!pimpl->session->IsAdminMode() && lastAdminMaintenance > File::GetLastWriteTime(mpmDatabasePath));
 
     // must build language.dat if:
@@ -332,7 +637,6 @@ void Application::AutoMaintenance()
     //   (2) in user mode and languages.ini is newer than languages.dat
     PathName userLanguageDat = pimpl->session->IsAdminMode() ? PathName() : pimpl->session->GetSpecialPath(SpecialPath::UserConfigRoot) / MIKTEX_PATH_LANGUAGE_DAT;
     bool mustRefreshUserLanguageDat = !pimpl->session->IsAdminMode() && File::Exists(userLanguageDat) && lastAdminMaintenance > File::GetLastWriteTime(userLanguageDat);
-    PathName userLanguagesIni = pimpl->session->IsAdminMode() ? PathName() : pimpl->session->GetSpecialPath(SpecialPath::UserConfigRoot) / MIKTEX_PATH_LANGUAGES_INI;
     mustRefreshUserLanguageDat = mustRefreshUserLanguageDat || (!pimpl->session->IsAdminMode() && IsNewer(userLanguagesIni, userLanguageDat));
 
     // must update package db if:
@@ -340,11 +644,26 @@ void Application::AutoMaintenance()
     bool mustUpdateDb = false;
     if (!pimpl->session->IsAdminMode())
     {
-        time_t lastAdminUpdateDb = pimpl->session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_DB, ConfigValue("0")).GetTimeT();
         PathName userPackageManifestsIni = pimpl->session->GetSpecialPath(SpecialPath::InstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
         mustUpdateDb = File::Exists(userPackageManifestsIni) && lastAdminUpdateDb > File::GetLastWriteTime(userPackageManifestsIni);
     }
 
+    if (!mustRefreshFndb && !mustRefreshUserLanguageDat && !mustUpdateDb)
+    {
+        state.lastAdminMaintenance = lastAdminMaintenance;
+        state.lastUserMaintenance = lastUserMaintenance;
+        state.lastAdminUpdateDb = lastAdminUpdateDb;
+        state.userLanguagesIniTime = userLanguagesIniTime;
+        state.upToDate = true;
+        pimpl->maintenanceStateChanged = true;
+        return;
+    }
+    if (state.upToDate)
+    {
+        state.upToDate = false;
+        pimpl->maintenanceStateChanged = true;
+    }
+
     PathName oneMiKTeXUtility;
     if ((mustRefreshFndb || mustRefreshUserLanguageDat || mustUpdateDb) && pimpl->session->FindFile(MIKTEX_MIKTEX_EXE, FileType::EXE, oneMiKTeXUtility))
     {
@@ -353,10 +672,10 @@ void Application::AutoMaintenance()
         {
             return;
         }
-        LOG4CXX_TRACE(pimpl->logger, "running MIKTEX_HOOK_AUTO_MAINTENANCE");
+        LOG4CXX_TRACE(pimpl->Logger(), "running MIKTEX_HOOK_AUTO_MAINTENANCE");
         if (mustUpdateDb)
         {
-            LOG4CXX_INFO(pimpl->logger, "refreshing user's package database from cache");
+            LOG4CXX_INFO(pimpl->Logger(), "refreshing user's package database from cache");
             if (pimpl->packageManager == nullptr)
             {
                 pimpl->packageManager = PackageManager::Create(PackageManager::InitInfo(this));
@@ -392,21 +711,21 @@ void Application::AutoMaintenance()
         {
             vector<string> args = commonArgs;
             args.insert(args.end(), { "fndb", "refresh" });
-            LOG4CXX_INFO(pimpl->logger, "running One MiKTeX Utility to refresh the file name database");
+            LOG4CXX_INFO(pimpl->Logger(), "running One MiKTeX Utility to refresh the file name database");
             pimpl->session->UnloadFilenameDatabase();
             if (!Process::Run(oneMiKTeXUtility, args, nullptr, &exitCode, nullptr))
             {
-                LOG4CXX_ERROR(pimpl->logger, "One MiKTEX Utility exited with code " << exitCode);
+                LOG4CXX_ERROR(pimpl->Logger(), "One MiKTEX Utility exited with code " << exitCode);
             }
         }
         if (mustRefreshFndb)
         {
             vector<string> args = commonArgs;
             args.insert(args.end(), { "fontmaps", "configure" });
-            LOG4CXX_INFO(pimpl->logger, "running One MiKTeX Utility to create font map files");
+            LOG4CXX_INFO(pimpl->Logger(), "running One MiKTeX Utility to create font map files");
             if (!Process::Run(oneMiKTeXUtility, args, nullptr, &exitCode, nullptr))
             {
-                LOG4CXX_ERROR(pimpl->logger, "One MiKTEX Utility exited with code " << exitCode);
+                LOG4CXX_ERROR(pimpl->Logger(), "One MiKTEX Utility exited with code " << exitCode);
             }
         }
         if (mustRefreshUserLanguageDat)
@@ -414,10 +733,10 @@ void Application::AutoMaintenance()
             MIKTEX_ASSERT(!pimpl->session->IsAdminMode());
             vector<string> args = commonArgs;
             args.insert(args.end(), { "languages", "configure" });
-            LOG4CXX_INFO(pimpl->logger, "running One MiKTeX Utility to refresh language.dat");
+            LOG4CXX_INFO(pimpl->Logger(), "running One MiKTeX Utility to refresh language.dat");
             if (!Process::Run(oneMiKTeXUtility, args, nullptr, &exitCode, nullptr))
             {
-                LOG4CXX_ERROR(pimpl->logger, "One MiKTeX Utility exited with code " << exitCode);
+                LOG4CXX_ERROR(pimpl->Logger(), "One MiKTeX Utility exited with code " << exitCode);
             }
         }
     }
@@ -430,32 +749,43 @@ void Application::AutoDiagnose()
 {
     time_t now = time(nullptr);
     PathName issuesJson = pimpl->session->GetSpecialPath(SpecialPath::ConfigRoot) / MIKTEX_PATH_ISSUES_JSON;
+    time_t issuesJsonTime = File::Exists(issuesJson) ? File::GetLastWriteTime(issuesJson) : 0;
+    MaintenanceState& state = pimpl->GetMaintenanceState();
+    bool mustFindIssues = issuesJsonTime == 0 || now > issuesJsonTime + ONE_WEEK;
+    if (!mustFindIssues && state.noIssues && state.issuesJsonTime == issuesJsonTime)
+    {
+        return;
+    }
     vector<Setup::Issue> issues;
     auto setupService = MiKTeX::Setup::SetupService::Create();
-    if (!File::Exists(issuesJson) || now > File::GetLastWriteTime(issuesJson) + ONE_WEEK)
+    if (mustFindIssues)
     {
         issues = setupService->FindIssues(false, false);
+        issuesJsonTime = File::Exists(issuesJson) ? File::GetLastWriteTime(issuesJson) : 0;
     }
     else
     {
         issues = setupService->GetIssues();
     }
+    state.issuesJsonTime = issuesJsonTime;
+    state.noIssues = issues.empty();
+    pimpl->maintenanceStateChanged = true;
 
     for (const Setup::Issue& issue : issues)
     {
-        if (pimpl->logger != nullptr)
+        if (pimpl->Logger() != nullptr)
         {
             if (issue.severity == Setup::IssueSeverity::Critical)
             {
-                LOG4CXX_FATAL(pimpl->logger, issue);
+                LOG4CXX_FATAL(pimpl->Logger(), issue);
             }
             else if (issue.severity == Setup::IssueSeverity::Major)
             {
-                LOG4CXX_ERROR(pimpl->logger, issue);
+                LOG4CXX_ERROR(pimpl->Logger(), issue);
             }
             else
             {
-                LOG4CXX_WARN(pimpl->logger, issue);
+                LOG4CXX_WARN(pimpl->Logger(), issue);
             }
         }
         if ((issue.severity == Setup::IssueSeverity::Critical || issue.severity == Setup::IssueSeverity::Major) && !GetQuietFlag())
@@ -471,34 +801,17 @@ void Application::Init(const Session::InitInfo& initInfoArg)
     pimpl->initialized = true;
     Session::InitInfo initInfo(initInfoArg);
     initInfo.SetTraceCallback(this);
-    pimpl->session = Session::Create(initInfo);
-    pimpl->session->SetFindFileCallback(this);
-    pimpl->translator = make_unique<Translator>(MIKTEX_COMP_ID, &pimpl->resources, pimpl->session);
-    ConfigureLogging();
-    auto thisProcess = Process::GetCurrentProcess();
-    auto parentProcess = thisProcess->get_Parent();
-    string invokerName;
-    if (parentProcess != nullptr)
-    {
-        invokerName = parentProcess->get_ProcessName();
-    }
-    if (invokerName.empty())
     {
-        invokerName = "unknown process";
+        PhaseStopwatch stopwatch(pimpl.get(), "session");
+        pimpl->session = Session::Create(initInfo);
+        pimpl->session->SetFindFileCallback(this);
     }
-    if (pimpl->commandLine.empty())
     {
-        // TODO
-    }
-    else
-    {
-        PathName cwd;
-        cwd.SetToCurrentDirectory();
-        LOG4CXX_INFO(pimpl->logger, fmt::format("this process ({0}) started by {1} in directory {2} with command line: {3}", thisProcess->GetSystemId(), Q_(invokerName), cwd.ToDisplayString(), pimpl->commandLine));
-#if defined(MIKTEX_WINDOWS)
-        LOG4CXX_INFO(pimpl->logger, fmt::format("running on Windows {0}", WindowsVersion::GetMajorMinorBuildString()));
-#endif
+        PhaseStopwatch stopwatch(pimpl.get(), "translator");
+        pimpl->translator = make_unique<Translator>(MIKTEX_COMP_ID, &pimpl->resources, pimpl->session);
     }
+    PhaseStopwatch settingsStopwatch(pimpl.get(), "settings");
+    pimpl->startupDirectory.SetToCurrentDirectory();
     pimpl->beQuiet = false;
     if (pimpl->enableInstaller == TriState::Undetermined)
     {
@@ -524,10 +837,13 @@ void Application::Init(const Session::InitInfo& initInfoArg)
     {
         SecurityRisk(T_("running with elevated privileges"));
     }
+    settingsStopwatch.Stop();
     if (pimpl->enableMaintenance == TriState::True)
     {
+        PhaseStopwatch stopwatch(pimpl.get(), "maintenance");
         AutoMaintenance();
     }
+    pimpl->PrintStartupTimes("startup");
 }
 
 void Application::Init(vector<const char*>& args)
@@ -560,7 +876,8 @@ void Application::Init(const string& programInvocationName)
 
 void Application::Finalize2(int exitCode)
 {
-    if (pimpl->logger != nullptr)
+    // a failure is worth configuring the logging system
+    if (pimpl->logger != nullptr || (exitCode != 0 && pimpl->Logger() != nullptr))
     {
         auto thisProcess = Process::GetCurrentProcess();
         LOG4CXX_INFO(pimpl->logger, "this process (" << thisProcess->GetSystemId() << ") finishes with exit code " << exitCode);
@@ -572,9 +889,32 @@ void Application::Finalize()
 {
     if (pimpl->enableDiagnose == TriState::True)
     {
+        PhaseStopwatch stopwatch(pimpl.get(), "diagnose");
         AutoDiagnose();
     }
-    FlushPendingTraceMessages();
+    pimpl->SaveMaintenanceState();
+    pimpl->PrintStartupTimes("deferred");
+    if (!isLog4cxxConfigured && pimpl->session != nullptr)
+    {
+        // messages traced before the session existed
+        for (const TraceCallback::TraceMessage& m : pimpl->pendingTraceMessages)
+        {
+            if (pimpl->IsLogged(m.level))
+            {
+                pimpl->Logger();
+                break;
+            }
+        }
+    }
+    if (isLog4cxxConfigured)
+    {
+        FlushPendingTraceMessages();
+    }
+    else
+    {
+        // nothing noteworthy happened
+        pimpl->pendingTraceMessages.clear();
+    }
     if (pimpl->installer != nullptr)
     {
         pimpl->installer->Dispose();
@@ -600,8 +940,8 @@ void Application::Finalize()
 
 void Application::ReportLine(const string& str)
 {
-    MIKTEX_ASSERT(pimpl->logger != nullptr);
-    LOG4CXX_INFO(pimpl->logger, "mpm: " << str);
+    MIKTEX_ASSERT(pimpl->Logger() != nullptr);
+    LOG4CXX_INFO(pimpl->Logger(), "mpm: " << str);
 }
 
 bool Application::OnRetryableError(const string& message)
@@ -700,7 +1040,7 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
     vector<string> fileList;
     fileList.push_back(packageId);
     pimpl->installer->SetFileLists(fileList, vector<string>());
-    LOG4CXX_INFO(pimpl->logger, "installing package " << packageId << " triggered by " << trigger.ToString());
+    LOG4CXX_INFO(pimpl->Logger(), "installing package " << packageId << " triggered by " << trigger.ToString());
     bool done = false;
     bool switchToAdminMode = (pimpl->mpmAutoAdmin == TriState::True && !pimpl->session->IsAdminMode());
     if (switchToAdminMode)
@@ -717,10 +1057,10 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
     {
         pimpl->enableInstaller = TriState::False;
         pimpl->ignoredPackages.insert(packageId);
-        LOG4CXX_FATAL(pimpl->logger, ex.GetErrorMessage());
-        LOG4CXX_FATAL(pimpl->logger, "Info: " << ex.GetInfo());
-        LOG4CXX_FATAL(pimpl->logger, "Source: " << ex.GetSourceFile());
-        LOG4CXX_FATAL(pimpl->logger, "Line: " << ex.GetSourceLine());
+        LOG4CXX_FATAL(pimpl->Logger(), ex.GetErrorMessage());
+        LOG4CXX_FATAL(pimpl->Logger(), "Info: " << ex.GetInfo());
+        LOG4CXX_FATAL(pimpl->Logger(), "Source: " << ex.GetSourceFile());
+        LOG4CXX_FATAL(pimpl->Logger(), "Line: " << ex.GetSourceLine());
     }
     if (switchToAdminMode)
     {
@@ -774,20 +1114,20 @@ bool Application::TryCreateFile(const PathName& fileName, FileType fileType)
     default:
         return false;
     }
-    LOG4CXX_INFO(pimpl->logger, "going to create file: " << fileName);
+    LOG4CXX_INFO(pimpl->Logger(), "going to create file: " << fileName);
     ProcessOutput<50000> processOutput;
     int exitCode;
     args[0] = makeUtility.GetFileNameWithoutExtension().ToString();
     if (!Process::Run(makeUtility, args, &processOutput, &exitCode, nullptr))
     {
-        LOG4CXX_ERROR(pimpl->logger, makeUtility << " could not be started");
+        LOG4CXX_ERROR(pimpl->Logger(), makeUtility << " could not be started");
         return false;
     }
     if (exitCode != 0)
     {
-        LOG4CXX_ERROR(pimpl->logger, makeUtility << " did not succeed; exitCode: " << exitCode);
-        LOG4CXX_ERROR(pimpl->logger, "output:");
-        LOG4CXX_ERROR(pimpl->logger, processOutput.StdoutToString());
+        LOG4CXX_ERROR(pimpl->Logger(), makeUtility << " did not succeed; exitCode: " << exitCode);
+        LOG4CXX_ERROR(pimpl->Logger(), "output:");
+        LOG4CXX_ERROR(pimpl->Logger(), processOutput.StdoutToString());
         return false;
     }
     return true;
@@ -807,12 +1147,18 @@ bool Application::Trace(const TraceCallback::TraceMessage& traceMessage)
 {
     if (!isLog4cxxConfigured)
     {
-        if (pimpl->pendingTraceMessages.size() > 100)
+        // messages which get logged are worth configuring the logging
+        // system; the others are dropped
+        if (!pimpl->IsLogged(traceMessage.level))
         {
-            pimpl->pendingTraceMessages.clear();
+            return true;
+        }
+        if (pimpl->Logger() == nullptr)
+        {
+            // no session yet
+            pimpl->pendingTraceMessages.push_back(traceMessage);
+            return true;
         }
-        pimpl->pendingTraceMessages.push_back(traceMessage);
-        return true;
     }
     FlushPendingTraceMessages();
     TraceInternal(traceMessage);
@@ -918,12 +1264,12 @@ void Application::Sorry(const string& name, const string& description, const str
 
 void Application::Sorry(const string& name, const MiKTeXException& ex)
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->Logger() != nullptr)
     {
-        LOG4CXX_FATAL(pimpl->logger, ex.GetErrorMessage());
-        LOG4CXX_FATAL(pimpl->logger, "Info: " << ex.GetInfo());
-        LOG4CXX_FATAL(pimpl->logger, "Source: " << ex.GetSourceFile());
-        LOG4CXX_FATAL(pimpl->logger, "Line: " << ex.GetSourceLine());
+        LOG4CXX_FATAL(pimpl->Logger(), ex.GetErrorMessage());
+        LOG4CXX_FATAL(pimpl->Logger(), "Info: " << ex.GetInfo());
+        LOG4CXX_FATAL(pimpl->Logger(), "Source: " << ex.GetSourceFile());
+        LOG4CXX_FATAL(pimpl->Logger(), "Line: " << ex.GetSourceLine());
     }
     else
     {
@@ -934,9 +1280,9 @@ void Application::Sorry(const string& name, const MiKTeXException& ex)
 
 void Application::Sorry(const string& name, const exception& ex)
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->Logger() != nullptr)
     {
-        LOG4CXX_FATAL(pimpl->logger, ex.what());
+        LOG4CXX_FATAL(pimpl->Logger(), ex.what());
     }
     else
     {
@@ -949,9 +1295,9 @@ void Application::Sorry(const string& name, const exception& ex)
 
 MIKTEXNORETURN void Application::FatalError(const string& s)
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->Logger() != nullptr)
     {
-        LOG4CXX_FATAL(pimpl->logger, s);
+        LOG4CXX_FATAL(pimpl->Logger(), s);
     }
     Sorry(Utils::GetExeName(), s);
     throw 1;
@@ -1104,24 +1450,24 @@ shared_ptr<Session> Application::GetSession() const
 
 void Application::LogInfo(const std::string& message) const
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->Logger() != nullptr)
     {
-        LOG4CXX_INFO(pimpl->logger, message);
+        LOG4CXX_INFO(pimpl->Logger(), message);
     }
 }
 
 void Application::LogWarn(const std::string& message) const
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->Logger() != nullptr)
     {
-        LOG4CXX_WARN(pimpl->logger, message);
+        LOG4CXX_WARN(pimpl->Logger(), message);
     }
 }
 
 void Application::LogError(const std::string& message) const
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->Logger() != nullptr)
     {
-        LOG4CXX_ERROR(pimpl->logger, message);
+        LOG4CXX_ERROR(pimpl->Logger(), message);
     }
 }
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Application class
  *
- * @copyright Copyright © 2005-2022 Christian Schenk
+ * @copyright Copyright © 2005-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Application Framework.
  *
@@ -253,7 +253,6 @@ private:
 
     void FlushPendingTraceMessages();
     void TraceInternal(const MiKTeX::Trace::TraceCallback::TraceMessage& traceMessage);
-    void ConfigureLogging();
     void AutoMaintenance();
     void AutoDiagnose();
 
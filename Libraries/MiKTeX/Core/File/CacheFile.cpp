@@ -0,0 +1,91 @@
+/**
+ * @file File/CacheFile.cpp
+ * @author Christian Schenk
+ * @brief Cache files derived from source files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <fmt/format.h>
+
+#include <miktex/Core/CacheFile>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Process>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+bool CacheFile::IsSettled(time_t lastWriteTime)
+{
+    // the modification time has a resolution of one second: a change within
+    // the same second would go unnoticed
+    return lastWriteTime < time(nullptr) - 1;
+}
+
+bool CacheFile::IsSettled(const PathName& path)
+{
+    return IsSettled(File::GetLastWriteTime(path));
+}
+
+bool CacheFile::IsUnchanged(const PathName& path, time_t lastWriteTime)
+{
+    return (File::Exists(path) || Directory::Exists(path)) && File::GetLastWriteTime(path) == lastWriteTime;
+}
+
+bool CacheFile::IsUnchanged(const PathName& path, uint64_t size, time_t lastWriteTime)
+{
+    return File::Exists(path) && File::GetSize(path) == size && File::GetLastWriteTime(path) == lastWriteTime;
+}
+
+namespace {
+
+    void WriteAndMove(const PathName& path, const function<void(const PathName&)>& write)
+    {
+        // write to a temporary file first, so that concurrent readers never
+        // see a partially written cache file
+        Directory::Create(path.GetDirectoryName());
+        PathName tempPath = path;
+        tempPath.AppendExtension(fmt::format(".{}.tmp", Process::GetCurrentProcess()->GetSystemId()));
+        try
+        {
+            write(tempPath);
+            File::Move(tempPath, path, { FileMoveOption::ReplaceExisting });
+        }
+        catch (const exception&)
+        {
+            if (File::Exists(tempPath))
+            {
+                File::Delete(tempPath);
+            }
+            throw;
+        }
+    }
+
+}
+
+void CacheFile::Write(const PathName& path, const vector<unsigned char>& data)
+{
+    WriteAndMove(path, [&data](const PathName& tempPath) { File::WriteBytes(tempPath, data); });
+}
+
+void CacheFile::Write(const PathName& path, const function<void(ostream&)>& writer)
+{
+    WriteAndMove(path, [&writer](const PathName& tempPath)
+    {
+        ofstream stream = File::CreateOutputStream(tempPath, ios_base::out | ios_base::binary);
+        writer(stream);
+        stream.close();
+    });
+}
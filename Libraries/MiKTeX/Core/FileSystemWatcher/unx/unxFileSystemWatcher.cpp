@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief File system watcher (Linux)
  *
- * @copyright Copyright © 2021-2023 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -13,6 +13,8 @@
 
 #include "config.h"
 
+#include <cstring>
+
 #include <unistd.h>
 #include <sys/inotify.h>
 
@@ -59,21 +61,41 @@ unxFileSystemWatcher::~unxFileSystemWatcher()
 
 void unxFileSystemWatcher::AddDirectories(const vector<PathName>& directories)
 {
+    vector<FileSystemChangeEvent> unwatched;
     unique_lock<shared_mutex> l(mutex);
     for (const auto& dir : directories)
     {
         int wd = inotify_add_watch(watchFd, dir.GetData(), IN_ALL_EVENTS);
         if (wd < 0)
         {
-            MIKTEX_FATAL_CRT_ERROR_2("inotify_add_Watch", "path", dir.ToString());
+            // e.g. ENOSPC: the inotify watch limit has been reached; let the
+            // subscribers know that changes in this directory go unnoticed
+            trace_error->WriteLine("core", MiKTeX::Trace::TraceLevel::Error, fmt::format("cannot watch directory {0}: {1}", Q_(dir.ToDisplayString()), strerror(errno)));
+            FileSystemChangeEvent ev;
+            ev.action = FileSystemChangeAction::Overflow;
+            ev.fileName = dir;
+            unwatched.push_back(ev);
+            continue;
         }
-        if (this->directories.find(wd) != this->directories.end())
+        // the watch descriptor of a renamed directory is the one which has
+        // been returned for the old path: remember the new path
+        auto it = this->directories.find(wd);
+        if (it != this->directories.end() && it->second == dir)
         {
             continue;
         }
         trace_files->WriteLine("core", fmt::format("watching directory: {0}", Q_(dir.ToDisplayString())));
         this->directories[wd] = dir;
     }
+    l.unlock();
+    if (!unwatched.empty())
+    {
+        {
+            lock_guard<std::mutex> l2(notifyMutex);
+            pendingNotifications.insert(pendingNotifications.end(), unwatched.begin(), unwatched.end());
+        }
+        notifyCondition.notify_all();
+    }
 }
 
 bool unxFileSystemWatcher::Start()
@@ -118,7 +140,9 @@ bool unxFileSystemWatcher::Stop()
 void unxFileSystemWatcher::WatchDirectories()
 {
     vector<unsigned char> buffer;
-    buffer.resize(4096);
+    // room for many events: a burst (e.g. unpacking an archive) would
+    // otherwise take many reads
+    buffer.resize(64 * 1024);
     while (true)
     {
         int maxFd = -1;
@@ -163,11 +187,27 @@ void unxFileSystemWatcher::WatchDirectories()
 void unxFileSystemWatcher::HandleDirectoryChange(const inotify_event* evt)
 {
     FileSystemChangeEvent ev;
-    if ((evt->mask & IN_CREATE) != 0)
+    if ((evt->mask & IN_Q_OVERFLOW) != 0)
+    {
+        // the kernel event queue has overflowed
+        trace_error->WriteLine("core", "inotify event queue overflow");
+        ev.action = FileSystemChangeAction::Overflow;
+        lock_guard<std::mutex> l2(notifyMutex);
+        pendingNotifications.push_back(ev);
+        return;
+    }
+    if ((evt->mask & IN_IGNORED) != 0)
+    {
+        // the watched directory has been removed
+        unique_lock<shared_mutex> l(mutex);
+        directories.erase(evt->wd);
+        return;
+    }
+    if ((evt->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
     {
         ev.action = FileSystemChangeAction::Added;
     }
-    else if ((evt->mask & IN_DELETE) != 0)
+    else if ((evt->mask & (IN_DELETE | IN_MOVED_FROM)) != 0)
     {
         ev.action = FileSystemChangeAction::Removed;
     }
@@ -1,6 +1,6 @@
 /* winFileSystemWatcher.cpp: file system watcher (Windows specials)
 
-   Copyright (C) 2021-2022 Christian Schenk
+   Copyright (C) 2021-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -175,6 +175,13 @@ void winFileSystemWatcher::WatchDirectories()
     if (bytesReturned == 0)
     {
       trace_error->WriteLine("core", MiKTeX::Trace::TraceLevel::Error, fmt::format("event buffer overflow while watching: {0}", dwi.path.ToDisplayString()));
+      {
+        FileSystemChangeEvent overflowEvent;
+        overflowEvent.action = FileSystemChangeAction::Overflow;
+        lock_guard l2(notifyMutex);
+        pendingNotifications.push_back(overflowEvent);
+      }
+      notifyCondition.notify_all();
       continue;
     }
     FILE_NOTIFY_INFORMATION *fni = reinterpret_cast<FILE_NOTIFY_INFORMATION *>(dwi.buffer);
@@ -204,12 +211,14 @@ void winFileSystemWatcher::HandleDirectoryChange(const PathName& dir, const FILE
   switch (fni->Action)
   {
   case FILE_ACTION_ADDED:
+  case FILE_ACTION_RENAMED_NEW_NAME:
     ev.action = FileSystemChangeAction::Added;
     break;
   case FILE_ACTION_MODIFIED:
     ev.action = FileSystemChangeAction::Modified;
     break;
   case FILE_ACTION_REMOVED:
+  case FILE_ACTION_RENAMED_OLD_NAME:
     ev.action = FileSystemChangeAction::Removed;
     break;
   default:
@@ -195,18 +195,15 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
     pathPattern = lpsz;
   }
 
-  PathName comparablePathPattern(pathPattern);
-  comparablePathPattern.TransformForComparison();
+  CompiledPathPattern& compiledPathPattern = CompilePathPattern(pathPattern);
 
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
-    PathName relativeDirectory;
-    relativeDirectory = it->second.GetDirectory();
-    if (Match(comparablePathPattern.GetData(), PathName(relativeDirectory).TransformForComparison().GetData()))
+    if (Matches(compiledPathPattern, it->second.directoryId))
     {
       PathName path;
       path = rootDirectory;
-      path /= relativeDirectory.ToString();
+      path /= it->second.GetDirectory();
       path /= fileName.ToString();
       trace_fndb->WriteLine("core", fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(it->second.GetInfo())));
       result.push_back({ path, it->second.GetInfo() });
@@ -296,10 +293,15 @@ bool FileNameDatabase::FileExists(const PathName& path)
   string fileName;
   string directory;
   std::tie(fileName, directory) = SplitPath(path);
+  FndbWord directoryId;
+  if (!TryGetDirectoryId(directory, directoryId))
+  {
+    return false;
+  }
   pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(directory)))
+    if (it->second.directoryId == directoryId)
     {
       return true;
     }
@@ -307,6 +309,136 @@ bool FileNameDatabase::FileExists(const PathName& path)
   return false;
 }
 
+vector<PathName> FileNameDatabase::ExpandPathPattern(const string& pathPattern_)
+{
+  string pathPattern = pathPattern_;
+
+  ApplyChangeFile();
+
+  trace_fndb->WriteLine("core", fmt::format(T_("fndb expand: rootDirectory={0}, pathPattern={1}"), Q_(rootDirectory), Q_(pathPattern)));
+
+  // path pattern must be relative to root directory
+  if (PathName(pathPattern).IsAbsolute())
+  {
+    const char* lpsz = Utils::GetRelativizedPath(pathPattern.c_str(), rootDirectory.GetData());
+    if (lpsz == nullptr)
+    {
+      MIKTEX_FATAL_ERROR_2(T_("Path pattern is not covered by file name database."), "pattern", pathPattern);
+    }
+    pathPattern = lpsz;
+  }
+
+  CompiledPathPattern& compiledPathPattern = CompilePathPattern(pathPattern);
+
+  // directory IDs have been assigned in walk order, i.e., parent directories
+  // come first
+  vector<PathName> result;
+  for (FndbWord directoryId = 0; directoryId < directories.size(); ++directoryId)
+  {
+    if (Matches(compiledPathPattern, directoryId))
+    {
+      string directory = GetDirectoryPath(directoryId);
+      result.push_back(directory.empty() ? rootDirectory : rootDirectory / directory);
+    }
+  }
+
+  return result;
+}
+
+void FileNameDatabase::NeedDirectoryIndex()
+{
+  if (haveDirectoryIndex)
+  {
+    return;
+  }
+  directoryIndex.clear();
+  directoryIndex.reserve(directories.size());
+  for (FndbWord directoryId = 0; directoryId < directories.size(); ++directoryId)
+  {
+    directoryIndex.emplace(PathName(GetDirectoryPath(directoryId)).TransformForComparison().ToString(), directoryId);
+  }
+  haveDirectoryIndex = true;
+}
+
+bool FileNameDatabase::TryGetDirectoryId(const string& directory, FndbWord& directoryId)
+{
+  NeedDirectoryIndex();
+  auto it = directoryIndex.find(PathName(directory).TransformForComparison().ToString());
+  if (it == directoryIndex.end())
+  {
+    return false;
+  }
+  directoryId = it->second;
+  return true;
+}
+
+FndbWord FileNameDatabase::GetDirectoryId(const string& directory)
+{
+  FndbWord directoryId;
+  if (TryGetDirectoryId(directory, directoryId))
+  {
+    return directoryId;
+  }
+  // new directory: intern the parent directory first
+  FndbWord parent = 0;
+  string parentDirectory = PathName(directory).GetDirectoryName().ToString();
+  if (!directory.empty() && parentDirectory != directory)
+  {
+    // RECURSION
+    parent = GetDirectoryId(parentDirectory);
+  }
+  directoryId = static_cast<FndbWord>(directories.size());
+  Directory dir;
+  dir.path = directory;
+  dir.parent = parent;
+  directories.push_back(dir);
+  directoryIndex.emplace(PathName(directory).TransformForComparison().ToString(), directoryId);
+  return directoryId;
+}
+
+FileNameDatabase::CompiledPathPattern& FileNameDatabase::CompilePathPattern(const string& pathPattern)
+{
+  auto it = compiledPathPatterns.find(pathPattern);
+  if (it != compiledPathPatterns.end())
+  {
+    return it->second;
+  }
+  CompiledPathPattern compiled;
+  compiled.comparablePattern = PathName(pathPattern).TransformForComparison().ToString();
+  size_t l = compiled.comparablePattern.length();
+  compiled.recursive = l >= RECURSION_INDICATOR_LENGTH && compiled.comparablePattern.compare(l - RECURSION_INDICATOR_LENGTH, RECURSION_INDICATOR_LENGTH, RECURSION_INDICATOR) == 0;
+  compiled.verdicts.resize(directories.size(), CompiledPathPattern::Unknown);
+  return compiledPathPatterns.emplace(pathPattern, std::move(compiled)).first->second;
+}
+
+bool FileNameDatabase::Matches(CompiledPathPattern& pattern, FndbWord directoryId)
+{
+  if (directoryId >= pattern.verdicts.size())
+  {
+    // directories have been added
+    pattern.verdicts.resize(directories.size(), CompiledPathPattern::Unknown);
+  }
+  if (pattern.verdicts[directoryId] == CompiledPathPattern::Unknown)
+  {
+    FndbWord parent = directories[directoryId].parent;
+    MIKTEX_ASSERT(parent <= directoryId);
+    // sub-directories of a matching directory match a recursive pattern: no
+    // need to look at the path
+    // RECURSION
+    if (pattern.recursive && parent != directoryId && Matches(pattern, parent))
+    {
+      pattern.verdicts[directoryId] = CompiledPathPattern::Yes;
+    }
+    else
+    {
+      PathName comparableDirectory(GetDirectoryPath(directoryId));
+      comparableDirectory.TransformForComparison();
+      pattern.verdicts[directoryId] = Match(pattern.comparablePattern.c_str(), comparableDirectory.GetData()) ? CompiledPathPattern::Yes : CompiledPathPattern::No;
+    }
+  }
+  return pattern.verdicts[directoryId] == CompiledPathPattern::Yes;
+}
+
 tuple<string, string> FileNameDatabase::SplitPath(const PathName& path_) const
 {
   PathName path = path_;
@@ -339,11 +471,12 @@ void FileNameDatabase::FastInsertRecord(FileNameDatabase::Record&& record)
 
 bool FileNameDatabase::InsertRecord(FileNameDatabase::Record&& record)
 {
+  record.directoryId = GetDirectoryId(record.GetDirectory());
   string key = MakeKey(record.fileName);
   pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key);
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(record.GetDirectory())))
+    if (it->second.directoryId == record.directoryId)
     {
       return false;
     }
@@ -372,11 +505,15 @@ void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
     FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.fileName);
   }
   vector<FileNameHashTable::const_iterator> toBeRemoved;
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  FndbWord directoryId;
+  if (TryGetDirectoryId(record.GetDirectory(), directoryId))
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(record.GetDirectory())))
+    for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
     {
-      toBeRemoved.push_back(it);
+      if (it->second.directoryId == directoryId)
+      {
+        toBeRemoved.push_back(it);
+      }
     }
   }
   if (toBeRemoved.empty())
@@ -389,6 +526,23 @@ void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
   }
 }
 
+void FileNameDatabase::ReadDirectories()
+{
+  const FileNameDatabaseDirectoryRecord* table = GetDirectoryTable();
+  directories.clear();
+  directories.reserve(fndbHeader->numDirectoryRecords);
+  for (size_t idx = 0; idx < fndbHeader->numDirectoryRecords; ++idx)
+  {
+    Directory dir;
+    dir.foPath = table[idx].foPath;
+    dir.parent = table[idx].parent;
+    directories.push_back(std::move(dir));
+  }
+  directoryIndex.clear();
+  haveDirectoryIndex = false;
+  compiledPathPatterns.clear();
+}
+
 void FileNameDatabase::ReadFileNames()
 {
   fileNames.clear();
@@ -402,7 +556,11 @@ void FileNameDatabase::ReadFileNames(const FileNameDatabaseRecord* table)
   for (size_t idx = 0; idx < fndbHeader->numFiles; ++idx)
   {
     const FileNameDatabaseRecord* rec = &table[idx];
-    FastInsertRecord(Record(this, GetString(rec->foFileName), rec->foDirectory, rec->foInfo));
+    if (rec->directory >= directories.size())
+    {
+      FNDB_DAMAGED_2(T_("Invalid directory ID."), "fileName", GetString(rec->foFileName));
+    }
+    FastInsertRecord(Record(this, GetString(rec->foFileName), rec->foDirectory, rec->foInfo, rec->directory));
   }
 }
 
@@ -434,6 +592,7 @@ void FileNameDatabase::Initialize(const PathName& fndbPath, const PathName& root
   fsWatcher->AddDirectories({fndbPath.GetDirectoryName()});
 
   OpenFileNameDatabase(fndbPath);
+  ReadDirectories();
   ReadFileNames();
 
   changeFile = fndbPath;
@@ -502,7 +661,9 @@ void FileNameDatabase::ApplyChangeFile()
         FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
       }
       string& fileNameInfo = data[2];
-      FastInsertRecord(Record(std::move(fileName), std::move(directory), std::move(fileNameInfo)));
+      Record record(std::move(fileName), std::move(directory), std::move(fileNameInfo));
+      record.directoryId = GetDirectoryId(record.GetDirectory());
+      FastInsertRecord(std::move(record));
     }
     else if (op == "-")
     {
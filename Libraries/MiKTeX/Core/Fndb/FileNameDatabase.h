@@ -26,7 +26,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <string>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include <miktex/Core/Debug>
 #include <miktex/Core/DirectoryLister>
@@ -69,6 +72,10 @@ public:
 public:
   bool FileExists(const MiKTeX::Util::PathName& path);
 
+  // get all directories matching the path pattern
+public:
+  std::vector<MiKTeX::Util::PathName> ExpandPathPattern(const std::string& pathPattern);
+
 public:
   std::chrono::time_point<std::chrono::high_resolution_clock> GetLastAccessTime() const
   {
@@ -79,9 +86,10 @@ private:
   struct Record
   {
   public:
-    Record(const FileNameDatabase* fndb, std::string&& fileName, FndbByteOffset foDirectory, FndbByteOffset foInfo) :
+    Record(const FileNameDatabase* fndb, std::string&& fileName, FndbByteOffset foDirectory, FndbByteOffset foInfo, FndbWord directoryId) :
       fndb(fndb),
       fileName(std::move(fileName)),
+      directoryId(directoryId),
       foDirectory(foDirectory),
       foInfo(foInfo)
     {
@@ -130,6 +138,8 @@ private:
     const FileNameDatabase* fndb = nullptr;
   public:
     std::string fileName;
+  public:
+    FndbWord directoryId = 0;
   private:
     FndbByteOffset foDirectory = 0;
   private:
@@ -140,6 +150,54 @@ private:
     std::string info;
   };
 
+private:
+  struct Directory
+  {
+    FndbByteOffset foPath = 0;
+    std::string path;
+    FndbWord parent = 0;
+  };
+
+  // a path pattern compiled into the set of directories it matches; the
+  // verdicts are computed on demand
+private:
+  struct CompiledPathPattern
+  {
+    enum Verdict : uint8_t
+    {
+      Unknown,
+      No,
+      Yes
+    };
+    std::string comparablePattern;
+    // the pattern ends with the recursion indicator, i.e., all
+    // sub-directories of a matching directory match as well
+    bool recursive = false;
+    std::vector<Verdict> verdicts;
+  };
+
+private:
+  std::string GetDirectoryPath(FndbWord directoryId) const
+  {
+    const Directory& dir = directories[directoryId];
+    return dir.foPath != 0 ? GetString(dir.foPath) : dir.path;
+  }
+
+private:
+  FndbWord GetDirectoryId(const std::string& directory);
+
+private:
+  bool TryGetDirectoryId(const std::string& directory, FndbWord& directoryId);
+
+private:
+  void NeedDirectoryIndex();
+
+private:
+  CompiledPathPattern& CompilePathPattern(const std::string& pathPattern);
+
+private:
+  bool Matches(CompiledPathPattern& pattern, FndbWord directoryId);
+
 private:
   std::tuple<std::string, std::string> SplitPath(const MiKTeX::Util::PathName& path) const;
 
@@ -163,6 +221,9 @@ private:
 
 private:
   void ReadFileNames(const FileNameDatabaseRecord* table);
+
+private:
+  void ReadDirectories();
 private:
   void Finalize();
 
@@ -201,6 +262,12 @@ private:
     return reinterpret_cast<const FileNameDatabaseRecord*>(GetPointer(fndbHeader->foTable));
   }
 
+private:
+  const FileNameDatabaseDirectoryRecord* GetDirectoryTable() const
+  {
+    return reinterpret_cast<const FileNameDatabaseDirectoryRecord*>(GetPointer(fndbHeader->foDirectories));
+  }
+
 private:
   void Initialize(const MiKTeX::Util::PathName& fndbPath, const MiKTeX::Util::PathName& rootDirectory, std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher);
 
@@ -237,6 +304,20 @@ private:
 private:
   FileNameHashTable fileNames;
 
+  // directory table; indexed by directory ID
+private:
+  std::vector<Directory> directories;
+
+  // comparable directory path -> directory ID; built on demand
+private:
+  std::unordered_map<std::string, FndbWord> directoryIndex;
+
+private:
+  bool haveDirectoryIndex = false;
+
+private:
+  std::unordered_map<std::string, CompiledPathPattern> compiledPathPatterns;
+
 private:
   std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
 
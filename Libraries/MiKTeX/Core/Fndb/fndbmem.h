@@ -62,7 +62,13 @@ struct FileNameDatabaseHeader
 
   // size (in bytes) of fndb; includes header size
   FndbWord size;
-  
+
+  // pointer to first directory record
+  FndbByteOffset foDirectories;
+
+  // number of directory records
+  FndbWord numDirectoryRecords;
+
   FndbWord reserved;
 
   void Init()
@@ -75,12 +81,23 @@ struct FileNameDatabaseHeader
   }
 };
 
+// the directory ID is the index of the directory record; parents come
+// before their children
+struct FileNameDatabaseDirectoryRecord
+{
+  // relative path (Unix style); empty for the root directory
+  FndbByteOffset foPath;
+
+  // parent directory ID; the root directory (ID 0) is its own parent
+  FndbWord parent;
+};
+
 struct FileNameDatabaseRecord
 {
   FndbByteOffset foFileName;
   FndbByteOffset foDirectory;
   FndbByteOffset foInfo;
-  FndbByteOffset reserved = 0;
+  FndbWord directory = 0;
 };
 
 CORE_INTERNAL_END_NAMESPACE;
@@ -58,9 +58,16 @@ struct FILENAMEINFO
 {
   string FileName;
   const string* Directory = nullptr;
+  FndbWord DirectoryId = 0;
   const string* Info = nullptr;
 };
 
+struct DIRECTORYINFO
+{
+  const string* Path = nullptr;
+  FndbWord Parent = 0;
+};
+
 class FndbManager
 {
 public:
@@ -133,10 +140,10 @@ private:
   static void GetIgnorableFiles(const PathName& dirPath, vector<string>& filesToBeIgnored);
 
 public:
-  void ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp);
+  void ReadDirectory(const PathName& dirPath, FndbWord directoryId, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp);
 
 private:
-  void CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames);
+  void CollectFiles(const PathName& parentPath, const PathName& folderName, FndbWord parentId, vector<FILENAMEINFO>& fileNames);
 
 private:
   PathName rootPath;
@@ -161,6 +168,9 @@ private:
 
 private:
   unordered_set<string> stringPool;
+
+private:
+  vector<DIRECTORYINFO> directories;
   
 private:
   typedef unordered_map<string, FndbByteOffset> StringMap;
@@ -268,7 +278,7 @@ void FndbManager::GetIgnorableFiles(const PathName& dirPath, vector<string>& fil
   sort(filesToBeIgnored.begin(), filesToBeIgnored.end(), StringComparerIgnoringCase());
 }
 
-void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp)
+void FndbManager::ReadDirectory(const PathName& dirPath, FndbWord directoryId, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp)
 {
   if (!Directory::Exists(dirPath))
   {
@@ -301,6 +311,7 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
       FILENAMEINFO filenameinfo;
       filenameinfo.FileName = entry.name;
       filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
+      filenameinfo.DirectoryId = directoryId;
       fileNames.push_back(filenameinfo);
     }
   }
@@ -327,7 +338,7 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   }
 }
 
-void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames)
+void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folderName, FndbWord parentId, vector<FILENAMEINFO>& fileNames)
 {
   if (currentLevel > deepestLevel)
   {
@@ -345,6 +356,12 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
   PathName directory(Utils::GetRelativizedPath(path.GetData(), rootPath.GetData()));
   directory = directory.ToUnix();
 
+  FndbWord directoryId = static_cast<FndbWord>(directories.size());
+  DIRECTORYINFO directoryinfo;
+  directoryinfo.Path = &*stringPool.insert(directory.ToString()).first;
+  directoryinfo.Parent = directoryId == 0 ? 0 : parentId;
+  directories.push_back(directoryinfo);
+
   if (callback != nullptr)
   {
     if (!callback->OnProgress(static_cast<unsigned>(currentLevel), path))
@@ -364,6 +381,7 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
         FILENAMEINFO filenameinfo;
         filenameinfo.FileName = files[i];
         filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
+        filenameinfo.DirectoryId = directoryId;
         filenameinfo.Info = &*stringPool.insert(infos[i]).first;
         fileNames.push_back(filenameinfo);
       }
@@ -372,7 +390,7 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
 
   if (!done)
   {
-    ReadDirectory(path, subDirectoryNames, fileNames, true);
+    ReadDirectory(path, directoryId, subDirectoryNames, fileNames, true);
   }
 
   numDirectories += subDirectoryNames.size();
@@ -384,7 +402,7 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
   for (const string& s : subDirectoryNames)
   {
     // RECURSION
-    CollectFiles(pathFolder, PathName(s), fileNames);
+    CollectFiles(pathFolder, PathName(s), directoryId, fileNames);
     ++i;
   }
   --currentLevel;
@@ -409,11 +427,14 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
     currentLevel = 0;
     this->callback = callback;
     vector<FILENAMEINFO> fileNames;
-    CollectFiles(rootPath, PathName(CURRENT_DIRECTORY), fileNames);
+    directories.clear();
+    CollectFiles(rootPath, PathName(CURRENT_DIRECTORY), 0, fileNames);
     numFiles = fileNames.size();
     AlignMem();
     fndb.foTable = ReserveMem(fileNames.size() * sizeof(FileNameDatabaseRecord));
     AlignMem();
+    fndb.foDirectories = ReserveMem(directories.size() * sizeof(FileNameDatabaseDirectoryRecord));
+    AlignMem();
     fndb.foStrings = GetMemTop();
     for (size_t idx = 0; idx < fileNames.size(); ++idx)
     {
@@ -421,8 +442,17 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
       rec.foFileName = PushBack(fileNames[idx].FileName.c_str());
       rec.foDirectory = PushBack(fileNames[idx].Directory->c_str());
       rec.foInfo = PushBack(fileNames[idx].Info == nullptr ? "" : fileNames[idx].Info->c_str());
+      rec.directory = fileNames[idx].DirectoryId;
       SetMem(static_cast<unsigned>(fndb.foTable + idx * sizeof(rec)), &rec, sizeof(rec));
     }
+    for (size_t idx = 0; idx < directories.size(); ++idx)
+    {
+      FileNameDatabaseDirectoryRecord rec;
+      rec.foPath = PushBack(directories[idx].Path->c_str());
+      rec.parent = directories[idx].Parent;
+      SetMem(static_cast<unsigned>(fndb.foDirectories + idx * sizeof(rec)), &rec, sizeof(rec));
+    }
+    fndb.numDirectoryRecords = static_cast<unsigned>(directories.size());
     fndb.numDirs = static_cast<unsigned>(numDirectories);
     fndb.numFiles = static_cast<unsigned>(numFiles);
     fndb.depth = static_cast<unsigned>(deepestLevel);
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Process handling (Unix-alike)
  *
- * @copyright Copyright © 1996-2023 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -16,10 +16,21 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#if defined(HAVE_POSIX_SPAWN)
+#  include <spawn.h>
+#endif
+
+#if defined(HAVE_EPOLL_CREATE1)
+#  include <sys/epoll.h>
+#else
+#  include <poll.h>
+#endif
+
 #if defined(__APPLE__)
 #  include <libproc.h>
 #  include <sys/proc.h>
@@ -36,6 +47,8 @@
 #   include <fcntl.h>
 #endif
 
+#include <algorithm>
+#include <set>
 #include <thread>
 #include <tuple>
 
@@ -66,12 +79,21 @@ const int filenoStdin = 0;
 const int filenoStdout = 1;
 const int filenoStderr = 2;
 
+MIKTEXSTATICFUNC(void) SetCloseOnExec(int fd)
+{
+    if (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fcntl");
+    }
+}
+
+// the duplicate is not inherited by other child processes
 MIKTEXSTATICFUNC(int) Dup(int fd)
 {
-    int dupfd = dup(fd);
+    int dupfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
     if (dupfd < 0)
     {
-        MIKTEX_FATAL_CRT_ERROR("dup");
+        MIKTEX_FATAL_CRT_ERROR("fcntl");
     }
     return dupfd;
 }
@@ -114,6 +136,10 @@ public:
         {
             MIKTEX_FATAL_CRT_ERROR("pipe");
         }
+        // we might be starting other child processes concurrently: they
+        // must not inherit the pipe (the reader would not see EOF)
+        SetCloseOnExec(twofd[0]);
+        SetCloseOnExec(twofd[1]);
     }
 
     int GetReadEnd() const
@@ -208,8 +234,6 @@ void unxProcess::Create()
 {
     MIKTEX_EXPECT(!startinfo.FileName.empty());
 
-    auto trace_process = TraceStream::Open(MIKTEX_TRACE_PROCESS);
-
     shared_ptr<SessionImpl> session = SESSION_IMPL();
 
     PathName fileName;
@@ -273,6 +297,130 @@ void unxProcess::Create()
 
     session->UnloadFilenameDatabase();
 
+    int fdStdout = pipeStdout.GetWriteEnd();
+    int fdStderr = pipeStderr.GetWriteEnd() >= 0 ? pipeStderr.GetWriteEnd() : fdChildStderr;
+    int fdStdin = pipeStdin.GetReadEnd() >= 0 ? pipeStdin.GetReadEnd() : fdChildStdin;
+
+#if defined(HAVE_POSIX_SPAWN)
+    bool canSpawn = true;
+#if !defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+    canSpawn = canSpawn && startinfo.WorkingDirectory.empty();
+#endif
+#if !defined(HAVE_POSIX_SPAWN_SETSID)
+    canSpawn = canSpawn && !startinfo.Daemonize;
+#endif
+    if (canSpawn)
+    {
+        Spawn(fileName, argv, environmentPointers, fdStdout, fdStderr, fdStdin);
+    }
+    else
+#endif
+    {
+        Fork(fileName, argv, environmentPointers, fdStdout, fdStderr, fdStdin);
+    }
+
+    MIKTEX_ASSERT(pid > 0);
+
+    if (startinfo.RedirectStandardOutput)
+    {
+        fdStandardOutput = pipeStdout.StealReadEnd();
+    }
+
+    if (startinfo.RedirectStandardError)
+    {
+        fdStandardError = pipeStderr.StealReadEnd();
+    }
+
+    if (startinfo.RedirectStandardInput)
+    {
+        fdStandardInput = pipeStdin.StealWriteEnd();
+    }
+
+    if (fdChildStderr >= 0)
+    {
+        ::Close_(fdChildStderr);
+    }
+
+    pipeStdout.Dispose();
+    pipeStderr.Dispose();
+    pipeStdin.Dispose();
+}
+
+#if defined(HAVE_POSIX_SPAWN)
+void unxProcess::Spawn(const PathName& fileName, Argv& argv, char** environmentPointers, int fdStdout, int fdStderr, int fdStdin)
+{
+    // posix_spawn() doesn't copy the page tables of the parent process (it
+    // uses vfork() semantics where available), i.e., it is cheap even if this
+    // is a big process
+    auto trace_process = TraceStream::Open(MIKTEX_TRACE_PROCESS);
+    trace_process->WriteLine("core", TraceLevel::Info, "spawning...");
+    posix_spawn_file_actions_t fileActions;
+    int err = posix_spawn_file_actions_init(&fileActions);
+    if (err != 0)
+    {
+        errno = err;
+        MIKTEX_FATAL_CRT_ERROR("posix_spawn_file_actions_init");
+    }
+    MIKTEX_AUTO(posix_spawn_file_actions_destroy(&fileActions));
+    posix_spawnattr_t attr;
+    err = posix_spawnattr_init(&attr);
+    if (err != 0)
+    {
+        errno = err;
+        MIKTEX_FATAL_CRT_ERROR("posix_spawnattr_init");
+    }
+    MIKTEX_AUTO(posix_spawnattr_destroy(&attr));
+    if (fdStdout >= 0)
+    {
+        err = posix_spawn_file_actions_adddup2(&fileActions, fdStdout, filenoStdout);
+    }
+    if (err == 0 && fdStderr >= 0)
+    {
+        err = posix_spawn_file_actions_adddup2(&fileActions, fdStderr, filenoStderr);
+    }
+    if (err == 0 && fdStdin >= 0)
+    {
+        err = posix_spawn_file_actions_adddup2(&fileActions, fdStdin, filenoStdin);
+    }
+    for (int fd : { fdStdout, fdStderr, fdStdin })
+    {
+        if (err == 0 && fd > filenoStderr)
+        {
+            err = posix_spawn_file_actions_addclose(&fileActions, fd);
+        }
+    }
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+    if (err == 0 && !startinfo.WorkingDirectory.empty())
+    {
+        err = posix_spawn_file_actions_addchdir_np(&fileActions, startinfo.WorkingDirectory.c_str());
+    }
+#endif
+#if defined(HAVE_POSIX_SPAWN_SETSID)
+    if (err == 0 && startinfo.Daemonize)
+    {
+        err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+    }
+#endif
+    if (err != 0)
+    {
+        errno = err;
+        MIKTEX_FATAL_CRT_ERROR("posix_spawn_file_actions");
+    }
+    err = posix_spawn(&pid, fileName.GetData(), &fileActions, &attr, const_cast<char* const*>(argv.GetArgv()), environmentPointers);
+    if (err != 0)
+    {
+        // e.g. the executable does not exist
+        pid = -1;
+        errno = err;
+        MIKTEX_FATAL_CRT_ERROR_2("posix_spawn", "path", fileName.ToString());
+    }
+}
+#endif
+
+void unxProcess::Fork(const PathName& fileName, Argv& argv, char** environmentPointers, int fdStdout, int fdStderr, int fdStdin)
+{
+    auto trace_process = TraceStream::Open(MIKTEX_TRACE_PROCESS);
+
     // fork
     trace_process->WriteLine("core", TraceLevel::Info, "forking...");
     pid = fork();
@@ -286,31 +434,25 @@ void unxProcess::Create()
         try
         {
             // I'm a child
-            if (pipeStdout.GetWriteEnd() >= 0)
-            {
-                Dup2(pipeStdout.GetWriteEnd(), filenoStdout);
-            }
-            if (pipeStderr.GetWriteEnd() >= 0)
+            if (fdStdout >= 0)
             {
-                Dup2(pipeStderr.GetWriteEnd(), filenoStderr);
+                Dup2(fdStdout, filenoStdout);
             }
-            else if (fdChildStderr >= 0)
+            if (fdStderr >= 0)
             {
-                Dup2(fdChildStderr, filenoStderr);
-                ::Close_(fdChildStderr);
+                Dup2(fdStderr, filenoStderr);
             }
-            if (pipeStdin.GetReadEnd() >= 0)
+            if (fdStdin >= 0)
             {
-                Dup2(pipeStdin.GetReadEnd(), filenoStdin);
+                Dup2(fdStdin, filenoStdin);
             }
-            else if (fdChildStdin >= 0)
+            for (int fd : { fdStdout, fdStderr, fdStdin })
             {
-                Dup2(fdChildStdin, filenoStdin);
-                ::Close_(fdChildStdin);
+                if (fd > filenoStderr)
+                {
+                    ::Close_(fd);
+                }
             }
-            pipeStdout.Dispose();
-            pipeStderr.Dispose();
-            pipeStdin.Dispose();
             if (startinfo.Daemonize)
             {
                 if (setsid() == -1)
@@ -330,32 +472,6 @@ void unxProcess::Create()
         }
         _exit(127);
     }
-
-    MIKTEX_ASSERT(pid > 0);
-
-    if (startinfo.RedirectStandardOutput)
-    {
-        fdStandardOutput = pipeStdout.StealReadEnd();
-    }
-
-    if (startinfo.RedirectStandardError)
-    {
-        fdStandardError = pipeStderr.StealReadEnd();
-    }
-
-    if (startinfo.RedirectStandardInput)
-    {
-        fdStandardInput = pipeStdin.StealWriteEnd();
-    }
-
-    if (fdChildStderr >= 0)
-    {
-        ::Close_(fdChildStderr);
-    }
-
-    pipeStdout.Dispose();
-    pipeStderr.Dispose();
-    pipeStdin.Dispose();
 }
 
 unxProcess::unxProcess(const ProcessStartInfo& startinfo):
@@ -527,6 +643,259 @@ bool unxProcess::get_Exception(MiKTeXException& ex) const
     return MiKTeXException::Load(tmpFile->GetPathName().ToString(), ex);
 }
 
+/// Waits for output of many child processes.
+class OutputMultiplexer
+{
+
+public:
+
+#if defined(HAVE_EPOLL_CREATE1)
+    OutputMultiplexer()
+    {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("epoll_create1");
+        }
+    }
+
+    ~OutputMultiplexer()
+    {
+        close(epollFd);
+    }
+
+    void Add(int fd)
+    {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("epoll_ctl");
+        }
+    }
+
+    void Remove(int fd)
+    {
+        if (epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr) < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("epoll_ctl");
+        }
+    }
+
+    vector<int> Wait()
+    {
+        struct epoll_event events[64];
+        int n;
+        while ((n = epoll_wait(epollFd, events, sizeof(events) / sizeof(events[0]), -1)) < 0)
+        {
+            if (errno != EINTR)
+            {
+                MIKTEX_FATAL_CRT_ERROR("epoll_wait");
+            }
+        }
+        vector<int> result;
+        for (int idx = 0; idx < n; ++idx)
+        {
+            // EPOLLHUP and EPOLLERR: read() tells
+            result.push_back(events[idx].data.fd);
+        }
+        return result;
+    }
+
+private:
+
+    int epollFd;
+#else
+    void Add(int fd)
+    {
+        fds.insert(fd);
+    }
+
+    void Remove(int fd)
+    {
+        fds.erase(fd);
+    }
+
+    vector<int> Wait()
+    {
+        vector<struct pollfd> pollFds;
+        for (int fd : fds)
+        {
+            struct pollfd pfd = {};
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pollFds.push_back(pfd);
+        }
+        while (poll(pollFds.data(), pollFds.size(), -1) < 0)
+        {
+            if (errno != EINTR)
+            {
+                MIKTEX_FATAL_CRT_ERROR("poll");
+            }
+        }
+        vector<int> result;
+        for (const auto& pfd : pollFds)
+        {
+            if (pfd.revents != 0)
+            {
+                result.push_back(pfd.fd);
+            }
+        }
+        return result;
+    }
+
+private:
+
+    set<int> fds;
+#endif
+};
+
+void Process::RunAll(vector<ProcessJob>& jobs, unsigned maxJobs)
+{
+    auto trace_process = TraceStream::Open(MIKTEX_TRACE_PROCESS);
+    maxJobs = std::max(maxJobs, 1u);
+    struct RunningJob
+    {
+        unique_ptr<unxProcess> process;
+        // standard output, and standard error unless it is merged
+        int openPipes = 0;
+        bool discardOutput = false;
+        bool discardError = false;
+    };
+    struct OutputPipe
+    {
+        size_t idx;
+        bool isStandardError;
+    };
+    unordered_map<size_t, RunningJob> running;
+    // indexed by the read end of the pipe
+    unordered_map<int, OutputPipe> pipes;
+    OutputMultiplexer multiplexer;
+    vector<char> buffer(64 * 1024);
+    size_t nextJob = 0;
+    auto finish = [&running, &jobs](size_t idx)
+    {
+        RunningJob& runningJob = running[idx];
+        ProcessJob& job = jobs[idx];
+        runningJob.process->WaitForExit();
+        job.ExitStatus = runningJob.process->get_ExitStatus();
+        job.ExitCode = job.ExitStatus == ProcessExitStatus::Exited ? runningJob.process->get_ExitCode() : -1;
+        if (job.ExitCode != 0 && !runningJob.process->get_Exception(job.Exception))
+        {
+            job.Exception = MiKTeXException(
+                job.FileName.GetFileName().ToDisplayString(),
+                T_("The executed process did not succeed."),
+                MiKTeXException::KVMAP(
+                    "fileName", job.FileName.ToDisplayString(),
+                    "exitCode", std::to_string(job.ExitCode)),
+                SourceLocation());
+        }
+        runningJob.process->Close();
+        running.erase(idx);
+    };
+    auto closePipe = [&running, &pipes, &multiplexer, &finish](int fd)
+    {
+        size_t idx = pipes[fd].idx;
+        pipes.erase(fd);
+        multiplexer.Remove(fd);
+        close(fd);
+        if (--running[idx].openPipes == 0)
+        {
+            finish(idx);
+        }
+    };
+    auto addPipe = [&pipes, &multiplexer](int fd, size_t idx, bool isStandardError)
+    {
+        if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+        {
+            close(fd);
+            MIKTEX_FATAL_CRT_ERROR("fcntl");
+        }
+        pipes[fd] = { idx, isStandardError };
+        multiplexer.Add(fd);
+    };
+    try
+    {
+        while (nextJob < jobs.size() || !running.empty())
+        {
+            while (nextJob < jobs.size() && running.size() < maxJobs)
+            {
+                ProcessJob& job = jobs[nextJob];
+                ProcessStartInfo startinfo;
+                startinfo.FileName = job.FileName.ToString();
+                startinfo.Arguments = job.Arguments;
+                startinfo.RedirectStandardOutput = true;
+                startinfo.RedirectStandardError = job.OnError ? true : false;
+                startinfo.WorkingDirectory = job.WorkingDirectory;
+                auto process = make_unique<unxProcess>(startinfo);
+                int fdOutput = process->fdStandardOutput;
+                process->fdStandardOutput = -1;
+                int fdError = process->fdStandardError;
+                process->fdStandardError = -1;
+                trace_process->WriteLine("core", fmt::format("started job #{0} (process {1})", nextJob, process->GetSystemId()));
+                RunningJob& runningJob = running[nextJob];
+                runningJob.process = std::move(process);
+                runningJob.discardOutput = !job.OnOutput;
+                runningJob.openPipes = fdError >= 0 ? 2 : 1;
+                addPipe(fdOutput, nextJob, false);
+                if (fdError >= 0)
+                {
+                    addPipe(fdError, nextJob, true);
+                }
+                ++nextJob;
+            }
+            for (int fd : multiplexer.Wait())
+            {
+                OutputPipe pipe = pipes[fd];
+                RunningJob& runningJob = running[pipe.idx];
+                ProcessJob& job = jobs[pipe.idx];
+                bool& discard = pipe.isStandardError ? runningJob.discardError : runningJob.discardOutput;
+                ssize_t n;
+                while ((n = read(fd, buffer.data(), buffer.size())) > 0)
+                {
+                    if (!discard)
+                    {
+                        discard = !(pipe.isStandardError ? job.OnError : job.OnOutput)(buffer.data(), n);
+                    }
+                }
+                if (n == 0)
+                {
+                    closePipe(fd);
+                }
+                else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    MIKTEX_FATAL_CRT_ERROR("read");
+                }
+            }
+        }
+    }
+    catch (const exception&)
+    {
+        // don't leave zombies behind
+        while (!pipes.empty())
+        {
+            int fd = pipes.begin()->first;
+            multiplexer.Remove(fd);
+            close(fd);
+            pipes.erase(fd);
+        }
+        while (!running.empty())
+        {
+            size_t idx = running.begin()->first;
+            try
+            {
+                finish(idx);
+            }
+            catch (const exception&)
+            {
+                running.erase(idx);
+            }
+        }
+        throw;
+    }
+}
+
 string ConfStr(int name)
 {
     size_t n = confstr(name, nullptr, 0);
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Process handling (Unix-alike)
  *
- * @copyright Copyright © 1996-2023 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Core Library.
  *
@@ -18,6 +18,7 @@
 
 #include <memory>
 
+#include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Process>
 #include <miktex/Core/TemporaryFile>
 
@@ -67,6 +68,12 @@ private:
 
     void Create();
 
+    void Fork(const MiKTeX::Util::PathName& fileName, MiKTeX::Core::Argv& argv, char** environmentPointers, int fdStdout, int fdStderr, int fdStdin);
+
+#if defined(HAVE_POSIX_SPAWN)
+    void Spawn(const MiKTeX::Util::PathName& fileName, MiKTeX::Core::Argv& argv, char** environmentPointers, int fdStdout, int fdStderr, int fdStdin);
+#endif
+
     int fdStandardError = -1;
     int fdStandardInput = -1;
     int fdStandardOutput = -1;
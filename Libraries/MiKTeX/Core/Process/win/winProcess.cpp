@@ -24,6 +24,12 @@
 #include <Windows.h>
 #include <Tlhelp32.h>
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 #include <fmt/xchar.h>
@@ -579,6 +585,174 @@ bool Process::ExecuteSystemCommand(const string& commandLine, int* exitCode, IRu
   return Process::Run(PathName(arguments[0]), arguments, callback, exitCode, workingDirectory);
 }
 
+void Process::RunAll(vector<ProcessJob>& jobs, unsigned maxJobs)
+{
+  auto trace_process = TraceStream::Open(MIKTEX_TRACE_PROCESS);
+  maxJobs = std::max(maxJobs, 1u);
+  // anonymous pipes do not support overlapped I/O: each running process
+  // gets a thread which reads its output and queues it for the calling
+  // thread
+  struct Chunk
+  {
+    size_t idx;
+    bool isStandardError;
+    // empty at the end of the output
+    vector<char> data;
+  };
+  struct RunningJob
+  {
+    unique_ptr<winProcess> process;
+    thread outputReader;
+    thread errorReader;
+    // standard output, and standard error unless it is merged
+    int openPipes = 0;
+    bool discardOutput = false;
+    bool discardError = false;
+    void JoinReaders()
+    {
+      if (outputReader.joinable())
+      {
+        outputReader.join();
+      }
+      if (errorReader.joinable())
+      {
+        errorReader.join();
+      }
+    }
+  };
+  map<size_t, RunningJob> running;
+  mutex chunksMutex;
+  condition_variable chunksCondition;
+  deque<Chunk> chunks;
+  size_t nextJob = 0;
+  auto startReader = [&chunksMutex, &chunksCondition, &chunks](size_t idx, bool isStandardError, HANDLE pipe)
+  {
+    return thread([idx, isStandardError, pipe, &chunksMutex, &chunksCondition, &chunks]()
+    {
+      const DWORD CHUNK_SIZE = 64 * 1024;
+      bool endOfOutput = false;
+      while (!endOfOutput)
+      {
+        Chunk chunk;
+        chunk.idx = idx;
+        chunk.isStandardError = isStandardError;
+        chunk.data.resize(CHUNK_SIZE);
+        DWORD n;
+        if (!ReadFile(pipe, chunk.data.data(), CHUNK_SIZE, &n, nullptr))
+        {
+          // ERROR_BROKEN_PIPE: the process has closed its end of the pipe
+          n = 0;
+          endOfOutput = true;
+        }
+        else if (n == 0)
+        {
+          continue;
+        }
+        chunk.data.resize(n);
+        {
+          lock_guard<mutex> l(chunksMutex);
+          chunks.push_back(std::move(chunk));
+        }
+        chunksCondition.notify_one();
+      }
+    });
+  };
+  auto finish = [&running, &jobs](size_t idx)
+  {
+    RunningJob& runningJob = running[idx];
+    ProcessJob& job = jobs[idx];
+    runningJob.JoinReaders();
+    runningJob.process->WaitForExit();
+    job.ExitStatus = runningJob.process->get_ExitStatus();
+    job.ExitCode = job.ExitStatus == ProcessExitStatus::Exited ? runningJob.process->get_ExitCode() : -1;
+    if (job.ExitCode != 0 && !runningJob.process->get_Exception(job.Exception))
+    {
+      job.Exception = MiKTeXException(
+        job.FileName.GetFileName().ToDisplayString(),
+        T_("The executed process did not succeed."),
+        MiKTeXException::KVMAP(
+          "fileName", job.FileName.ToDisplayString(),
+          "exitCode", std::to_string(job.ExitCode)),
+        SourceLocation());
+    }
+    runningJob.process->Close();
+    running.erase(idx);
+  };
+  try
+  {
+    while (nextJob < jobs.size() || !running.empty())
+    {
+      while (nextJob < jobs.size() && running.size() < maxJobs)
+      {
+        ProcessJob& job = jobs[nextJob];
+        ProcessStartInfo startinfo;
+        startinfo.FileName = job.FileName.ToString();
+        startinfo.Arguments = job.Arguments;
+        startinfo.RedirectStandardOutput = true;
+        startinfo.RedirectStandardError = job.OnError ? true : false;
+        startinfo.WorkingDirectory = job.WorkingDirectory;
+        auto process = make_unique<winProcess>(startinfo);
+        HANDLE standardOutput = process->standardOutput;
+        HANDLE standardError = process->standardError;
+        trace_process->WriteLine("core", fmt::format("started job #{0} (process {1})", nextJob, process->GetSystemId()));
+        RunningJob& runningJob = running[nextJob];
+        runningJob.process = std::move(process);
+        runningJob.discardOutput = !job.OnOutput;
+        runningJob.openPipes = 1;
+        runningJob.outputReader = startReader(nextJob, false, standardOutput);
+        if (standardError != INVALID_HANDLE_VALUE)
+        {
+          runningJob.openPipes = 2;
+          runningJob.errorReader = startReader(nextJob, true, standardError);
+        }
+        ++nextJob;
+      }
+      deque<Chunk> ready;
+      {
+        unique_lock<mutex> l(chunksMutex);
+        chunksCondition.wait(l, [&chunks]() { return !chunks.empty(); });
+        swap(ready, chunks);
+      }
+      for (const Chunk& chunk : ready)
+      {
+        RunningJob& runningJob = running[chunk.idx];
+        if (chunk.data.empty())
+        {
+          if (--runningJob.openPipes == 0)
+          {
+            finish(chunk.idx);
+          }
+          continue;
+        }
+        ProcessJob& job = jobs[chunk.idx];
+        bool& discard = chunk.isStandardError ? runningJob.discardError : runningJob.discardOutput;
+        if (!discard)
+        {
+          discard = !(chunk.isStandardError ? job.OnError : job.OnOutput)(chunk.data.data(), chunk.data.size());
+        }
+      }
+    }
+  }
+  catch (const exception&)
+  {
+    // the reader threads end as soon as the processes have exited
+    while (!running.empty())
+    {
+      size_t idx = running.begin()->first;
+      try
+      {
+        finish(idx);
+      }
+      catch (const exception&)
+      {
+        running.begin()->second.JoinReaders();
+        running.erase(idx);
+      }
+    }
+    throw;
+  }
+}
+
 unique_ptr<Process> Process::StartSystemCommand(const string& commandLine, FILE** ppFileStandardInput, FILE** ppFileStandardOutput)
 {
   const char* workingDirectory = nullptr;
@@ -0,0 +1,369 @@
+/**
+ * @file Session/ConfigSnapshot.cpp
+ * @author Christian Schenk
+ * @brief Compiled configuration settings
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include <miktex/Core/CacheFile>
+#include <miktex/Core/File>
+#include <miktex/Core/Utils>
+
+#include "internal.h"
+
+#include "ConfigSnapshot.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+constexpr char SIGNATURE[8] = { 'M', 'i', 'K', 'T', 'e', 'X', 'C', 'S' };
+
+// increment whenever the layout or the hash function changes
+constexpr uint32_t VERSION = 1;
+
+constexpr uint32_t NO_ENTRY = static_cast<uint32_t>(-1);
+
+struct ConfigSnapshot::Header
+{
+    char signature[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint32_t numSources;
+    uint32_t sourcesOffset;
+    uint32_t numEntries;
+    uint32_t entriesOffset;
+    uint32_t numBuckets;
+    uint32_t bucketsOffset;
+    uint32_t numSlots;
+    uint32_t slotsOffset;
+    uint32_t stringsSize;
+    uint32_t stringsOffset;
+};
+
+struct ConfigSnapshot::SourceRecord
+{
+    uint32_t path;
+    uint32_t exists;
+    uint64_t size;
+    int64_t lastWriteTime;
+};
+
+struct ConfigSnapshot::Entry
+{
+    // string pool offsets; section and value names are lower case
+    uint32_t sectionName;
+    uint32_t valueName;
+    uint32_t value;
+};
+
+namespace {
+
+    // FNV-1a over "section\0value"
+    uint64_t Hash(const string& sectionName, const string& valueName)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        auto update = [&h](const string& s)
+        {
+            for (unsigned char ch : s)
+            {
+                h ^= ch;
+                h *= 0x100000001b3ULL;
+            }
+        };
+        update(sectionName);
+        // the separator: h ^= 0
+        h *= 0x100000001b3ULL;
+        update(valueName);
+        return h;
+    }
+
+    // second level of the hash-and-displace scheme: each bucket has a
+    // displacement which has been chosen so that all keys of the bucket
+    // land in free slots
+    uint32_t Slot(uint64_t h, uint32_t displacement, uint32_t numSlots)
+    {
+        uint64_t x = h + (static_cast<uint64_t>(displacement) + 1) * 0x9e3779b97f4a7c15ULL;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return static_cast<uint32_t>(x % numSlots);
+    }
+
+    uint32_t Bucket(uint64_t h, uint32_t numBuckets)
+    {
+        return static_cast<uint32_t>((h >> 32) % numBuckets);
+    }
+
+    class Builder
+    {
+    public:
+
+        uint32_t AddString(const string& s)
+        {
+            if (s.empty())
+            {
+                return 0;
+            }
+            auto it = stringIndex.find(s);
+            if (it != stringIndex.end())
+            {
+                return it->second;
+            }
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            strings.insert(strings.end(), s.begin(), s.end());
+            strings.push_back(0);
+            stringIndex.emplace(s, offset);
+            return offset;
+        }
+
+        // offset 0 is the empty string
+        vector<char> strings = { 0 };
+        unordered_map<string, uint32_t> stringIndex;
+    };
+
+    template<typename T> uint32_t Append(vector<unsigned char>& buf, const T* data, size_t count)
+    {
+        // keep all sections 8-byte aligned
+        buf.resize((buf.size() + 7) & ~static_cast<size_t>(7));
+        uint32_t offset = static_cast<uint32_t>(buf.size());
+        if (count > 0)
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+            buf.insert(buf.end(), bytes, bytes + count * sizeof(T));
+        }
+        return offset;
+    }
+
+}
+
+ConfigSnapshot::ConfigSnapshot()
+{
+}
+
+ConfigSnapshot::~ConfigSnapshot()
+{
+    try
+    {
+        Close();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+bool ConfigSnapshot::Create(const PathName& path, const vector<PathName>& sources, Cfg& cfg)
+{
+    Builder builder;
+
+    vector<SourceRecord> sourceRecords;
+    for (const PathName& source : sources)
+    {
+        SourceRecord rec{};
+        rec.path = builder.AddString(source.ToString());
+        if (File::Exists(source))
+        {
+            rec.exists = 1;
+            rec.size = File::GetSize(source);
+            rec.lastWriteTime = File::GetLastWriteTime(source);
+            if (!CacheFile::IsSettled(rec.lastWriteTime))
+            {
+                return false;
+            }
+        }
+        sourceRecords.push_back(rec);
+    }
+
+    vector<Entry> entries;
+    vector<uint64_t> hashes;
+    for (const auto& key : cfg)
+    {
+        string sectionName = Utils::MakeLower(key->GetName());
+        for (const auto& value : *key)
+        {
+            if (value->IsCommentedOut())
+            {
+                continue;
+            }
+            string valueName = Utils::MakeLower(value->GetName());
+            Entry entry;
+            entry.sectionName = builder.AddString(sectionName);
+            entry.valueName = builder.AddString(valueName);
+            entry.value = builder.AddString(value->AsString());
+            entries.push_back(entry);
+            hashes.push_back(Hash(sectionName, valueName));
+        }
+    }
+
+    // hash and displace: distribute the keys over buckets (~4 keys per
+    // bucket); then, starting with the largest bucket, search a displacement
+    // which maps all keys of the bucket to free slots
+    uint32_t numEntries = static_cast<uint32_t>(entries.size());
+    uint32_t numBuckets = max<uint32_t>(1, (numEntries + 3) / 4);
+    uint32_t numSlots = max<uint32_t>(1, numEntries + numEntries / 4);
+    vector<vector<uint32_t>> buckets(numBuckets);
+    for (uint32_t idx = 0; idx < numEntries; ++idx)
+    {
+        buckets[Bucket(hashes[idx], numBuckets)].push_back(idx);
+    }
+    vector<uint32_t> order(numBuckets);
+    for (uint32_t b = 0; b < numBuckets; ++b)
+    {
+        order[b] = b;
+    }
+    stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+    vector<uint32_t> displacements(numBuckets, 0);
+    vector<uint32_t> slots(numSlots, NO_ENTRY);
+    vector<uint32_t> candidateSlots;
+    for (uint32_t b : order)
+    {
+        if (buckets[b].empty())
+        {
+            break;
+        }
+        for (uint32_t displacement = 0; ; ++displacement)
+        {
+            if (displacement == 0x100000)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            candidateSlots.clear();
+            bool ok = true;
+            for (uint32_t idx : buckets[b])
+            {
+                uint32_t slot = Slot(hashes[idx], displacement, numSlots);
+                if (slots[slot] != NO_ENTRY || find(candidateSlots.begin(), candidateSlots.end(), slot) != candidateSlots.end())
+                {
+                    ok = false;
+                    break;
+                }
+                candidateSlots.push_back(slot);
+            }
+            if (ok)
+            {
+                for (size_t k = 0; k < candidateSlots.size(); ++k)
+                {
+                    slots[candidateSlots[k]] = buckets[b][k];
+                }
+                displacements[b] = displacement;
+                break;
+            }
+        }
+    }
+
+    Header header{};
+    memcpy(header.signature, SIGNATURE, sizeof(header.signature));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    vector<unsigned char> buf;
+    Append(buf, &header, 1);
+    header.numSources = static_cast<uint32_t>(sourceRecords.size());
+    header.sourcesOffset = Append(buf, sourceRecords.data(), sourceRecords.size());
+    header.numEntries = numEntries;
+    header.entriesOffset = Append(buf, entries.data(), entries.size());
+    header.numBuckets = numBuckets;
+    header.bucketsOffset = Append(buf, displacements.data(), displacements.size());
+    header.numSlots = numSlots;
+    header.slotsOffset = Append(buf, slots.data(), slots.size());
+    header.stringsSize = static_cast<uint32_t>(builder.strings.size());
+    header.stringsOffset = Append(buf, builder.strings.data(), builder.strings.size());
+    header.fileSize = buf.size();
+    memcpy(buf.data(), &header, sizeof(header));
+
+    CacheFile::Write(path, buf);
+    return true;
+}
+
+bool ConfigSnapshot::TryOpen(const PathName& path, const vector<PathName>& sources)
+{
+    Close();
+    if (!File::Exists(path) || File::GetSize(path) < sizeof(Header))
+    {
+        return false;
+    }
+    mmap.reset(MemoryMappedFile::Create());
+    const Header* hdr = reinterpret_cast<const Header*>(mmap->Open(path, false));
+    if (memcmp(hdr->signature, SIGNATURE, sizeof(hdr->signature)) != 0
+        || hdr->version != VERSION
+        || hdr->headerSize != sizeof(Header)
+        || hdr->fileSize != mmap->GetSize()
+        || hdr->numSources != sources.size()
+        || hdr->numBuckets == 0
+        || hdr->numSlots == 0)
+    {
+        mmap->Close();
+        mmap = nullptr;
+        return false;
+    }
+    header = hdr;
+    const SourceRecord* sourceRecords = reinterpret_cast<const SourceRecord*>(reinterpret_cast<const char*>(header) + header->sourcesOffset);
+    for (size_t idx = 0; idx < sources.size(); ++idx)
+    {
+        const SourceRecord& rec = sourceRecords[idx];
+        bool exists = File::Exists(sources[idx]);
+        if (!PathName::Equals(PathName(GetString(rec.path)), sources[idx])
+            || (rec.exists != 0) != exists
+            || exists && !CacheFile::IsUnchanged(sources[idx], rec.size, rec.lastWriteTime))
+        {
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ConfigSnapshot::Close()
+{
+    header = nullptr;
+    if (mmap != nullptr)
+    {
+        mmap->Close();
+        mmap = nullptr;
+    }
+}
+
+bool ConfigSnapshot::TryGetValue(const string& sectionName, const string& valueName, string& value) const
+{
+    MIKTEX_EXPECT(header != nullptr);
+    if (header->numEntries == 0)
+    {
+        return false;
+    }
+    string lookupSectionName = Utils::MakeLower(sectionName);
+    string lookupValueName = Utils::MakeLower(valueName);
+    uint64_t h = Hash(lookupSectionName, lookupValueName);
+    const char* base = reinterpret_cast<const char*>(header);
+    const uint32_t* displacements = reinterpret_cast<const uint32_t*>(base + header->bucketsOffset);
+    const uint32_t* slots = reinterpret_cast<const uint32_t*>(base + header->slotsOffset);
+    const Entry* entries = reinterpret_cast<const Entry*>(base + header->entriesOffset);
+    uint32_t idx = slots[Slot(h, displacements[Bucket(h, header->numBuckets)], header->numSlots)];
+    // the key may not be in the table: compare
+    if (idx == NO_ENTRY
+        || lookupSectionName != GetString(entries[idx].sectionName)
+        || lookupValueName != GetString(entries[idx].valueName))
+    {
+        return false;
+    }
+    value = GetString(entries[idx].value);
+    return true;
+}
+
+const char* ConfigSnapshot::GetString(uint32_t offset) const
+{
+    MIKTEX_ASSERT(offset < header->stringsSize);
+    return reinterpret_cast<const char*>(header) + header->stringsOffset + offset;
+}
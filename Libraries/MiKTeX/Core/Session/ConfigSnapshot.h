@@ -0,0 +1,103 @@
+/**
+ * @file Session/ConfigSnapshot.h
+ * @author Christian Schenk
+ * @brief Compiled configuration settings
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Cfg>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief A compiled, memory-mapped form of the configuration files of one
+ * application (e.g. all `miktex/config/pdftex.ini` files).
+ *
+ * The snapshot file contains:
+ * - a perfect hash table: (section, value name) -> value
+ * - the candidate configuration files together with their size and
+ *   modification time (or the fact that they do not exist)
+ *
+ * The snapshot is stale as soon as one of the candidate files is created,
+ * changed or removed. It is a local cache: it uses the native byte order and
+ * is recreated whenever it does not match the running program.
+ */
+class ConfigSnapshot
+{
+public:
+
+    ConfigSnapshot();
+
+    ConfigSnapshot(const ConfigSnapshot& other) = delete;
+
+    ConfigSnapshot& operator=(const ConfigSnapshot& other) = delete;
+
+    ~ConfigSnapshot();
+
+    /**
+     * @brief Compiles configuration settings into a snapshot file.
+     * @param path Path to the snapshot file.
+     * @param sources The candidate files `cfg` was read from.
+     * @param cfg The configuration settings.
+     * @return Returns `false`, if the snapshot was not written, because one of
+     * the sources was modified too recently.
+     */
+    static bool Create(const MiKTeX::Util::PathName& path, const std::vector<MiKTeX::Util::PathName>& sources, MiKTeX::Core::Cfg& cfg);
+
+    /**
+     * @brief Maps a snapshot file into memory.
+     * @param path Path to the snapshot file.
+     * @param sources The candidate files the snapshot must have been compiled
+     * from.
+     * @return Returns `false`, if the snapshot does not exist, is not
+     * compatible or is stale.
+     */
+    bool TryOpen(const MiKTeX::Util::PathName& path, const std::vector<MiKTeX::Util::PathName>& sources);
+
+    void Close();
+
+    bool IsOpen() const
+    {
+        return header != nullptr;
+    }
+
+    /**
+     * @brief Looks up a configuration value.
+     * @param sectionName The section name (case-insensitive).
+     * @param valueName The value name (case-insensitive).
+     * @param[out] value The (unexpanded) value.
+     * @return Returns `true`, if the value was found.
+     */
+    bool TryGetValue(const std::string& sectionName, const std::string& valueName, std::string& value) const;
+
+public:
+
+    struct Entry;
+    struct Header;
+    struct SourceRecord;
+
+private:
+
+    const char* GetString(std::uint32_t offset) const;
+
+    const Header* header = nullptr;
+    std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mmap;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
@@ -52,6 +52,7 @@
 #include <miktex/Core/win/COMInitializer>
 #endif
 
+#include "ConfigSnapshot.h"
 #include "Fndb/FileNameDatabase.h"
 #include "RootDirectoryInternals.h"
 
@@ -813,6 +814,12 @@ private:
 private:
   void ReadAllConfigFiles(const std::string& baseName, MiKTeX::Core::Cfg& cfg);
 
+private:
+  std::vector<MiKTeX::Util::PathName> GetConfigFileCandidates(const std::string& baseName);
+
+private:
+  ConfigSnapshot* GetConfigSnapshot(const std::string& baseName);
+
 private:
   std::deque<MiKTeX::Util::PathName> inputDirectories;
 
@@ -983,7 +990,16 @@ private:
   std::string ExpandValues(const std::string& toBeExpanded, MiKTeX::Configuration::HasNamedValues* callback);
 
 private:
-  void DirectoryWalk(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths);
+  struct DirectoryWalkResult
+  {
+    std::vector<MiKTeX::Util::PathName> paths;
+    // the directories which have been listed, together with their
+    // modification times
+    std::vector<std::pair<MiKTeX::Util::PathName, time_t>> listedDirectories;
+  };
+
+private:
+  void DirectoryWalk(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, DirectoryWalkResult& result, bool parallel);
 
 private:
   void ExpandBraces(const std::string& toBeExpanded, std::vector<MiKTeX::Util::PathName>& paths);
@@ -998,7 +1014,22 @@ private:
   std::vector<MiKTeX::Util::PathName> ExpandRootDirectories(const std::string& toBeExpanded);
 
 private:
-  void ExpandPathPattern(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths);
+  void ExpandPathPattern(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, DirectoryWalkResult& result, bool parallel);
+
+private:
+  std::vector<MiKTeX::Util::PathName> GetExpandedPathPattern(const MiKTeX::Util::PathName& pathPattern);
+
+private:
+  bool TryExpandPathPatternFromFndb(const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths);
+
+private:
+  MiKTeX::Util::PathName GetPathPatternCacheFile(const MiKTeX::Util::PathName& pathPattern);
+
+private:
+  bool TryLoadExpandedPathPattern(const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths);
+
+private:
+  void SaveExpandedPathPattern(const MiKTeX::Util::PathName& pathPattern, const DirectoryWalkResult& result);
 
 private:
   std::vector<MiKTeX::Util::PathName> ExpandPathPatterns(const std::string& toBeExpanded);
@@ -1076,6 +1107,14 @@ private:
 private:
   ConfigurationSettings configurationSettings;
 
+private:
+  typedef std::unordered_map<std::string, std::unique_ptr<ConfigSnapshot>> ConfigSnapshots;
+
+private:
+  // compiled configuration settings by application name; nullptr, if there
+  // is no usable snapshot (the settings are in configurationSettings then)
+  ConfigSnapshots configSnapshots;
+
 private:
   std::vector<FormatInfo_> formats;
 
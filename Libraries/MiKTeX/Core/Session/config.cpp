@@ -30,6 +30,7 @@
 #include <miktex/Core/Directory>
 #include <miktex/Core/Environment>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
 #include <miktex/Util/PathName>
 #include <miktex/Core/Paths>
 #include <miktex/Util/Tokenizer>
@@ -158,24 +159,83 @@ PathName SessionImpl::GetBinDirectory(bool canonicalized)
   return p.second;
 }
 
-void SessionImpl::ReadAllConfigFiles(const string& baseName, Cfg& cfg)
+vector<PathName> SessionImpl::GetConfigFileCandidates(const string& baseName)
 {
   PathName fileName = PathName(MIKTEX_PATH_MIKTEX_CONFIG_DIR) / baseName;
   fileName.AppendExtension(".ini");
-  vector<PathName> configFiles;
-  if (!FindFile(fileName.ToString(), MIKTEX_PATH_TEXMF_PLACEHOLDER, { FindFileOption::All }, configFiles))
+  vector<PathName> candidates;
+  for (unsigned r = 0; r < rootDirectories.size(); ++r)
   {
-    return;
+    if (IsManagedRoot(r))
+    {
+      candidates.push_back(rootDirectories[r].get_Path() / fileName);
+    }
   }
+  return candidates;
+}
+
+void SessionImpl::ReadAllConfigFiles(const string& baseName, Cfg& cfg)
+{
+  vector<PathName> configFiles = GetConfigFileCandidates(baseName);
+  // read in reverse order: settings in the first root directory win
   for (vector<PathName>::const_reverse_iterator it = configFiles.rbegin(); it != configFiles.rend(); ++it)
   {
-    unsigned r = TryDeriveTEXMFRoot(*it);
-    if (r != INVALID_ROOT_INDEX && !IsManagedRoot(r))
+    if (File::Exists(*it))
+    {
+      cfg.Read(*it);
+    }
+  }
+}
+
+ConfigSnapshot* SessionImpl::GetConfigSnapshot(const string& baseName)
+{
+  ConfigSnapshots::iterator it = configSnapshots.find(baseName);
+  if (it != configSnapshots.end())
+  {
+    return it->second.get();
+  }
+  vector<PathName> configFiles = GetConfigFileCandidates(baseName);
+  if (configFiles.empty())
+  {
+    // root directories not yet initialized
+    return nullptr;
+  }
+  // a recursive lookup (while the snapshot is being compiled) falls back to
+  // the configuration files
+  configSnapshots[baseName] = nullptr;
+  // one snapshot per (root directories, application name)
+  MD5Builder md5Builder;
+  for (const PathName& path : configFiles)
+  {
+    md5Builder.Update(path.GetData(), path.GetLength());
+    md5Builder.Update("\n", 1);
+  }
+  string snapshotName = fmt::format("{0}-{1}.snapshot", baseName, md5Builder.Final().ToString().substr(0, 16));
+  PathName snapshotPath;
+  unique_ptr<ConfigSnapshot> snapshot = make_unique<ConfigSnapshot>();
+  try
+  {
+    snapshotPath = GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_CONFIG_SNAPSHOT_DIR) / snapshotName;
+    if (!snapshot->TryOpen(snapshotPath, configFiles))
     {
-      continue;
+      trace_config->WriteLine("core", TraceLevel::Info, fmt::format(T_("compiling configuration settings: {0}"), Q_(snapshotPath)));
+      unique_ptr<Cfg> cfg = Cfg::Create();
+      ReadAllConfigFiles(baseName, *cfg);
+      if (!ConfigSnapshot::Create(snapshotPath, configFiles, *cfg) || !snapshot->TryOpen(snapshotPath, configFiles))
+      {
+        return nullptr;
+      }
     }
-    cfg.Read(*it);
   }
+  catch (const MiKTeXException& e)
+  {
+    // for example: the data root directory is read-only
+    trace_config->WriteLine("core", TraceLevel::Warning, fmt::format(T_("configuration snapshot {0} cannot be used: {1}"), Q_(snapshotPath), e.GetErrorMessage()));
+    return nullptr;
+  }
+  ConfigSnapshot* result = snapshot.get();
+  configSnapshots[baseName] = std::move(snapshot);
+  return result;
 }
 
 MIKTEXSTATICFUNC(void) AppendToEnvVarName(string& name, const string& part)
@@ -211,19 +271,24 @@ bool SessionImpl::GetSessionValue(const string& sectionName, const string& value
 
     string lookupKeyName = Utils::MakeLower(*app);
 
+    ConfigSnapshot* snapshot = GetConfigSnapshot(lookupKeyName);
+
     Cfg* cfg = nullptr;
 
-    // read configuration files
-    ConfigurationSettings::iterator it = configurationSettings.find(lookupKeyName);
-    if (it != configurationSettings.end())
+    // read configuration files, unless they have been compiled
+    if (snapshot == nullptr)
     {
-      cfg = it->second.get();
-    }
-    else
-    {
-      pair<ConfigurationSettings::iterator, bool> p = configurationSettings.insert(ConfigurationSettings::value_type(lookupKeyName, Cfg::Create()));
-      cfg = p.first->second.get();
-      ReadAllConfigFiles(lookupKeyName, *cfg);
+      ConfigurationSettings::iterator it = configurationSettings.find(lookupKeyName);
+      if (it != configurationSettings.end())
+      {
+        cfg = it->second.get();
+      }
+      else
+      {
+        pair<ConfigurationSettings::iterator, bool> p = configurationSettings.insert(ConfigurationSettings::value_type(lookupKeyName, Cfg::Create()));
+        cfg = p.first->second.get();
+        ReadAllConfigFiles(lookupKeyName, *cfg);
+      }
     }
 
     // section name defaults to application name
@@ -258,7 +323,8 @@ bool SessionImpl::GetSessionValue(const string& sectionName, const string& value
 #endif
 
     // try configuration file
-    if (cfg != nullptr && cfg->TryGetValueAsString(defaultSectionName, valueName, value))
+    if (snapshot != nullptr && snapshot->TryGetValue(defaultSectionName, valueName, value)
+      || cfg != nullptr && cfg->TryGetValueAsString(defaultSectionName, valueName, value))
     {
       haveValue = true;
       break;
@@ -493,6 +559,7 @@ void SessionImpl::SetConfigValue(const std::string& sectionName, const string& v
   {
     Fndb::Add({ { pathConfigFile } });
   }
+  configSnapshots.clear();
   configurationSettings.clear();
 }
 
@@ -82,22 +82,7 @@ bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPatte
 
   trace_filesearch->WriteLine("core", fmt::format(T_("file system search: fileName={0}, pathPattern={1}"), Q_(fileName), Q_(pathPattern)));
 
-  vector<PathName> directories;
-
-  PathName comparablePathPattern(pathPattern);
-  comparablePathPattern.TransformForComparison();
-
-  SearchPathDictionary::const_iterator it = expandedPathPatterns.find(comparablePathPattern.ToString());
-
-  if (it == expandedPathPatterns.end())
-  {
-    ExpandPathPattern(PathName(), PathName(pathPattern), directories);
-    expandedPathPatterns[comparablePathPattern.ToString()] = directories;
-  }
-  else
-  {
-    directories = it->second;
-  }
+  vector<PathName> directories = GetExpandedPathPattern(PathName(pathPattern));
 
   bool found = false;
 
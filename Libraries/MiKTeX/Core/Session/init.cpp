@@ -256,6 +256,7 @@ void SessionImpl::Close()
   WritePackageHistory();
   inputDirectories.clear();
   UnregisterLibraryTraceStreams();
+  configSnapshots.clear();
   configurationSettings.clear();
 }
 
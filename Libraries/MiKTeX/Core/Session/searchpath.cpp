@@ -21,10 +21,20 @@
 
 #include "config.h"
 
+#include <atomic>
+#include <ctime>
+#include <fstream>
+#include <future>
+#include <thread>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/CacheFile>
 #include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
 
@@ -209,16 +219,19 @@ string SessionImpl::GetExpandedSearchPath(FileType fileType)
   return MakeSearchPath(GetDirectoryPatterns(fileType));
 }
 
-void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathPattern, vector<PathName>& paths)
+void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathPattern, DirectoryWalkResult& result, bool parallel)
 {
   if (pathPattern.Empty())
   {
-    paths.push_back(directory);
+    result.paths.push_back(directory);
   }
   else
   {
-    ExpandPathPattern(directory, pathPattern, paths);
+    ExpandPathPattern(directory, pathPattern, result, false);
   }
+  // get the modification time before listing the directory: a concurrent
+  // change invalidates the result
+  time_t lastWriteTime = File::GetLastWriteTime(directory);
   unique_ptr<DirectoryLister> dirLister = DirectoryLister::Open(directory, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
   DirectoryEntry entry;
   vector<PathName> subdirs;
@@ -230,19 +243,54 @@ void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathP
     subdirs.push_back(subdir);
   }
   dirLister->Close();
-  // TODO: async?
-  for (const PathName& subdir : subdirs)
+  result.listedDirectories.push_back(make_pair(directory, lastWriteTime));
+  auto walkSubdir = [this, &pathPattern](const PathName& subdir, DirectoryWalkResult& subdirResult)
   {
     if (!pathPattern.Empty())
     {
-      ExpandPathPattern(subdir, pathPattern, paths);
+      ExpandPathPattern(subdir, pathPattern, subdirResult, false);
     }
     // RECURSION
-    DirectoryWalk(subdir, pathPattern, paths);
+    DirectoryWalk(subdir, pathPattern, subdirResult, false);
+  };
+  if (!parallel || subdirs.size() < 2)
+  {
+    for (const PathName& subdir : subdirs)
+    {
+      walkSubdir(subdir, result);
+    }
+    return;
+  }
+  // walk the sub directory trees concurrently; the results are merged in
+  // directory order, i.e., we get the same result as with a sequential walk
+  vector<DirectoryWalkResult> subdirResults(subdirs.size());
+  atomic_size_t nextSubdir(0);
+  size_t numWorkers = std::min<size_t>(subdirs.size(), std::max(thread::hardware_concurrency(), 1u));
+  {
+    vector<future<void>> workers;
+    for (size_t n = 0; n < numWorkers; ++n)
+    {
+      workers.push_back(async(launch::async, [&]()
+      {
+        for (size_t idx = nextSubdir++; idx < subdirs.size(); idx = nextSubdir++)
+        {
+          walkSubdir(subdirs[idx], subdirResults[idx]);
+        }
+      }));
+    }
+    for (future<void>& worker : workers)
+    {
+      worker.get();
+    }
+  }
+  for (DirectoryWalkResult& subdirResult : subdirResults)
+  {
+    result.paths.insert(result.paths.end(), subdirResult.paths.begin(), subdirResult.paths.end());
+    result.listedDirectories.insert(result.listedDirectories.end(), subdirResult.listedDirectories.begin(), subdirResult.listedDirectories.end());
   }
 }
 
-void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathName& pathPattern, vector<PathName>& paths)
+void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathName& pathPattern, DirectoryWalkResult& result, bool parallel)
 {
   MIKTEX_ASSERT(!pathPattern.Empty());
   const char* lpszRecursionIndicator = strstr(pathPattern.GetData(), RECURSION_INDICATOR);
@@ -254,7 +302,7 @@ void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathNam
     directory /= pathPattern.ToString();
     if (!IsMpmFile(directory.GetData()) && Directory::Exists(directory))
     {
-      paths.push_back(directory);
+      result.paths.push_back(directory);
     }
   }
   else
@@ -271,30 +319,179 @@ void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathNam
     // check to see whether the sub directory exists
     if (!IsMpmFile(directory.GetData()) && Directory::Exists(directory))
     {
-      DirectoryWalk(directory, PathName(lpszSmallerPathPattern), paths);
+      DirectoryWalk(directory, PathName(lpszSmallerPathPattern), result, parallel);
     }
   }
 }
 
-vector<PathName> SessionImpl::ExpandPathPatterns(const string& toBeExpanded)
+bool SessionImpl::TryExpandPathPatternFromFndb(const PathName& pathPattern, vector<PathName>& paths)
 {
-  vector<PathName> pathNames;
-  for (const PathName& pattern : SplitSearchPath(toBeExpanded))
+  const char* lpszRecursionIndicator = strstr(pathPattern.GetData(), RECURSION_INDICATOR);
+  MIKTEX_ASSERT(lpszRecursionIndicator != nullptr);
+  PathName directory(string(pathPattern.GetData(), lpszRecursionIndicator - pathPattern.GetData()));
+  unsigned r = TryDeriveTEXMFRoot(directory);
+  // the file name databases of other roots might be out of date
+  if (r == INVALID_ROOT_INDEX || r == MPM_ROOT || !IsManagedRoot(r))
+  {
+    return false;
+  }
+  shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(r);
+  if (fndb == nullptr)
   {
-    PathName comparablePathPattern(pattern);
-    comparablePathPattern.TransformForComparison();
-    SearchPathDictionary::const_iterator it2 = expandedPathPatterns.find(comparablePathPattern.GetData());
-    if (it2 == expandedPathPatterns.end())
+    return false;
+  }
+  paths = fndb->ExpandPathPattern(pathPattern.ToString());
+  trace_filesearch->WriteLine("core", fmt::format(T_("{0} expanded from fndb: {1} directories"), Q_(pathPattern), paths.size()));
+  return true;
+}
+
+PathName SessionImpl::GetPathPatternCacheFile(const PathName& pathPattern)
+{
+  PathName comparablePathPattern(pathPattern);
+  comparablePathPattern.TransformForComparison();
+  MD5Builder md5Builder;
+  md5Builder.Update(comparablePathPattern.GetData(), comparablePathPattern.GetLength());
+  return GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_PATH_PATTERN_CACHE_DIR) / (md5Builder.Final().ToString() + ".txt");
+}
+
+// the cache file starts with a signature and the path pattern; then follow
+// the listed directories ("d<TAB>mtime<TAB>path") and the resulting
+// directories ("p<TAB>path")
+const char* const PATH_PATTERN_CACHE_SIGNATURE = "MiKTeX path pattern cache 1";
+
+bool SessionImpl::TryLoadExpandedPathPattern(const PathName& pathPattern, vector<PathName>& paths)
+{
+  PathName cacheFile;
+  try
+  {
+    cacheFile = GetPathPatternCacheFile(pathPattern);
+    if (!File::Exists(cacheFile))
     {
-      vector<PathName> paths2;
-      ExpandPathPattern(PathName(), pattern, paths2);
-      expandedPathPatterns[comparablePathPattern.GetData()] = paths2;
-      pathNames.insert(pathNames.end(), paths2.begin(), paths2.end());
+      return false;
     }
-    else
+    ifstream reader = File::CreateInputStream(cacheFile);
+    string line;
+    if (!getline(reader, line) || line != PATH_PATTERN_CACHE_SIGNATURE || !getline(reader, line) || line != pathPattern.ToString())
     {
-      pathNames.insert(pathNames.end(), it2->second.begin(), it2->second.end());
+      return false;
     }
+    vector<PathName> result;
+    while (getline(reader, line))
+    {
+      if (line.length() < 2 || line[1] != '\t')
+      {
+        return false;
+      }
+      if (line[0] == 'd')
+      {
+        size_t tab = line.find('\t', 2);
+        if (tab == string::npos)
+        {
+          return false;
+        }
+        time_t lastWriteTime = static_cast<time_t>(std::stoll(line.substr(2, tab - 2)));
+        PathName directory(line.substr(tab + 1));
+        // a directory's modification time changes when entries are added,
+        // removed or renamed
+        if (!CacheFile::IsUnchanged(directory, lastWriteTime))
+        {
+          trace_filesearch->WriteLine("core", fmt::format(T_("{0} has been modified"), Q_(directory)));
+          return false;
+        }
+      }
+      else if (line[0] == 'p')
+      {
+        result.push_back(PathName(line.substr(2)));
+      }
+      else
+      {
+        return false;
+      }
+    }
+    paths = std::move(result);
+  }
+  catch (const exception& e)
+  {
+    trace_filesearch->WriteLine("core", TraceLevel::Warning, fmt::format(T_("path pattern cache {0} cannot be used: {1}"), Q_(cacheFile), e.what()));
+    return false;
+  }
+  trace_filesearch->WriteLine("core", fmt::format(T_("{0} expanded from cache: {1} directories"), Q_(pathPattern), paths.size()));
+  return true;
+}
+
+void SessionImpl::SaveExpandedPathPattern(const PathName& pathPattern, const DirectoryWalkResult& result)
+{
+  if (result.listedDirectories.empty())
+  {
+    // nothing to validate against
+    return;
+  }
+  for (const auto& dir : result.listedDirectories)
+  {
+    if (!CacheFile::IsSettled(dir.second))
+    {
+      return;
+    }
+  }
+  PathName cacheFile;
+  try
+  {
+    cacheFile = GetPathPatternCacheFile(pathPattern);
+    CacheFile::Write(cacheFile, [&](ostream& writer)
+    {
+      writer << PATH_PATTERN_CACHE_SIGNATURE << "\n" << pathPattern.ToString() << "\n";
+      for (const auto& dir : result.listedDirectories)
+      {
+        writer << "d\t" << static_cast<long long>(dir.second) << "\t" << dir.first.ToString() << "\n";
+      }
+      for (const PathName& path : result.paths)
+      {
+        writer << "p\t" << path.ToString() << "\n";
+      }
+    });
+  }
+  catch (const MiKTeXException& e)
+  {
+    // for example: the data root directory is read-only
+    trace_filesearch->WriteLine("core", TraceLevel::Warning, fmt::format(T_("path pattern cache {0} cannot be written: {1}"), Q_(cacheFile), e.GetErrorMessage()));
+  }
+}
+
+vector<PathName> SessionImpl::GetExpandedPathPattern(const PathName& pathPattern)
+{
+  PathName comparablePathPattern(pathPattern);
+  comparablePathPattern.TransformForComparison();
+  SearchPathDictionary::const_iterator it = expandedPathPatterns.find(comparablePathPattern.ToString());
+  if (it != expandedPathPatterns.end())
+  {
+    return it->second;
+  }
+  vector<PathName> paths;
+  bool recursive = strstr(pathPattern.GetData(), RECURSION_INDICATOR) != nullptr;
+  if (!recursive || !pathPattern.IsFullyQualified() || IsMpmFile(pathPattern.GetData()))
+  {
+    DirectoryWalkResult result;
+    ExpandPathPattern(PathName(), pathPattern, result, false);
+    paths = std::move(result.paths);
+  }
+  else if (!TryExpandPathPatternFromFndb(pathPattern, paths) && !TryLoadExpandedPathPattern(pathPattern, paths))
+  {
+    DirectoryWalkResult result;
+    ExpandPathPattern(PathName(), pathPattern, result, true);
+    SaveExpandedPathPattern(pathPattern, result);
+    paths = std::move(result.paths);
+  }
+  expandedPathPatterns[comparablePathPattern.ToString()] = paths;
+  return paths;
+}
+
+vector<PathName> SessionImpl::ExpandPathPatterns(const string& toBeExpanded)
+{
+  vector<PathName> pathNames;
+  for (const PathName& pattern : SplitSearchPath(toBeExpanded))
+  {
+    vector<PathName> paths = GetExpandedPathPattern(pattern);
+    pathNames.insert(pathNames.end(), paths.begin(), paths.end());
   }
   return pathNames;
 }
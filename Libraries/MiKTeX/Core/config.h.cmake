@@ -28,9 +28,13 @@
 
 #cmakedefine HAVE_CHOWN 1
 #cmakedefine HAVE_CONFSTR 1
+#cmakedefine HAVE_EPOLL_CREATE1 1
 #cmakedefine HAVE_FORK 1
 #cmakedefine HAVE_FUTIMES 1
 #cmakedefine HAVE_MMAP 1
+#cmakedefine HAVE_POSIX_SPAWN 1
+#cmakedefine HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP 1
+#cmakedefine HAVE_POSIX_SPAWN_SETSID 1
 #cmakedefine HAVE_STATVFS 1
 #cmakedefine HAVE_UNAME_SYSCALL 1
 #cmakedefine HAVE_VFORK 1
@@ -0,0 +1,83 @@
+/**
+ * @file miktex/Core/CacheFile.h
+ * @author Christian Schenk
+ * @brief Cache files derived from source files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Core Library.
+ *
+ * The MiKTeX Core Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <miktex/Core/config.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+MIKTEX_CORE_BEGIN_NAMESPACE;
+
+/// Helpers for cache files which are derived from source files and which
+/// are validated against the sizes and modification times of these sources.
+class MIKTEXNOVTABLE CacheFile
+{
+public:
+    CacheFile() = delete;
+    CacheFile(const CacheFile& other) = delete;
+    CacheFile& operator=(const CacheFile& other) = delete;
+    CacheFile(CacheFile&& other) = delete;
+    CacheFile& operator=(CacheFile&& other) = delete;
+    ~CacheFile() = delete;
+
+    /// Tests whether a source file modification time can be recorded.
+    /// @param lastWriteTime The modification time of the source file.
+    /// @return Returns `false`, if the source file has been modified so
+    /// recently that a subsequent change might not alter its modification
+    /// time.
+    static MIKTEXCORECEEAPI(bool) IsSettled(std::time_t lastWriteTime);
+
+    /// Tests whether a source file can be recorded.
+    /// @param path The path to the source file.
+    /// @return Returns `false`, if the source file has been modified too
+    /// recently.
+    static MIKTEXCORECEEAPI(bool) IsSettled(const MiKTeX::Util::PathName& path);
+
+    /// Tests whether a source file or directory is still as recorded.
+    /// @param path The path to the source file or directory.
+    /// @param lastWriteTime The recorded modification time.
+    /// @return Returns `true`, if the source exists and has not been
+    /// modified.
+    static MIKTEXCORECEEAPI(bool) IsUnchanged(const MiKTeX::Util::PathName& path, std::time_t lastWriteTime);
+
+    /// Tests whether a source file is still as recorded.
+    /// @param path The path to the source file.
+    /// @param size The recorded file size.
+    /// @param lastWriteTime The recorded modification time.
+    /// @return Returns `true`, if the source file exists and has not been
+    /// modified.
+    static MIKTEXCORECEEAPI(bool) IsUnchanged(const MiKTeX::Util::PathName& path, std::uint64_t size, std::time_t lastWriteTime);
+
+    /// Replaces a cache file, so that concurrent readers see either the
+    /// old or the new contents.
+    /// @param path The path to the cache file.
+    /// @param data The new contents.
+    static MIKTEXCORECEEAPI(void) Write(const MiKTeX::Util::PathName& path, const std::vector<unsigned char>& data);
+
+    /// Replaces a cache file, so that concurrent readers see either the
+    /// old or the new contents.
+    /// @param path The path to the cache file.
+    /// @param writer The function which writes the new contents.
+    static MIKTEXCORECEEAPI(void) Write(const MiKTeX::Util::PathName& path, const std::function<void(std::ostream&)>& writer);
+};
+
+MIKTEX_CORE_END_NAMESPACE;
@@ -1,6 +1,6 @@
 /* miktex/Core/FileSystemWatcher.h:
 
-   Copyright (C) 2021-2022 Christian Schenk
+   Copyright (C) 2021-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -37,6 +37,9 @@ enum class FileSystemChangeAction
   Added,
   Modified,
   Removed,
+  // events have been lost; the watched directories must be rescanned; if
+  // fileName is set, it is a directory which cannot be watched at all
+  Overflow,
 };
 
 inline std::string FileSystemChangeActionToString(FileSystemChangeAction action)
@@ -49,6 +52,8 @@ inline std::string FileSystemChangeActionToString(FileSystemChangeAction action)
       return "modified";
     case FileSystemChangeAction::Removed:
       return "removed";
+    case FileSystemChangeAction::Overflow:
+      return "overflow";
     default:
       return "?";
   }
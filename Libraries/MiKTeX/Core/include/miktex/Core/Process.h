@@ -1,6 +1,6 @@
 /* miktex/Core/Process.h:                               -*- C++ -*-
 
-   Copyright (C) 1996-2021 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -197,6 +197,38 @@ struct ProcessInfo
   int parent = -1;
 };
 
+/// A process to be executed by `Process::RunAll()`.
+struct ProcessJob
+{
+  /// The name of an executable file to run in the process.
+  MiKTeX::Util::PathName FileName;
+
+  /// The command-line arguments to pass when starting the process.
+  std::vector<std::string> Arguments;
+
+  /// Working directory for the process.
+  std::string WorkingDirectory;
+
+  /// Receives the output of the process; the output is discarded, if this
+  /// is empty. The callback is invoked on the calling thread. Returning
+  /// `false` discards the remaining output.
+  std::function<bool(const void*, std::size_t)> OnOutput;
+
+  /// Receives the error output of the process; the error output is merged
+  /// into the output, if this is empty. Otherwise like `OnOutput`.
+  std::function<bool(const void*, std::size_t)> OnError;
+
+  /// How the process has exited.
+  ProcessExitStatus ExitStatus = ProcessExitStatus::None;
+
+  /// The exit code of the process; -1, if the process has not exited
+  /// normally.
+  int ExitCode = -1;
+
+  /// The MiKTeX exception thrown by the process, if `ExitCode` isn't 0.
+  MiKTeXException Exception;
+};
+
 /// An instance of this class manages a child process.
 class MIKTEXNOVTABLE Process
 {
@@ -373,6 +405,14 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) Run(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments, std::function<bool(const void*, std::size_t)> callback, int* exitCode, MiKTeXException* miktexException, const char* workingDirectory);
 
+  /// Executes processes concurrently.
+  /// The output of all running processes is collected by the calling thread.
+  /// @param[in,out] jobs The processes to run; receive the outcomes.
+  /// @param maxJobs The maximum number of processes running at the same
+  /// time.
+public:
+  static MIKTEXCORECEEAPI(void) RunAll(std::vector<ProcessJob>& jobs, unsigned maxJobs);
+
   /// Executes a process.
   /// @param fileName The name of an executable file to run in the process.
   /// @param arguments The command-line arguments to pass when starting
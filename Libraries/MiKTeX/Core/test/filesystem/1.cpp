@@ -205,6 +205,7 @@ BEGIN_TEST_FUNCTION(8);
             case FileSystemChangeAction::Added: added = true; break;
             case FileSystemChangeAction::Modified: modified = true; break;
             case FileSystemChangeAction::Removed: removed = true; break;
+            default: break;
             }
         }
         };
@@ -236,6 +237,81 @@ BEGIN_TEST_FUNCTION(8);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(9);
+{
+    class ChangeHandler : public FileSystemWatcherCallback
+    {
+    public:
+        void OnChange(const FileSystemChangeEvent &ev) override {
+        if (ev.fileName.GetFileName() == PathName("9a.txt") && ev.action == FileSystemChangeAction::Removed)
+        {
+            removed = true;
+        }
+        else if (ev.fileName.GetFileName() == PathName("9b.txt") && ev.action == FileSystemChangeAction::Added)
+        {
+            added = true;
+        }
+        };
+        bool added = false;
+        bool removed = false;
+    };
+    ChangeHandler handler;
+    Touch("9a.txt");
+    auto watcher = FileSystemWatcher::Create();
+    watcher->Start();
+    PathName dir;
+    dir.SetToCurrentDirectory();
+    watcher->AddDirectories({dir});
+    this_thread::sleep_for(chrono::seconds(1));
+    watcher->Subscribe(&handler);
+    File::Move(PathName("9a.txt"), PathName("9b.txt"));
+    this_thread::sleep_for(chrono::seconds(1));
+    File::Delete(PathName("9b.txt"));
+    TESTX(watcher->Stop());
+    TESTX(watcher = nullptr);
+    TEST(handler.removed);
+    TEST(handler.added);
+}
+END_TEST_FUNCTION();
+
+#if defined(__linux__)
+BEGIN_TEST_FUNCTION(10);
+{
+    class ChangeHandler : public FileSystemWatcherCallback
+    {
+    public:
+        void OnChange(const FileSystemChangeEvent &ev) override {
+        if (ev.fileName.GetFileName() == PathName("10.txt") && ev.action == FileSystemChangeAction::Added)
+        {
+            added = ev.fileName;
+        }
+        };
+        PathName added;
+    };
+    ChangeHandler handler;
+    PathName cd;
+    cd.SetToCurrentDirectory();
+    PathName dir = cd / "10a";
+    PathName renamedDir = cd / "10b";
+    TESTX(Directory::Create(dir));
+    auto watcher = FileSystemWatcher::Create();
+    watcher->Start();
+    watcher->AddDirectories({dir});
+    TESTX(Directory::Move(dir, renamedDir));
+    // a renamed directory keeps its watch descriptor
+    watcher->AddDirectories({renamedDir});
+    this_thread::sleep_for(chrono::seconds(1));
+    watcher->Subscribe(&handler);
+    Touch((renamedDir / "10.txt").GetData());
+    this_thread::sleep_for(chrono::seconds(1));
+    TESTX(watcher->Stop());
+    TESTX(watcher = nullptr);
+    TEST(handler.added == renamedDir / "10.txt");
+    TESTX(Directory::Delete(renamedDir, true));
+}
+END_TEST_FUNCTION();
+#endif
+
 BEGIN_TEST_PROGRAM();
 {
     CALL_TEST_FUNCTION(1);
@@ -248,6 +324,12 @@ BEGIN_TEST_PROGRAM();
 #endif
     CALL_TEST_FUNCTION(7);
     CALL_TEST_FUNCTION(8);
+#if !defined(__APPLE__)
+    CALL_TEST_FUNCTION(9);
+#endif
+#if defined(__linux__)
+    CALL_TEST_FUNCTION(10);
+#endif
 }
 END_TEST_PROGRAM();
 
@@ -1,6 +1,6 @@
 /* 1.cpp:
 
-   Copyright (C) 1996-2021 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -138,6 +138,46 @@ BEGIN_TEST_FUNCTION(5);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(6);
+{
+  PathName pathExe = pSession->GetMyLocation(false);
+  PathName pathExe2 = pathExe / "core_process_test1-2" MIKTEX_EXE_FILE_SUFFIX;
+  PathName pathExe3 = pathExe / "core_process_test1-3" MIKTEX_EXE_FILE_SUFFIX;
+  const int n = 10;
+  vector<ProcessJob> jobs(n);
+  vector<string> outputs(n);
+  for (int idx = 0; idx < n; ++idx)
+  {
+    if (idx % 3 == 2)
+    {
+      jobs[idx].FileName = pathExe3;
+      jobs[idx].Arguments = { pathExe3.ToString() };
+    }
+    else
+    {
+      jobs[idx].FileName = pathExe2;
+      jobs[idx].Arguments = { pathExe2.ToString(), "hello", std::to_string(idx) };
+      jobs[idx].OnOutput = [&outputs, idx](const void* output, size_t n) { outputs[idx].append(reinterpret_cast<const char*>(output), n); return true; };
+    }
+  }
+  TESTX(Process::RunAll(jobs, 4));
+  for (int idx = 0; idx < n; ++idx)
+  {
+    TEST(jobs[idx].ExitStatus == ProcessExitStatus::Exited);
+    if (idx % 3 == 2)
+    {
+      TEST(jobs[idx].ExitCode == 1);
+      TEST(jobs[idx].Exception.GetErrorMessage() == "xerrorMessagey");
+    }
+    else
+    {
+      TEST(jobs[idx].ExitCode == 0);
+      TEST(outputs[idx] == "hello\n" + std::to_string(idx) + "\n");
+    }
+  }
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -145,6 +185,7 @@ BEGIN_TEST_PROGRAM();
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
   CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
 }
 END_TEST_PROGRAM();
 
@@ -1,6 +1,6 @@
 /* dvi.cpp:
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -23,6 +23,8 @@
 
 #include "config.h"
 
+#include <thread>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -1676,6 +1678,85 @@ bool DviImpl::MakeFonts(const FontMap & fontMap, int recursion)
   return done;
 }
 
+void DviImpl::CollectMissingPkFonts(const FontMap& fontMap, vector<pair<PkFont*, int>>& missingPkFonts, set<pair<string, int>>& seen, int recursion)
+{
+  for (FontMap::const_iterator it = fontMap.begin(); it != fontMap.end(); ++it)
+  {
+    if (it->second->IsNotLoadable())
+    {
+      continue;
+    }
+    PkFont* pkFont = dynamic_cast<PkFont*>(it->second);
+    if (pkFont != nullptr)
+    {
+      int dpi;
+      if (pkFont->IsMissing(dpi) && seen.insert(make_pair(pkFont->GetName(), dpi)).second)
+      {
+        missingPkFonts.push_back(make_pair(pkFont, dpi));
+      }
+      continue;
+    }
+    VFont* pVFont = dynamic_cast<VFont*>(it->second);
+    if (pVFont == nullptr)
+    {
+      continue;
+    }
+    const int maxRecursion = 20;
+    if (recursion >= maxRecursion)
+    {
+      trace_error->WriteLine("libdvi", T_("infinite VF recursion?"));
+      continue;
+    }
+    // reading the VF file defines the fonts it refers to
+    pVFont->Read();
+    if (!pVFont->IsNotLoadable())
+    {
+      CollectMissingPkFonts(pVFont->GetFontMap(), missingPkFonts, seen, recursion + 1);
+    }
+  }
+}
+
+// prescan: make the missing PK fonts of all pages (and virtual fonts) at
+// once; makepk processes run in parallel; concurrent requests for the same
+// font (e.g. from another Yap window) are serialized by makepk
+void DviImpl::MakeMissingPkFonts()
+{
+  vector<pair<PkFont*, int>> missingPkFonts;
+  set<pair<string, int>> seen;
+  CollectMissingPkFonts(*fontMap, missingPkFonts, seen, 0);
+  if (missingPkFonts.empty())
+  {
+    return;
+  }
+  Progress(DviNotification::BeginLoadFont, fmt::format(T_("making {0} font(s)..."), missingPkFonts.size()));
+  size_t numJobs = min<size_t>(missingPkFonts.size(), max<unsigned>(thread::hardware_concurrency(), 1));
+  trace_dvifile->WriteLine("libdvi", fmt::format(T_("making {0} PK font(s), {1} job(s)"), missingPkFonts.size(), numJobs));
+  // the session is not thread-safe: resolve makepk and build the command
+  // lines here; the workers only run the processes
+  for (const pair<PkFont*, int>& missing : missingPkFonts)
+  {
+    missing.first->PrepareMakeMissing(missing.second);
+  }
+  atomic<size_t> nextFont(0);
+  auto job = [&missingPkFonts, &nextFont]()
+  {
+    for (size_t idx = nextFont++; idx < missingPkFonts.size(); idx = nextFont++)
+    {
+      missingPkFonts[idx].first->MakeMissing();
+    }
+  };
+  vector<thread> jobs;
+  for (size_t j = 1; j < numJobs; ++j)
+  {
+    jobs.push_back(thread(job));
+  }
+  job();
+  for (thread& t : jobs)
+  {
+    t.join();
+  }
+}
+
 bool DviImpl::MakeFonts()
 {
   CheckCondition();
@@ -1685,6 +1766,7 @@ bool DviImpl::MakeFonts()
     {
       MIKTEX_UNEXPECTED();
     }
+    MakeMissingPkFonts();
     return MakeFonts(*fontMap, 0);
   }
   END_CRITICAL_SECTION();
@@ -46,6 +46,12 @@ public:
     return dviInfo.fileName;
   }
 
+public:
+  const string& GetName()
+  {
+    return dviInfo.name;
+  }
+
 public:
   int GetScaledAt()
   {
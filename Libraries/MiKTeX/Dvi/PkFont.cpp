@@ -1,6 +1,6 @@
 /* PkFont.cpp:
 
-   Copyright (C) 1996-2022 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -168,13 +168,7 @@ void PkFont::Read()
 
   trace_pkfont->WriteLine("libdvi", fmt::format(T_("going to load pk font {0}"), dviInfo.name));
 
-  int dpi =
-    static_cast<int>((static_cast<double>(mag)
-      * static_cast<double>(scaledAt)
-      * static_cast<double>(baseDpi))
-      / (static_cast<double>(designSize) * 1000.0)
-      + 0.5);
-  dpi = CheckDpi(dpi, baseDpi);
+  int dpi = GetDpi();
 
   dviInfo.notLoadable = true;
 
@@ -184,7 +178,8 @@ void PkFont::Read()
 
   if (!fontFileExists)
   {
-    if (Make(dviInfo.name, dpi, baseDpi, metafontMode))
+    // don't try again, if the prescan failed to make the font
+    if (!makeFailed && Make(dviInfo.name, dpi, baseDpi, metafontMode))
     {
       fontFileExists = session->FindPkFile(dviInfo.name, metafontMode, dpi, fileName);
       if (!fontFileExists)
@@ -303,18 +298,59 @@ void PkFont::Read()
   dviInfo.notLoadable = !fontFileExists;
 }
 
+int PkFont::GetDpi()
+{
+  int dpi =
+    static_cast<int>((static_cast<double>(mag)
+      * static_cast<double>(scaledAt)
+      * static_cast<double>(baseDpi))
+      / (static_cast<double>(designSize) * 1000.0)
+      + 0.5);
+  return CheckDpi(dpi, baseDpi);
+}
+
+bool PkFont::IsMissing(int& dpi)
+{
+  if (!pkChars.empty() || dviInfo.notLoadable || makeFailed)
+  {
+    return false;
+  }
+  dpi = GetDpi();
+  PathName fileName;
+  return !session->FindPkFile(dviInfo.name, metafontMode, dpi, fileName);
+}
+
+void PkFont::PrepareMakeMissing(int dpi)
+{
+  PrepareMakePk(dviInfo.name, dpi, baseDpi, metafontMode);
+}
+
+void PkFont::MakeMissing()
+{
+  makeFailed = !RunMakePk();
+}
+
 bool PkFont::Make(const string& name, int dpi, int baseDpi, const string& metafontMode)
+{
+  dviImpl->Progress(DviNotification::BeginLoadFont, fmt::format("{0}...", dviInfo.name));
+  PrepareMakePk(name, dpi, baseDpi, metafontMode);
+  return RunMakePk();
+}
+
+void PkFont::PrepareMakePk(const string& name, int dpi, int baseDpi, const string& metafontMode)
 {
   dviInfo.transcript += "\r\n";
   dviInfo.transcript += T_("Making PK font:\r\n");
-  PathName pathMakePk;
-  vector<string> args = session->MakeMakePkCommandLine(name, dpi, baseDpi, metafontMode, pathMakePk, TriState::Undetermined);
-  dviInfo.transcript += CommandLineBuilder(args).ToString();
+  makePkArgs = session->MakeMakePkCommandLine(name, dpi, baseDpi, metafontMode, pathMakePk, TriState::Undetermined);
+  dviInfo.transcript += CommandLineBuilder(makePkArgs).ToString();
   dviInfo.transcript += "\r\n";
-  dviImpl->Progress(DviNotification::BeginLoadFont, fmt::format("{0}...", dviInfo.name));
+}
+
+bool PkFont::RunMakePk()
+{
   ProcessOutput<4096> makepkOutput;
   int exitCode;
-  bool b = Process::Run(pathMakePk, args, &makepkOutput, &exitCode, nullptr) && exitCode == 0;
+  bool b = Process::Run(pathMakePk, makePkArgs, &makepkOutput, &exitCode, nullptr) && exitCode == 0;
   if (!b)
   {
     trace_error->WriteLine("libdvi", makepkOutput.StdoutToString());
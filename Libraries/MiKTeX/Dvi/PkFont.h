@@ -1,6 +1,6 @@
 /* PkFont.h:                                            -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -44,9 +44,32 @@ private:
 private:
   int CheckDpi(int dpi, int baseDpi);
 
+private:
+  int GetDpi();
+
+public:
+  /// Checks whether the PK file has to be made.
+  /// @param[out] dpi The resolution of the PK file.
+  bool IsMissing(int& dpi);
+
+public:
+  /// Builds the makepk command line for MakeMissing(). Must be called on
+  /// the thread which uses the session.
+  void PrepareMakeMissing(int dpi);
+
+public:
+  /// Makes the PK file; may be called on a worker thread.
+  void MakeMissing();
+
 private:
   bool Make(const string& name, int dpi, int baseDpi, const string& metafontMode);
 
+private:
+  void PrepareMakePk(const string& name, int dpi, int baseDpi, const string& metafontMode);
+
+private:
+  bool RunMakePk();
+
 private:
   bool MakeTFM(const string& name);
 
@@ -74,6 +97,15 @@ private:
 private:
   bool checkDpi = false;
 
+private:
+  bool makeFailed = false;
+
+private:
+  PathName pathMakePk;
+
+private:
+  vector<string> makePkArgs;
+
 private:
   int hppp;
 
@@ -1,6 +1,6 @@
 /* internal.h: internal DVI definitions                 -*- C++ -*-
 
-   Copyright (C) 1996-2022 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX DVI Library.
 
@@ -21,6 +21,7 @@
 
 #include <atomic>
 #include <mutex>
+#include <set>
 #include <stack>
 
 #include <fmt/format.h>
@@ -1182,6 +1183,12 @@ private:
 private:
   bool MakeFonts(const FontMap& mapnumtofontptr, int recursion);
 
+private:
+  void CollectMissingPkFonts(const FontMap& mapnumtofontptr, vector<pair<PkFont*, int>>& missingPkFonts, set<pair<string, int>>& seen, int recursion);
+
+private:
+  void MakeMissingPkFonts();
+
 private:
   double GetConv()
   {
@@ -76,12 +76,31 @@ void PackageDataStore::SaveVarData()
     comboCfg.Save();
 }
 
+vector<string> PackageDataStore::Search(const string& text, PackageSearchFieldSet fields)
+{
+    if (searchIndex == nullptr)
+    {
+        unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "building the package search index");
+        searchIndex = make_unique<PackageSearchIndex>();
+        for (const PackageInfo& packageInfo : *this)
+        {
+            searchIndex->Add(packageInfo);
+        }
+    }
+    return searchIndex->Search(text, fields);
+}
+
 void PackageDataStore::Clear()
 {
     packageTable.clear();
+    packagesWithoutFiles.clear();
+    manifestsDb.Close();
     installedFileInfoTable.clear();
+    fileRefCounts.clear();
+    haveFileRefCounts = false;
     loadedAllPackageManifests = false;
     comboCfg.Clear();
+    searchIndex = nullptr;
 }
 
 tuple<bool, PackageInfo> PackageDataStore::TryGetPackage(const string& packageId)
@@ -94,6 +113,7 @@ tuple<bool, PackageInfo> PackageDataStore::TryGetPackage(const string& packageId
     }
     else
     {
+        NeedFiles(it->second);
         return make_tuple(true, it->second);
     }
 }
@@ -126,18 +146,19 @@ void PackageDataStore::SetReleaseState(const string& packageId, RepositoryReleas
 PackageDataStore::iterator PackageDataStore::begin()
 {
     MIKTEX_EXPECT(loadedAllPackageManifests);
-    return iterator(packageTable.begin());
+    return iterator(this, packageTable.begin());
 }
 
 PackageDataStore::iterator PackageDataStore::end()
 {
     MIKTEX_EXPECT(loadedAllPackageManifests);
-    return iterator(packageTable.end());
+    return iterator(this, packageTable.end());
 }
 
 void PackageDataStore::DefinePackage(const PackageInfo& packageInfo)
 {
     pair<PackageDefinitionTable::iterator, bool> p = packageTable.insert(make_pair(packageInfo.id, packageInfo));
+    searchIndex = nullptr;
     if (session->IsMiKTeXDirect())
     {
         // installed from the start
@@ -161,15 +182,65 @@ void PackageDataStore::DefinePackage(const PackageInfo& packageInfo)
 
 void PackageDataStore::IncrementFileRefCounts(const string& packageId)
 {
-    const PackageInfo& package = (*this)[packageId];
-    IncrementFileRefCounts(package.runFiles);
-    IncrementFileRefCounts(package.docFiles);
-    IncrementFileRefCounts(package.sourceFiles);
+    MIKTEX_EXPECT(loadedAllPackageManifests);
+    if (!haveFileRefCounts)
+    {
+        // the package is already marked as installed and will be counted
+        NeedFileRefCounts();
+        return;
+    }
+    IncrementFileRefCounts((*this)[packageId]);
+}
+
+void PackageDataStore::IncrementFileRefCounts(const PackageInfo& packageInfo)
+{
+    auto it = packagesWithoutFiles.find(packageInfo.id);
+    if (it != packagesWithoutFiles.end())
+    {
+        for (uint32_t fileId : manifestsDb.GetFileIds(it->second))
+        {
+            ++fileRefCounts[fileId];
+        }
+        return;
+    }
+    IncrementFileRefCounts(packageInfo.runFiles);
+    IncrementFileRefCounts(packageInfo.docFiles);
+    IncrementFileRefCounts(packageInfo.sourceFiles);
+}
+
+void PackageDataStore::NeedFileRefCounts()
+{
+    if (haveFileRefCounts)
+    {
+        return;
+    }
+    unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "counting file references");
+    haveFileRefCounts = true;
+    if (manifestsDb.IsOpen())
+    {
+        fileRefCounts.assign(manifestsDb.GetNumberOfFileIds(), 0);
+    }
+    for (const auto& kv : packageTable)
+    {
+        if (kv.second.IsInstalled())
+        {
+            IncrementFileRefCounts(kv.second);
+        }
+    }
 }
 
 unsigned long PackageDataStore::GetFileRefCount(const PathName& path)
 {
     MIKTEX_EXPECT(loadedAllPackageManifests);
+    NeedFileRefCounts();
+    if (manifestsDb.IsOpen())
+    {
+        uint32_t fileId = manifestsDb.FindFile(path);
+        if (fileId != PackageManifestsDb::npos)
+        {
+            return fileRefCounts[fileId];
+        }
+    }
     InstalledFileInfoTable::const_iterator it = installedFileInfoTable.find(path.ToString());
     if (it == installedFileInfoTable.end())
     {
@@ -181,6 +252,19 @@ unsigned long PackageDataStore::GetFileRefCount(const PathName& path)
 unsigned long PackageDataStore::DecrementFileRefCount(const PathName& path)
 {
     MIKTEX_EXPECT(loadedAllPackageManifests);
+    NeedFileRefCounts();
+    if (manifestsDb.IsOpen())
+    {
+        uint32_t fileId = manifestsDb.FindFile(path);
+        if (fileId != PackageManifestsDb::npos)
+        {
+            if (fileRefCounts[fileId] == 0)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            return --fileRefCounts[fileId];
+        }
+    }
     InstalledFileInfoTable::iterator it = installedFileInfoTable.find(path.ToString());
     if (it == installedFileInfoTable.end() || it->second.refCount == 0)
     {
@@ -232,24 +316,65 @@ PackageDataStore& PackageDataStore::Load()
     }
     unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "loading all package manifests");
     NeedPackageManifestsIni();
-    unique_ptr<Cfg> cfg = Cfg::Create();
+    PathName userPath;
     if (!session->IsAdminMode())
     {
-        PathName userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
-        if (File::Exists(userPath))
+        userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
+    }
+    PathName commonPath;
+    if (session->IsAdminMode() || session->IsSharedSetup() && session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize())
+    {
+        commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
+    }
+    vector<PathName> sources;
+    if (!userPath.Empty() && File::Exists(userPath))
+    {
+        sources.push_back(userPath);
+    }
+    if (!commonPath.Empty() && File::Exists(commonPath))
+    {
+        sources.push_back(commonPath);
+    }
+    PathName dbPath = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_DB;
+    try
+    {
+        if (manifestsDb.TryOpen(dbPath, sources))
         {
-            cfg->Read(userPath);
+            Load(manifestsDb);
+            loadedAllPackageManifests = true;
+            return *this;
         }
     }
-    if (session->IsAdminMode() || session->IsSharedSetup() && session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize())
+    catch (const MiKTeXException& e)
     {
-        PathName commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
-        if (File::Exists(commonPath))
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("cannot open {0}: {1}"), Q_(dbPath), e.GetErrorMessage()));
+        manifestsDb.Close();
+    }
+    unique_ptr<Cfg> cfg = Cfg::Create();
+    if (!userPath.Empty() && File::Exists(userPath))
+    {
+        cfg->Read(userPath);
+    }
+    if (!commonPath.Empty() && File::Exists(commonPath))
+    {
+        cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
+        cfg->Read(commonPath);
+    }
+    try
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("compiling package manifests into {0}"), Q_(dbPath)));
+        if (PackageManifestsDb::Create(dbPath, sources, *cfg) && manifestsDb.TryOpen(dbPath, sources))
         {
-            cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
-            cfg->Read(commonPath);
+            Load(manifestsDb);
+            loadedAllPackageManifests = true;
+            return *this;
         }
     }
+    catch (const MiKTeXException& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("cannot create {0}: {1}"), Q_(dbPath), e.GetErrorMessage()));
+        manifestsDb.Close();
+    }
     Load(*cfg);
     loadedAllPackageManifests = true;
     return *this;
@@ -287,18 +412,51 @@ void PackageDataStore::Load(Cfg& cfg)
 
         // insert into database
         DefinePackage(packageInfo);
+    }
+
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("found {0} package manifests"), count));
+
+    ResolveDependencies();
+}
+
+void PackageDataStore::Load(const PackageManifestsDb& db)
+{
+    unsigned count = 0;
+    uint32_t numberOfPackages = db.GetNumberOfPackages();
+    for (uint32_t idx = 0; idx < numberOfPackages; ++idx)
+    {
+        // file lists are loaded on demand
+        PackageInfo packageInfo = db.GetPackageManifest(idx);
+
+#if IGNORE_OTHER_SYSTEMS
+        string targetSystems = packageInfo.targetSystem;
+        if (targetSystems != "" && !StringUtil::Contains(targetSystems, MIKTEX_SYSTEM_TAG))
+        {
+            continue;
+        }
+#endif
 
-        // increment file ref counts, if package is installed
-        if (packageInfo.IsInstalled())
+#if defined(MIKTEX_WINDOWS)
+        if (!packageInfo.minTargetSystemVersion.empty() && VersionNumber(WindowsVersion::GetMajorMinorBuildString()) < VersionNumber(packageInfo.minTargetSystemVersion))
         {
-            IncrementFileRefCounts(packageInfo.runFiles);
-            IncrementFileRefCounts(packageInfo.docFiles);
-            IncrementFileRefCounts(packageInfo.sourceFiles);
+            continue;
         }
+#endif
+
+        count += 1;
+
+        // insert into database
+        DefinePackage(packageInfo);
+        packagesWithoutFiles[packageInfo.id] = idx;
     }
 
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("found {0} package manifests"), count));
 
+    ResolveDependencies();
+}
+
+void PackageDataStore::ResolveDependencies()
+{
     // determine dependencies
     for (auto& kv : packageTable)
     {
@@ -328,7 +486,8 @@ void PackageDataStore::Load(Cfg& cfg)
         }
         if (timeInstalledMin > 0)
         {
-            if (pkg.IsPureContainer() || (pkg.IsInstalled() && pkg.GetTimeInstalled() < timeInstalledMax))
+            // same as pkg.IsPureContainer(), without loading the file lists
+            if ((pkg.IsContainer() && GetNumberOfFiles(pkg) <= 1) || (pkg.IsInstalled() && pkg.GetTimeInstalled() < timeInstalledMax))
             {
                 if (session->IsAdminMode())
                 {
@@ -402,9 +561,27 @@ PackageInfo& PackageDataStore::operator[](const string& packageId)
     {
         MIKTEX_FATAL_ERROR_2(T_("The requested package is unknown."), "name", packageId);
     }
+    NeedFiles(it->second);
     return it->second;
 }
 
+void PackageDataStore::NeedFiles(PackageInfo& packageInfo)
+{
+    auto it = packagesWithoutFiles.find(packageInfo.id);
+    if (it == packagesWithoutFiles.end())
+    {
+        return;
+    }
+    manifestsDb.GetFiles(it->second, packageInfo);
+    packagesWithoutFiles.erase(it);
+}
+
+size_t PackageDataStore::GetNumberOfFiles(const PackageInfo& packageInfo)
+{
+    auto it = packagesWithoutFiles.find(packageInfo.id);
+    return it == packagesWithoutFiles.end() ? packageInfo.GetNumFiles() : manifestsDb.GetNumberOfFiles(it->second);
+}
+
 time_t PackageDataStore::GetTimeInstalled(const string& packageId, ConfigurationScope scope)
 {
     LoadVarData();
@@ -496,6 +673,15 @@ void PackageDataStore::IncrementFileRefCounts(const vector<string>& files)
 {
     for (const string& file : files)
     {
+        if (manifestsDb.IsOpen())
+        {
+            uint32_t fileId = manifestsDb.FindFile(PathName(file));
+            if (fileId != PackageManifestsDb::npos)
+            {
+                ++fileRefCounts[fileId];
+                continue;
+            }
+        }
         ++installedFileInfoTable[file].refCount;
 #if POLLUTE_THE_DEBUG_STREAM
         if (installedFileInfoTable[file].refCount >= 2)
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Package data store
  *
- * @copyright Copyright © 2018-2022 Christian Schenk
+ * @copyright Copyright © 2018-2024 Christian Schenk
  *
  * This file is part of MiKTeX Package Manager.
  *
@@ -19,6 +19,7 @@
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include <miktex/Util/PathName>
 #include <miktex/Core/Session>
@@ -29,6 +30,8 @@
 #include <miktex/PackageManager/PackageManager>
 
 #include "ComboCfg.h"
+#include "PackageManifestsDb.h"
+#include "PackageSearchIndex.h"
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
 
@@ -37,6 +40,7 @@ MPM_INTERNAL_BEGIN_NAMESPACE;
  *
  * The record data is retrieved from two sources:
  * - `miktex/config/package-manifests.ini`: immutable package manifests
+ *   (usually via the compiled `miktex/cache/package-manifests.db`)
  * - `miktex/config/packages.ini`: mutable package data such as installation
  *   timestamps
  */
@@ -140,6 +144,18 @@ public:
      */
     void SaveVarData();
 
+    /**
+     * @brief Searches package records.
+     *
+     * The search index is built on first use and discarded together with the
+     * records.
+     *
+     * @param text The search text.
+     * @param fields The fields to be searched.
+     * @return Returns the IDs of the matching packages.
+     */
+    std::vector<std::string> Search(const std::string& text, MiKTeX::Packages::PackageSearchFieldSet fields);
+
     /**
      * Updates a record in the data store.
      * @param packageInfo The record to update.
@@ -147,6 +163,8 @@ public:
     void SetPackage(const MiKTeX::Packages::PackageInfo& packageInfo)
     {
         (*this)[packageInfo.id] = packageInfo;
+        // the searched fields may have changed
+        searchIndex = nullptr;
     }
 
     /**
@@ -178,12 +196,14 @@ public:
     class iterator
     {
     public:
-        iterator(PackageDefinitionTable::iterator it) :
+        iterator(PackageDataStore* store, PackageDefinitionTable::iterator it) :
+            store(store),
             it(it)
         {
         }
         MiKTeX::Packages::PackageInfo& operator*()
         {
+            store->NeedFiles(it->second);
             return it->second;
         }
         iterator& operator++()
@@ -200,6 +220,7 @@ public:
             return it != rhs.it;
         }
     private:
+        PackageDataStore* store;
         PackageDefinitionTable::iterator it;
     };
 
@@ -226,20 +247,35 @@ private:
 
     typedef std::unordered_map<std::string, InstalledFileInfo, hash_path, equal_path> InstalledFileInfoTable;
 
+    /// Maps IDs of packages, whose file lists have not been loaded yet, to
+    /// package manifests database records.
+    typedef std::unordered_map<std::string, std::uint32_t, MiKTeX::Core::hash_icase, MiKTeX::Core::equal_icase> PackagesWithoutFilesTable;
+
     MiKTeX::Packages::PackageInfo& operator[](const std::string& packageId);
     MiKTeX::Packages::RepositoryReleaseState GetReleaseState(const std::string& packageId);
     bool IsObsolete(const std::string& packageId);
     bool IsRemovable(const std::string& packageId);
     std::time_t GetTimeInstalled(const std::string& packageId);
     std::time_t GetTimeInstalled(const std::string& packageId, MiKTeX::Core::ConfigurationScope scope);
+    std::size_t GetNumberOfFiles(const MiKTeX::Packages::PackageInfo& packageInfo);
+    void IncrementFileRefCounts(const MiKTeX::Packages::PackageInfo& packageInfo);
     void IncrementFileRefCounts(const std::vector<std::string>& files);
     void Load(MiKTeX::Core::Cfg& cfg);
+    void Load(const PackageManifestsDb& db);
     void LoadVarData();
+    void NeedFileRefCounts();
+    void NeedFiles(MiKTeX::Packages::PackageInfo& packageInfo);
+    void ResolveDependencies();
 
     ComboCfg comboCfg;
+    std::vector<unsigned long> fileRefCounts;
+    bool haveFileRefCounts = false;
     InstalledFileInfoTable installedFileInfoTable;
     bool loadedAllPackageManifests = false;
+    PackageManifestsDb manifestsDb;
     PackageDefinitionTable packageTable;
+    PackagesWithoutFilesTable packagesWithoutFiles;
+    std::unique_ptr<PackageSearchIndex> searchIndex;
     std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
     std::unique_ptr<MiKTeX::Trace::TraceStream> trace_mpm;
     std::unique_ptr<MiKTeX::Trace::TraceStream> trace_stopwatch;
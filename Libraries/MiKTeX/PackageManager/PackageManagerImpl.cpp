@@ -14,9 +14,13 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <future>
 #include <locale>
 #include <stack>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <fmt/format.h>
@@ -26,6 +30,7 @@
 #include <miktex/Core/Directory>
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/Environment>
+#include <miktex/Core/Process>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/Uri>
 #include <miktex/Core/Utils>
@@ -1085,96 +1090,268 @@ void PackageManagerImpl::OnProgress()
 {
 }
 
-bool PackageManagerImpl::TryGetFileDigest(const PathName& prefix, const string& fileName, bool& haveDigest, MD5& digest)
+PathName PackageManagerImpl::GetInstallPrefix(const PackageInfo& packageInfo)
 {
-    string unprefixed;
-    if (!StripTeXMFPrefix(fileName, unprefixed))
-    {
-        return true;
-    }
-    PathName path = prefix;
-    path /= unprefixed;
-    if (!File::Exists(path))
-    {
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
-        return false;
-    }
-    if (path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
+    PathName prefix;
+
+    if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
     {
-        haveDigest = false;
+        prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
     }
-    else
+
+    if (prefix.Empty() && session->IsSharedSetup())
     {
-        digest = MD5::FromFile(path);
-        haveDigest = true;
+        prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
     }
-    return true;
+
+    return prefix;
 }
 
-bool PackageManagerImpl::TryCollectFileDigests(const PathName& prefix, const vector<string>& files, FileDigestTable& fileDigests)
+bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
 {
-    for (const string& fileName : files)
+    return VerifyInstalledPackagesNoLock({ packageId }, {}, false)[0].ok;
+}
+
+namespace {
+
+    struct VerificationRecord
     {
-        bool haveDigest;
+        size_t size;
+        time_t lastWriteTime;
         MD5 digest;
-        if (!TryGetFileDigest(prefix, fileName, haveDigest, digest))
+    };
+
+    typedef unordered_map<string, VerificationRecord, hash_path, equal_path> VerificationRecordTable;
+
+    struct FileToVerify
+    {
+        size_t packageIdx;
+        string fileName;
+        PathName path;
+        bool needDigest;
+        bool exists = false;
+        size_t size = 0;
+        time_t lastWriteTime = InvalidTimeT;
+        MD5 digest;
+    };
+
+    // record format: DIGEST TAB SIZE TAB LASTWRITETIME TAB PATH
+    VerificationRecordTable ReadVerificationRecords(const PathName& path)
+    {
+        VerificationRecordTable records;
+        if (!File::Exists(path))
         {
-            return false;
+            return records;
         }
-        if (haveDigest)
+        ifstream stream = File::CreateInputStream(path);
+        string line;
+        while (std::getline(stream, line))
         {
-            fileDigests[fileName] = digest;
+            string::size_type pos1 = line.find('\t');
+            string::size_type pos2 = pos1 == string::npos ? string::npos : line.find('\t', pos1 + 1);
+            string::size_type pos3 = pos2 == string::npos ? string::npos : line.find('\t', pos2 + 1);
+            if (pos3 == string::npos)
+            {
+                continue;
+            }
+            VerificationRecord record;
+            record.digest = MD5::Parse(line.substr(0, pos1));
+            record.size = Utils::ToSizeT(line.substr(pos1 + 1, pos2 - pos1 - 1));
+            record.lastWriteTime = Utils::ToTimeT(line.substr(pos2 + 1, pos3 - pos2 - 1));
+            records[line.substr(pos3 + 1)] = record;
         }
+        return records;
     }
-    return true;
+
+    void WriteVerificationRecords(const PathName& path, const VerificationRecordTable& records)
+    {
+        Directory::Create(path.GetDirectoryName());
+        PathName tempPath = path;
+        tempPath.AppendExtension(fmt::format(".{}.tmp", Process::GetCurrentProcess()->GetSystemId()));
+        {
+            ofstream stream = File::CreateOutputStream(tempPath);
+            for (const auto& kv : records)
+            {
+                stream << kv.second.digest.ToString() << '\t' << kv.second.size << '\t' << kv.second.lastWriteTime << '\t' << kv.first << '\n';
+            }
+            stream.close();
+        }
+        File::Move(tempPath, path, { FileMoveOption::ReplaceExisting });
+    }
+
 }
 
-bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+vector<PackageVerificationResult> PackageManagerImpl::VerifyInstalledPackagesNoLock(const vector<string>& packageIds, VerificationOptionSet options, bool updateRecords)
 {
-    PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+    unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "verifying installed packages");
 
-    PathName prefix;
+    vector<PackageVerificationResult> results;
+    vector<PackageInfo> packages;
+    vector<FileToVerify> files;
 
-    if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
+    for (const string& packageId : packageIds)
     {
-        prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+        PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+        PathName prefix = GetInstallPrefix(packageInfo);
+        for (const vector<string>* fileList : { &packageInfo.runFiles, &packageInfo.docFiles, &packageInfo.sourceFiles })
+        {
+            for (const string& fileName : *fileList)
+            {
+                string unprefixed;
+                if (!StripTeXMFPrefix(fileName, unprefixed))
+                {
+                    continue;
+                }
+                FileToVerify file;
+                file.packageIdx = packages.size();
+                file.fileName = fileName;
+                file.path = prefix / unprefixed;
+                file.needDigest = !file.path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX);
+                files.push_back(file);
+            }
+        }
+        PackageVerificationResult result;
+        result.packageId = packageId;
+        results.push_back(result);
+        packages.push_back(packageInfo);
     }
 
-    if (prefix.Empty() && session->IsSharedSetup())
+    PathName recordsPath = session->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_PACKAGE_VERIFICATION_RECORDS;
+    VerificationRecordTable records;
+    if (updateRecords || options[VerificationOption::UseFileTimes])
     {
-        prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+        try
+        {
+            records = ReadVerificationRecords(recordsPath);
+        }
+        catch (const MiKTeXException& e)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("ignoring {0}: {1}"), Q_(recordsPath), e.GetErrorMessage()));
+            records.clear();
+        }
     }
 
-    FileDigestTable fileDigests;
-
-    if (!TryCollectFileDigests(prefix, packageInfo.runFiles, fileDigests)
-        || !TryCollectFileDigests(prefix, packageInfo.docFiles, fileDigests)
-        || !TryCollectFileDigests(prefix, packageInfo.sourceFiles, fileDigests))
+    // verification is I/O latency bound: keep several reads in flight
+    atomic<size_t> nextFile(0);
+    atomic<size_t> numRehashed(0);
+    auto verifyFiles = [&]()
     {
-        return false;
+        size_t idx;
+        while ((idx = nextFile++) < files.size())
+        {
+            FileToVerify& file = files[idx];
+            file.exists = File::Exists(file.path);
+            if (!file.exists || !file.needDigest)
+            {
+                continue;
+            }
+            file.size = File::GetSize(file.path);
+            file.lastWriteTime = File::GetLastWriteTime(file.path);
+            if (options[VerificationOption::UseFileTimes])
+            {
+                auto it = records.find(file.path.ToString());
+                if (it != records.end() && it->second.size == file.size && it->second.lastWriteTime == file.lastWriteTime)
+                {
+                    file.digest = it->second.digest;
+                    continue;
+                }
+            }
+            file.digest = MD5::FromFile(file.path);
+            numRehashed++;
+        }
+    };
+    size_t numThreads = std::min<size_t>(std::max(thread::hardware_concurrency(), 1u) * 2, files.size());
+    vector<future<void>> futures;
+    for (size_t n = 1; n < numThreads; ++n)
+    {
+        futures.push_back(std::async(launch::async, verifyFiles));
+    }
+    verifyFiles();
+    for (future<void>& f : futures)
+    {
+        f.get();
     }
 
-    MD5Builder md5Builder;
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("verified {0} files ({1} rehashed)"), files.size(), numRehashed.load()));
 
-    for (const pair<string, MD5> p : fileDigests)
+    vector<FileDigestTable> fileDigests(packages.size());
+    for (const FileToVerify& file : files)
     {
-        PathName path(p.first);
-        // we must dosify the path name for backward compatibility
-        path.ConvertToDos();
-        md5Builder.Update(path.GetData(), path.GetLength());
-        md5Builder.Update(p.second.data(), p.second.size());
+        PackageVerificationResult& result = results[file.packageIdx];
+        if (!file.exists)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(file.path)));
+            result.missingFiles.push_back(file.fileName);
+            continue;
+        }
+        if (!file.needDigest)
+        {
+            continue;
+        }
+        fileDigests[file.packageIdx][file.fileName] = file.digest;
+        auto it = records.find(file.path.ToString());
+        if (it != records.end() && it->second.digest != file.digest)
+        {
+            result.modifiedFiles.push_back(file.fileName);
+        }
     }
 
-    bool ok = md5Builder.Final() == packageInfo.digest;
+    for (size_t idx = 0; idx < packages.size(); ++idx)
+    {
+        PackageVerificationResult& result = results[idx];
+        if (!result.missingFiles.empty())
+        {
+            continue;
+        }
+
+        MD5Builder md5Builder;
 
-    if (!ok)
+        for (const pair<string, MD5> p : fileDigests[idx])
+        {
+            PathName path(p.first);
+            // we must dosify the path name for backward compatibility
+            path.ConvertToDos();
+            md5Builder.Update(path.GetData(), path.GetLength());
+            md5Builder.Update(p.second.data(), p.second.size());
+        }
+
+        result.ok = md5Builder.Final() == packages[idx].digest;
+
+        if (!result.ok)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(result.packageId)));
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), packages[idx].digest.ToString()));
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5().ToString()));
+        }
+    }
+
+    if (updateRecords)
     {
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(packageId)));
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), packageInfo.digest.ToString()));
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5().ToString()));
+        // only record the state of correctly installed files; the records of
+        // the other files are kept, so that modifications can be reported
+        bool changed = false;
+        for (const FileToVerify& file : files)
+        {
+            if (file.needDigest && results[file.packageIdx].ok)
+            {
+                records[file.path.ToString()] = VerificationRecord{ file.size, file.lastWriteTime, file.digest };
+                changed = true;
+            }
+        }
+        if (changed)
+        {
+            try
+            {
+                WriteVerificationRecords(recordsPath, records);
+            }
+            catch (const MiKTeXException& e)
+            {
+                trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("cannot write {0}: {1}"), Q_(recordsPath), e.GetErrorMessage()));
+            }
+        }
     }
 
-    return ok;
+    return results;
 }
 
 string PackageManagerImpl::GetContainerPathNoLock(const string& packageId, bool useDisplayNames)
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief PackageManager implementation
  *
- * @copyright Copyright © 2001-2022 Christian Schenk
+ * @copyright Copyright © 2001-2024 Christian Schenk
  *
  * This file is part of MiKTeX Package Manager.
  *
@@ -140,6 +140,21 @@ public:
 
     bool MIKTEXTHISCALL TryVerifyInstalledPackageNoLock(const std::string& packageId);
 
+    std::vector<MiKTeX::Packages::PackageVerificationResult> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, MiKTeX::Packages::VerificationOptionSet options) override
+    {
+        if (!packageDataStore.LoadedAllPackageManifests())
+        {
+            MPM_LOCK_BEGIN(this)
+            {
+                packageDataStore.Load();
+            }
+            MPM_LOCK_END();
+        }
+        return VerifyInstalledPackagesNoLock(packageIds, options, true);
+    }
+
+    std::vector<MiKTeX::Packages::PackageVerificationResult> VerifyInstalledPackagesNoLock(const std::vector<std::string>& packageIds, MiKTeX::Packages::VerificationOptionSet options, bool updateRecords);
+
     std::string MIKTEXTHISCALL GetContainerPath(const std::string& packageId, bool useDisplayNames) override
     {
         if (!packageDataStore.LoadedAllPackageManifests())
@@ -155,6 +170,20 @@ public:
 
     std::string MIKTEXTHISCALL GetContainerPathNoLock(const std::string& packageId, bool useDisplayNames);
     InstallationSummary MIKTEXTHISCALL GetInstallationSummary(bool userScope) override;
+
+    std::vector<std::string> MIKTEXTHISCALL SearchPackages(const std::string& text, MiKTeX::Packages::PackageSearchFieldSet fields) override
+    {
+        if (!packageDataStore.LoadedAllPackageManifests())
+        {
+            MPM_LOCK_BEGIN(this)
+            {
+                packageDataStore.Load();
+            }
+            MPM_LOCK_END();
+        }
+        return packageDataStore.Search(text, fields);
+    }
+
     PackageManagerImpl(const MiKTeX::Packages::PackageManager::InitInfo& initInfo);
     void Lock(std::chrono::milliseconds timeout);
     void Unlock();
@@ -162,8 +191,7 @@ public:
 
 private:
 
-    bool TryGetFileDigest(const MiKTeX::Util::PathName& prefix, const std::string& fileName, bool& haveDigest, MiKTeX::Core::MD5& digest);
-    bool TryCollectFileDigests(const MiKTeX::Util::PathName& prefix, const std::vector<std::string>& files, FileDigestTable& fileDigests);
+    MiKTeX::Util::PathName GetInstallPrefix(const MiKTeX::Packages::PackageInfo& packageInfo);
     void Dispose();
 
     std::unique_ptr<MiKTeX::Core::LockFile> lockFile;
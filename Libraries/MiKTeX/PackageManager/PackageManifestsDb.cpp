@@ -0,0 +1,480 @@
+/**
+ * @file PackageManifestsDb.cpp
+ * @author Christian Schenk
+ * @brief Compiled package manifests
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+
+#include <miktex/Core/CacheFile>
+#include <miktex/Core/File>
+#include <miktex/Core/less_icase_dos>
+
+#include "internal.h"
+
+#include "PackageManifestsDb.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+constexpr char SIGNATURE[8] = { 'M', 'i', 'K', 'T', 'e', 'X', 'P', 'M' };
+
+// increment whenever the layout changes
+constexpr uint32_t VERSION = 1;
+
+struct PackageManifestsDb::Header
+{
+    char signature[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint32_t numSources;
+    uint32_t sourcesOffset;
+    uint32_t numPackages;
+    uint32_t packagesOffset;
+    uint32_t numFiles;
+    uint32_t filesOffset;
+    uint32_t fileHashSize;
+    uint32_t fileHashOffset;
+    uint32_t numRefs;
+    uint32_t refsOffset;
+    uint32_t stringsSize;
+    uint32_t stringsOffset;
+};
+
+struct PackageManifestsDb::SourceRecord
+{
+    uint32_t path;
+    uint32_t reserved;
+    uint64_t size;
+    int64_t lastWriteTime;
+};
+
+struct PackageManifestsDb::PackageRecord
+{
+    // string pool offsets
+    uint32_t id;
+    uint32_t displayName;
+    uint32_t creator;
+    uint32_t title;
+    uint32_t version;
+    uint32_t targetSystem;
+    uint32_t minTargetSystemVersion;
+    uint32_t description;
+    uint32_t ctanPath;
+    uint32_t copyrightOwner;
+    uint32_t copyrightYear;
+    uint32_t licenseType;
+    // ranges in the refs array: string pool offsets (required packages), file
+    // IDs (run, doc and source files)
+    uint32_t firstRequiredPackage;
+    uint32_t numRequiredPackages;
+    uint32_t firstRunFile;
+    uint32_t numRunFiles;
+    uint32_t firstDocFile;
+    uint32_t numDocFiles;
+    uint32_t firstSourceFile;
+    uint32_t numSourceFiles;
+    uint8_t digest[16];
+    uint64_t sizeRunFiles;
+    uint64_t sizeDocFiles;
+    uint64_t sizeSourceFiles;
+    int64_t timePackaged;
+};
+
+namespace {
+
+uint32_t HashPath(const PathName& path)
+{
+    return static_cast<uint32_t>(path.GetHash());
+}
+
+class Builder
+{
+public:
+
+    uint32_t AddString(const string& s)
+    {
+        if (s.empty())
+        {
+            return 0;
+        }
+        auto it = stringIndex.find(s);
+        if (it != stringIndex.end())
+        {
+            return it->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings.insert(strings.end(), s.begin(), s.end());
+        strings.push_back(0);
+        stringIndex.emplace(s, offset);
+        return offset;
+    }
+
+    uint32_t AddFile(const string& path)
+    {
+        auto it = fileIndex.find(path);
+        if (it != fileIndex.end())
+        {
+            return it->second;
+        }
+        uint32_t fileId = static_cast<uint32_t>(files.size());
+        files.push_back(AddString(path));
+        fileIndex.emplace(path, fileId);
+        return fileId;
+    }
+
+    void AddFiles(const vector<string>& paths, uint32_t& first, uint32_t& num)
+    {
+        first = static_cast<uint32_t>(refs.size());
+        num = static_cast<uint32_t>(paths.size());
+        for (const string& path : paths)
+        {
+            refs.push_back(AddFile(path));
+        }
+    }
+
+    // offset 0 is the empty string
+    vector<char> strings = { 0 };
+    unordered_map<string, uint32_t> stringIndex;
+    vector<uint32_t> files;
+    unordered_map<string, uint32_t, hash_path, equal_path> fileIndex;
+    vector<uint32_t> refs;
+};
+
+template<typename T> uint32_t Append(vector<unsigned char>& buf, const T* data, size_t count)
+{
+    // keep all sections 8-byte aligned
+    buf.resize((buf.size() + 7) & ~static_cast<size_t>(7));
+    uint32_t offset = static_cast<uint32_t>(buf.size());
+    if (count > 0)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        buf.insert(buf.end(), bytes, bytes + count * sizeof(T));
+    }
+    return offset;
+}
+
+}
+
+PackageManifestsDb::PackageManifestsDb()
+{
+}
+
+PackageManifestsDb::~PackageManifestsDb()
+{
+    try
+    {
+        Close();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+bool PackageManifestsDb::Create(const PathName& path, const vector<PathName>& sources, Cfg& cfg)
+{
+    for (const PathName& source : sources)
+    {
+        if (!CacheFile::IsSettled(source))
+        {
+            return false;
+        }
+    }
+
+    vector<string> packageIds;
+    for (const auto& key : cfg)
+    {
+        packageIds.push_back(key->GetName());
+    }
+    // records are sorted so that FindPackage() can do a binary search;
+    // stable_sort() + unique(): the first definition wins
+    stable_sort(packageIds.begin(), packageIds.end(), less_icase_dos());
+    packageIds.erase(unique(packageIds.begin(), packageIds.end(), [](const string& a, const string& b) { return Utils::EqualsIgnoreCase(a, b); }), packageIds.end());
+
+    Builder builder;
+
+    vector<SourceRecord> sourceRecords;
+    for (const PathName& source : sources)
+    {
+        SourceRecord rec{};
+        rec.path = builder.AddString(source.ToString());
+        rec.size = File::GetSize(source);
+        rec.lastWriteTime = File::GetLastWriteTime(source);
+        sourceRecords.push_back(rec);
+    }
+
+    vector<PackageRecord> packageRecords;
+    packageRecords.reserve(packageIds.size());
+    for (const string& packageId : packageIds)
+    {
+        PackageInfo packageInfo = PackageManager::GetPackageManifest(cfg, packageId, TEXMF_PREFIX_DIRECTORY);
+        PackageRecord rec{};
+        rec.id = builder.AddString(packageInfo.id);
+        rec.displayName = builder.AddString(packageInfo.displayName);
+        rec.creator = builder.AddString(packageInfo.creator);
+        rec.title = builder.AddString(packageInfo.title);
+        rec.version = builder.AddString(packageInfo.version);
+        rec.targetSystem = builder.AddString(packageInfo.targetSystem);
+        rec.minTargetSystemVersion = builder.AddString(packageInfo.minTargetSystemVersion);
+        rec.description = builder.AddString(packageInfo.description);
+        rec.ctanPath = builder.AddString(packageInfo.ctanPath);
+        rec.copyrightOwner = builder.AddString(packageInfo.copyrightOwner);
+        rec.copyrightYear = builder.AddString(packageInfo.copyrightYear);
+        rec.licenseType = builder.AddString(packageInfo.licenseType);
+        rec.firstRequiredPackage = static_cast<uint32_t>(builder.refs.size());
+        rec.numRequiredPackages = static_cast<uint32_t>(packageInfo.requiredPackages.size());
+        for (const string& req : packageInfo.requiredPackages)
+        {
+            builder.refs.push_back(builder.AddString(req));
+        }
+        builder.AddFiles(packageInfo.runFiles, rec.firstRunFile, rec.numRunFiles);
+        builder.AddFiles(packageInfo.docFiles, rec.firstDocFile, rec.numDocFiles);
+        builder.AddFiles(packageInfo.sourceFiles, rec.firstSourceFile, rec.numSourceFiles);
+        memcpy(rec.digest, packageInfo.digest.data(), sizeof(rec.digest));
+        rec.sizeRunFiles = packageInfo.sizeRunFiles;
+        rec.sizeDocFiles = packageInfo.sizeDocFiles;
+        rec.sizeSourceFiles = packageInfo.sizeSourceFiles;
+        rec.timePackaged = packageInfo.timePackaged;
+        packageRecords.push_back(rec);
+    }
+
+    // open addressing hash table: file path -> file ID
+    uint32_t fileHashSize = 16;
+    while (fileHashSize < builder.files.size() * 2)
+    {
+        fileHashSize *= 2;
+    }
+    vector<uint32_t> fileHash(fileHashSize, npos);
+    for (uint32_t fileId = 0; fileId < builder.files.size(); ++fileId)
+    {
+        uint32_t slot = HashPath(PathName(&builder.strings[builder.files[fileId]])) & (fileHashSize - 1);
+        while (fileHash[slot] != npos)
+        {
+            slot = (slot + 1) & (fileHashSize - 1);
+        }
+        fileHash[slot] = fileId;
+    }
+
+    Header header{};
+    memcpy(header.signature, SIGNATURE, sizeof(header.signature));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    vector<unsigned char> buf;
+    Append(buf, &header, 1);
+    header.numSources = static_cast<uint32_t>(sourceRecords.size());
+    header.sourcesOffset = Append(buf, sourceRecords.data(), sourceRecords.size());
+    header.numPackages = static_cast<uint32_t>(packageRecords.size());
+    header.packagesOffset = Append(buf, packageRecords.data(), packageRecords.size());
+    header.numFiles = static_cast<uint32_t>(builder.files.size());
+    header.filesOffset = Append(buf, builder.files.data(), builder.files.size());
+    header.fileHashSize = fileHashSize;
+    header.fileHashOffset = Append(buf, fileHash.data(), fileHash.size());
+    header.numRefs = static_cast<uint32_t>(builder.refs.size());
+    header.refsOffset = Append(buf, builder.refs.data(), builder.refs.size());
+    header.stringsSize = static_cast<uint32_t>(builder.strings.size());
+    header.stringsOffset = Append(buf, builder.strings.data(), builder.strings.size());
+    header.fileSize = buf.size();
+    memcpy(buf.data(), &header, sizeof(header));
+
+    CacheFile::Write(path, buf);
+    return true;
+}
+
+bool PackageManifestsDb::TryOpen(const PathName& path, const vector<PathName>& sources)
+{
+    Close();
+    if (!File::Exists(path) || File::GetSize(path) < sizeof(Header))
+    {
+        return false;
+    }
+    mmap.reset(MemoryMappedFile::Create());
+    const Header* hdr = reinterpret_cast<const Header*>(mmap->Open(path, false));
+    if (memcmp(hdr->signature, SIGNATURE, sizeof(hdr->signature)) != 0
+        || hdr->version != VERSION
+        || hdr->headerSize != sizeof(Header)
+        || hdr->fileSize != mmap->GetSize()
+        || hdr->numSources != sources.size())
+    {
+        mmap->Close();
+        mmap = nullptr;
+        return false;
+    }
+    header = hdr;
+    const SourceRecord* sourceRecords = reinterpret_cast<const SourceRecord*>(reinterpret_cast<const char*>(header) + header->sourcesOffset);
+    for (size_t idx = 0; idx < sources.size(); ++idx)
+    {
+        const SourceRecord& rec = sourceRecords[idx];
+        if (!PathName::Equals(PathName(GetString(rec.path)), sources[idx])
+            || !CacheFile::IsUnchanged(sources[idx], rec.size, rec.lastWriteTime))
+        {
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PackageManifestsDb::Close()
+{
+    header = nullptr;
+    if (mmap != nullptr)
+    {
+        mmap->Close();
+        mmap = nullptr;
+    }
+}
+
+uint32_t PackageManifestsDb::GetNumberOfPackages() const
+{
+    MIKTEX_EXPECT(header != nullptr);
+    return header->numPackages;
+}
+
+uint32_t PackageManifestsDb::FindPackage(const string& packageId) const
+{
+    MIKTEX_EXPECT(header != nullptr);
+    uint32_t lo = 0;
+    uint32_t hi = header->numPackages;
+    less_icase_dos less;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        string id = GetString(GetPackageRecord(mid).id);
+        if (less(id, packageId))
+        {
+            lo = mid + 1;
+        }
+        else if (less(packageId, id))
+        {
+            hi = mid;
+        }
+        else
+        {
+            return mid;
+        }
+    }
+    return npos;
+}
+
+PackageInfo PackageManifestsDb::GetPackageManifest(uint32_t idx) const
+{
+    const PackageRecord& rec = GetPackageRecord(idx);
+    PackageInfo packageInfo;
+    packageInfo.id = GetString(rec.id);
+    packageInfo.displayName = GetString(rec.displayName);
+    packageInfo.creator = GetString(rec.creator);
+    packageInfo.title = GetString(rec.title);
+    packageInfo.version = GetString(rec.version);
+    packageInfo.targetSystem = GetString(rec.targetSystem);
+    packageInfo.minTargetSystemVersion = GetString(rec.minTargetSystemVersion);
+    packageInfo.description = GetString(rec.description);
+    packageInfo.ctanPath = GetString(rec.ctanPath);
+    packageInfo.copyrightOwner = GetString(rec.copyrightOwner);
+    packageInfo.copyrightYear = GetString(rec.copyrightYear);
+    packageInfo.licenseType = GetString(rec.licenseType);
+    const uint32_t* requiredPackages = GetRefs(rec.firstRequiredPackage);
+    for (uint32_t n = 0; n < rec.numRequiredPackages; ++n)
+    {
+        packageInfo.requiredPackages.push_back(GetString(requiredPackages[n]));
+    }
+    memcpy(packageInfo.digest.data(), rec.digest, sizeof(rec.digest));
+    packageInfo.sizeRunFiles = static_cast<size_t>(rec.sizeRunFiles);
+    packageInfo.sizeDocFiles = static_cast<size_t>(rec.sizeDocFiles);
+    packageInfo.sizeSourceFiles = static_cast<size_t>(rec.sizeSourceFiles);
+    packageInfo.timePackaged = static_cast<time_t>(rec.timePackaged);
+    return packageInfo;
+}
+
+size_t PackageManifestsDb::GetNumberOfFiles(uint32_t idx) const
+{
+    const PackageRecord& rec = GetPackageRecord(idx);
+    return static_cast<size_t>(rec.numRunFiles) + rec.numDocFiles + rec.numSourceFiles;
+}
+
+void PackageManifestsDb::GetFiles(uint32_t idx, PackageInfo& packageInfo) const
+{
+    const PackageRecord& rec = GetPackageRecord(idx);
+    const uint32_t* files = reinterpret_cast<const uint32_t*>(reinterpret_cast<const char*>(header) + header->filesOffset);
+    auto get = [this, files](uint32_t first, uint32_t num, vector<string>& result)
+    {
+        const uint32_t* fileIds = GetRefs(first);
+        result.clear();
+        result.reserve(num);
+        for (uint32_t n = 0; n < num; ++n)
+        {
+            result.push_back(GetString(files[fileIds[n]]));
+        }
+    };
+    get(rec.firstRunFile, rec.numRunFiles, packageInfo.runFiles);
+    get(rec.firstDocFile, rec.numDocFiles, packageInfo.docFiles);
+    get(rec.firstSourceFile, rec.numSourceFiles, packageInfo.sourceFiles);
+}
+
+vector<uint32_t> PackageManifestsDb::GetFileIds(uint32_t idx) const
+{
+    const PackageRecord& rec = GetPackageRecord(idx);
+    vector<uint32_t> result;
+    result.reserve(GetNumberOfFiles(idx));
+    result.insert(result.end(), GetRefs(rec.firstRunFile), GetRefs(rec.firstRunFile) + rec.numRunFiles);
+    result.insert(result.end(), GetRefs(rec.firstDocFile), GetRefs(rec.firstDocFile) + rec.numDocFiles);
+    result.insert(result.end(), GetRefs(rec.firstSourceFile), GetRefs(rec.firstSourceFile) + rec.numSourceFiles);
+    return result;
+}
+
+uint32_t PackageManifestsDb::GetNumberOfFileIds() const
+{
+    MIKTEX_EXPECT(header != nullptr);
+    return header->numFiles;
+}
+
+uint32_t PackageManifestsDb::FindFile(const PathName& path) const
+{
+    MIKTEX_EXPECT(header != nullptr);
+    const uint32_t* files = reinterpret_cast<const uint32_t*>(reinterpret_cast<const char*>(header) + header->filesOffset);
+    const uint32_t* fileHash = reinterpret_cast<const uint32_t*>(reinterpret_cast<const char*>(header) + header->fileHashOffset);
+    uint32_t mask = header->fileHashSize - 1;
+    for (uint32_t slot = HashPath(path) & mask; fileHash[slot] != npos; slot = (slot + 1) & mask)
+    {
+        if (PathName::Equals(PathName(GetString(files[fileHash[slot]])), path))
+        {
+            return fileHash[slot];
+        }
+    }
+    return npos;
+}
+
+const char* PackageManifestsDb::GetString(uint32_t offset) const
+{
+    MIKTEX_EXPECT(offset < header->stringsSize);
+    return reinterpret_cast<const char*>(header) + header->stringsOffset + offset;
+}
+
+const PackageManifestsDb::PackageRecord& PackageManifestsDb::GetPackageRecord(uint32_t idx) const
+{
+    MIKTEX_EXPECT(header != nullptr && idx < header->numPackages);
+    return reinterpret_cast<const PackageRecord*>(reinterpret_cast<const char*>(header) + header->packagesOffset)[idx];
+}
+
+const uint32_t* PackageManifestsDb::GetRefs(uint32_t first) const
+{
+    MIKTEX_EXPECT(first <= header->numRefs);
+    return reinterpret_cast<const uint32_t*>(reinterpret_cast<const char*>(header) + header->refsOffset) + first;
+}
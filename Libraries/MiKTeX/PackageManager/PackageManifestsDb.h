@@ -0,0 +1,147 @@
+/**
+ * @file PackageManifestsDb.h
+ * @author Christian Schenk
+ * @brief Compiled package manifests
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Cfg>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Util/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief A compiled, memory-mapped form of `package-manifests.ini`.
+ *
+ * The database file contains:
+ * - the package records, sorted by package ID (so that they double as the
+ *   package ID index)
+ * - an interned table of all file paths together with a hash index
+ * - per package, the IDs of its run, doc and source files
+ * - the size and modification time of the INI files it was compiled from
+ *
+ * The database is stale as soon as one of the INI files changes. It is a
+ * local cache: it uses the native byte order and is recreated whenever it
+ * does not match the running program.
+ */
+class PackageManifestsDb
+{
+public:
+
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+    PackageManifestsDb();
+
+    ~PackageManifestsDb();
+
+    /**
+     * @brief Compiles package manifests into a database file.
+     * @param path Path to the database file.
+     * @param sources The INI files `cfg` was read from.
+     * @param cfg The package manifests.
+     * @return Returns `false`, if the database was not written, because one of
+     * the sources was modified too recently.
+     */
+    static bool Create(const MiKTeX::Util::PathName& path, const std::vector<MiKTeX::Util::PathName>& sources, MiKTeX::Core::Cfg& cfg);
+
+    /**
+     * @brief Maps a database file into memory.
+     * @param path Path to the database file.
+     * @param sources The INI files the database must have been compiled from.
+     * @return Returns `false`, if the database does not exist, is not
+     * compatible or is stale.
+     */
+    bool TryOpen(const MiKTeX::Util::PathName& path, const std::vector<MiKTeX::Util::PathName>& sources);
+
+    void Close();
+
+    bool IsOpen() const
+    {
+        return header != nullptr;
+    }
+
+    std::uint32_t GetNumberOfPackages() const;
+
+    /**
+     * @brief Looks up a package record.
+     * @param packageId The package ID.
+     * @return Returns the index of the package record or `npos`.
+     */
+    std::uint32_t FindPackage(const std::string& packageId) const;
+
+    /**
+     * @brief Gets a package manifest without file lists.
+     * @param idx The index of the package record.
+     * @return Returns the package manifest.
+     */
+    MiKTeX::Packages::PackageInfo GetPackageManifest(std::uint32_t idx) const;
+
+    /**
+     * @brief Gets the number of files of a package.
+     * @param idx The index of the package record.
+     * @return Returns the number of run, doc and source files.
+     */
+    std::size_t GetNumberOfFiles(std::uint32_t idx) const;
+
+    /**
+     * @brief Fills in the file lists of a package manifest.
+     * @param idx The index of the package record.
+     * @param packageInfo The package manifest.
+     */
+    void GetFiles(std::uint32_t idx, MiKTeX::Packages::PackageInfo& packageInfo) const;
+
+    /**
+     * @brief Gets the file IDs of a package.
+     * @param idx The index of the package record.
+     * @return Returns the IDs of all run, doc and source files.
+     */
+    std::vector<std::uint32_t> GetFileIds(std::uint32_t idx) const;
+
+    /**
+     * @brief Gets the number of interned file paths.
+     * @return Returns the number of file IDs.
+     */
+    std::uint32_t GetNumberOfFileIds() const;
+
+    /**
+     * @brief Looks up a file path.
+     * @param path The file path.
+     * @return Returns the file ID or `npos`.
+     */
+    std::uint32_t FindFile(const MiKTeX::Util::PathName& path) const;
+
+public:
+
+    struct Header;
+    struct PackageRecord;
+    struct SourceRecord;
+
+private:
+
+    const char* GetString(std::uint32_t offset) const;
+    const PackageRecord& GetPackageRecord(std::uint32_t idx) const;
+    const std::uint32_t* GetRefs(std::uint32_t first) const;
+
+    const Header* header = nullptr;
+    std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mmap;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,196 @@
+/**
+ * @file PackageSearchIndex.cpp
+ * @author Christian Schenk
+ * @brief Package search index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <miktex/Util/PathName>
+
+#include "internal.h"
+
+#include "PackageSearchIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+static string ToLower(const string& s)
+{
+    string result = s;
+    for (char& ch : result)
+    {
+        if (ch >= 'A' && ch <= 'Z')
+        {
+            ch = ch - 'A' + 'a';
+        }
+    }
+    return result;
+}
+
+static uint32_t MakeTrigram(const char* s)
+{
+    return (static_cast<uint32_t>(static_cast<unsigned char>(s[0])) << 16)
+        | (static_cast<uint32_t>(static_cast<unsigned char>(s[1])) << 8)
+        | static_cast<uint32_t>(static_cast<unsigned char>(s[2]));
+}
+
+void PackageSearchIndex::Add(const PackageInfo& packageInfo)
+{
+    uint32_t idx = static_cast<uint32_t>(entries.size());
+    Entry entry;
+    entry.packageId = packageInfo.id;
+    entry.texts[static_cast<size_t>(PackageSearchField::Id)] = ToLower(packageInfo.id);
+    entry.texts[static_cast<size_t>(PackageSearchField::Title)] = ToLower(packageInfo.title);
+    entry.texts[static_cast<size_t>(PackageSearchField::Description)] = ToLower(packageInfo.description);
+    for (const string& file : packageInfo.runFiles)
+    {
+        entry.fileNames.push_back(PathName(file).GetFileName().ToString());
+    }
+    AddTrigrams(PackageSearchField::Id, entry.texts[static_cast<size_t>(PackageSearchField::Id)], idx);
+    AddTrigrams(PackageSearchField::Title, entry.texts[static_cast<size_t>(PackageSearchField::Title)], idx);
+    AddTrigrams(PackageSearchField::Description, entry.texts[static_cast<size_t>(PackageSearchField::Description)], idx);
+    for (const string& fileName : entry.fileNames)
+    {
+        AddTrigrams(PackageSearchField::FileName, ToLower(fileName), idx);
+    }
+    entries.push_back(std::move(entry));
+}
+
+void PackageSearchIndex::AddTrigrams(PackageSearchField field, const string& text, uint32_t idx)
+{
+    PostingsTable& table = postings[static_cast<size_t>(field)];
+    for (size_t pos = 0; pos + 3 <= text.length(); ++pos)
+    {
+        // entries are added in ascending order: the lists stay sorted
+        vector<uint32_t>& list = table[MakeTrigram(text.c_str() + pos)];
+        if (list.empty() || list.back() != idx)
+        {
+            list.push_back(idx);
+        }
+    }
+}
+
+bool PackageSearchIndex::TryGetCandidates(PackageSearchField field, const vector<string>& literals, vector<uint32_t>& candidates) const
+{
+    const PostingsTable& table = postings[static_cast<size_t>(field)];
+    bool haveTrigrams = false;
+    for (const string& literal : literals)
+    {
+        for (size_t pos = 0; pos + 3 <= literal.length(); ++pos)
+        {
+            auto it = table.find(MakeTrigram(literal.c_str() + pos));
+            if (it == table.end())
+            {
+                candidates.clear();
+                return true;
+            }
+            if (!haveTrigrams)
+            {
+                candidates = it->second;
+                haveTrigrams = true;
+            }
+            else
+            {
+                vector<uint32_t> intersection;
+                set_intersection(candidates.begin(), candidates.end(), it->second.begin(), it->second.end(), back_inserter(intersection));
+                candidates = std::move(intersection);
+            }
+            if (candidates.empty())
+            {
+                return true;
+            }
+        }
+    }
+    return haveTrigrams;
+}
+
+bool PackageSearchIndex::IsMatch(const Entry& entry, PackageSearchField field, const string& text, const string& lowerText) const
+{
+    if (field == PackageSearchField::FileName)
+    {
+        for (const string& fileName : entry.fileNames)
+        {
+            if (PathName::Match(text, PathName(fileName)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    return entry.texts[static_cast<size_t>(field)].find(lowerText) != string::npos;
+}
+
+vector<string> PackageSearchIndex::Search(const string& text, PackageSearchFieldSet fields) const
+{
+    string lowerText = ToLower(text);
+    vector<bool> matches(entries.size());
+    for (PackageSearchField field : { PackageSearchField::Id, PackageSearchField::Title, PackageSearchField::Description, PackageSearchField::FileName })
+    {
+        if (!fields[field])
+        {
+            continue;
+        }
+        vector<string> literals;
+        if (field == PackageSearchField::FileName)
+        {
+            // the parts between wildcards
+            size_t start = 0;
+            size_t end;
+            while ((end = lowerText.find_first_of("*?", start)) != string::npos)
+            {
+                literals.push_back(lowerText.substr(start, end - start));
+                start = end + 1;
+            }
+            literals.push_back(lowerText.substr(start));
+        }
+        else
+        {
+            literals.push_back(lowerText);
+        }
+        vector<uint32_t> candidates;
+        if (TryGetCandidates(field, literals, candidates))
+        {
+            for (uint32_t idx : candidates)
+            {
+                if (!matches[idx] && IsMatch(entries[idx], field, text, lowerText))
+                {
+                    matches[idx] = true;
+                }
+            }
+        }
+        else
+        {
+            for (size_t idx = 0; idx < entries.size(); ++idx)
+            {
+                if (!matches[idx] && IsMatch(entries[idx], field, text, lowerText))
+                {
+                    matches[idx] = true;
+                }
+            }
+        }
+    }
+    vector<string> result;
+    for (size_t idx = 0; idx < entries.size(); ++idx)
+    {
+        if (matches[idx])
+        {
+            result.push_back(entries[idx].packageId);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file PackageSearchIndex.h
+ * @author Christian Schenk
+ * @brief Package search index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/PackageManager/PackageManager>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief A trigram index over package IDs, titles, descriptions and the names
+ * of run-time files.
+ *
+ * The index yields candidates which contain all trigrams of the search text.
+ * The candidates are then checked against the indexed text. Search texts
+ * shorter than three characters degrade to a scan of the indexed text, which
+ * is still much cheaper than iterating package records.
+ */
+class PackageSearchIndex
+{
+public:
+
+    /**
+     * @brief Adds a package record to the index.
+     * @param packageInfo The package record (including the file lists).
+     */
+    void Add(const MiKTeX::Packages::PackageInfo& packageInfo);
+
+    /**
+     * @brief Searches the index.
+     * @param text The search text.
+     * @param fields The fields to be searched.
+     * @return Returns the IDs of the matching packages.
+     */
+    std::vector<std::string> Search(const std::string& text, MiKTeX::Packages::PackageSearchFieldSet fields) const;
+
+private:
+
+    static constexpr std::size_t NUM_FIELDS = 4;
+
+    struct Entry
+    {
+        std::string packageId;
+        /// Lower-case ID, title and description.
+        std::array<std::string, NUM_FIELDS - 1> texts;
+        /// File names (without directories).
+        std::vector<std::string> fileNames;
+    };
+
+    typedef std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> PostingsTable;
+
+    void AddTrigrams(MiKTeX::Packages::PackageSearchField field, const std::string& text, std::uint32_t idx);
+
+    bool TryGetCandidates(MiKTeX::Packages::PackageSearchField field, const std::vector<std::string>& literals, std::vector<std::uint32_t>& candidates) const;
+
+    bool IsMatch(const Entry& entry, MiKTeX::Packages::PackageSearchField field, const std::string& text, const std::string& lowerText) const;
+
+    std::vector<Entry> entries;
+    std::array<PostingsTable, NUM_FIELDS> postings;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
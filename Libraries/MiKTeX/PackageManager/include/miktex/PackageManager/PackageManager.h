@@ -1,6 +1,6 @@
 /* miktex/PackageManager/PackageManager.h:              -*- C++ -*-
 
-   Copyright (C) 2001-2020 Christian Schenk
+   Copyright (C) 2001-2024 Christian Schenk
 
    This file is part of MiKTeX Package Manager.
 
@@ -35,6 +35,7 @@
 #include <vector>
 
 #include <miktex/Core/Cfg>
+#include <miktex/Util/OptionSet>
 #include <miktex/Util/PathName>
 
 #include <miktex/Trace/TraceCallback>
@@ -72,6 +73,44 @@ struct InstallationSummary
   std::size_t packageCount = 0;
 };
 
+/// Package verification options.
+enum class VerificationOption
+{
+  /// Do not rehash files whose size and modification time have not changed
+  /// since the last verification.
+  UseFileTimes,
+};
+
+typedef MiKTeX::Util::OptionSet<VerificationOption> VerificationOptionSet;
+
+/// Package search fields.
+enum class PackageSearchField
+{
+  /// The package ID.
+  Id,
+  /// The package title.
+  Title,
+  /// The package description.
+  Description,
+  /// The names of the run-time files.
+  FileName,
+};
+
+typedef MiKTeX::Util::OptionSet<PackageSearchField> PackageSearchFieldSet;
+
+/// Package verification result.
+struct PackageVerificationResult
+{
+  /// Package ID.
+  std::string packageId;
+  /// `true`, if the package is correctly installed.
+  bool ok = false;
+  /// Files which do not exist.
+  std::vector<std::string> missingFiles;
+  /// Files which have been modified since the last successful verification.
+  std::vector<std::string> modifiedFiles;
+};
+
 /// The package manager interface.
 class MIKTEXNOVTABLE PackageManager
 {
@@ -188,6 +227,32 @@ public:
 public:
   virtual InstallationSummary MIKTEXTHISCALL GetInstallationSummary(bool userScope) = 0;
 
+  /// @brief Verifies installed packages.
+  ///
+  /// The files of all packages are hashed in parallel. The digests of
+  /// correctly installed files are recorded, so that the next verification
+  /// can skip unchanged files (see `VerificationOption::UseFileTimes`).
+  ///
+  /// @param packageIds Identifies the packages.
+  /// @param options Verification options.
+  /// @return Returns one result per package.
+public:
+  virtual std::vector<PackageVerificationResult> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, VerificationOptionSet options) = 0;
+
+  /// @brief Searches the package database.
+  ///
+  /// A package matches, if its ID, title or description contains the search
+  /// text (ignoring case), or if the name of one of its run-time files
+  /// matches the search text (wildcards allowed). The search index is built
+  /// on first use and lives as long as the loaded package database.
+  ///
+  /// @param text The search text.
+  /// @param fields The fields to be searched.
+  /// @return Returns the IDs of the matching packages (in no particular
+  /// order).
+public:
+  virtual std::vector<std::string> MIKTEXTHISCALL SearchPackages(const std::string& text, PackageSearchFieldSet fields) = 0;
+
 public:
   /// Initialization options.
   struct InitInfo
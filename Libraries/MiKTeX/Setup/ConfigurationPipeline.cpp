@@ -0,0 +1,146 @@
+/**
+ * @file ConfigurationPipeline.cpp
+ * @author Christian Schenk
+ * @brief Post-install configuration steps
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Setup Library.
+ *
+ * The MiKTeX Setup Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "internal.h"
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Setup;
+
+void ConfigurationPipeline::Add(const string& name, const vector<string>& dependencies, Action action)
+{
+    MIKTEX_ASSERT(!Has(name));
+    Step step;
+    step.name = name;
+    for (const string& dep : dependencies)
+    {
+        auto it = find_if(steps.begin(), steps.end(), [&dep](const Step& s) { return s.name == dep; });
+        if (it == steps.end())
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        step.dependencies.push_back(it - steps.begin());
+    }
+    step.action = action;
+    steps.push_back(step);
+}
+
+bool ConfigurationPipeline::Has(const string& name) const
+{
+    return find_if(steps.begin(), steps.end(), [&name](const Step& s) { return s.name == name; }) != steps.end();
+}
+
+void ConfigurationPipeline::Run(unsigned maxJobs, function<bool()> shouldStop, function<void(const ConfigurationStepResult&)> onFinished)
+{
+    enum class State { Waiting, Running, Finished };
+    vector<State> states(steps.size(), State::Waiting);
+    vector<ConfigurationStepResult> results(steps.size());
+    mutex finishedMutex;
+    condition_variable finishedCondition;
+    vector<size_t> finishedSteps;
+    vector<thread> workers;
+    unsigned numRunning = 0;
+    bool stop = false;
+    exception_ptr error;
+    auto pipelineStart = steady_clock::now();
+    maxJobs = max(maxJobs, 1u);
+    while (true)
+    {
+        // start the steps whose dependencies have finished
+        for (size_t idx = 0; !stop && error == nullptr && numRunning < maxJobs && idx < steps.size(); ++idx)
+        {
+            if (states[idx] != State::Waiting
+                || any_of(steps[idx].dependencies.begin(), steps[idx].dependencies.end(), [&states](size_t dep) { return states[dep] != State::Finished; }))
+            {
+                continue;
+            }
+            states[idx] = State::Running;
+            numRunning++;
+            results[idx].name = steps[idx].name;
+            results[idx].startTime = duration_cast<milliseconds>(steady_clock::now() - pipelineStart);
+            workers.push_back(thread([this, idx, &results, &finishedMutex, &finishedCondition, &finishedSteps]()
+            {
+                ConfigurationStepResult& result = results[idx];
+                auto stepStart = steady_clock::now();
+                try
+                {
+                    steps[idx].action(result);
+                }
+                catch (const MiKTeXException& e)
+                {
+                    result.failed = true;
+                    result.exception = e;
+                }
+                catch (const exception& e)
+                {
+                    result.failed = true;
+                    result.exception = MiKTeXException(e.what());
+                }
+                result.duration = duration_cast<milliseconds>(steady_clock::now() - stepStart);
+                {
+                    lock_guard<mutex> lock(finishedMutex);
+                    finishedSteps.push_back(idx);
+                }
+                finishedCondition.notify_one();
+            }));
+        }
+        if (numRunning == 0)
+        {
+            break;
+        }
+        vector<size_t> finished;
+        {
+            unique_lock<mutex> lock(finishedMutex);
+            finishedCondition.wait(lock, [&finishedSteps]() { return !finishedSteps.empty(); });
+            finished.swap(finishedSteps);
+        }
+        for (size_t idx : finished)
+        {
+            states[idx] = State::Finished;
+            numRunning--;
+            if (error == nullptr)
+            {
+                try
+                {
+                    onFinished(results[idx]);
+                }
+                catch (...)
+                {
+                    error = current_exception();
+                }
+            }
+        }
+        if (!stop && shouldStop())
+        {
+            stop = true;
+        }
+    }
+    for (thread& t : workers)
+    {
+        t.join();
+    }
+    if (error != nullptr)
+    {
+        rethrow_exception(error);
+    }
+}
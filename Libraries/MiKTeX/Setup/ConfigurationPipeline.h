@@ -0,0 +1,81 @@
+/**
+ * @file ConfigurationPipeline.h
+ * @author Christian Schenk
+ * @brief Post-install configuration steps
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of the MiKTeX Setup Library.
+ *
+ * The MiKTeX Setup Library is licensed under GNU General Public License version
+ * 2 or any later version.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Exceptions>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+/// The outcome of a configuration step.
+struct ConfigurationStepResult
+{
+    std::string name;
+    /// What has been done (e.g. the command line).
+    std::string description;
+    bool failed = false;
+    /// Valid, if `failed` is `true`.
+    MiKTeX::Core::MiKTeXException exception;
+    /// Time elapsed since the pipeline was started.
+    std::chrono::milliseconds startTime{ 0 };
+    std::chrono::milliseconds duration{ 0 };
+};
+
+/// Configuration steps and the dependencies between them.
+///
+/// A step can start when all steps it depends on have finished. Steps which
+/// can start run concurrently on worker threads. A step must neither use the
+/// session nor write to the setup log; it may forward output to the setup
+/// callback, provided that the calls are serialized.
+class ConfigurationPipeline
+{
+
+public:
+
+    typedef std::function<void(ConfigurationStepResult& result)> Action;
+
+    /// Adds a step.
+    /// @param name The name of the step.
+    /// @param dependencies Names of steps which have been added before.
+    /// @param action The work to be done.
+    void Add(const std::string& name, const std::vector<std::string>& dependencies, Action action);
+
+    bool Has(const std::string& name) const;
+
+    /// Runs the steps.
+    /// @param maxJobs The maximum number of steps running at the same time.
+    /// @param shouldStop Called on the calling thread; no more steps are
+    /// started, if it returns `true`.
+    /// @param onFinished Called on the calling thread for each finished step.
+    /// If it throws, no more steps are started; the exception is rethrown as
+    /// soon as the running steps have finished.
+    void Run(unsigned maxJobs, std::function<bool()> shouldStop, std::function<void(const ConfigurationStepResult&)> onFinished);
+
+private:
+
+    struct Step
+    {
+        std::string name;
+        std::vector<size_t> dependencies;
+        Action action;
+    };
+
+    std::vector<Step> steps;
+};
+
+END_INTERNAL_NAMESPACE;
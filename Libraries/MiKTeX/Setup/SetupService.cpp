@@ -1365,56 +1365,69 @@ void SetupServiceImpl::ConfigureMiKTeX()
         {
             args.push_back(fmt::format("--set-config-value=[{}]{}={}", MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_USERLINKTARGETDIRECTORY, options.UserLinkTargetDirectory.ToString()));
         }
+    }
+
+    // the configuration steps: independent steps run concurrently
+    ConfigurationPipeline pipeline;
+    set<string> essentialSteps;
+    auto initexmf = [this](const vector<string>& arguments)
+    {
+        PathName exePath;
+        vector<string> allArgs = MakeIniTeXMFCommandLine(arguments, exePath);
+        return MakeProcessAction(exePath, allArgs);
+    };
+    auto oneMiKTeXUtility = [this](const vector<string>& arguments)
+    {
+        PathName exePath;
+        vector<string> allArgs = MakeOneMiKTeXUtilityCommandLine(arguments, exePath);
+        return MakeProcessAction(exePath, allArgs);
+    };
+    auto existing = [&pipeline](const vector<string>& names)
+    {
+        vector<string> result;
+        copy_if(names.begin(), names.end(), back_inserter(result), [&pipeline](const string& name) { return pipeline.Has(name); });
+        return result;
+    };
+
+    if (options.Task != SetupTask::PrepareMiKTeXDirect)
+    {
         if (!args.empty())
         {
-            RunIniTeXMF(args, true);
-        }
-        if (cancelled)
-        {
-            return;
+            pipeline.Add("roots", {}, initexmf(args));
+            essentialSteps.insert("roots");
         }
 
         if (options.Task != SetupTask::FinishSetup)
         {
-            RunOneMiKTeXUtility({ "fndb", "remove" }, false);
+            pipeline.Add("fndb-remove", existing({ "roots" }), oneMiKTeXUtility({ "fndb", "remove" }));
         }
 
         // register components, configure files
 #if defined(MIKTEX_WINDOWS)
         if (options.Task != SetupTask::FinishSetup)
         {
-            RunMpm({ "--register-components" });
+            PathName exePath;
+            vector<string> allArgs = MakeMpmCommandLine({ "--register-components" }, exePath);
+            pipeline.Add("components", existing({ "fndb-remove" }), MakeProcessAction(exePath, allArgs));
+            essentialSteps.insert("components");
         }
 #endif
 
         // create file name database files
-        RunOneMiKTeXUtility({ "fndb", "refresh" }, false);
-        if (cancelled)
-        {
-            return;
-        }
-
-        // create latex.exe, ...
-        RunOneMiKTeXUtility({ "links", "install", "--force" }, false);
-        if (cancelled)
-        {
-            return;
-        }
+        pipeline.Add("fndb", existing({ "roots", "fndb-remove", "components" }), oneMiKTeXUtility({ "fndb", "refresh" }));
 
-        // create font map files and language.dat
-        RunOneMiKTeXUtility({ "fontmaps", "configure" }, false);
-        RunOneMiKTeXUtility({ "languages", "configure" }, false);
-
-        if (cancelled)
-        {
-            return;
-        }
+        // create latex.exe, ..., font map files and language.dat
+        pipeline.Add("links", { "fndb" }, oneMiKTeXUtility({ "links", "install", "--force" }));
+        pipeline.Add("fontmaps", { "fndb" }, oneMiKTeXUtility({ "fontmaps", "configure" }));
+        pipeline.Add("languages", { "fndb" }, oneMiKTeXUtility({ "languages", "configure" }));
     }
 
+    // configuration values are set one after another
+
     // set paper size
     if (!options.PaperSize.empty())
     {
-        RunIniTeXMF({ "--default-paper-size=" + options.PaperSize }, false);
+        pipeline.Add("paper-size", existing({ "links", "fontmaps", "languages" }), initexmf({ "--default-paper-size=" + options.PaperSize }));
     }
 
     // set auto-install
@@ -1422,36 +1435,30 @@ void SetupServiceImpl::ConfigureMiKTeX()
     valueSpec += MIKTEX_CONFIG_VALUE_AUTOINSTALL;
     valueSpec += "=";
     valueSpec += std::to_string((int)options.IsInstallOnTheFlyEnabled);
-    RunIniTeXMF({ "--set-config-value=" + valueSpec }, false);
+    pipeline.Add("auto-install", existing({ "links", "fontmaps", "languages", "paper-size" }), initexmf({ "--set-config-value=" + valueSpec }));
 
     if (options.Task != SetupTask::PrepareMiKTeXDirect)
     {
         // refresh file name database again
-        RunOneMiKTeXUtility({ "fndb", "refresh" }, false);
-        if (cancelled)
-        {
-            return;
-        }
+        pipeline.Add("fndb-again", { "auto-install" }, oneMiKTeXUtility({ "fndb", "refresh" }));
     }
 
     if (!options.IsPortable)
     {
 #if defined(MIKTEX_WINDOWS)
-        RunOneMiKTeXUtility({ "filetypes", "register" }, false);
+        pipeline.Add("filetypes", existing({ "auto-install", "fndb-again" }), oneMiKTeXUtility({ "filetypes", "register" }));
 #endif
     }
 
     if (!options.IsPortable && options.IsRegisterPathEnabled)
     {
-        RunIniTeXMF({ "--modify-path" }, false);
+        pipeline.Add("path", existing({ "auto-install", "fndb-again" }), initexmf({ "--modify-path" }));
     }
 
     // create report
-    RunIniTeXMF({ "--report" }, false);
-    if (cancelled)
-    {
-        return;
-    }
+    pipeline.Add("report", existing({ "auto-install", "fndb-again", "filetypes", "path" }), initexmf({ "--report" }));
+
+    RunConfigurationPipeline(pipeline, essentialSteps);
 }
 
 PathName SetupServiceImpl::GetInstallRoot() const
@@ -1482,10 +1489,10 @@ PathName SetupServiceImpl::GetBinDir() const
     }
 }
 
-void SetupServiceImpl::RunIniTeXMF(const vector<string>& args, bool mustSucceed)
+vector<string> SetupServiceImpl::MakeIniTeXMFCommandLine(const vector<string>& args, PathName& exePath)
 {
     // make absolute exe path name
-    PathName exePath = GetBinDir() / MIKTEX_INITEXMF_EXE;
+    exePath = GetBinDir() / MIKTEX_INITEXMF_EXE;
 
     // make command line
     vector<string> allArgs{ exePath.GetFileNameWithoutExtension().ToString() };
@@ -1496,6 +1503,46 @@ void SetupServiceImpl::RunIniTeXMF(const vector<string>& args, bool mustSucceed)
     }
     allArgs.push_back("--disable-installer");
     allArgs.push_back("--verbose");
+    return allArgs;
+}
+
+vector<string> SetupServiceImpl::MakeOneMiKTeXUtilityCommandLine(const vector<string>& args, PathName& exePath)
+{
+    // make absolute exe path name
+    exePath = GetBinDir() / MIKTEX_MIKTEX_EXE;
+
+    // make command line
+    vector<string> allArgs{ exePath.GetFileNameWithoutExtension().ToString() };
+    if (options.IsCommonSetup && session->IsAdminMode())
+    {
+        allArgs.push_back("--admin");
+    }
+    allArgs.push_back("--disable-installer");
+    allArgs.push_back("--verbose");
+    allArgs.insert(allArgs.end(), args.begin(), args.end());
+    return allArgs;
+}
+
+vector<string> SetupServiceImpl::MakeMpmCommandLine(const vector<string>& args, PathName& exePath)
+{
+    // make absolute exe path name
+    exePath = GetBinDir() / MIKTEX_MPM_EXE;
+
+    // make command line
+    vector<string> allArgs{ exePath.GetFileNameWithoutExtension().ToString() };
+    allArgs.insert(allArgs.end(), args.begin(), args.end());
+    if (options.IsCommonSetup && session->IsAdminMode())
+    {
+        allArgs.push_back("--admin");
+    }
+    allArgs.push_back("--verbose");
+    return allArgs;
+}
+
+void SetupServiceImpl::RunIniTeXMF(const vector<string>& args, bool mustSucceed)
+{
+    PathName exePath;
+    vector<string> allArgs = MakeIniTeXMFCommandLine(args, exePath);
 
     // run initexmf.exe
     if (!options.IsDryRun)
@@ -1521,18 +1568,8 @@ void SetupServiceImpl::RunIniTeXMF(const vector<string>& args, bool mustSucceed)
 
 void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool mustSucceed)
 {
-    // make absolute exe path name
-    PathName exePath = GetBinDir() / MIKTEX_MIKTEX_EXE;
-
-    // make command line
-    vector<string> allArgs{ exePath.GetFileNameWithoutExtension().ToString() };
-    if (options.IsCommonSetup && session->IsAdminMode())
-    {
-        allArgs.push_back("--admin");
-    }
-    allArgs.push_back("--disable-installer");
-    allArgs.push_back("--verbose");
-    allArgs.insert(allArgs.end(), args.begin(), args.end());
+    PathName exePath;
+    vector<string> allArgs = MakeOneMiKTeXUtilityCommandLine(args, exePath);
 
     // run One MiKTeX Utility
     if (!options.IsDryRun)
@@ -1558,17 +1595,8 @@ void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool must
 
 void SetupServiceImpl::RunMpm(const vector<string>& args)
 {
-    // make absolute exe path name
-    PathName exePath = GetBinDir() / MIKTEX_MPM_EXE;
-
-    // make command line
-    vector<string> allArgs{ exePath.GetFileNameWithoutExtension().ToString() };
-    allArgs.insert(allArgs.end(), args.begin(), args.end());
-    if (options.IsCommonSetup && session->IsAdminMode())
-    {
-        allArgs.push_back("--admin");
-    }
-    allArgs.push_back("--verbose");
+    PathName exePath;
+    vector<string> allArgs = MakeMpmCommandLine(args, exePath);
 
     // run mpm.exe
     if (!options.IsDryRun)
@@ -1578,6 +1606,81 @@ void SetupServiceImpl::RunMpm(const vector<string>& args)
     }
 }
 
+ConfigurationPipeline::Action SetupServiceImpl::MakeProcessAction(const PathName& exePath, const vector<string>& args)
+{
+    // runs on a worker thread: complete lines are forwarded as they arrive,
+    // so that the output of concurrent steps does not get mixed up
+    return [this, exePath, args](ConfigurationStepResult& result)
+    {
+        result.description = CommandLineBuilder(args).ToString();
+        int exitCode;
+        MiKTeXException miktexException;
+        string pending;
+        auto forwardOutput = [this](const char* output, size_t n)
+        {
+            lock_guard<mutex> lock(processOutputMutex);
+            if (cancelled || !callback->OnProcessOutput(output, n))
+            {
+                cancelled = true;
+                return false;
+            }
+            return true;
+        };
+        auto onOutput = [&pending, &forwardOutput](const void* output, size_t n)
+        {
+            pending.append(reinterpret_cast<const char*>(output), n);
+            size_t endOfLine = pending.rfind('\n');
+            if (endOfLine == string::npos)
+            {
+                return true;
+            }
+            bool proceed = forwardOutput(pending.c_str(), endOfLine + 1);
+            pending.erase(0, endOfLine + 1);
+            // when we stop reading, the child process gets terminated as soon
+            // as it writes to the closed pipe
+            return proceed;
+        };
+        if (!Process::Run(exePath, args, onOutput, &exitCode, &miktexException, nullptr) || exitCode != 0)
+        {
+            result.failed = true;
+            result.exception = miktexException;
+        }
+        if (!pending.empty() && !cancelled)
+        {
+            forwardOutput(pending.c_str(), pending.length());
+        }
+    };
+}
+
+void SetupServiceImpl::RunConfigurationPipeline(ConfigurationPipeline& pipeline, const set<string>& essentialSteps)
+{
+    if (options.IsDryRun)
+    {
+        return;
+    }
+    // the child processes rebuild file name databases
+    session->UnloadFilenameDatabase();
+    unsigned maxJobs = thread::hardware_concurrency();
+    auto start = chrono::steady_clock::now();
+    chrono::milliseconds stepTimes(0);
+    pipeline.Run(maxJobs, [this]() { return cancelled.load(); }, [this, &essentialSteps, &stepTimes](const ConfigurationStepResult& result)
+    {
+        stepTimes += result.duration;
+        Log(fmt::format("{}:\n", result.description));
+        Log(fmt::format("step {0}: started at {1} ms, took {2} ms\n", result.name, result.startTime.count(), result.duration.count()));
+        if (result.failed)
+        {
+            if (essentialSteps.find(result.name) != essentialSteps.end())
+            {
+                throw result.exception;
+            }
+            Warning(result.exception);
+        }
+    });
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    Log(fmt::format("configuration took {0} ms (sum of step times: {1} ms, up to {2} concurrent steps)\n", elapsed.count(), stepTimes.count(), max(maxJobs, 1u)));
+}
+
 void SetupServiceImpl::CreateInfoFile()
 {
     StreamWriter stream(PathName(options.LocalPackageRepository / DOWNLOAD_INFO_FILE));
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Internal definitions
  *
- * @copyright Copyright © 2013-2023 Christian Schenk
+ * @copyright Copyright © 2013-2024 Christian Schenk
  *
  * This file is part of the MiKTeX Setup Library.
  *
@@ -27,9 +27,12 @@
 #include <VersionHelpers.h>
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <mutex>
 #include <set>
+#include <thread>
 
 #include <miktex/Configuration/ConfigNames>
 
@@ -89,6 +92,8 @@ namespace MiKTeX {                                      \
 
 #include "SetupResources.h"
 
+#include "ConfigurationPipeline.h"
+
 BEGIN_INTERNAL_NAMESPACE;
 
 #if !defined(UNUSED)
@@ -264,6 +269,11 @@ protected:
     void RunIniTeXMF(const std::vector<std::string>& args, bool mustSucceed);
     void RunOneMiKTeXUtility(const std::vector<std::string>& args, bool mustSucceed);
     void RunMpm(const std::vector<std::string>& args);
+    std::vector<std::string> MakeIniTeXMFCommandLine(const std::vector<std::string>& args, MiKTeX::Util::PathName& exePath);
+    std::vector<std::string> MakeOneMiKTeXUtilityCommandLine(const std::vector<std::string>& args, MiKTeX::Util::PathName& exePath);
+    std::vector<std::string> MakeMpmCommandLine(const std::vector<std::string>& args, MiKTeX::Util::PathName& exePath);
+    ConfigurationPipeline::Action MakeProcessAction(const MiKTeX::Util::PathName& exePath, const std::vector<std::string>& args);
+    void RunConfigurationPipeline(ConfigurationPipeline& pipeline, const std::set<std::string>& essentialSteps);
     std::wstring& Expand(const std::string& source, std::wstring& dest);
     bool FindFile(const MiKTeX::Util::PathName& fileName, MiKTeX::Util::PathName& result);
     void RemoveFormatFiles();
@@ -307,12 +317,14 @@ protected:
     enum Section { None, Files, HKLM, HKCU };
 
     SetupServiceCallback* callback = &myCallbacks;
-    bool cancelled = false;
+    std::atomic_bool cancelled{ false };
     bool initialized = false;
     MiKTeX::Util::PathName intermediateLogFile;
     LogFile logFile;
     std::ofstream logStream;
     std::mutex logStreamMutex;
+    // serializes the output of concurrent configuration steps
+    std::mutex processOutputMutex;
     bool logging = false;
     SetupOptions options;
     std::shared_ptr<MiKTeX::Packages::PackageInstaller> packageInstaller;
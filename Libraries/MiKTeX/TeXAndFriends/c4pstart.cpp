@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief C4P startup code
  *
- * @copyright Copyright © 1996-2022 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -20,6 +20,10 @@
 #   include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -37,8 +41,11 @@
 
 using namespace std;
 
+using namespace std::chrono;
+
 using namespace MiKTeX::App;
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
 
 using namespace C4P;
 
@@ -149,10 +156,61 @@ C4PTHISAPI(void) C4P::ProgramBase::Finish()
         pimpl->parent->Warning("some characters could not be written to the terminal window");
         pimpl->terminalIssue = false;
     }
+    if (procedureProfiler != nullptr)
+    {
+        string reportFile;
+        if (Utils::GetEnvironmentString("MIKTEX_C4P_PROFILE", reportFile))
+        {
+            procedureProfiler->WriteReport(PathName(reportFile), pimpl->runtime.programName);
+        }
+        procedureProfiler = nullptr;
+    }
     pimpl->runtime.ClearCommandLine();
     pimpl->runtime.programName = "";
 }
 
+void C4P::ProgramBase::StartProcedureProfiler(const char* const* procedureNames, size_t count)
+{
+    string reportFile;
+    if (Utils::GetEnvironmentString("MIKTEX_C4P_PROFILE", reportFile) && !reportFile.empty())
+    {
+        procedureProfiler = make_unique<ProcedureProfiler>(procedureNames, count);
+    }
+}
+
+C4P::ProcedureProfiler::ProcedureProfiler(const char* const* procedureNames, size_t count) :
+    records(count),
+    names(procedureNames, procedureNames + count),
+    startTicks(GetTicks()),
+    startTime(steady_clock::now())
+{
+}
+
+void C4P::ProcedureProfiler::WriteReport(const PathName& path, const string& programName) const
+{
+    double elapsedSeconds = duration_cast<duration<double>>(steady_clock::now() - startTime).count();
+    C4P_unsigned64 ticks = GetTicks() - startTicks;
+    double ticksPerMillisecond = elapsedSeconds > 0 ? ticks / (elapsedSeconds * 1000.0) : 1.0;
+    vector<size_t> handles(records.size());
+    iota(handles.begin(), handles.end(), 0);
+    handles.erase(remove_if(handles.begin(), handles.end(), [this](size_t h) { return records[h].calls == 0; }), handles.end());
+    sort(handles.begin(), handles.end(), [this](size_t h1, size_t h2) { return records[h1].selfTicks > records[h2].selfTicks; });
+    ofstream stream = File::CreateOutputStream(path);
+    stream << fmt::format("C4P procedure profile of {0}: {1} of {2} procedures called, {3:.3f} seconds", programName, handles.size(), records.size() - 1, elapsedSeconds) << "\n\n";
+    stream << fmt::format("{0:>12} {1:>12} {2:>7} {3:>12}  {4}", "calls", "self [ms]", "self %", "incl [ms]", "procedure") << "\n";
+    for (size_t h : handles)
+    {
+        const Record& record = records[h];
+        stream << fmt::format("{0:>12} {1:>12.3f} {2:>7.2f} {3:>12.3f}  {4}",
+            record.calls,
+            record.selfTicks / ticksPerMillisecond,
+            ticks > 0 ? 100.0 * record.selfTicks / ticks : 0.0,
+            record.inclusiveTicks / ticksPerMillisecond,
+            names[h]) << "\n";
+    }
+    stream.close();
+}
+
 C4PTHISAPI(void) C4P::ProgramBase::SetParent(Application* parent)
 {
     pimpl->parent = parent;
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Pascalish run-time support
  *
- * @copyright Copyright © 1996-2022 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <chrono>
 #include <exception>
 #include <memory>
 #include <string>
@@ -38,6 +39,14 @@
 #include <miktex/Util/StringUtil>
 #include <miktex/Util/inliners.h>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <intrin.h>
+#   define C4P_HAVE_RDTSC 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   include <x86intrin.h>
+#   define C4P_HAVE_RDTSC 1
+#endif
+
 /// @namespace C4P
 ///
 /// @brief The "C/C++ for Pascal" namespace.
@@ -343,6 +352,99 @@ public:
 #define output (*(GetStdFilePtr(1)))
 #define c4perroroutput (*(GetStdFilePtr(2)))
 
+/// Counts procedure calls and measures the time spent in procedures.
+///
+/// The instrumentation is generated by `c4p --profile`: each procedure
+/// body starts with a `Scope` object.
+class C4PTYPEAPI(ProcedureProfiler)
+{
+
+public:
+
+    C4PEXPORT MIKTEXTHISCALL ProcedureProfiler(const char* const* procedureNames, std::size_t count);
+
+    /// Writes the procedures sorted by self time.
+    C4PTHISAPI(void) WriteReport(const MiKTeX::Util::PathName& path, const std::string& programName) const;
+
+    static C4P_unsigned64 GetTicks()
+    {
+#if defined(C4P_HAVE_RDTSC)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    class Scope
+    {
+
+    public:
+
+        Scope(ProcedureProfiler* profiler, int handle) :
+            profiler(profiler),
+            handle(handle)
+        {
+            if (profiler != nullptr)
+            {
+                Record& record = profiler->records[handle];
+                record.calls += 1;
+                record.activations += 1;
+                parent = profiler->current;
+                profiler->current = this;
+                start = GetTicks();
+            }
+        }
+
+        Scope(const Scope& other) = delete;
+        Scope& operator=(const Scope& other) = delete;
+
+        ~Scope()
+        {
+            if (profiler != nullptr)
+            {
+                C4P_unsigned64 elapsed = GetTicks() - start;
+                Record& record = profiler->records[handle];
+                record.selfTicks += elapsed - childTicks;
+                // count recursive activations only once
+                record.activations -= 1;
+                if (record.activations == 0)
+                {
+                    record.inclusiveTicks += elapsed;
+                }
+                if (parent != nullptr)
+                {
+                    parent->childTicks += elapsed;
+                }
+                profiler->current = parent;
+            }
+        }
+
+    private:
+
+        ProcedureProfiler* profiler;
+        int handle;
+        Scope* parent = nullptr;
+        C4P_unsigned64 start = 0;
+        C4P_unsigned64 childTicks = 0;
+    };
+
+private:
+
+    struct Record
+    {
+        C4P_unsigned64 calls = 0;
+        C4P_unsigned64 selfTicks = 0;
+        C4P_unsigned64 inclusiveTicks = 0;
+        unsigned activations = 0;
+    };
+
+    std::vector<Record> records;
+    std::vector<std::string> names;
+    Scope* current = nullptr;
+    C4P_unsigned64 startTicks;
+    std::chrono::steady_clock::time_point startTime;
+};
+
 class C4PTYPEAPI(ProgramBase)
 {
 
@@ -355,6 +457,9 @@ public:
     C4PTHISAPI(time_t) GetStartUpTime();
     C4PTHISAPI(void) SetParent(MiKTeX::App::Application* parent);
     C4PTHISAPI(void) SetStartUpTime(time_t time, bool useUtc);
+    /// Starts profiling, if the environment variable `MIKTEX_C4P_PROFILE`
+    /// is set to the name of the report file.
+    C4PTHISAPI(void) StartProcedureProfiler(const char* const* procedureNames, std::size_t count);
     ProgramBase& operator=(ProgramBase && other) = delete;
     ProgramBase& operator=(const ProgramBase& other) = delete;
     ProgramBase(ProgramBase && other) = delete;
@@ -374,6 +479,8 @@ protected:
     C4PTHISAPI(void) Finish();
     C4PTHISAPI(void) Initialize(const char* programName, int argc, char* argv[]);
 
+    std::unique_ptr<ProcedureProfiler> procedureProfiler;
+
     template<class Ft> void c4p_write_f(Ft&, Ft&)
     {
     }
@@ -765,6 +872,7 @@ C4PCEEAPI(C4P_integer) Round(double r);
 
 #define C4P_PROC_ENTRY(handle) c4p_proc_entry<handle>();
 #define C4P_PROC_EXIT(handle) C4P_LABEL_PROC_EXIT: c4p_proc_exit<handle>();
+#define C4P_PROC_PROFILE(handle) C4P::ProcedureProfiler::Scope c4p_profiler_scope(this->procedureProfiler.get(), handle);
 
 #define C4P_READ_BEGIN() {
 #define C4P_READLN_BEGIN() C4P_READ_BEGIN()
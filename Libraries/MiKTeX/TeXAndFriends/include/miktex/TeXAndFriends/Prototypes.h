@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief Prototypes
  *
- * @copyright Copyright © 1996-2022 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -15,6 +15,8 @@
 
 #include <miktex/TeXAndFriends/config.h>
 
+#include <cstddef>
+
 #include <miktex/Util/PathName>
 
 /// @namespace MiKTeX::TeXAndFriends
@@ -31,4 +33,19 @@ MIKTEXMFCEEAPI(bool) OpenVFFile(void* ptr, const MiKTeX::Util::PathName& fileNam
 MIKTEXMFCEEAPI(int) OpenXFMFile(void* ptr, const MiKTeX::Util::PathName& fileName);
 MIKTEXMFCEEAPI(int) OpenXVFFile(void* ptr, const MiKTeX::Util::PathName& fileName);
 
+/// Reserves zero-initialized memory which does not add to the resident set
+/// size until it is touched.
+/// @param size The size of the memory block.
+/// @return Returns `nullptr`, if no such memory could be reserved.
+MIKTEXMFCEEAPI(void*) ReserveElasticMemory(std::size_t size);
+
+/// Releases memory reserved by `ReserveElasticMemory()`.
+MIKTEXMFCEEAPI(void) ReleaseElasticMemory(void* ptr, std::size_t size);
+
+/// Commits a range of memory reserved by `ReserveElasticMemory()`, so that
+/// it can be passed to system calls. Other memory is left alone.
+/// @param ptr The start of the range.
+/// @param size The size of the range.
+MIKTEXMFCEEAPI(void) CommitElasticMemory(void* ptr, std::size_t size);
+
 MIKTEX_TEXMF_END_NAMESPACE;
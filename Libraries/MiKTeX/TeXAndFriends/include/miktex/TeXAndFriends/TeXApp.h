@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX TeX base implementation
  *
- * @copyright Copyright © 1996-2022 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -77,14 +77,19 @@ public:
     MIKTEXMFTHISAPI(bool) IsNewSource(int sourceFileName, int line) const;
     MIKTEXMFTHISAPI(bool) IsSourceSpecialOn(SourceSpecial s) const;
     MIKTEXMFTHISAPI(bool) MLTeXP() const;
+    MIKTEXMFTHISAPI(bool) ProfileMacrosP() const;
     MIKTEXMFTHISAPI(bool) SourceSpecialsP() const;
     MIKTEXMFTHISAPI(bool) Write18P() const;
     MIKTEXMFTHISAPI(int) GetSynchronizationOptions() const;
     MIKTEXMFTHISAPI(int) MakeSrcSpecial(int sourceFileName, int line) const;
+    MIKTEXMFTHISAPI(void) EnterMacro(int cs, int csText, int sourceFileName, int line);
     MIKTEXMFTHISAPI(void) Finalize() override;
+    MIKTEXMFTHISAPI(void) LeaveMacro();
+    MIKTEXMFTHISAPI(void) OnTeXMFFinishJob() override;
     MIKTEXMFTHISAPI(void) OnTeXMFStartJob() override;
     MIKTEXMFTHISAPI(void) RememberSourceInfo(int sourceFileName, int line) const;
     MIKTEXMFTHISAPI(void) SetFormatHandler(IFormatHandler* formatHandler);
+    MIKTEXMFTHISAPI(void) SetMacroProfilerLayout(int activeBase, int singleBase, int nullCs, int hashBase);
 
     MiKTeX::Core::FileType GetInputFileType() const override
     {
@@ -246,6 +251,26 @@ inline int miktexgetsynchronizationoptions()
     return TeXApp::GetTeXApp()->GetSynchronizationOptions();
 }
 
+inline bool miktexprofilemacrosp()
+{
+    return TeXApp::GetTeXApp()->ProfileMacrosP();
+}
+
+inline void miktexprofilesetlayout(int activeBase, int singleBase, int nullCs, int hashBase)
+{
+    TeXApp::GetTeXApp()->SetMacroProfilerLayout(activeBase, singleBase, nullCs, hashBase);
+}
+
+inline void miktexprofileentermacro(int cs, int csText, int sourceFileName, int line)
+{
+    TeXApp::GetTeXApp()->EnterMacro(cs, csText, sourceFileName, line);
+}
+
+inline void miktexprofileleavemacro()
+{
+    TeXApp::GetTeXApp()->LeaveMacro();
+}
+
 inline bool miktexsourcespecialsp()
 {
     return TeXApp::GetTeXApp()->SourceSpecialsP();
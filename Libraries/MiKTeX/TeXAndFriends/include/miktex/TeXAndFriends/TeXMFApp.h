@@ -194,6 +194,10 @@ public:
 
     template<typename FILE_, typename ELETYPE_> void Dump(FILE_& f, const ELETYPE_& e, std::size_t n)
     {
+#if defined(MIKTEX_WINDOWS)
+        // the CRT may pass the array to WriteFile()
+        CommitElasticMemory(const_cast<ELETYPE_*>(&e), sizeof(e) * n);
+#endif
         if (fwrite(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
         {
         MIKTEX_FATAL_CRT_ERROR("fwrite");
@@ -208,6 +212,11 @@ public:
     template<typename FILE_, typename ELETYPE_> void Undump(FILE_& f, ELETYPE_& e, std::size_t n)
     {
         f.PascalFileIO(false);
+#if defined(MIKTEX_WINDOWS)
+        // the CRT may pass the array to ReadFile(), which does not trigger
+        // the commit-on-access handler
+        CommitElasticMemory(&e, sizeof(e) * n);
+#endif
         if (fread(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
         {
         MIKTEX_FATAL_CRT_ERROR("fread");
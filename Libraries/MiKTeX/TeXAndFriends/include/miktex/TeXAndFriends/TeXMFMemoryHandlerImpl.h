@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX TeXMF memory handler implementation
  *
- * @copyright Copyright © 2017-2022 Christian Schenk
+ * @copyright Copyright © 2017-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -13,6 +13,10 @@
 
 #pragma once
 
+#include <cstring>
+
+#include <unordered_set>
+
 #include <miktex/Configuration/ConfigNames>
 
 #include <miktex/TeXAndFriends/config.h>
@@ -63,7 +67,7 @@ public:
         program.mainmemory = GetCheckedParameter("main_memory", infmainmemory, supmainmemory, userParams, texmfapp::texmfapp::main_memory());
 #endif
         program.maxprintline = GetParameter("max_print_line", userParams, texmfapp::texmfapp::max_print_line());
-        program.maxstrings = GetCheckedParameter("max_strings", program.infmaxstrings, program.supmaxstrings, userParams, texmfapp::texmfapp::max_strings());
+        program.maxstrings = GetElasticParameter("max_strings", program.infmaxstrings, program.supmaxstrings, userParams, texmfapp::texmfapp::max_strings(), sizeof(*program.strstart));
 #if defined(MIKTEX_METAFONT)
         const int infparamsize = 60;
         const int supparamsize = 600000;
@@ -71,12 +75,12 @@ public:
         const int infparamsize = program.infparamsize;
         const int supparamsize = program.supparamsize;
 #endif
-        program.paramsize = GetCheckedParameter("param_size", infparamsize, supparamsize, userParams, texmfapp::texmfapp::param_size());
+        program.paramsize = GetElasticParameter("param_size", infparamsize, supparamsize, userParams, texmfapp::texmfapp::param_size(), sizeof(*program.paramstack));
 #if defined(HAVE_POOL_FREE)
         program.poolfree = GetCheckedParameter("pool_free", program.infpoolfree, program.suppoolfree, userParams, texmfapp::texmfapp::pool_free());
 #endif
-        program.poolsize = GetCheckedParameter("pool_size", program.infpoolsize, program.suppoolsize, userParams, texmfapp::texmfapp::pool_size());
-        program.stacksize = GetCheckedParameter("stack_size", program.infstacksize, program.supstacksize, userParams, texmfapp::texmfapp::stack_size());
+        program.poolsize = GetElasticParameter("pool_size", program.infpoolsize, program.suppoolsize, userParams, texmfapp::texmfapp::pool_size(), sizeof(*program.strpool));
+        program.stacksize = GetElasticParameter("stack_size", program.infstacksize, program.supstacksize, userParams, texmfapp::texmfapp::stack_size(), sizeof(*program.inputstack));
 #if defined(HAVE_STRINGS_FREE)
         program.stringsfree = GetCheckedParameter("strings_free", program.infstringsfree, program.supstringsfree, userParams, texmfapp::texmfapp::strings_free());
 #endif
@@ -100,6 +104,16 @@ public:
         {
             program.extramemtop = 0;
         }
+#if defined(MIKTEX_TEX_COMPILER)
+        else if (elasticMemory && userParams.find("extra_mem_top") == userParams.end() && CanReserveElasticMemory((static_cast<std::size_t>(supmainmemory) + 1) * sizeof(*program.yzmem)))
+#else
+        else if (elasticMemory && userParams.find("extra_mem_top") == userParams.end() && CanReserveElasticMemory((static_cast<std::size_t>(supmainmemory) + 1) * sizeof(*program.mem)))
+#endif
+        {
+            // mem_top + extra_mem_top must not exceed max_halfword; assume
+            // that the format has been dumped with the same main_memory
+            program.extramemtop = supmainmemory - program.mainmemory;
+        }
         if (program.extramemtop > supmainmemory)
         {
             program.extramemtop = supmainmemory;
@@ -160,15 +174,15 @@ public:
     {
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.buffer);
 #if defined(MIKTEX_TEX_COMPILER)
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.yzmem);
+        CheckArray(program.yzmem);
 #else
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.mem);
+        CheckArray(program.mem);
 #endif
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.inputstack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.paramstack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.strpool);
+        CheckArray(program.inputstack);
+        CheckArray(program.paramstack);
+        CheckArray(program.strpool);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.trickbuf);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(program.strstart);
+        CheckArray(program.strstart);
     }
 
     void* ReallocateArray(const std::string& arrayName, void* ptr, std::size_t elemSize, std::size_t numElem, const MiKTeX::Core::SourceLocation& sourceLocation) override
@@ -184,8 +198,46 @@ public:
             amount = (numElem + 1) * elemSize;
         }
         trace_mem->WriteLine("libtexmf", "reallocate " + arrayName + ": ptr == " + std::string(ptr == nullptr ? "nullptr" : "...") + ", elementSize == " + std::to_string(elemSize) + ", nElements == " + std::to_string(numElem));
-        ptr = MiKTeX::Debug::Realloc(ptr, amount, sourceLocation);
-        return ptr;
+        auto it = elasticBlocks.find(ptr);
+        if (it == elasticBlocks.end())
+        {
+            if (ptr == nullptr && amount > 0 && elasticArrays.find(arrayName) != elasticArrays.end())
+            {
+                // GetElasticParameter() has made sure that the address space
+                // is available; otherwise the array has its configured size
+                void* block = ReserveElasticMemory(amount);
+                if (block != nullptr)
+                {
+                    elasticBlocks[block] = amount;
+                    return block;
+                }
+            }
+            ptr = MiKTeX::Debug::Realloc(ptr, amount, sourceLocation);
+            return ptr;
+        }
+        if (amount > 0 && amount <= it->second)
+        {
+            // pages which have not been touched yet do not cost anything
+            return ptr;
+        }
+        void* newPtr = nullptr;
+        if (amount > 0)
+        {
+            trace_mem->WriteLine("libtexmf", "moving " + arrayName + " to a bigger block");
+            newPtr = ReserveElasticMemory(amount);
+            if (newPtr != nullptr)
+            {
+                elasticBlocks[newPtr] = amount;
+            }
+            else
+            {
+                newPtr = MiKTeX::Debug::Realloc(nullptr, amount, sourceLocation);
+            }
+            memcpy(newPtr, ptr, it->second);
+        }
+        ReleaseElasticMemory(ptr, it->second);
+        elasticBlocks.erase(ptr);
+        return newPtr;
     }
 
 protected:
@@ -248,6 +300,36 @@ protected:
         return result;
     }
 
+    /// Gets the value of a parameter which determines the size of an array.
+    /// In elastic mode, the hard limit is used unless the value has been
+    /// specified on the command line: array pages are committed when they are
+    /// touched for the first time, so that unused capacity does not cost
+    /// anything. If the address space for the hard limit cannot be reserved,
+    /// the configured value is used.
+    int GetElasticParameter(const std::string& parameterName, int minValue, int maxValue, const std::unordered_map<std::string, int>& userParams, int defaultValue, std::size_t elementSize)
+    {
+        if (elasticMemory && userParams.find(parameterName) == userParams.end() && CanReserveElasticMemory((static_cast<std::size_t>(maxValue) + 1) * elementSize))
+        {
+            return maxValue;
+        }
+        return GetCheckedParameter(parameterName, minValue, maxValue, userParams, defaultValue);
+    }
+
+    static bool CanReserveElasticMemory(std::size_t size)
+    {
+        void* ptr = ReserveElasticMemory(size);
+        ReleaseElasticMemory(ptr, size);
+        return ptr != nullptr;
+    }
+
+    template<typename T> void CheckArray(T* ptr) const
+    {
+        if (elasticBlocks.find(ptr) == elasticBlocks.end())
+        {
+            MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(ptr);
+        }
+    }
+
     template<typename T> T* AllocateArray(const std::string& arrayName, T*& ptr, std::size_t n)
     {
         ptr = (T*)ReallocateArray(arrayName, nullptr, sizeof(*ptr), n, MIKTEX_SOURCE_LOCATION_DEBUG());
@@ -263,6 +345,15 @@ protected:
     PROGRAM_CLASS& program;
     TeXMFApp& texmfapp;
     std::unique_ptr<MiKTeX::Trace::TraceStream> trace_mem;
+
+    /// Elastic mode: arrays are sized to their hard limits.
+    bool elasticMemory = false;
+
+    /// Names of the arrays which live in elastic memory.
+    std::unordered_set<std::string> elasticArrays;
+
+    /// Memory blocks reserved by ReserveElasticMemory() and their sizes.
+    std::unordered_map<void*, std::size_t> elasticBlocks;
 };
 
 MIKTEX_TEXMF_END_NAMESPACE;
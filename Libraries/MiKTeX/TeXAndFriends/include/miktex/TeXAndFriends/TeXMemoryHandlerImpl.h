@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX TeX memory handler implementation
  *
- * @copyright Copyright © 2017-2022 Christian Schenk
+ * @copyright Copyright © 2017-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -44,11 +44,30 @@ public:
             MIKTEX_FATAL_ERROR(MIKTEXTEXT("mem_bot must be 0 or 1."));
         }
 
+        this->elasticMemory = this->GetParameter("elastic_memory", userParams, texapp::texapp::elastic_memory()) != 0;
+        if (this->elasticMemory)
+        {
+            // arrays which are filled from the bottom; the trie and the
+            // hyphenation exceptions are hash tables, and the buffer gets
+            // cleared on startup
+            this->elasticArrays = {
+                "fontinfo",
+                "inputstack",
+                "mem",
+                "nest",
+                "paramstack",
+                "savestack",
+                "strpool",
+                "strstart",
+                "yzmem",
+            };
+        }
+
         TeXMFMemoryHandlerImpl<PROGRAM_CLASS>::Allocate(userParams);
 
         this->program.maxinopen = this->GetCheckedParameter("max_in_open", this->program.infmaxinopen, this->program.supmaxinopen, userParams, texapp::texapp::max_in_open());
-        this->program.nestsize = this->GetCheckedParameter("nest_size", this->program.infnestsize, this->program.supnestsize, userParams, texapp::texapp::nest_size());
-        this->program.savesize = this->GetCheckedParameter("save_size", this->program.infsavesize, this->program.supsavesize, userParams, texapp::texapp::save_size());
+        this->program.nestsize = this->GetElasticParameter("nest_size", this->program.infnestsize, this->program.supnestsize, userParams, texapp::texapp::nest_size(), sizeof(*this->program.nest));
+        this->program.savesize = this->GetElasticParameter("save_size", this->program.infsavesize, this->program.supsavesize, userParams, texapp::texapp::save_size(), sizeof(*this->program.savestack));
         this->program.triesize = this->GetCheckedParameter("trie_size", this->program.inftriesize, this->program.suptriesize, userParams, texapp::texapp::trie_size());
 
         this->program.expanddepth = this->GetCheckedParameter("expand_depth", this->program.infexpanddepth, this->program.supexpanddepth, userParams, texapp::texapp::expand_depth());
@@ -69,7 +88,7 @@ public:
 
         this->program.hyphsize = this->GetCheckedParameter("hyph_size", this->program.infhyphsize, this->program.suphyphsize, userParams, texapp::texapp::hyph_size());
         this->program.fontmax = this->GetParameter("font_max", userParams, texapp::texapp::font_max());
-        this->program.fontmemsize = this->GetCheckedParameter("font_mem_size", this->program.inffontmemsize, this->program.supfontmemsize, userParams, texapp::texapp::font_mem_size());
+        this->program.fontmemsize = this->GetElasticParameter("font_mem_size", this->program.inffontmemsize, this->program.supfontmemsize, userParams, texapp::texapp::font_mem_size(), sizeof(*this->program.fontinfo));
 
         this->AllocateArray("trietrl", this->program.trietrl, this->program.triesize);
         this->AllocateArray("trietro", this->program.trietro, this->program.triesize);
@@ -178,8 +197,8 @@ public:
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.inputfile);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fullsourcefilenamestack);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.sourcefilenamestack);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.nest);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.savestack);
+        this->CheckArray(this->program.nest);
+        this->CheckArray(this->program.savestack);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.triec);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.triehash);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.triel);
@@ -207,7 +226,7 @@ public:
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontec);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontfalsebchar);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontglue);
-        MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontinfo);
+        this->CheckArray(this->program.fontinfo);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontname);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontparams);
         MIKTEX_ASSERT_VALID_HEAP_POINTER_OR_NIL(this->program.fontsize);
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX TeX base implementation
  *
- * @copyright Copyright © 1996-2022 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -11,10 +11,18 @@
  * version 2 or any later version.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/File>
 #include <miktex/Util/Tokenizer>
 
 #if defined(MIKTEX_TEXMF_SHARED)
@@ -36,6 +44,7 @@
 #include "internal.h"
 
 using namespace std;
+using namespace std::chrono;
 
 using namespace MiKTeX::Core;
 using namespace MiKTeX::TeXAndFriends;
@@ -43,6 +52,281 @@ using namespace MiKTeX::Util;
 
 #define EXPERT_SRC_SPECIALS 0
 
+/// Attributes the time spent in macros to macro call stacks.
+///
+/// The call stacks are kept in a tree. The root nodes stand for the source
+/// lines from which top-level macros have been called. The time between two
+/// enter/leave events is charged to the innermost active macro.
+class MacroProfiler
+{
+public:
+
+    MacroProfiler(function<string(int)> getTeXString) :
+        getTeXString(getTeXString)
+    {
+    }
+
+    void SetLayout(int activeBase, int singleBase, int nullCs, int hashBase)
+    {
+        this->activeBase = activeBase;
+        this->singleBase = singleBase;
+        this->nullCs = nullCs;
+        this->hashBase = hashBase;
+    }
+
+    void Enter(int cs, int csText, int sourceFileName, int line)
+    {
+        auto now = steady_clock::now();
+        int parent;
+        if (stack.empty())
+        {
+            parent = GetRoot(sourceFileName, line);
+        }
+        else
+        {
+            parent = stack.back();
+            nodes[parent].selfTime += now - lastEventTime;
+        }
+        lastEventTime = now;
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(parent)) << 32) | static_cast<uint32_t>(cs);
+        auto it = children.find(key);
+        int node;
+        if (it == children.end())
+        {
+            node = static_cast<int>(nodes.size());
+            nodes.push_back(Node{ parent, cs });
+            children[key] = node;
+            if (names.find(cs) == names.end())
+            {
+                names[cs] = MakeName(cs, csText);
+            }
+        }
+        else
+        {
+            node = it->second;
+        }
+        nodes[node].calls++;
+        stack.push_back(node);
+    }
+
+    void Leave()
+    {
+        if (stack.empty())
+        {
+            return;
+        }
+        auto now = steady_clock::now();
+        nodes[stack.back()].selfTime += now - lastEventTime;
+        lastEventTime = now;
+        stack.pop_back();
+    }
+
+    void WriteReport(const PathName& path);
+
+private:
+
+    struct Node
+    {
+        int parent;
+        int cs;
+        uint64_t calls = 0;
+        steady_clock::duration selfTime{ 0 };
+    };
+
+    static constexpr int ROOT = -1;
+
+    int GetRoot(int sourceFileName, int line)
+    {
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(sourceFileName)) << 32) | static_cast<uint32_t>(line);
+        auto it = roots.find(key);
+        if (it != roots.end())
+        {
+            return it->second;
+        }
+        int node = static_cast<int>(nodes.size());
+        nodes.push_back(Node{ ROOT, ROOT });
+        roots[key] = node;
+        sourceLocations[node] = fmt::format("{0}:{1}", sourceFileName > 0 ? getTeXString(sourceFileName) : "<unknown>", line);
+        return node;
+    }
+
+    string MakeName(int cs, int csText) const
+    {
+        if (cs >= hashBase)
+        {
+            return "\\" + getTeXString(csText);
+        }
+        else if (cs == nullCs)
+        {
+            return "\\csname\\endcsname";
+        }
+        else if (cs >= singleBase)
+        {
+            return "\\" + CharToString(cs - singleBase);
+        }
+        else
+        {
+            return CharToString(cs - activeBase);
+        }
+    }
+
+    static string CharToString(int ch)
+    {
+        string s;
+        if (ch < 0x20 || ch == 0x7f)
+        {
+            s = "^^";
+            s += static_cast<char>(ch ^ 0x40);
+        }
+        else if (ch < 0x80)
+        {
+            s = static_cast<char>(ch);
+        }
+        else if (ch < 0x800)
+        {
+            s += static_cast<char>(0xc0 | (ch >> 6));
+            s += static_cast<char>(0x80 | (ch & 0x3f));
+        }
+        else if (ch < 0x10000)
+        {
+            s += static_cast<char>(0xe0 | (ch >> 12));
+            s += static_cast<char>(0x80 | ((ch >> 6) & 0x3f));
+            s += static_cast<char>(0x80 | (ch & 0x3f));
+        }
+        else
+        {
+            s += static_cast<char>(0xf0 | (ch >> 18));
+            s += static_cast<char>(0x80 | ((ch >> 12) & 0x3f));
+            s += static_cast<char>(0x80 | ((ch >> 6) & 0x3f));
+            s += static_cast<char>(0x80 | (ch & 0x3f));
+        }
+        return s;
+    }
+
+    function<string(int)> getTeXString;
+    int activeBase = 0;
+    int singleBase = 0;
+    int nullCs = 0;
+    int hashBase = 0;
+    vector<Node> nodes;
+    unordered_map<uint64_t, int> children;
+    unordered_map<uint64_t, int> roots;
+    unordered_map<int, string> sourceLocations;
+    unordered_map<int, string> names;
+    vector<int> stack;
+    steady_clock::time_point lastEventTime;
+    steady_clock::time_point startTime = steady_clock::now();
+};
+
+void MacroProfiler::WriteReport(const PathName& path)
+{
+    auto now = steady_clock::now();
+    if (!stack.empty())
+    {
+        nodes[stack.back()].selfTime += now - lastEventTime;
+        stack.clear();
+    }
+    double elapsedSeconds = duration_cast<duration<double>>(now - startTime).count();
+
+    // the folded stacks: one line per call stack, the value is the self time
+    // in nanoseconds; semicolons in macro names are written as ^^3b
+    vector<string> frames(nodes.size());
+    vector<steady_clock::duration> inclusiveTime(nodes.size());
+    ofstream stream = File::CreateOutputStream(path);
+    for (size_t idx = 0; idx < nodes.size(); ++idx)
+    {
+        const Node& node = nodes[idx];
+        if (node.parent == ROOT)
+        {
+            frames[idx] = sourceLocations[static_cast<int>(idx)];
+            continue;
+        }
+        string name = names[node.cs];
+        for (size_t pos = name.find(';'); pos != string::npos; pos = name.find(';', pos))
+        {
+            name.replace(pos, 1, "^^3b");
+        }
+        frames[idx] = frames[node.parent] + ";" + name;
+        stream << frames[idx] << " " << duration_cast<nanoseconds>(node.selfTime).count() << "\n";
+    }
+    stream.close();
+
+    // children have been created after their parents
+    for (size_t idx = nodes.size(); idx-- > 0; )
+    {
+        inclusiveTime[idx] += nodes[idx].selfTime;
+        if (nodes[idx].parent != ROOT)
+        {
+            inclusiveTime[nodes[idx].parent] += inclusiveTime[idx];
+        }
+    }
+
+    struct Record
+    {
+        string name;
+        uint64_t calls = 0;
+        steady_clock::duration selfTime{ 0 };
+        steady_clock::duration inclusiveTime{ 0 };
+    };
+    unordered_map<int, Record> macros;
+    unordered_map<int, Record> lines;
+    for (size_t idx = 0; idx < nodes.size(); ++idx)
+    {
+        const Node& node = nodes[idx];
+        if (node.parent == ROOT)
+        {
+            Record& record = lines[static_cast<int>(idx)];
+            record.name = sourceLocations[static_cast<int>(idx)];
+            record.inclusiveTime = inclusiveTime[idx];
+            continue;
+        }
+        if (nodes[node.parent].parent == ROOT)
+        {
+            lines[node.parent].calls += node.calls;
+        }
+        Record& record = macros[node.cs];
+        record.name = names[node.cs];
+        record.calls += node.calls;
+        record.selfTime += node.selfTime;
+        // count recursive calls once
+        bool recursive = false;
+        for (int ancestor = node.parent; !recursive && nodes[ancestor].parent != ROOT; ancestor = nodes[ancestor].parent)
+        {
+            recursive = nodes[ancestor].cs == node.cs;
+        }
+        if (!recursive)
+        {
+            record.inclusiveTime += inclusiveTime[idx];
+        }
+    }
+    auto sorted = [](const unordered_map<int, Record>& records, function<bool(const Record&, const Record&)> less)
+    {
+        vector<const Record*> result;
+        for (const auto& kv : records)
+        {
+            result.push_back(&kv.second);
+        }
+        sort(result.begin(), result.end(), [&less](const Record* r1, const Record* r2) { return less(*r1, *r2); });
+        return result;
+    };
+    auto ms = [](steady_clock::duration d) { return duration_cast<duration<double, milli>>(d).count(); };
+    PathName summaryPath(path);
+    summaryPath.AppendExtension(".summary");
+    stream = File::CreateOutputStream(summaryPath);
+    stream << fmt::format("TeX macro profile: {0} macros, {1} source lines, {2:.3f} seconds", macros.size(), lines.size(), elapsedSeconds) << "\n\n";
+    stream << fmt::format("{0:>12} {1:>12} {2:>12}  {3}", "calls", "self [ms]", "incl [ms]", "macro") << "\n";
+    for (const Record* record : sorted(macros, [](const Record& r1, const Record& r2) { return r1.selfTime > r2.selfTime; }))
+    {
+        stream << fmt::format("{0:>12} {1:>12.3f} {2:>12.3f}  {3}", record->calls, ms(record->selfTime), ms(record->inclusiveTime), record->name) << "\n";
+    }
+    stream << "\n" << fmt::format("{0:>12} {1:>12}  {2}", "calls", "incl [ms]", "source line") << "\n";
+    for (const Record* record : sorted(lines, [](const Record& r1, const Record& r2) { return r1.inclusiveTime > r2.inclusiveTime; }))
+    {
+        stream << fmt::format("{0:>12} {1:>12.3f}  {2}", record->calls, ms(record->inclusiveTime), record->name) << "\n";
+    }
+    stream.close();
+}
+
 class TeXApp::impl
 {
 public:
@@ -54,6 +338,8 @@ public:
     IFormatHandler* formatHandler;
     int lastLineNum;
     PathName lastSourceFilename;
+    PathName macroProfileFile;
+    unique_ptr<MacroProfiler> macroProfiler;
 };
 
 TeXApp::TeXApp() :
@@ -86,9 +372,21 @@ void TeXApp::OnTeXMFStartJob()
     EnableShellCommands(shellCommandMode);
 }
 
+void TeXApp::OnTeXMFFinishJob()
+{
+    if (pimpl->macroProfiler != nullptr)
+    {
+        pimpl->macroProfiler->WriteReport(pimpl->macroProfileFile);
+        pimpl->macroProfiler = nullptr;
+    }
+    TeXMFApp::OnTeXMFFinishJob();
+}
+
 void TeXApp::Finalize()
 {
     pimpl->lastSourceFilename = "";
+    pimpl->macroProfileFile = "";
+    pimpl->macroProfiler = nullptr;
     pimpl->sourceSpecials.reset();
     TeXMFApp::Finalize();
 }
@@ -104,6 +402,7 @@ enum {
     OPT_MAX_IN_OPEN,
     OPT_MEM_BOT,
     OPT_NEST_SIZE,
+    OPT_PROFILE_MACROS,
     OPT_RESTRICT_WRITE18,
     OPT_SAVE_SIZE,
     OPT_SRC_SPECIALS,
@@ -147,6 +446,11 @@ void TeXApp::AddOptions()
         POPT_ARG_STRING,
         "N");
 
+    AddOption("profile-macros", T_("Measure the time spent in macros and write the call stacks to FILE."),
+        FIRST_OPTION_VAL + pimpl->optBase + OPT_PROFILE_MACROS,
+        POPT_ARG_STRING,
+        "FILE");
+
     AddOption("restrict-write18", T_("Partially enable the \\write18{COMMAND} construct."),
         FIRST_OPTION_VAL + pimpl->optBase + OPT_RESTRICT_WRITE18);
 
@@ -269,6 +573,9 @@ bool TeXApp::ProcessOption(int optchar, const string& optArg)
     case OPT_NEST_SIZE:
         GetUserParams()["nest_size"] = std::stoi(optArg);
         break;
+    case OPT_PROFILE_MACROS:
+        pimpl->macroProfileFile = optArg;
+        break;
     case OPT_RESTRICT_WRITE18:
         if (!inParseFirstLine)
         {
@@ -427,6 +734,36 @@ int TeXApp::GetSynchronizationOptions() const
     return pimpl->synchronizationOptions;
 }
 
+bool TeXApp::ProfileMacrosP() const
+{
+    return !pimpl->macroProfileFile.Empty();
+}
+
+void TeXApp::SetMacroProfilerLayout(int activeBase, int singleBase, int nullCs, int hashBase)
+{
+    if (pimpl->macroProfiler == nullptr)
+    {
+        pimpl->macroProfiler = make_unique<MacroProfiler>([this](int stringNumber) { return GetTeXString(stringNumber); });
+    }
+    pimpl->macroProfiler->SetLayout(activeBase, singleBase, nullCs, hashBase);
+}
+
+void TeXApp::EnterMacro(int cs, int csText, int sourceFileName, int line)
+{
+    if (pimpl->macroProfiler != nullptr)
+    {
+        pimpl->macroProfiler->Enter(cs, csText, sourceFileName, line);
+    }
+}
+
+void TeXApp::LeaveMacro()
+{
+    if (pimpl->macroProfiler != nullptr)
+    {
+        pimpl->macroProfiler->Leave();
+    }
+}
+
 bool TeXApp::EncTeXP() const
 {
     return pimpl->enableEncTeX;
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief TeX'n'Friends helpers
  *
- * @copyright Copyright © 1996-2022 Christian Schenk
+ * @copyright Copyright © 1996-2024 Christian Schenk
  *
  * This file is part of the MiKTeX TeXMF Framework.
  *
@@ -11,6 +11,15 @@
  * version 2 or any later version.
  */
 
+#if defined(MIKTEX_WINDOWS)
+#   include <algorithm>
+#   include <mutex>
+#   include <shared_mutex>
+#   include <vector>
+#else
+#   include <sys/mman.h>
+#endif
+
 #include <miktex/Core/Paths>
 #include <miktex/Core/StreamReader>
 
@@ -81,6 +90,142 @@ int MIKTEXCEECALL MiKTeX::TeXAndFriends::OpenXVFFile(void* ptr, const PathName&
     MIKTEX_API_END("OpenXVFFile");
 }
 
+#if defined(MIKTEX_WINDOWS)
+namespace
+{
+    // address space reserved by ReserveElasticMemory(); pages are committed
+    // when they are accessed for the first time
+    struct ElasticBlock
+    {
+        char* begin = nullptr;
+        size_t size = 0;
+    };
+
+    shared_mutex elasticBlocksMutex;
+    vector<ElasticBlock> elasticBlocks;
+    once_flag commitOnAccessFlag;
+
+    // commit 64 KB at a time, so that filling an array does not take a
+    // fault per page
+    constexpr size_t COMMIT_CHUNK_SIZE = 64 * 1024;
+
+    bool TryGetElasticBlock(const char* address, ElasticBlock& result)
+    {
+        shared_lock<shared_mutex> lock(elasticBlocksMutex);
+        for (const ElasticBlock& block : elasticBlocks)
+        {
+            if (address >= block.begin && address < block.begin + block.size)
+            {
+                result = block;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Commit(const ElasticBlock& block, size_t offset, size_t size)
+    {
+        size_t begin = offset / COMMIT_CHUNK_SIZE * COMMIT_CHUNK_SIZE;
+        size_t end = min((offset + size + COMMIT_CHUNK_SIZE - 1) / COMMIT_CHUNK_SIZE * COMMIT_CHUNK_SIZE, block.size);
+        return VirtualAlloc(block.begin + begin, end - begin, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+    }
+
+    LONG CALLBACK CommitOnAccess(EXCEPTION_POINTERS* exceptionPointers)
+    {
+        const EXCEPTION_RECORD* record = exceptionPointers->ExceptionRecord;
+        if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION || record->NumberParameters < 2)
+        {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+        const char* address = reinterpret_cast<const char*>(record->ExceptionInformation[1]);
+        ElasticBlock block;
+        if (!TryGetElasticBlock(address, block) || !Commit(block, address - block.begin, 1))
+        {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+        return EXCEPTION_CONTINUE_EXECUTION;
+    }
+}
+#endif
+
+void* MIKTEXCEECALL MiKTeX::TeXAndFriends::ReserveElasticMemory(size_t size)
+{
+    MIKTEX_API_BEGIN("ReserveElasticMemory");
+    if (sizeof(void*) < 8 || size == 0)
+    {
+        // not enough address space
+        return nullptr;
+    }
+#if defined(MIKTEX_WINDOWS)
+    // reserve address space only: the exception handler commits pages when
+    // they are touched
+    call_once(commitOnAccessFlag, []()
+    {
+        if (AddVectoredExceptionHandler(1, CommitOnAccess) == nullptr)
+        {
+            MIKTEX_FATAL_WINDOWS_ERROR("AddVectoredExceptionHandler");
+        }
+    });
+    void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (ptr != nullptr)
+    {
+        unique_lock<shared_mutex> lock(elasticBlocksMutex);
+        elasticBlocks.push_back({ static_cast<char*>(ptr), size });
+    }
+    return ptr;
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+    flags |= MAP_NORESERVE;
+#endif
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+#endif
+    MIKTEX_API_END("ReserveElasticMemory");
+}
+
+void MIKTEXCEECALL MiKTeX::TeXAndFriends::ReleaseElasticMemory(void* ptr, size_t size)
+{
+    MIKTEX_API_BEGIN("ReleaseElasticMemory");
+    if (ptr == nullptr)
+    {
+        return;
+    }
+#if defined(MIKTEX_WINDOWS)
+    {
+        unique_lock<shared_mutex> lock(elasticBlocksMutex);
+        elasticBlocks.erase(remove_if(elasticBlocks.begin(), elasticBlocks.end(), [ptr](const ElasticBlock& block) { return block.begin == ptr; }), elasticBlocks.end());
+    }
+    if (!VirtualFree(ptr, 0, MEM_RELEASE))
+    {
+        MIKTEX_FATAL_WINDOWS_ERROR("VirtualFree");
+    }
+#else
+    if (munmap(ptr, size) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("munmap");
+    }
+#endif
+    MIKTEX_API_END("ReleaseElasticMemory");
+}
+
+void MIKTEXCEECALL MiKTeX::TeXAndFriends::CommitElasticMemory(void* ptr, size_t size)
+{
+    MIKTEX_API_BEGIN("CommitElasticMemory");
+#if defined(MIKTEX_WINDOWS)
+    ElasticBlock block;
+    if (size == 0 || !TryGetElasticBlock(static_cast<const char*>(ptr), block))
+    {
+        return;
+    }
+    if (!Commit(block, static_cast<const char*>(ptr) - block.begin, size))
+    {
+        MIKTEX_FATAL_WINDOWS_ERROR("VirtualAlloc");
+    }
+#endif
+    MIKTEX_API_END("CommitElasticMemory");
+}
+
 STATICFUNC(bool) OpenAlphaFile(void* p, const char* lpszFileName, FileType fileType, const char* lpszExtension)
 {
     MIKTEX_ASSERT(p != nullptr);
@@ -57,6 +57,7 @@
 #define MIKTEX_TRACE_MTPRINT "mtprint"
 #define MIKTEX_TRACE_PROCESS "process"
 #define MIKTEX_TRACE_SETUP "setup"
+#define MIKTEX_TRACE_SHAPING "shaping"
 #define MIKTEX_TRACE_STOPWATCH "stopwatch"
 #define MIKTEX_TRACE_TEMPFILE "tempfile"
 #define MIKTEX_TRACE_TIME "time"
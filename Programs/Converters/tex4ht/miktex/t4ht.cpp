@@ -0,0 +1,588 @@
+/**
+ * @file miktex/t4ht.cpp
+ * @author Christian Schenk
+ * @brief MiKTeX t4ht picture jobs
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Process>
+#include <miktex/Util/PathName>
+
+#include "t4ht.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    /// A picture: the commands which convert a DVI page into an image file.
+    struct PictureJob
+    {
+        string idvName;
+        long page;
+        PathName outputPath;
+        /// Used to compute the cache key.
+        string templates;
+        /// Produce the picture.
+        vector<string> commands;
+        /// Run in any case (e.g., chmod).
+        vector<string> epilogue;
+        bool collectingEpilogue = false;
+        PathName cachePath;
+        int exitCode = 0;
+        string output;
+    };
+
+    /// The pages of a DVI file.
+    class IdvFile
+    {
+    public:
+
+        bool Load(const PathName& path)
+        {
+            if (!File::Exists(path))
+            {
+                return false;
+            }
+            bytes = File::ReadAllBytes(path);
+            return ParsePostamble();
+        }
+
+        /// Gets the bytes which determine the rendering of a page: the
+        /// preamble parameters (without the comment, which carries a
+        /// timestamp), the page body (without the bop header) and the
+        /// postamble definitions of the fonts which the page selects.
+        bool GetPageContents(long page, string& contents) const
+        {
+            size_t idx = bops.size();
+            for (size_t i = 0; i < bops.size(); ++i)
+            {
+                if (Read4(bops[i] + 1) == page)
+                {
+                    idx = i;
+                    break;
+                }
+            }
+            if (idx == bops.size())
+            {
+                if (page < 1 || page > static_cast<long>(bops.size()))
+                {
+                    return false;
+                }
+                idx = page - 1;
+            }
+            size_t begin = bops[idx] + BOP_SIZE;
+            size_t end = idx + 1 < bops.size() ? bops[idx + 1] : post;
+            set<long> fonts;
+            if (!GetFonts(begin, end, fonts))
+            {
+                return false;
+            }
+            // i, num, den, mag
+            contents.assign(reinterpret_cast<const char*>(&bytes[1]), 13);
+            contents.append(reinterpret_cast<const char*>(&bytes[begin]), end - begin);
+            for (long font : fonts)
+            {
+                auto it = fontDefs.find(font);
+                if (it != fontDefs.end())
+                {
+                    // checksum, scale, design size and name
+                    contents.append(reinterpret_cast<const char*>(&bytes[it->second.first]), it->second.second);
+                }
+            }
+            return true;
+        }
+
+    private:
+
+        static constexpr size_t BOP_SIZE = 45;
+        static constexpr size_t PRE_SIZE = 15;
+        static constexpr size_t POST_SIZE = 29;
+        static constexpr uint8_t SET1 = 128;
+        static constexpr uint8_t SET_RULE = 132;
+        static constexpr uint8_t PUT1 = 133;
+        static constexpr uint8_t PUT_RULE = 137;
+        static constexpr uint8_t NOP = 138;
+        static constexpr uint8_t BOP = 139;
+        static constexpr uint8_t RIGHT1 = 143;
+        static constexpr uint8_t FNT_NUM_0 = 171;
+        static constexpr uint8_t FNT1 = 235;
+        static constexpr uint8_t XXX1 = 239;
+        static constexpr uint8_t FNT_DEF1 = 243;
+        static constexpr uint8_t PRE = 247;
+        static constexpr uint8_t POST = 248;
+        static constexpr uint8_t POST_POST = 249;
+        static constexpr uint8_t FILLER = 223;
+
+        long Read4(size_t pos) const
+        {
+            return static_cast<int32_t>((static_cast<uint32_t>(bytes[pos]) << 24) | (bytes[pos + 1] << 16) | (bytes[pos + 2] << 8) | bytes[pos + 3]);
+        }
+
+        /// Reads an n-byte parameter; only four-byte parameters are signed.
+        long ReadParameter(size_t pos, size_t n) const
+        {
+            if (n == 4)
+            {
+                return Read4(pos);
+            }
+            long value = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                value = (value << 8) | bytes[pos + i];
+            }
+            return value;
+        }
+
+        /// Gets the size of a fnt_def command.
+        bool GetFontDefSize(size_t pos, size_t end, size_t& size) const
+        {
+            size_t n = bytes[pos] - FNT_DEF1 + 1;
+            size_t lengths = pos + 1 + n + 12;
+            if (lengths + 2 > end)
+            {
+                return false;
+            }
+            size = 1 + n + 12 + 2 + bytes[lengths] + bytes[lengths + 1];
+            return pos + size <= end;
+        }
+
+        /// Collects the fonts which are selected by the commands in
+        /// [`begin`, `end`).
+        bool GetFonts(size_t begin, size_t end, set<long>& fonts) const
+        {
+            size_t pos = begin;
+            while (pos < end)
+            {
+                uint8_t op = bytes[pos];
+                size_t size;
+                if (op < SET1 || op == NOP || (op > BOP && op < RIGHT1) || (op >= FNT_NUM_0 && op < FNT1))
+                {
+                    // set_char, nop, eop, push, pop, fnt_num
+                    size = 1;
+                    if (op >= FNT_NUM_0)
+                    {
+                        fonts.insert(op - FNT_NUM_0);
+                    }
+                }
+                else if (op == SET_RULE || op == PUT_RULE)
+                {
+                    size = 9;
+                }
+                else if (op < SET_RULE || (op >= PUT1 && op < PUT_RULE))
+                {
+                    size = 1 + (op - (op < SET_RULE ? SET1 : PUT1)) + 1;
+                }
+                else if (op >= RIGHT1 && op < FNT_NUM_0)
+                {
+                    // right, w, x, down, y, z: w0, x0, y0 and z0 have no
+                    // parameter
+                    static const uint8_t sizes[] = { 2, 3, 4, 5, 1, 2, 3, 4, 5, 1, 2, 3, 4, 5, 2, 3, 4, 5, 1, 2, 3, 4, 5, 1, 2, 3, 4, 5 };
+                    size = sizes[op - RIGHT1];
+                }
+                else if (op >= FNT1 && op < XXX1)
+                {
+                    size_t n = op - FNT1 + 1;
+                    if (pos + 1 + n > end)
+                    {
+                        return false;
+                    }
+                    fonts.insert(ReadParameter(pos + 1, n));
+                    size = 1 + n;
+                }
+                else if (op >= XXX1 && op < FNT_DEF1)
+                {
+                    size_t n = op - XXX1 + 1;
+                    if (pos + 1 + n > end)
+                    {
+                        return false;
+                    }
+                    long k = ReadParameter(pos + 1, n);
+                    if (k < 0)
+                    {
+                        return false;
+                    }
+                    size = 1 + n + k;
+                }
+                else if (op >= FNT_DEF1 && op < PRE)
+                {
+                    if (!GetFontDefSize(pos, end, size))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    // bop, pre, post, post_post or undefined
+                    return false;
+                }
+                pos += size;
+            }
+            return pos == end;
+        }
+
+        bool ParseFontDefs()
+        {
+            size_t pos = post + POST_SIZE;
+            while (pos < bytes.size() && bytes[pos] != POST_POST)
+            {
+                if (bytes[pos] == NOP)
+                {
+                    ++pos;
+                    continue;
+                }
+                size_t size;
+                if (bytes[pos] < FNT_DEF1 || bytes[pos] >= PRE || !GetFontDefSize(pos, bytes.size(), size))
+                {
+                    return false;
+                }
+                size_t n = bytes[pos] - FNT_DEF1 + 1;
+                fontDefs[ReadParameter(pos + 1, n)] = make_pair(pos + 1 + n, size - 1 - n);
+                pos += size;
+            }
+            return pos < bytes.size();
+        }
+
+        bool ParsePostamble()
+        {
+            size_t pos = bytes.size();
+            while (pos > 0 && bytes[pos - 1] == FILLER)
+            {
+                --pos;
+            }
+            // id byte and pointer to the postamble
+            if (pos < 6 || bytes[pos - 6] != POST_POST)
+            {
+                return false;
+            }
+            long postPos = Read4(pos - 5);
+            if (postPos < 0 || static_cast<size_t>(postPos) + 5 > bytes.size() || bytes[postPos] != POST)
+            {
+                return false;
+            }
+            post = postPos;
+            for (long bop = Read4(post + 1); bop >= 0; bop = Read4(bop + 41))
+            {
+                if (static_cast<size_t>(bop) + BOP_SIZE > post || bytes[bop] != BOP || bops.size() > bytes.size() / BOP_SIZE)
+                {
+                    return false;
+                }
+                bops.push_back(bop);
+            }
+            reverse(bops.begin(), bops.end());
+            return !bops.empty() && bytes[0] == PRE && bops[0] >= PRE_SIZE && ParseFontDefs();
+        }
+
+        vector<uint8_t> bytes;
+        vector<size_t> bops;
+        size_t post = 0;
+        /// Font number -> offset and size of the definition (without the
+        /// font number).
+        map<long, pair<size_t, size_t>> fontDefs;
+    };
+
+    const char* const CACHE_DIRECTORY = ".t4ht-cache";
+
+    // cached pictures which have not been used for this long are removed
+    constexpr time_t CACHE_MAX_AGE = 30 * 24 * 60 * 60;
+
+    unsigned maxJobs = 1;
+    bool useCache = true;
+    bool ignoreErrors = false;
+    vector<unique_ptr<PictureJob>> jobs;
+    unique_ptr<PictureJob> currentJob;
+    map<string, unique_ptr<IdvFile>> idvFiles;
+    bool haveCacheDirectory = false;
+    mutex outputMutex;
+
+    int RunCommands(const vector<string>& commands, string& output)
+    {
+        for (const string& command : commands)
+        {
+            ProcessOutput<1024 * 1024> processOutput;
+            int exitCode;
+            output += "System call: " + command + "\n";
+            try
+            {
+                if (!Process::ExecuteSystemCommand(command, &exitCode, &processOutput, nullptr))
+                {
+                    exitCode = -1;
+                }
+            }
+            catch (const MiKTeXException&)
+            {
+                exitCode = -1;
+            }
+            output += processOutput.StdoutToString();
+            output += (exitCode != 0 ? "--- Warning --- " : "") + string("System return: ") + std::to_string(exitCode) + "\n";
+            // -g: keep going, like call_sys() does
+            if (exitCode != 0 && !ignoreErrors)
+            {
+                return exitCode;
+            }
+        }
+        return 0;
+    }
+
+    void RunJob(PictureJob& job)
+    {
+        if (!job.cachePath.Empty() && File::Exists(job.cachePath))
+        {
+            File::Copy(job.cachePath, job.outputPath);
+            // the modification time tells when the picture has been used
+            time_t now = time(nullptr);
+            File::SetTimes(job.cachePath, now, now, now);
+            job.output = job.outputPath.ToString() + " reused from previous run\n";
+        }
+        else
+        {
+            job.exitCode = RunCommands(job.commands, job.output);
+            if (job.exitCode == 0 && !job.cachePath.Empty() && File::Exists(job.outputPath))
+            {
+                // identical pictures may be stored concurrently
+                PathName tempPath = job.cachePath;
+                tempPath.AppendExtension(".tmp" + std::to_string(job.page));
+                File::Copy(job.outputPath, tempPath);
+                File::Move(tempPath, job.cachePath);
+            }
+        }
+        if (job.exitCode == 0)
+        {
+            job.exitCode = RunCommands(job.epilogue, job.output);
+        }
+        lock_guard<mutex> lock(outputMutex);
+        fputs(job.output.c_str(), stdout);
+        fflush(stdout);
+    }
+
+    void ComputeCachePath(PictureJob& job)
+    {
+        auto it = idvFiles.find(job.idvName);
+        if (it == idvFiles.end())
+        {
+            unique_ptr<IdvFile> idvFile = make_unique<IdvFile>();
+            if (!idvFile->Load(PathName(job.idvName).AppendExtension(".idv")))
+            {
+                idvFile = nullptr;
+            }
+            it = idvFiles.emplace(job.idvName, std::move(idvFile)).first;
+        }
+        string contents;
+        if (it->second == nullptr || !it->second->GetPageContents(job.page, contents))
+        {
+            return;
+        }
+        PathName cacheDirectory(CACHE_DIRECTORY);
+        if (!haveCacheDirectory)
+        {
+            Directory::Create(cacheDirectory);
+            haveCacheDirectory = true;
+        }
+        MD5Builder md5Builder;
+        md5Builder.Update(job.templates.c_str(), job.templates.length());
+        md5Builder.Update(contents.c_str(), contents.length());
+        job.cachePath = cacheDirectory / md5Builder.Final().ToString();
+        job.cachePath.AppendExtension(job.outputPath.GetExtension());
+    }
+
+    void TryComputeCachePath(PictureJob& job)
+    {
+        if (!useCache)
+        {
+            return;
+        }
+        try
+        {
+            ComputeCachePath(job);
+        }
+        catch (const MiKTeXException&)
+        {
+            job.cachePath = "";
+        }
+    }
+
+    void RunJobAndReport(PictureJob& job)
+    {
+        try
+        {
+            RunJob(job);
+        }
+        catch (const MiKTeXException& e)
+        {
+            job.exitCode = -1;
+            lock_guard<mutex> lock(outputMutex);
+            fprintf(stdout, "--- Warning --- %s: %s\n", job.outputPath.GetData(), e.GetErrorMessage().c_str());
+        }
+    }
+
+    /// Removes pictures which have not been used for a long time, and
+    /// leftovers of interrupted runs.
+    void EvictCachedPictures()
+    {
+        PathName cacheDirectory(CACHE_DIRECTORY);
+        if (!Directory::Exists(cacheDirectory))
+        {
+            return;
+        }
+        time_t now = time(nullptr);
+        vector<PathName> toBeRemoved;
+        unique_ptr<DirectoryLister> lister = DirectoryLister::Open(cacheDirectory);
+        DirectoryEntry entry;
+        while (lister->GetNext(entry))
+        {
+            if (entry.isDirectory)
+            {
+                continue;
+            }
+            PathName path = cacheDirectory / entry.name;
+            time_t age = now - File::GetLastWriteTime(path);
+            bool isTemporary = entry.name.find(".tmp") != string::npos;
+            if (age > CACHE_MAX_AGE || (isTemporary && age > 60 * 60))
+            {
+                toBeRemoved.push_back(path);
+            }
+        }
+        lister->Close();
+        for (const PathName& path : toBeRemoved)
+        {
+            File::Delete(path);
+        }
+    }
+}
+
+void miktex_set_picture_jobs(int n)
+{
+    maxJobs = n > 0 ? n : thread::hardware_concurrency();
+    maxJobs = max(maxJobs, 1u);
+}
+
+void miktex_enable_picture_cache(bool enable)
+{
+    useCache = enable;
+}
+
+void miktex_ignore_picture_job_errors(bool ignore)
+{
+    ignoreErrors = ignore;
+}
+
+bool miktex_picture_jobs_parallel()
+{
+    return maxJobs > 1;
+}
+
+void miktex_begin_picture_job(const char* idvName, long page, const char* outputPath)
+{
+    currentJob = make_unique<PictureJob>();
+    currentJob->idvName = idvName;
+    currentJob->page = page;
+    currentJob->outputPath = outputPath;
+}
+
+void miktex_add_picture_job_template(const char* commandTemplate)
+{
+    currentJob->templates += commandTemplate;
+    currentJob->templates += '\n';
+}
+
+void miktex_begin_picture_job_epilogue()
+{
+    currentJob->collectingEpilogue = true;
+}
+
+int miktex_end_picture_job()
+{
+    unique_ptr<PictureJob> job = std::move(currentJob);
+    if (maxJobs > 1)
+    {
+        jobs.push_back(std::move(job));
+        return 0;
+    }
+    // -j1: convert the picture right away, as without jobs
+    TryComputeCachePath(*job);
+    RunJobAndReport(*job);
+    return job->exitCode;
+}
+
+bool miktex_collect_picture_command(const char* command)
+{
+    if (currentJob == nullptr)
+    {
+        return false;
+    }
+    (currentJob->collectingEpilogue ? currentJob->epilogue : currentJob->commands).push_back(command);
+    return true;
+}
+
+int miktex_run_picture_jobs()
+{
+    for (auto& job : jobs)
+    {
+        TryComputeCachePath(*job);
+    }
+    atomic_size_t nextJob(0);
+    auto worker = [&nextJob]()
+    {
+        for (size_t idx = nextJob++; idx < jobs.size(); idx = nextJob++)
+        {
+            RunJobAndReport(*jobs[idx]);
+        }
+    };
+    vector<thread> workers;
+    for (unsigned n = 1; n < min(maxJobs, static_cast<unsigned>(jobs.size())); ++n)
+    {
+        workers.push_back(thread(worker));
+    }
+    worker();
+    for (thread& t : workers)
+    {
+        t.join();
+    }
+    int exitCode = 0;
+    for (const auto& job : jobs)
+    {
+        if (job->exitCode != 0)
+        {
+            exitCode = job->exitCode;
+        }
+    }
+    jobs.clear();
+    idvFiles.clear();
+    if (useCache)
+    {
+        try
+        {
+            EvictCachedPictures();
+        }
+        catch (const MiKTeXException&)
+        {
+        }
+    }
+    return exitCode;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file miktex/t4ht.h
+ * @author Christian Schenk
+ * @brief MiKTeX t4ht picture jobs
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+/// Sets the maximum number of pictures which are converted at the same time.
+void miktex_set_picture_jobs(int maxJobs);
+
+/// Enables/disables the reuse of pictures from previous runs.
+void miktex_enable_picture_cache(bool enable);
+
+/// Keeps running the commands of a job after a command has failed (`-g`).
+void miktex_ignore_picture_job_errors(bool ignore);
+
+/// Returns `true`, if pictures are converted in parallel.
+bool miktex_picture_jobs_parallel();
+
+/// Starts collecting the commands which convert a DVI page into a picture.
+/// @param idvName The name of the DVI file (without `.idv`).
+/// @param page The page number.
+/// @param outputPath The path to the resulting picture file.
+void miktex_begin_picture_job(const char* idvName, long page, const char* outputPath);
+
+/// Adds a command template to the cache key of the current job.
+void miktex_add_picture_job_template(const char* commandTemplate);
+
+/// Subsequent commands will be run, even if the picture is found in the cache.
+void miktex_begin_picture_job_epilogue();
+
+/// Queues the current job, or runs it right away if pictures are converted
+/// one at a time.
+/// @return Returns 0, if the job has been queued or has succeeded.
+int miktex_end_picture_job();
+
+/// Collects a command, if a picture job is being built.
+/// @return Returns `true`, if the command has been collected.
+bool miktex_collect_picture_command(const char* command);
+
+/// Runs the queued jobs and removes pictures from the cache which have not
+/// been used for a long time.
+/// @return Returns 0, if all jobs have succeeded.
+int miktex_run_picture_jobs();
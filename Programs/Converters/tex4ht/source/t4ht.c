@@ -112,6 +112,7 @@
 #endif
 #if defined(MIKTEX)
 # include <miktex/tex4ht.h>
+# include <miktex/t4ht.h>
 #endif
 
 #ifdef KPATHSEA
@@ -460,9 +461,15 @@ static const C_CHAR *warn_err_mssg[]={
 "  -e...  location of tex4ht.env\n"
 "  -i     debugging info\n"
 "  -g     ignore errors in system calls\n"
+#if defined(MIKTEX)
+"  -j...  convert ... pictures at a time (0: one per CPU; default: 1)\n"
+#endif
 "  -m...  chmod ... of new output files (reused bitmaps excluded)\n"
 "  -p     don't convert pictures           (default:  convert)\n"
 "  -r     replace bitmaps of all glyphs    (default:  reuse old ones)\n"
+#if defined(MIKTEX)
+"         and don't reuse pictures from .t4ht-cache\n"
+#endif
 "  -M...  chmod ... of all output files\n"
 "  -Q     quit, if tex4ht.c had problems\n"
 "  -S...  permission for system calls: *-always, filter\n"
@@ -1188,6 +1195,9 @@ static void call_sys
 #endif
 {
    if( *command ){
+#if defined(MIKTEX)
+      if( system_yes && miktex_collect_picture_command(command) ){ return; }
+#endif
       (IGNORED) printf("System call: %s\n", command);
 #if defined(MIKTEX)
       system_return = system_yes ? miktex_system(command) : -1;
@@ -1668,11 +1678,22 @@ lg_name++;
 
  break; }
   case 'i':{ debug = q-1;  break;}
-  case 'g':{ always_call_sys = TRUE;  break;}
+  case 'g':{ always_call_sys = TRUE;
+#if defined(MIKTEX)
+    miktex_ignore_picture_job_errors(TRUE);
+#endif
+    break;}
+#if defined(MIKTEX)
+  case 'j':{ miktex_set_picture_jobs(atoi(q));  break;}
+#endif
   case 'm':{ ch_mod = q;  break; }
   case 'p':{ nopict = q-1;  break;}
   case 'Q':{ check_tex4ht_c_err = TRUE;  break;}
-  case 'r':{ noreuse = q-1;  break;}
+  case 'r':{ noreuse = q-1;
+#if defined(MIKTEX)
+    miktex_enable_picture_cache(false);
+#endif
+    break;}
   case '.':{ Dotfield = q;  break;}
    default:{ bad_arg;  }
 }
@@ -2680,6 +2701,37 @@ empty_pic = empty_pic->next;
 if( !nopict && !skip ){
    
 filtered_dvigif_script = filterGifScript(dvigif_script, match[3]);
+#if defined(MIKTEX)
+{                 struct script_struct *scr;
+                  Q_CHAR output_path[255], unique_name[300];
+(IGNORED) strcpy((char *) output_path, "");
+if( dir && !bitmaps_no_dm ){ (IGNORED) strct(output_path, dir); }
+(IGNORED) strct(output_path, match[3]);
+miktex_begin_picture_job(match[1], gif_i, output_path);
+/* collected commands don't set system_return: the job stops at the
+   first failure */
+system_return = 0;
+for( scr = filtered_dvigif_script; scr; scr = scr->next ){
+  miktex_add_picture_job_template(scr->command);
+}
+if( miktex_picture_jobs_parallel() ){
+  (IGNORED) sprintf(unique_name, "%s-%ld", job_name, gif_i);
+} else {
+  (IGNORED) strcpy((char *) unique_name, (char *) job_name);
+}
+(void) execute_script(
+  filtered_dvigif_script,match[1],match[2],match[3],unique_name);
+(void) free_script( filtered_dvigif_script );
+if( dir && !bitmaps_no_dm && !system_return ){
+  (void) execute_script(move_script,match[3],dir,".","");
+}
+miktex_begin_picture_job_epilogue();
+if( ch_mod && !bitmaps_no_dm && !system_return ){
+  (void) execute_script(chmod_script, ch_mod, dir?dir:"",match[3], "");
+}
+system_return = miktex_end_picture_job();
+}
+#else
 (void) execute_script(
   filtered_dvigif_script,match[1],match[2],match[3],job_name);
 (void) free_script( filtered_dvigif_script );
@@ -2689,6 +2741,7 @@ if( dir && !bitmaps_no_dm && !system_return ){
 if( ch_mod && !bitmaps_no_dm && !system_return ){
   (void) execute_script(chmod_script, ch_mod, dir?dir:"",match[3], "");
 }
+#endif
 
 
 }
@@ -2720,6 +2773,9 @@ if( status ){
       }
       if ( eoln_ch == EOF ){ break; }
 }  }
+#if defined(MIKTEX)
+system_return = miktex_run_picture_jobs();
+#endif
 
 
    
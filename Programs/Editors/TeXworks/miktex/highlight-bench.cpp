@@ -0,0 +1,115 @@
+/**
+ * @file miktex/highlight-bench.cpp
+ * @author Christian Schenk
+ * @brief Syntax highlighter benchmark
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <QApplication>
+#include <QStringList>
+
+#include "TWUtils.h"
+#include "TeXHighlighter.h"
+#include "document/TeXDocument.h"
+
+#include "miktex-texworks.hpp"
+
+using namespace std;
+
+// Generates a LaTeX document with roughly numLines lines; the mix of
+// sections, environments, math, comments and plain text exercises all kinds
+// of highlighting rules
+static QString MakeDocument(int numLines)
+{
+    QStringList lines;
+    lines << QStringLiteral("\\documentclass{article}")
+          << QStringLiteral("\\usepackage{amsmath}")
+          << QStringLiteral("\\begin{document}");
+    for (int n = 0; lines.size() < numLines; ++n)
+    {
+        lines << QStringLiteral("\\section{Section %1}\\label{sec:%1}").arg(n)
+              << QStringLiteral("% a comment with a \\command and $math$ that must not be highlighted")
+              << QStringLiteral("Some \\emph{emphasized} text, a reference to Section~\\ref{sec:%1} and a citation~\\cite{key%1}.").arg(n)
+              << QStringLiteral("Inline math $a_%1 + b^{2} = \\sqrt{c}$ and more plain text to fill the line.").arg(n)
+              << QStringLiteral("\\begin{equation}")
+              << QStringLiteral("  \\int_0^\\infty e^{-x^2}\\,dx = \\frac{\\sqrt{\\pi}}{2} % equation %1").arg(n)
+              << QStringLiteral("\\end{equation}")
+              << QStringLiteral("\\begin{itemize}")
+              << QStringLiteral("  \\item \\textbf{bold} and \\texttt{typewriter} text")
+              << QStringLiteral("\\end{itemize}");
+    }
+    lines << QStringLiteral("\\end{document}");
+    return lines.join(QChar::fromLatin1('\n'));
+}
+
+static int Main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+    // the same settings as TWApp, so that the syntax patterns are found in
+    // the resources library
+    QCoreApplication::setOrganizationName(QString::fromLatin1("TUG"));
+    QCoreApplication::setOrganizationDomain(QString::fromLatin1("tug.org"));
+    QCoreApplication::setApplicationName(QString::fromLatin1(TEXWORKS_NAME));
+
+    int numLines = 20000;
+    int repetitions = 5;
+    if (argc > 1)
+    {
+        numLines = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        repetitions = atoi(argv[2]);
+    }
+    if (numLines < 1 || repetitions < 1)
+    {
+        cerr << "Usage: " << argv[0] << " [LINES [REPETITIONS]]" << endl;
+        return EXIT_FAILURE;
+    }
+
+    Tw::Document::TeXDocument document(MakeDocument(numLines));
+    TeXHighlighter highlighter(&document);
+    int index = TeXHighlighter::syntaxOptions().indexOf(QStringLiteral("LaTeX"));
+    if (index < 0)
+    {
+        cerr << "no LaTeX syntax patterns found" << endl;
+        return EXIT_FAILURE;
+    }
+    highlighter.setActiveIndex(index);
+    // warm up caches
+    highlighter.highlightPendingBlocks();
+
+    vector<double> samples;
+    for (int n = 0; n < repetitions; ++n)
+    {
+        highlighter.rehighlight();
+        auto start = chrono::steady_clock::now();
+        highlighter.highlightPendingBlocks();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count());
+    }
+    sort(samples.begin(), samples.end());
+    double median = samples.size() % 2 == 1 ? samples[samples.size() / 2] : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+    cout << "lines: " << document.blockCount() << endl
+         << "min: " << samples.front() << " ms" << endl
+         << "median: " << median << " ms" << endl
+         << "median per line: " << median * 1000.0 / document.blockCount() << " us" << endl;
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    MiKTeX::TeXworks::Wrapper wrapper;
+    return wrapper.Run(Main, argc, argv);
+}
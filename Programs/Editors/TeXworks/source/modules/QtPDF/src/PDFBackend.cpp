@@ -398,13 +398,13 @@ QSharedPointer<QImage> Page::getCachedImage(double xres, double yres, QRect rend
   return _parent->pageCache().getImage(tile);
 }
 
-void Page::asyncRenderToImage(QObject *listener, double xres, double yres, QRect render_box, bool cache)
+void Page::asyncRenderToImage(QObject *listener, double xres, double yres, QRect render_box, bool cache, PageProcessingRequest::Priority priority)
 {
   QReadLocker docLocker(_docLock.data());
   QReadLocker pageLocker(&_pageLock);
   if (!_parent)
     return;
-  _parent->processingThread().addPageProcessingRequest(new PageProcessingRenderPageRequest(this, listener, xres, yres, render_box, cache));
+  _parent->processingThread().addPageProcessingRequest(new PageProcessingRenderPageRequest(this, listener, xres, yres, render_box, cache, priority));
 }
 
 bool higherResolutionThan(const PDFPageTile & t1, const PDFPageTile & t2)
@@ -413,7 +413,7 @@ bool higherResolutionThan(const PDFPageTile & t1, const PDFPageTile & t2)
   return t1.xres > t2.xres;
 }
 
-QSharedPointer<QImage> Page::getTileImage(QObject * listener, const double xres, const double yres, QRect render_box /* = QRect() */)
+QSharedPointer<QImage> Page::getTileImage(QObject * listener, const double xres, const double yres, QRect render_box /* = QRect() */, const PageProcessingRequest::Priority priority /* = PageProcessingRequest::Priority_Visible */)
 {
   QReadLocker docLocker(_docLock.data());
   QReadLocker pageLocker(&_pageLock);
@@ -428,6 +428,11 @@ QSharedPointer<QImage> Page::getTileImage(QObject * listener, const double xres,
   // background and we don't need to do anything)
   PDFPageCache::TileStatus status{PDFPageCache::UNKNOWN};
   QSharedPointer<QImage> retVal = getCachedImage(xres, yres, render_box, &status);
+  if (retVal && status == PDFPageCache::PLACEHOLDER && listener && _parent) {
+    // The tile may have been queued with a lower priority (e.g., as a
+    // prefetched tile that has now become visible)
+    _parent->processingThread().raisePriority(listener, xres, yres, render_box, priority);
+  }
   if (retVal && (status == PDFPageCache::CURRENT || status == PDFPageCache::PLACEHOLDER))
     return retVal;
 
@@ -437,7 +442,7 @@ QSharedPointer<QImage> Page::getTileImage(QObject * listener, const double xres,
     // Note: Start the rendering in the background before constructing the image
     // to take advantage of multi-core CPUs. Since we hold the write lock here
     // there's nothing to worry about
-    asyncRenderToImage(listener, xres, yres, render_box, true);
+    asyncRenderToImage(listener, xres, yres, render_box, true, priority);
 
     if (retVal && status == PDFPageCache::OUTDATED) {
       // If we have an outdated image, use that as a placeholder
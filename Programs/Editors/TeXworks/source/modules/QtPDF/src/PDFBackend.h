@@ -221,7 +221,7 @@ protected:
   QSharedPointer<QImage> getCachedImage(double xres, double yres, QRect render_box = QRect(), PDFPageCache::TileStatus * status = nullptr);
 
   // Uses doc-read-lock and page-read-lock.
-  virtual void asyncRenderToImage(QObject *listener, double xres, double yres, QRect render_box = QRect(), bool cache = false);
+  virtual void asyncRenderToImage(QObject *listener, double xres, double yres, QRect render_box = QRect(), bool cache = false, PageProcessingRequest::Priority priority = PageProcessingRequest::Priority_Visible);
 
 public:
   // Class to encapsulate boxes, e.g., for selecting
@@ -277,8 +277,11 @@ public:
   // returns a dummy image (which is added to the cache to speed up future
   // requests). Otherwise, the method renders the page synchronously and returns
   // the result.
+  // `priority` determines the order in which asynchronous requests are
+  // processed (e.g., tiles that are currently visible come before tiles that
+  // are merely prefetched).
   // Uses page-read-lock and doc-read-lock.
-  QSharedPointer<QImage> getTileImage(QObject * listener, const double xres, const double yres, QRect render_box = QRect());
+  QSharedPointer<QImage> getTileImage(QObject * listener, const double xres, const double yres, QRect render_box = QRect(), const PageProcessingRequest::Priority priority = PageProcessingRequest::Priority_Visible);
 
   virtual QList< QSharedPointer<Annotation::AbstractAnnotation> > loadAnnotations() { return QList< QSharedPointer<Annotation::AbstractAnnotation> >(); }
 
@@ -1335,6 +1335,8 @@ void PDFDocumentView::paintEvent(QPaintEvent *event)
       _currentPage = nextCurrentPage;
       emit changedPage(_currentPage);
     }
+
+    cancelStaleRenderRequests();
   }
 
   if (_armedTool)
@@ -1343,6 +1345,32 @@ void PDFDocumentView::paintEvent(QPaintEvent *event)
   emit updated();
 }
 
+void PDFDocumentView::cancelStaleRenderRequests()
+{
+  if (!_pdf_scene)
+    return;
+  QSharedPointer<Backend::Document> doc(_pdf_scene->document().toStrongRef());
+  if (!doc)
+    return;
+
+  QSet<const QObject *> visiblePages;
+  const QList<QGraphicsItem *> visibleItems = items(viewport()->rect());
+  for (const QGraphicsItem * item : visibleItems) {
+    if (isPageItem(item))
+      visiblePages.insert(static_cast<const PDFPageGraphicsItem *>(item));
+  }
+
+  // Only consider requests of page items in our own scene; the document may be
+  // shown in other views, too
+  const PDFDocumentScene * scene = _pdf_scene.data();
+  doc->processingThread().cancelRequests([scene, &visiblePages](const Backend::PageProcessingRequest & request) {
+    if (request.type() != Backend::PageProcessingRequest::PageRendering)
+      return false;
+    const PDFPageGraphicsItem * pageItem = qobject_cast<const PDFPageGraphicsItem *>(request.listener);
+    return (pageItem && pageItem->scene() == scene && !visiblePages.contains(request.listener));
+  });
+}
+
 void PDFDocumentView::keyPressEvent(QKeyEvent *event)
 {
   // FIXME: No moving while tools are active?
@@ -2407,6 +2435,19 @@ void PDFPageGraphicsItem::paint(QPainter *painter, const QStyleOptionGraphicsIte
 #endif
       }
     }
+
+    // Prefetch the rows of tiles directly above and below the visible ones so
+    // they are (likely) ready by the time they are scrolled into view. They
+    // are queued with a lower priority than the visible tiles.
+    const int numTileRows = (pageRect.height() + effectiveTileSize - 1) / effectiveTileSize;
+    for (const int j : {jmin - 1, jmax}) {
+      if (j < 0 || j >= numTileRows)
+        continue;
+      for (int i = imin; i < imax; ++i) {
+        QRect renderTile(i * TILE_SIZE, j * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+        page->getTileImage(this, _dpiX * scaleFactor * painter->device()->devicePixelRatio(), _dpiY * scaleFactor * painter->device()->devicePixelRatio(), renderTile, Backend::PageProcessingRequest::Priority_Prefetch);
+      }
+    }
   }
   painter->restore();
 }
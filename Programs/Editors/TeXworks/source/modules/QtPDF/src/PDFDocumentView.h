@@ -192,6 +192,10 @@ protected:
 
   void armTool(DocumentTool::AbstractTool * tool);
 
+  // Cancels pending render requests for pages of this view that are no longer
+  // visible
+  void cancelStaleRenderRequests();
+
 protected slots:
   void maybeUpdateSceneRect();
   void maybeArmTool(uint modifiers);
@@ -16,16 +16,27 @@
 
 #include <QImage>
 
+#include <algorithm>
+#include <vector>
+
 namespace QtPDF {
 
 namespace Backend {
 
+void PDFPageCache::setMaxCost(const size_type cost)
+{
+  QWriteLocker locker(&_lock);
+  m_maxCost = cost;
+  trim(m_maxCost);
+}
+
 QSharedPointer<QImage> PDFPageCache::getImage(const PDFPageTile & tile) const
 {
   QReadLocker locker(&_lock);
-  CachedTileData * data = m_cache.object(tile);
-  if (data) {
-    return data->image;
+  const auto it = m_cache.constFind(tile);
+  if (it != m_cache.constEnd()) {
+    touch(*it.value());
+    return it.value()->image;
   }
   return {};
 }
@@ -33,9 +44,9 @@ QSharedPointer<QImage> PDFPageCache::getImage(const PDFPageTile & tile) const
 PDFPageCache::TileStatus PDFPageCache::getStatus(const PDFPageTile & tile) const
 {
   QReadLocker locker(&_lock);
-  CachedTileData * data = m_cache.object(tile);
-  if (data) {
-    return data->status;
+  const auto it = m_cache.constFind(tile);
+  if (it != m_cache.constEnd()) {
+    return it.value()->status;
   }
   return UNKNOWN;
 }
@@ -44,37 +55,108 @@ QSharedPointer<QImage> PDFPageCache::setImage(const PDFPageTile & tile, QSharedP
 {
   QWriteLocker locker(&_lock);
 
-  auto insert = [this](const PDFPageTile & tile, QSharedPointer<QImage> image, const TileStatus status) {
-    CachedTileData * data = new CachedTileData{image, status};
-#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
-    m_cache.insert(tile, data, (image ? image->byteCount() : 0));
-#elif QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    // No image (1024x124x4 bytes by default) should ever come even close to the
-    // 2 GB mark corresponding to INT_MAX; note that Document::Document() sets
-    // the cache's max-size to 1 GB total
-    m_cache.insert(tile, data, (image ? static_cast<int>(image->sizeInBytes()) : 0));
-#else
-    m_cache.insert(tile, data, (image ? image->sizeInBytes() : 0));
-#endif
-  };
-
-  CachedTileData * data = m_cache.object(tile);
-  if (!data) {
+  const auto it = m_cache.constFind(tile);
+  if (it == m_cache.constEnd()) {
     insert(tile, image, status);
     return image;
   }
+  const QSharedPointer<CachedTileData> data = it.value();
   if (data->image == image) {
     // Trying to overwrite an image with itself - just update the status
     data->status = status;
+    touch(*data);
     return data->image;
   }
   if (overwrite) {
     insert(tile, image, status);
     return image;
   }
+  touch(*data);
   return data->image;
 }
 
+void PDFPageCache::setRenderCost(const PDFPageTile & tile, const qint64 msecs)
+{
+  QWriteLocker locker(&_lock);
+  const auto it = m_cache.constFind(tile);
+  if (it != m_cache.constEnd()) {
+    it.value()->renderCost = msecs;
+  }
+}
+
+void PDFPageCache::insert(const PDFPageTile & tile, QSharedPointer<QImage> image, const TileStatus status)
+{
+  remove(tile);
+
+  QSharedPointer<CachedTileData> data{new CachedTileData};
+  data->image = image;
+  data->status = status;
+#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
+  data->cost = (image ? image->byteCount() : 0);
+#elif QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  // No image (1024x124x4 bytes by default) should ever come even close to the
+  // 2 GB mark corresponding to INT_MAX; note that Document::Document() sets
+  // the cache's max-size to 1 GB total
+  data->cost = (image ? static_cast<int>(image->sizeInBytes()) : 0);
+#else
+  data->cost = (image ? image->sizeInBytes() : 0);
+#endif
+  // Just like QCache, refuse to hold objects that are larger than the whole
+  // cache
+  if (data->cost > m_maxCost) {
+    return;
+  }
+  touch(*data);
+  m_totalCost += data->cost;
+  m_cache.insert(tile, data);
+  trim(m_maxCost, &tile);
+}
+
+void PDFPageCache::remove(const PDFPageTile & tile)
+{
+  const auto it = m_cache.find(tile);
+  if (it == m_cache.end()) {
+    return;
+  }
+  m_totalCost -= it.value()->cost;
+  m_cache.erase(it);
+}
+
+void PDFPageCache::trim(const size_type maxCost, const PDFPageTile * keep /* = nullptr */)
+{
+  if (m_totalCost <= maxCost) {
+    return;
+  }
+
+  // Order the tiles from least to most recently used; this is only done when
+  // evicting, which happens at most once per rendered tile
+  struct Candidate {
+    PDFPageTile tile;
+    QSharedPointer<CachedTileData> data;
+    quint64 lastUse;
+  };
+  std::vector<Candidate> candidates;
+  candidates.reserve(static_cast<std::size_t>(m_cache.size()));
+  for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+    if (keep && it.key() == *keep) {
+      continue;
+    }
+    candidates.push_back({it.key(), it.value(), it.value()->lastUse.load(std::memory_order_relaxed)});
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate & a, const Candidate & b) { return a.lastUse < b.lastUse; });
+
+  auto begin = candidates.begin();
+  while (m_totalCost > maxCost && begin != candidates.end()) {
+    // Among the oldest few tiles, evict the one that is cheapest to re-render
+    const auto end = begin + std::min<std::ptrdiff_t>(EvictionCandidates, candidates.end() - begin);
+    const auto victim = std::min_element(begin, end, [](const Candidate & a, const Candidate & b) { return a.data->renderCost < b.data->renderCost; });
+    remove(victim->tile);
+    // Keep the remaining candidates in LRU order
+    std::rotate(begin, victim, victim + 1);
+    ++begin;
+  }
+}
+
 void PDFPageCache::removeDocumentTiles(const Document *doc)
 {
   QWriteLocker l(&_lock);
@@ -82,7 +164,7 @@ void PDFPageCache::removeDocumentTiles(const Document *doc)
   const auto keys = m_cache.keys();
   for (const PDFPageTile & tile : keys) {
     if (tile.doc == doc) {
-      m_cache.remove(tile);
+      remove(tile);
     }
   }
 }
@@ -91,14 +173,23 @@ void PDFPageCache::markOutdated(const Document * doc)
 {
   QWriteLocker l(&_lock);
 
-  const auto keys = m_cache.keys();
-  for (const PDFPageTile & tile : keys) {
-    if (tile.doc == doc) {
-      m_cache[tile]->status = OUTDATED;
+  for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+    if (it.key().doc == doc) {
+      it.value()->status = OUTDATED;
     }
   }
 }
 
+void PDFPageCache::markOutdated(const PDFPageTile & tile)
+{
+  QWriteLocker l(&_lock);
+
+  const auto it = m_cache.find(tile);
+  if (it != m_cache.end() && it.value()->status == PLACEHOLDER) {
+    it.value()->status = OUTDATED;
+  }
+}
+
 } // namespace Backend
 
 } // namespace QtPDF
@@ -17,12 +17,14 @@
 
 #include "PDFPageTile.h"
 
-#include <QCache>
+#include <QHash>
 #include <QMap>
 #include <QReadWriteLock>
 #include <QSharedPointer>
 #include <QWriteLocker>
 
+#include <atomic>
+
 class QImage;
 
 namespace QtPDF {
@@ -30,6 +32,9 @@ namespace QtPDF {
 namespace Backend {
 
 // This class is thread-safe
+// Like a QCache, the cache is bounded by the total size (in bytes) of the
+// images it holds. When it is full, it evicts one of the least recently used
+// tiles, preferring those that were cheapest to render (see setRenderCost()).
 class PDFPageCache
 {
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -40,8 +45,8 @@ class PDFPageCache
 public:
   enum TileStatus { UNKNOWN, PLACEHOLDER, CURRENT, OUTDATED };
 
-  size_type maxCost() const { QReadLocker locker(&_lock); return m_cache.maxCost(); }
-  void setMaxCost(const size_type cost) { QWriteLocker locker(&_lock); m_cache.setMaxCost(cost); }
+  size_type maxCost() const { QReadLocker locker(&_lock); return m_maxCost; }
+  void setMaxCost(const size_type cost);
 
   // Returns the image under the key `tile` or nullptr if it doesn't exist
   QSharedPointer<QImage> getImage(const PDFPageTile & tile) const;
@@ -50,24 +55,51 @@ public:
   // the insertion. If overwrite == true, this will always be image, otherwise
   // it can be different
   QSharedPointer<QImage> setImage(const PDFPageTile & tile, QSharedPointer<QImage> image, const TileStatus status, const bool overwrite = true);
+  // Records how long (in ms) it took to render the image under the key `tile`
+  // so that cheap tiles are evicted before expensive ones
+  void setRenderCost(const PDFPageTile & tile, const qint64 msecs);
 
-  void clear() { QWriteLocker l(&_lock); m_cache.clear(); }
+  void clear() { QWriteLocker l(&_lock); m_cache.clear(); m_totalCost = 0; }
   void removeDocumentTiles(const Document *doc);
   // Mark all tiles outdated
   void markOutdated(const Document *doc);
+  // Mark the tile outdated if it is a placeholder (e.g., because its render
+  // request was cancelled and the placeholder must not stay around forever)
+  void markOutdated(const PDFPageTile & tile);
 
   QList<PDFPageTile> tiles() const { QReadLocker locker(&_lock); return m_cache.keys(); }
 protected:
   struct CachedTileData {
     QSharedPointer<QImage> image;
-    TileStatus status;
+    TileStatus status{UNKNOWN};
+    size_type cost{0};
+    qint64 renderCost{0};
+    // Value of m_useCounter at the time of the last access; atomic as it is
+    // updated by readers (which only hold the read lock)
+    std::atomic<quint64> lastUse{0};
   };
 
+  // The caller must hold the write lock
+  void insert(const PDFPageTile & tile, QSharedPointer<QImage> image, const TileStatus status);
+  // The caller must hold the write lock
+  void remove(const PDFPageTile & tile);
+  // Evicts tiles until the total cost is at most `maxCost`; `keep` (if
+  // non-null) is never evicted. The caller must hold the write lock
+  void trim(const size_type maxCost, const PDFPageTile * keep = nullptr);
+  void touch(CachedTileData & data) const { data.lastUse.store(++m_useCounter, std::memory_order_relaxed); }
+
+  // Number of least recently used tiles among which the cheapest one is
+  // evicted
+  static constexpr int EvictionCandidates = 8;
+
   mutable QReadWriteLock _lock;
 
+  QHash<PDFPageTile, QSharedPointer<CachedTileData>> m_cache;
+  size_type m_totalCost{0};
   // Set cache for rendered pages to be 1GB. This is enough for 256 RGBA tiles
   // (1024 x 1024 pixels x 4 bytes per pixel).
-  QCache<PDFPageTile, CachedTileData> m_cache{1024 * 1024 * 1024};
+  size_type m_maxCost{1024 * 1024 * 1024};
+  mutable std::atomic<quint64> m_useCounter{0};
 };
 
 } // namespace Backend
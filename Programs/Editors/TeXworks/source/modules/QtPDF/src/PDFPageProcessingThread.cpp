@@ -3,21 +3,25 @@
 #include "PDFBackend.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 
 namespace QtPDF {
 namespace Backend {
 
 #ifdef DEBUG
-void PDFPageProcessingThread::dumpWorkStack(const QStack<PageProcessingRequest*> & ws)
+void PDFPageProcessingThread::dumpWorkStacks() const
 {
   QStringList strList;
-  for (int i = 0; i < ws.size(); ++i) {
-    PageProcessingRequest * request = ws[i];
-    if (!request)
-      strList << QString::fromUtf8("NULL");
-    else {
-      strList << *request;
+  for (const QStack<PageProcessingRequest*> & ws : _workStacks) {
+    for (int i = 0; i < ws.size(); ++i) {
+      PageProcessingRequest * request = ws[i];
+      if (!request)
+        strList << QString::fromUtf8("NULL");
+      else {
+        strList << *request;
+      }
     }
+    strList << QString::fromUtf8("|");
   }
   qDebug() << strList;
 }
@@ -26,13 +30,33 @@ void PDFPageProcessingThread::dumpWorkStack(const QStack<PageProcessingRequest*>
 // Backend Rendering
 // =================
 
+class PDFPageProcessingThread::Worker : public QThread
+{
+public:
+  explicit Worker(PDFPageProcessingThread & pool) : _pool(pool) { }
+
+protected:
+  void run() override { _pool.processRequests(); }
+
+private:
+  PDFPageProcessingThread & _pool;
+};
+
+PDFPageProcessingThread::PDFPageProcessingThread()
+  : _maxWorkers(qMax(1, QThread::idealThreadCount()))
+{
+}
+
 PDFPageProcessingThread::~PDFPageProcessingThread()
 {
   _mutex.lock();
   _quit = true;
   _waitCondition.wakeAll();
   _mutex.unlock();
-  wait();
+  for (Worker * worker : _workers) {
+    worker->wait();
+    delete worker;
+  }
 }
 
 void PDFPageProcessingThread::addPageProcessingRequest(PageProcessingRequest * request)
@@ -46,51 +70,88 @@ void PDFPageProcessingThread::addPageProcessingRequest(PageProcessingRequest * r
   Q_ASSERT(request->thread() == QCoreApplication::instance()->thread());
 
   QMutexLocker locker(&(this->_mutex));
-  // Note: Commenting the "remove identical requests in the stack" code for now.
-  // This should be handled by the caching routine elsewhere automatically. If
-  // in doubt, it's better to render a tile twice than to not render it at all
-  // (thereby leaving the dummy image in the cache indefinitely)
-/*
-  // remove any instances of the given request type before adding the new one to
-  // avoid processing it several times
-  // **TODO:** Could it be that we require several concurrent versions of the
-  //           same page?
-  int i;
-  for (i = _workStack.size() - 1; i >= 0; --i) {
-    if (*(_workStack[i]) == *request) {
-      // Using deleteLater() doesn't work because we have no event queue in this
-      // thread. However, since the object is still on the stack, it is still
-      // sleeping and directly deleting it should therefore be safe.
-      delete _workStack[i];
-      _workStack.remove(i);
-    }
-  }
-*/
-
-  _workStack.push(request);
+  // Note: Identical requests in the queue are not removed. This should be
+  // handled by the caching routine elsewhere automatically. If in doubt, it's
+  // better to render a tile twice than to not render it at all (thereby leaving
+  // the dummy image in the cache indefinitely)
+  _workStacks[request->priority()].push(request);
 #ifdef DEBUG
   qDebug() << "new request:" << *request;
 #endif
 
-  locker.unlock();
-  if (!isRunning())
-    start();
-  else
+  // Wake an idle worker if there is one; otherwise, start a new worker (as
+  // long as we have fewer than one per core)
+  if (_idleWorkers > 0)
     _waitCondition.wakeOne();
+  else if (_workers.size() < _maxWorkers) {
+    Worker * worker = new Worker(*this);
+    _workers.append(worker);
+    worker->start();
+  }
+}
+
+void PDFPageProcessingThread::raisePriority(const QObject * listener, const double xres, const double yres, const QRect & render_box, const PageProcessingRequest::Priority priority)
+{
+  QMutexLocker locker(&(this->_mutex));
+  for (int p = priority + 1; p < PageProcessingRequest::NumPriorities; ++p) {
+    QStack<PageProcessingRequest*> & ws = _workStacks[p];
+    for (int i = ws.size() - 1; i >= 0; --i) {
+      if (ws[i]->listener != listener || ws[i]->type() != PageProcessingRequest::PageRendering)
+        continue;
+      const PageProcessingRenderPageRequest * rr = static_cast<const PageProcessingRenderPageRequest*>(ws[i]);
+      if (!qFuzzyCompare(rr->xres, xres) || !qFuzzyCompare(rr->yres, yres) || rr->render_box != render_box)
+        continue;
+      PageProcessingRenderPageRequest * request = static_cast<PageProcessingRenderPageRequest*>(ws[i]);
+      ws.remove(i);
+      request->_priority = priority;
+      _workStacks[priority].push(request);
+      return;
+    }
+  }
 }
 
-void PDFPageProcessingThread::run()
+void PDFPageProcessingThread::cancelRequests(const std::function<bool(const PageProcessingRequest &)> & isStale)
+{
+  QMutexLocker locker(&(this->_mutex));
+  for (QStack<PageProcessingRequest*> & ws : _workStacks) {
+    for (int i = ws.size() - 1; i >= 0; --i) {
+      PageProcessingRequest * workItem = ws[i];
+      if (!isStale(*workItem))
+        continue;
+      Q_ASSERT(workItem->thread() == QCoreApplication::instance()->thread());
+      workItem->cancel();
+      workItem->discard();
+      workItem->deleteLater();
+      ws.remove(i);
+    }
+  }
+  for (PageProcessingRequest * workItem : _activeRequests) {
+    if (isStale(*workItem))
+      workItem->cancel();
+  }
+}
+
+PageProcessingRequest * PDFPageProcessingThread::takeNextRequest()
+{
+  for (QStack<PageProcessingRequest*> & ws : _workStacks) {
+    if (!ws.empty())
+      return ws.pop();
+  }
+  return nullptr;
+}
+
+void PDFPageProcessingThread::processRequests()
 {
   _mutex.lock();
-  _idle = false;
   while (!_quit) {
     // mutex must be locked at start of loop
-    if (!_workStack.empty()) {
-      PageProcessingRequest * workItem = _workStack.pop();
+    PageProcessingRequest * workItem = takeNextRequest();
+    if (workItem) {
+      _activeRequests.append(workItem);
       _mutex.unlock();
 
 #ifdef DEBUG
-      qDebug() << "processing work item" << *workItem << "; remaining items:" << _workStack.size();
+      qDebug() << "processing work item" << *workItem;
       QElapsedTimer timer;
       timer.start();
 #endif
@@ -108,24 +169,30 @@ void PDFPageProcessingThread::run()
       qDebug() << "finished " << jobDesc << "for page" << workItem->page->pageNum() << ". Time elapsed: " << timer.elapsed() << " ms.";
 #endif
 
+      _mutex.lock();
+      _activeRequests.removeOne(workItem);
+
       // Delete the work item as it has fulfilled its purpose
       // Note that we can't delete it here or we might risk that some emitted
       // signals are invalidated; to ensure they reach their destination, we
       // need to call deleteLater().
       // Note: workItem *must* live in the main (GUI) thread for this!
+      // Note: This must happen after removing workItem from _activeRequests
+      // (and while holding the mutex); otherwise the main thread could still
+      // access it in cancelRequests() after it has been deleted.
       Q_ASSERT(workItem->thread() == QCoreApplication::instance()->thread());
       workItem->deleteLater();
 
-      _mutex.lock();
+      if (_activeRequests.empty())
+        _idleCondition.wakeAll();
     }
     else {
 #ifdef DEBUG
       qDebug() << "going to sleep";
 #endif
-      _idle = true;
-      _idleCondition.wakeAll();
+      ++_idleWorkers;
       _waitCondition.wait(&_mutex);
-      _idle = false;
+      --_idleWorkers;
 #ifdef DEBUG
       qDebug() << "waking up";
 #endif
@@ -138,18 +205,19 @@ void PDFPageProcessingThread::clearWorkStack()
 {
   _mutex.lock();
 
-  foreach(PageProcessingRequest * workItem, _workStack) {
-    if (!workItem)
-      continue;
-    Q_ASSERT(workItem->thread() == QCoreApplication::instance()->thread());
-    workItem->deleteLater();
+  for (QStack<PageProcessingRequest*> & ws : _workStacks) {
+    foreach(PageProcessingRequest * workItem, ws) {
+      if (!workItem)
+        continue;
+      Q_ASSERT(workItem->thread() == QCoreApplication::instance()->thread());
+      workItem->deleteLater();
+    }
+    ws.clear();
   }
-  _workStack.clear();
 
-  if (!_idle) {
-    // Wait until the current operation finishes
+  // Wait until the current operations finish
+  while (!_activeRequests.empty())
     _idleCondition.wait(&_mutex);
-  }
   _mutex.unlock();
 }
 
@@ -193,21 +261,48 @@ const QEvent::Type PDFLinksLoadedEvent::LinksLoadedEvent = static_cast<QEvent::T
 
 bool PageProcessingRenderPageRequest::execute()
 {
-  // TODO: Aborting renders doesn't really work right now---the backend knows
-  // nothing about the PDF scenes.
-  //
-  // Idea: Perhaps allow page render requests to provide a pointer to a function
-  // that returns a `bool` value indicating if the request is still valid? Then
-  // the `PDFPageGraphicsItem` could have a function that indicates if the item
-  // is anywhere near a viewport.
+  // NB: Aborting renders that are already in progress is not possible as the
+  // backends can't interrupt rendering. Cancelled requests still put their
+  // result in the cache (if requested), but don't notify the listener.
+  // Requests that are cancelled before rendering started must release their
+  // placeholder, though, as they are no longer in the work stacks (so
+  // cancelRequests() didn't discard them).
+  if (isCancelled()) {
+    discard();
+    return false;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
   QImage rendered_page = page->renderToImage(xres, yres, render_box, cache);
+
+  if (cache) {
+    // Let the cache know how expensive this tile is to recreate
+    Document * doc = page->document();
+    if (doc)
+      Document::pageCache().setRenderCost(PDFPageTile(xres, yres, render_box, doc, page->pageNum()), timer.elapsed());
+  }
+
+  if (isCancelled())
+    return false;
   QCoreApplication::postEvent(listener, new PDFPageRenderedEvent(xres, yres, render_box, rendered_page));
 
   return true;
 }
 
+void PageProcessingRenderPageRequest::discard()
+{
+  // The tile is no longer being rendered, so its placeholder image (if any)
+  // must not keep it from being requested again later on
+  Document * doc = page->document();
+  if (cache && doc)
+    Document::pageCache().markOutdated(PDFPageTile(xres, yres, render_box, doc, page->pageNum()));
+}
+
 bool PageProcessingLoadLinksRequest::execute()
 {
+  if (isCancelled())
+    return false;
   QCoreApplication::postEvent(listener, new PDFLinksLoadedEvent(page->loadLinks()));
   return true;
 }
@@ -10,8 +10,12 @@
 #include <QRect>
 #include <QStack>
 #include <QThread>
+#include <QVector>
 #include <QWaitCondition>
 
+#include <atomic>
+#include <functional>
+
 namespace QtPDF {
 namespace Backend {
 
@@ -30,11 +34,24 @@ protected:
   // Returns true if finished successfully, false otherwise
   virtual bool execute() = 0;
 
+  // Called (in the thread that cancelled the request) if the request is
+  // dropped before it was executed
+  virtual void discard() { }
+
 public:
   enum Type { PageRendering, LoadLinks };
+  // Requests with a lower priority value are processed first; within the same
+  // priority, the most recent request is processed first
+  enum Priority { Priority_Visible = 0, Priority_Prefetch, Priority_LoadLinks, NumPriorities };
 
   ~PageProcessingRequest() override = default;
   virtual Type type() const = 0;
+  virtual Priority priority() const = 0;
+
+  // Cancellation is cooperative: cancelled requests that are still queued are
+  // dropped, and `execute` implementations skip posting their results
+  void cancel() { _cancelled.store(true, std::memory_order_relaxed); }
+  bool isCancelled() const { return _cancelled.load(std::memory_order_relaxed); }
 
   Page *page;
   QObject *listener;
@@ -43,6 +60,9 @@ public:
 #ifdef DEBUG
   virtual operator QString() const = 0;
 #endif
+
+private:
+  std::atomic<bool> _cancelled{false};
 };
 
 class PageProcessingRenderPageRequest : public PageProcessingRequest
@@ -51,13 +71,15 @@ class PageProcessingRenderPageRequest : public PageProcessingRequest
   friend class PDFPageProcessingThread;
 
 public:
-  PageProcessingRenderPageRequest(Page *page, QObject *listener, double xres, double yres, QRect render_box = QRect(), bool cache = false) :
+  PageProcessingRenderPageRequest(Page *page, QObject *listener, double xres, double yres, QRect render_box = QRect(), bool cache = false, Priority priority = Priority_Visible) :
     PageProcessingRequest(page, listener),
     xres(xres), yres(yres),
     render_box(render_box),
-    cache(cache)
+    cache(cache),
+    _priority(priority)
   {}
   Type type() const override { return PageRendering; }
+  Priority priority() const override { return _priority; }
 
   bool operator==(const PageProcessingRequest & r) const override;
 #ifdef DEBUG
@@ -66,10 +88,12 @@ public:
 
 protected:
   bool execute() override;
+  void discard() override;
 
   double xres, yres;
   QRect render_box;
   bool cache;
+  Priority _priority;
 };
 
 
@@ -101,6 +125,7 @@ class PageProcessingLoadLinksRequest : public PageProcessingRequest
 public:
   PageProcessingLoadLinksRequest(Page *page, QObject *listener) : PageProcessingRequest(page, listener) { }
   Type type() const override { return LoadLinks; }
+  Priority priority() const override { return Priority_LoadLinks; }
 
 #ifdef DEBUG
   operator QString() const override;
@@ -131,22 +156,34 @@ public:
 // Modelled after the "Blocking Fortune Client Example" in the Qt docs
 // (http://doc.qt.nokia.com/stable/network-blockingfortuneclient.html)
 
-// The `PDFPageProcessingThread` is a thread that processes background jobs.
-// Each job is represented by a subclass of `PageProcessingRequest` and
-// contains an `execute` method that performs the actual work.
-class PDFPageProcessingThread : public QThread
+// The `PDFPageProcessingThread` manages a pool of worker threads that process
+// background jobs. Each job is represented by a subclass of
+// `PageProcessingRequest` and contains an `execute` method that performs the
+// actual work. Jobs are queued by priority (see
+// `PageProcessingRequest::Priority`) so that visible tiles are rendered before
+// prefetched ones, and links are loaded last. Worker threads are started on
+// demand, up to one per core.
+class PDFPageProcessingThread
 {
-  Q_OBJECT
-
 public:
-  PDFPageProcessingThread() = default;
-  ~PDFPageProcessingThread() override;
+  PDFPageProcessingThread();
+  ~PDFPageProcessingThread();
 
-  // add a processing request to the work stack
+  // add a processing request to the work queue
   // Note: request must have been created on the heap and must be in the scope
-  // of this thread; use requestRenderPage() and requestLoadLinks() for that
+  // of the main (GUI) thread; use requestRenderPage() and requestLoadLinks()
+  // for that
   void addPageProcessingRequest(PageProcessingRequest * request);
 
+  // Cancels all queued and running requests for which `isStale` returns true
+  // (e.g., renderings of pages that were scrolled out of view). Queued requests
+  // are dropped immediately; running requests finish but don't post results.
+  void cancelRequests(const std::function<bool(const PageProcessingRequest &)> & isStale);
+
+  // Moves a queued render request for the given tile to `priority` (e.g.,
+  // when a prefetched tile becomes visible before it was rendered)
+  void raisePriority(const QObject * listener, const double xres, const double yres, const QRect & render_box, const PageProcessingRequest::Priority priority);
+
   // drop all remaining processing requests
   // WARNING: This function *must not* be called while the calling thread holds
   // any locks that would prevent and work item from finishing. Otherwise, we
@@ -156,18 +193,28 @@ public:
   // finish. However, that lock is held by the caller of clearWorkStack().
   void clearWorkStack();
 
-protected:
-  void run() override;
+  int maxWorkerCount() const { return _maxWorkers; }
 
 private:
-  QStack<PageProcessingRequest*> _workStack;
+  class Worker;
+
+  // Called by the worker threads
+  void processRequests();
+  // The caller must hold _mutex
+  PageProcessingRequest * takeNextRequest();
+
+  QStack<PageProcessingRequest*> _workStacks[PageProcessingRequest::NumPriorities];
+  // Requests currently being executed by a worker
+  QList<PageProcessingRequest*> _activeRequests;
+  QVector<Worker*> _workers;
+  int _maxWorkers{1};
+  int _idleWorkers{0};
   QMutex _mutex;
   QWaitCondition _waitCondition;
-  bool _idle{true};
   QWaitCondition _idleCondition;
   bool _quit{false};
 #ifdef DEBUG
-  static void dumpWorkStack(const QStack<PageProcessingRequest*> & ws);
+  void dumpWorkStacks() const;
 #endif
 
 };
@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2017-2022  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
+	Copyright (C) 2017-2024  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -21,6 +21,9 @@
 #include "BibTeXFile.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
 #include <QTextCodec>
 
 BibTeXFile::Entry::Type BibTeXFile::Entry::type() const
@@ -86,31 +89,116 @@ bool BibTeXFile::load(const QString & filename)
 	QFile file(filename);
 	QByteArray content;
 	QTextCodec * codec = QTextCodec::codecForName("utf-8");
-	size_type curPos = 0;
 
-	_entries.clear();
+	// Entries of a different file can't be reused
+	if (filename != _filename) {
+		_entries.clear();
+		_content.clear();
+	}
+	_filename = filename;
 
-	if (!file.open(QFile::ReadOnly | QFile::Text))
+	// FIXME: Encoding detection
+	if (!codec || !file.open(QFile::ReadOnly | QFile::Text)) {
+		_entries.clear();
+		_normalEntries.clear();
+		_content.clear();
+		_lastModified = QDateTime();
+		_fileSize = -1;
 		return false;
+	}
 
+	_lastModified = QFileInfo(file).lastModified();
+	_fileSize = file.size();
 	content = file.readAll();
 	file.close();
 
-	// FIXME: Encoding detection
-	if (!codec)
-		return false;
+	parse(content, codec);
+	return true;
+}
 
-	do {
+// static
+BibTeXFile BibTeXFile::loadCached(const QString & filename)
+{
+	static QMutex mutex;
+	static QHash<QString, BibTeXFile> cache;
+
+	const QFileInfo fileInfo(filename);
+	const QString path = fileInfo.absoluteFilePath();
+
+	QMutexLocker locker(&mutex);
+	BibTeXFile & file = cache[path];
+	if (file._fileSize != fileInfo.size() || file._lastModified != fileInfo.lastModified()) {
+		if (!file.load(path)) {
+			cache.remove(path);
+			return BibTeXFile();
+		}
+	}
+	return file;
+}
+
+void BibTeXFile::parse(const QByteArray & content, const QTextCodec * codec)
+{
+	// Determine how much of the old content is unchanged at the beginning and
+	// at the end
+	const size_type oldSize = _content.size();
+	const size_type newSize = content.size();
+	const size_type maxCommon = qMin(oldSize, newSize);
+	const char * oldData = _content.constData();
+	const char * newData = content.constData();
+	size_type prefix = 0;
+	while (prefix < maxCommon && oldData[prefix] == newData[prefix])
+		++prefix;
+	size_type suffix = 0;
+	while (suffix < maxCommon - prefix && oldData[oldSize - 1 - suffix] == newData[newSize - 1 - suffix])
+		++suffix;
+
+	// Entries entirely within the unchanged parts are kept (those at the end
+	// are moved to their new position)
+	// NB: _entries may be shared with copies of this file, so avoid detaching
+	const QList<Entry> & oldEntries = _entries;
+	QList<Entry> entries;
+	QList<Entry> tail;
+	for (const Entry & e : oldEntries) {
+		if (e._end <= prefix)
+			entries.append(e);
+		else if (e._start >= oldSize - suffix) {
+			tail.append(e);
+			tail.last()._start += newSize - oldSize;
+			tail.last()._end += newSize - oldSize;
+		}
+	}
+
+	// Reparse the changed part; once the next entry coincides with one of the
+	// tail, the rest is unchanged
+	size_type curPos = (entries.empty() ? 0 : entries.last()._end);
+	int iTail = 0;
+	bool resynced = false;
+	while (true) {
+		// Skip entries of the tail that are (partially) covered by reparsed
+		// ones
+		while (iTail < tail.size() && tail[iTail]._start < curPos)
+			++iTail;
+		if (iTail < tail.size() && content.indexOf('@', curPos) == tail[iTail]._start) {
+			resynced = true;
+			break;
+		}
 		Entry e(this);
 		curPos = readEntry(e, content, curPos, codec);
-		if (curPos > 0) {
-			e.updateCache();
-			_entries.append(e);
-		}
-		// DEBUG
-	} while(curPos > 0);
+		if (curPos < 0)
+			break;
+		e.updateCache();
+		entries.append(e);
+	}
+	if (resynced)
+		entries.append(tail.mid(iTail));
 
-	return true;
+	_content = content;
+	_entries = entries;
+	_normalEntries.clear();
+	for (int i = 0; i < _entries.size(); ++i) {
+		if (_entries.at(i).type() == Entry::NORMAL)
+			_normalEntries.append(i);
+	}
 }
 
 template <class S, class C> BibTeXFile::size_type findBlock(const S & content, const BibTeXFile::size_type from, const C & startDelim, const C & endDelim, const C & escapeChar)
@@ -151,6 +239,7 @@ BibTeXFile::size_type BibTeXFile::readEntry(Entry & e, const QByteArray & conten
 	size_type curPos = content.indexOf('@', startPos);
 	if (curPos < 0)
 		return -1;
+	e._start = curPos;
 	++curPos;
 	size_type start = content.indexOf('{', curPos);
 	if (start < 0)
@@ -178,6 +267,7 @@ BibTeXFile::size_type BibTeXFile::readEntry(Entry & e, const QByteArray & conten
 		break;
 	}
 
+	e._end = end + 1;
 	return end + 1;
 }
 
@@ -248,11 +338,7 @@ void BibTeXFile::parseFields(BibTeXFile::Entry & e, const QString & block, const
 unsigned int BibTeXFile::numEntries() const
 {
 	// Only count "normal" entries
-	unsigned int retVal = 0;
-	for (int i = 0; i < _entries.size(); ++i) {
-		if (_entries[i].type() == Entry::NORMAL) ++retVal;
-	}
-	return retVal;
+	return static_cast<unsigned int>(_normalEntries.size());
 }
 
 QMap<QString, QString> BibTeXFile::strings() const
@@ -273,12 +359,8 @@ QMap<QString, QString> BibTeXFile::strings() const
 
 const BibTeXFile::Entry & BibTeXFile::entry(const unsigned int idx) const
 {
-	unsigned int j = 0;
-	for (int i = 0; i < _entries.size(); ++i) {
-		if (_entries[i].type() != Entry::NORMAL) continue;
-		if (j == idx) return _entries[i];
-		++j;
-	}
+	if (idx < static_cast<unsigned int>(_normalEntries.size()))
+		return _entries[_normalEntries[static_cast<int>(idx)]];
 	// We should never get here
 	static BibTeXFile::Entry e(nullptr);
 	return e;
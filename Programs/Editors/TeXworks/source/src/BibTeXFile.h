@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2017-2022  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
+	Copyright (C) 2017-2024  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -21,10 +21,12 @@
 #ifndef BIBTEXFILE_H
 #define BIBTEXFILE_H
 
+#include <QDateTime>
 #include <QList>
 #include <QMap>
 #include <QString>
 #include <QTextCodec>
+#include <QVector>
 
 class BibTeXFile
 {
@@ -64,6 +66,9 @@ public:
 		} _cache;
 		QMap<QString, QString> _fields;
 		BibTeXFile * _parent;
+		// Byte range of the entry in the file (from '@' to after the closing
+		// '}')
+		size_type _start{-1}, _end{-1};
 	};
 
 	BibTeXFile() = default;
@@ -73,13 +78,27 @@ public:
 	QMap<QString, QString> strings() const;
 	const Entry & entry(const unsigned int idx) const;
 
+	// Loading the same file again only reparses the entries that have changed
 	bool load(const QString & filename);
+	// Returns the contents of filename; all files are cached, so files that
+	// were loaded before are only reparsed (incrementally) if they have been
+	// modified in the meantime. This function is thread-safe.
+	static BibTeXFile loadCached(const QString & filename);
 protected:
+	void parse(const QByteArray & content, const QTextCodec * codec);
   static size_type readEntry(Entry & e, const QByteArray & content, const size_type startPos, const QTextCodec * codec);
 	static void parseEntry(Entry & e, const QString & block);
   static void parseFields(Entry & e, const QString & block, const size_type startPos = 0);
 
+	QString _filename;
+	QDateTime _lastModified;
+	qint64 _fileSize{-1};
+	// The raw file contents the entries were parsed from (needed for
+	// incremental reparsing)
+	QByteArray _content;
 	QList<Entry> _entries;
+	// Indices of all "normal" entries in _entries
+	QVector<int> _normalEntries;
 };
 
 #endif // BIBTEXFILE_H
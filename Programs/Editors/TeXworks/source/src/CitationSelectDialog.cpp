@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2017-2022  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
+	Copyright (C) 2017-2024  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -22,7 +22,28 @@
 #include "CitationSelectDialog.h"
 
 #include <QAbstractButton>
+#include <QFileInfo>
+#include <QFutureWatcher>
 #include <QKeyEvent>
+#include <QtConcurrent>
+
+// Splits text into (lower case) words, i.e., runs of letters and digits
+static QStringList splitIntoWords(const QString & text)
+{
+	QStringList words;
+	QString word;
+	for (const QChar & c : text) {
+		if (c.isLetterOrNumber())
+			word += c.toLower();
+		else if (!word.isEmpty()) {
+			words << word;
+			word.clear();
+		}
+	}
+	if (!word.isEmpty())
+		words << word;
+	return words;
+}
 
 KeyForwarder::KeyForwarder(QObject * target, QObject * parent /* = nullptr */)
   : QObject(parent), _target(target)
@@ -76,6 +97,34 @@ CitationSelectDialog::CitationSelectDialog(QWidget *parent)
 	connect(buttonBox, &QDialogButtonBox::clicked, this, &CitationSelectDialog::buttonClicked);
 }
 
+void CitationSelectDialog::addBibTeXFile(const QString & filename)
+{
+	// Files up to this size are loaded right away
+	constexpr qint64 MaxForegroundSize = 1024 * 1024;
+
+	if (QFileInfo(filename).size() <= MaxForegroundSize) {
+		addBibTeXFile(BibTeXFile::loadCached(filename));
+		return;
+	}
+
+	using Result = QPair<BibTeXFile, CitationModel::WordIndex>;
+	QFutureWatcher<Result> * watcher = new QFutureWatcher<Result>(this);
+	connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() {
+		const Result result = watcher->result();
+		addBibTeXFile(result.first, result.second);
+		tableView->resizeColumnsToContents();
+		watcher->deleteLater();
+		if (--_pendingLoads == 0)
+			unsetCursor();
+	});
+	if (_pendingLoads++ == 0)
+		setCursor(Qt::BusyCursor);
+	watcher->setFuture(QtConcurrent::run([filename]() {
+		const BibTeXFile file = BibTeXFile::loadCached(filename);
+		return Result(file, CitationModel::indexWords(file));
+	}));
+}
+
 void CitationSelectDialog::buttonClicked(QAbstractButton * button)
 {
 	if (buttonBox->buttonRole(button) == QDialogButtonBox::ResetRole)
@@ -277,22 +326,66 @@ bool CitationModel::setData(const QModelIndex &index, const QVariant &value, int
 }
 
 
-void CitationModel::addBibTeXFile(const BibTeXFile & file)
+//static
+CitationModel::WordIndex CitationModel::indexWords(const BibTeXFile & file)
+{
+	static QLatin1String space(" ");
+	WordIndex wordIndex;
+	for (unsigned int iEntry = 0; iEntry < file.numEntries(); ++iEntry) {
+		const BibTeXFile::Entry & e = file.entry(iEntry);
+		const QString text = e.key() + space + e.typeString() + space + e.author() + space + e.title() + space + e.year() + space + e.howPublished();
+		Q_FOREACH(QString word, splitIntoWords(text)) {
+			QVector<int> & entries = wordIndex[word];
+			if (entries.empty() || entries.last() != static_cast<int>(iEntry))
+				entries.append(static_cast<int>(iEntry));
+		}
+	}
+	return wordIndex;
+}
+
+void CitationModel::addBibTeXFile(const BibTeXFile & file, const WordIndex & wordIndex)
 {
 	int n = rowCount();
 	beginInsertRows(QModelIndex(), n, n + static_cast<int>(file.numEntries()) - 1);
 	_bibFiles.append(file);
+	_wordIndices.append(wordIndex);
 	endInsertRows();
 }
 
+bool CitationModel::rowMatches(const int row, const QString & filter) const
+{
+	if (!_filterValid || filter != _filter) {
+		_filterMatches.fill(true, static_cast<int>(_entries.size()));
+		Q_FOREACH(QString word, splitIntoWords(filter)) {
+			QBitArray wordMatches(static_cast<int>(_entries.size()));
+			for (int iBibFile = 0; iBibFile < _wordIndices.size(); ++iBibFile) {
+				const WordIndex & wordIndex = _wordIndices[iBibFile];
+				// All words starting with word form a contiguous range of the index
+				for (WordIndex::const_iterator it = wordIndex.lowerBound(word); it != wordIndex.constEnd() && it.key().startsWith(word); ++it) {
+					for (int iEntry : it.value())
+						wordMatches.setBit(_firstRows[iBibFile] + iEntry);
+				}
+			}
+			_filterMatches &= wordMatches;
+		}
+		_filter = filter;
+		_filterValid = true;
+	}
+	return _filterMatches.testBit(row);
+}
+
 void CitationModel::rebuildEntryCache()
 {
 	_entries.clear();
+	_firstRows.clear();
+	_filterValid = false;
 	int i = 0, n = 0;
 
 	// resize the vector first to avoid reallocations later on
-	for (int iBibFile = 0; iBibFile < _bibFiles.size(); ++iBibFile)
+	for (int iBibFile = 0; iBibFile < _bibFiles.size(); ++iBibFile) {
+		_firstRows.append(n);
 		n += _bibFiles[iBibFile].numEntries();
+	}
 	_entries.resize(n);
 
 	for (int iBibFile = 0; iBibFile < _bibFiles.size(); ++iBibFile) {
@@ -305,24 +398,13 @@ void CitationModel::rebuildEntryCache()
 bool CitationProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
 	Q_UNUSED(source_parent)
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-	constexpr auto SkipEmptyParts = QString::SkipEmptyParts;
-#else
-	constexpr auto SkipEmptyParts = Qt::SkipEmptyParts;
-#endif
-	static QLatin1String space(" ");
-	const BibTeXFile::Entry * e = static_cast<const BibTeXFile::Entry*>(sourceModel()->index(source_row, 1).internalPointer());
-	QString haystack = e->key() + space + e->typeString() + space + e->author() + space + e->title() + space + e->year() + space + e->howPublished();
+	const CitationModel * model = qobject_cast<const CitationModel*>(sourceModel());
+	if (!model) return true;
+	// The model looks up the filter in its word index once and caches the
+	// result for all rows
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-	QStringList needles = filterRegExp().pattern().split(QChar::fromLatin1(' '), SkipEmptyParts);
+	return model->rowMatches(source_row, filterRegExp().pattern());
 #else
-	QStringList needles = filterRegularExpression().pattern().split(QChar::fromLatin1(' '), SkipEmptyParts);
+	return model->rowMatches(source_row, filterRegularExpression().pattern());
 #endif
-
-	haystack = haystack.toLower();
-
-	Q_FOREACH(QString needle, needles) {
-		if (!haystack.contains(needle.toLower())) return false;
-	}
-	return true;
 }
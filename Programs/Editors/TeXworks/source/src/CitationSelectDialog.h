@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2017-2020  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
+	Copyright (C) 2017-2024  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 
 #include "BibTeXFile.h"
 
+#include <QBitArray>
 #include <QDialog>
 #include <QDialogButtonBox>
 #include <QLineEdit>
@@ -49,13 +50,33 @@ public:
 	const BibTeXFile::Entry * getEntry(const unsigned int idx) const { return (static_cast<int>(idx) < _entries.size() ? _entries[static_cast<int>(idx)] : nullptr); }
 	const BibTeXFile::Entry * getEntry(const QString & key) const;
 
-	void addBibTeXFile(const BibTeXFile & file);
+	// Maps (lower case) words to the (ascending) indices of the entries
+	// containing them
+	using WordIndex = QMap<QString, QVector<int> >;
+	// Builds the word index of file; this function is thread-safe, so that
+	// large files can be indexed in the background
+	static WordIndex indexWords(const BibTeXFile & file);
+
+	void addBibTeXFile(const BibTeXFile & file) { addBibTeXFile(file, indexWords(file)); }
+	void addBibTeXFile(const BibTeXFile & file, const WordIndex & wordIndex);
+
+	// Returns true if each word of filter is the beginning of a word in the
+	// key, type, author, title, year, or journal of the given row
+	bool rowMatches(const int row, const QString & filter) const;
 protected slots:
 	void rebuildEntryCache();
 protected:
 	QList<BibTeXFile> _bibFiles;
+	// The word index of each file in _bibFiles
+	QList<WordIndex> _wordIndices;
+	// The row of the first entry of each file in _bibFiles
+	QVector<int> _firstRows;
 	QVector<const BibTeXFile::Entry *> _entries;
 	QSet<QString> _selectedKeys;
+	// Result of the most recent rowMatches() query
+	mutable QString _filter;
+	mutable QBitArray _filterMatches;
+	mutable bool _filterValid{false};
 };
 
 class CitationProxyModel : public QSortFilterProxyModel
@@ -91,11 +112,9 @@ public:
 
 	void setInitialKeys(const QStringList & keys) { _initialKeys = keys; _initialKeys.removeAll(QLatin1String("")); _model.setSelectedKeys(_initialKeys); }
 
-	void addBibTeXFile(const BibTeXFile & file) {
-		_model.addBibTeXFile(file);
-		_proxyModel.sort(0, Qt::DescendingOrder);
-	}
-	void addBibTeXFile(const QString & filename) { addBibTeXFile(BibTeXFile(filename)); }
+	void addBibTeXFile(const BibTeXFile & file) { addBibTeXFile(file, CitationModel::indexWords(file)); }
+	// Large files are loaded (and indexed) in the background
+	void addBibTeXFile(const QString & filename);
 
 	QStringList getSelectedKeys(const bool ordered = true) const;
 
@@ -106,9 +125,15 @@ public slots:
 
 
 protected:
+	void addBibTeXFile(const BibTeXFile & file, const CitationModel::WordIndex & wordIndex) {
+		_model.addBibTeXFile(file, wordIndex);
+		_proxyModel.sort(0, Qt::DescendingOrder);
+	}
+
 	CitationProxyModel _proxyModel;
 	CitationModel _model;
 	QStringList _initialKeys;
+	int _pendingLoads{0};
 };
 
 
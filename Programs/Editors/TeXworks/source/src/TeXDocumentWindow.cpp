@@ -1223,6 +1223,16 @@ void TeXDocumentWindow::delayedInit()
 		TeXHighlighter * highlighter = new TeXHighlighter(_texDoc);
 		connect(textEdit, &CompletingEdit::rehighlight, highlighter, &TeXHighlighter::rehighlight);
 
+		// Highlight the part of the document that is on screen first; the rest
+		// is highlighted in the background
+		auto updateVisibleRange = [this, highlighter]() {
+			const QRect r = textEdit->viewport()->rect();
+			highlighter->setVisibleRange(textEdit->cursorForPosition(r.topLeft()).position(), textEdit->cursorForPosition(r.bottomRight()).position() + 1);
+		};
+		connect(textEdit->verticalScrollBar(), &QScrollBar::valueChanged, highlighter, updateVisibleRange);
+		connect(textEdit->verticalScrollBar(), &QScrollBar::rangeChanged, highlighter, updateVisibleRange);
+		updateVisibleRange();
+
 		// set up syntax highlighting
 		// First, use the current file's syntaxMode property (if available)
 		QMap<QString,QVariant> properties = TWApp::instance()->getFileProperties(textDoc()->absoluteFilePath());
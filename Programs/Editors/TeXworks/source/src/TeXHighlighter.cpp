@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2007-2022  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
+	Copyright (C) 2007-2024  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -24,17 +24,21 @@
 #include "document/TeXDocument.h"
 #include "utils/ResourcesLibrary.h"
 
+#include <QMutexLocker>
 #include <QTextCursor>
 #include <climits> // for INT_MAX
 
 QList<TeXHighlighter::HighlightingSpec> *TeXHighlighter::syntaxRules = nullptr;
 QList<TeXHighlighter::TagPattern> *TeXHighlighter::tagPatterns = nullptr;
+TeXHighlighter::CombinedMatcher *TeXHighlighter::tagMatcher = nullptr;
 
 TeXHighlighter::TeXHighlighter(Tw::Document::TeXDocument * parent)
 	: NonblockingSyntaxHighlighter(parent)
 	, highlightIndex(-1)
 	, isTagging(true)
 	, _dictionary(nullptr)
+	, _checkSynchronously(true)
+	, _spellCheckThread(this)
 	, texDoc(parent)
 {
 	loadPatterns();
@@ -48,6 +52,11 @@ TeXHighlighter::TeXHighlighter(Tw::Document::TeXDocument * parent)
 	spellFormat.setUnderlineColor(Qt::red);
 }
 
+TeXHighlighter::~TeXHighlighter()
+{
+	_spellCheckThread.stop();
+}
+
 void TeXHighlighter::spellCheckRange(const QString &text, QString::size_type index, QString::size_type limit, const QTextCharFormat &spellFormat)
 {
 	while (index < limit) {
@@ -58,7 +67,13 @@ void TeXHighlighter::spellCheckRange(const QString &text, QString::size_type ind
 			if (end > limit)
 				end = limit;
 			if (start < end) {
-				if (!_dictionary->isWordCorrect(text.mid(start, end - start)))
+				const QString word = text.mid(start, end - start);
+				bool isCorrect{true};
+				if (_checkSynchronously)
+					isCorrect = _dictionary->isWordCorrect(word);
+				else if (!_dictionary->cachedVerdict(word, isCorrect))
+					_deferredWords.append({start, end - start, word, spellFormat});
+				if (!isCorrect)
 					setFormat(start, end - start, spellFormat);
 			}
 		}
@@ -66,79 +81,159 @@ void TeXHighlighter::spellCheckRange(const QString &text, QString::size_type ind
 	}
 }
 
+void TeXHighlighter::applySpellCheckResults()
+{
+	const QVector<SpellCheckThread::Job> results = _spellCheckThread.takeResults();
+	if (!document())
+		return;
+	for (const SpellCheckThread::Job & result : results) {
+		// Drop results that were obtained with another dictionary or before
+		// the dictionary changed
+		if (result.words.empty() || result.dictionary != _dictionary || result.generation != _dictionary->generation())
+			continue;
+		// Blocks that have changed in the meantime or that are queued for
+		// highlighting anyway are skipped; the latter will use the cached
+		// verdicts
+		const QTextBlock block = document()->findBlockByNumber(result.blockNumber);
+		if (!block.isValid() || isBlockPending(block) || block.text() != result.blockText)
+			continue;
+		QVector<QTextLayout::FormatRange> formats;
+		for (const SpellCheckThread::Word & word : result.words) {
+			QTextLayout::FormatRange formatRange;
+			formatRange.start = static_cast<decltype(formatRange.start)>(word.start);
+			formatRange.length = static_cast<decltype(formatRange.length)>(word.length);
+			formatRange.format = word.format;
+			formats << formatRange;
+		}
+		addFormats(block, formats);
+	}
+	markDirtyContent();
+}
+
 void TeXHighlighter::highlightBlock(const QString &text)
 {
+	_checkSynchronously = isBlockVisible(currentBlock()) || isBlockEdited(currentBlock());
+	_deferredWords.clear();
+
 	QString::size_type charPos = 0;
 	if (highlightIndex >= 0 && highlightIndex < syntaxRules->count()) {
-		QList<HighlightingRule>& highlightingRules = (*syntaxRules)[highlightIndex].rules;
-		// Go through the whole text...
-		while (charPos < text.length()) {
-			// ... and find the highlight pattern that matches closest to the
-			// current character index
-			QString::size_type firstIndex{std::numeric_limits<QString::size_type>::max()}, len{0};
-			const HighlightingRule* firstRule = nullptr;
-			QRegularExpressionMatch firstMatch;
-			for (int i = 0; i < highlightingRules.size(); ++i) {
-				HighlightingRule &rule = highlightingRules[i];
-				QRegularExpressionMatch m = rule.pattern.match(text, charPos);
-				if (m.capturedStart() >= 0 && m.capturedStart() < firstIndex) {
-					firstIndex = m.capturedStart();
-					firstMatch = m;
-					firstRule = &rule;
-				}
-			}
-			// If we found a rule, apply it and advance the character index to
-			// the end of the highlighted range
-			if (firstRule && firstMatch.hasMatch() && (len = firstMatch.capturedLength()) > 0) {
-				if (_dictionary && firstIndex > charPos)
-					spellCheckRange(text, charPos, firstIndex, spellFormat);
-				setFormat(firstIndex, len, firstRule->format);
-				charPos = firstIndex + len;
-				if (_dictionary && firstRule->spellCheck)
-					spellCheckRange(text, firstIndex, charPos, firstRule->spellFormat);
-			}
-			// If no rule matched, we can break out of the loop
-			else
+		const HighlightingSpec & spec = (*syntaxRules)[highlightIndex];
+		CombinedMatcher::Match m;
+		// Go through the whole text and find the highlight pattern that matches
+		// closest to the current character index
+		while (charPos < text.length() && spec.matcher.match(text, charPos, m)) {
+			const QString::size_type firstIndex = m.start();
+			const QString::size_type len = m.length();
+			// If no rule matched (or the match is empty), we can break out of
+			// the loop
+			if (len <= 0)
 				break;
+			// Otherwise, apply the rule and advance the character index to the
+			// end of the highlighted range
+			const HighlightingRule & rule = spec.rules[m.index];
+			if (_dictionary && firstIndex > charPos)
+				spellCheckRange(text, charPos, firstIndex, spellFormat);
+			setFormat(firstIndex, len, rule.format);
+			charPos = firstIndex + len;
+			if (_dictionary && rule.spellCheck)
+				spellCheckRange(text, firstIndex, charPos, rule.spellFormat);
 		}
 	}
 	if (_dictionary)
 		spellCheckRange(text, charPos, text.length(), spellFormat);
 
+	if (!_deferredWords.empty()) {
+		SpellCheckThread::Job job;
+		job.dictionary = _dictionary;
+		job.generation = _dictionary->generation();
+		job.blockNumber = currentBlock().blockNumber();
+		job.blockText = text;
+		job.words.swap(_deferredWords);
+		_spellCheckThread.enqueue(job);
+	}
+
 	if (texDoc) {
 		texDoc->removeTags(currentBlock().position(), currentBlock().length());
 		if (isTagging) {
 			QString::size_type index = 0;
-			while (index < text.length()) {
-				QString::size_type firstIndex{std::numeric_limits<QString::size_type>::max()}, len{0};
-				TagPattern* firstPatt = nullptr;
-				QRegularExpressionMatch firstMatch;
-				for (int i = 0; i < tagPatterns->count(); ++i) {
-					TagPattern& patt = (*tagPatterns)[i];
-					QRegularExpressionMatch m = patt.pattern.match(text, index);
-					if (m.capturedStart() >= 0 && m.capturedStart() < firstIndex) {
-						firstIndex = m.capturedStart();
-						firstMatch = m;
-						firstPatt = &patt;
-					}
-				}
-				if (firstPatt && firstMatch.hasMatch() && (len = firstMatch.capturedLength()) > 0) {
-					QTextCursor	cursor(document());
-					cursor.setPosition(currentBlock().position() + firstIndex);
-					cursor.setPosition(currentBlock().position() + firstIndex + len, QTextCursor::KeepAnchor);
-					QString tagText = firstMatch.captured(1);
-					if (tagText.isEmpty())
-						tagText = firstMatch.captured(0);
-					texDoc->addTag(cursor, firstPatt->level, tagText);
-					index = firstIndex + len;
-				}
-				else
+			CombinedMatcher::Match m;
+			while (index < text.length() && tagMatcher->match(text, index, m)) {
+				const QString::size_type firstIndex = m.start();
+				const QString::size_type len = m.length();
+				if (len <= 0)
 					break;
+				QTextCursor	cursor(document());
+				cursor.setPosition(currentBlock().position() + firstIndex);
+				cursor.setPosition(currentBlock().position() + firstIndex + len, QTextCursor::KeepAnchor);
+				QString tagText = m.captured(1);
+				if (tagText.isEmpty())
+					tagText = m.captured(0);
+				texDoc->addTag(cursor, (*tagPatterns)[m.index].level, tagText);
+				index = firstIndex + len;
 			}
 		}
 	}
 }
 
+void TeXHighlighter::CombinedMatcher::compile(const QList<QRegularExpression> & patterns)
+{
+	// Numbered backreferences, subroutine calls, and branch resets would refer
+	// to the wrong groups once the pattern is embedded in the alternation
+	static const QRegularExpression groupReference(QStringLiteral("\\\\[1-9gk]|\\(\\?(?:[0-9+\\-&|R]|P[=>])"));
+
+	_patterns = patterns;
+	_combined = QRegularExpression();
+	_groupOffsets.clear();
+
+	QStringList alternatives;
+	QVector<int> groupOffsets;
+	int group = 1;
+	for (const QRegularExpression & pattern : patterns) {
+		if (pattern.pattern().contains(groupReference))
+			return;
+		groupOffsets << group;
+		alternatives << QStringLiteral("(%1)").arg(pattern.pattern());
+		group += pattern.captureCount() + 1;
+	}
+	QRegularExpression combined(alternatives.join(QChar::fromLatin1('|')));
+	if (!combined.isValid() || combined.captureCount() != group - 1)
+		return;
+	combined.optimize();
+	_combined = combined;
+	_groupOffsets = groupOffsets;
+}
+
+bool TeXHighlighter::CombinedMatcher::match(const QString & text, const QString::size_type offset, Match & result) const
+{
+	result = Match();
+	if (isCombined()) {
+		QRegularExpressionMatch m = _combined.match(text, offset);
+		if (!m.hasMatch())
+			return false;
+		// Exactly one of the enclosing groups participates in the match
+		for (int i = 0; i < _groupOffsets.size(); ++i) {
+			if (m.capturedStart(_groupOffsets[i]) >= 0) {
+				result.index = i;
+				result.match = m;
+				result.groupOffset = _groupOffsets[i];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	QString::size_type firstIndex{std::numeric_limits<QString::size_type>::max()};
+	for (int i = 0; i < _patterns.size(); ++i) {
+		QRegularExpressionMatch m = _patterns[i].match(text, offset);
+		if (m.capturedStart() >= 0 && m.capturedStart() < firstIndex) {
+			firstIndex = m.capturedStart();
+			result.index = i;
+			result.match = m;
+		}
+	}
+	return result.index >= 0;
+}
+
 void TeXHighlighter::setActiveIndex(int index)
 {
 	int oldIndex = highlightIndex;
@@ -150,6 +245,9 @@ void TeXHighlighter::setActiveIndex(int index)
 void TeXHighlighter::setSpellChecker(Tw::Document::SpellChecker::Dictionary * dictionary)
 {
 	if (_dictionary != dictionary) {
+		// The old dictionary may be deallocated once we return (see
+		// TWApp::reloadSpellchecker()), so make sure it is no longer in use
+		_spellCheckThread.cancel();
 		_dictionary = dictionary;
 		QTimer::singleShot(1, this, SLOT(rehighlight()));
 	}
@@ -248,6 +346,12 @@ void TeXHighlighter::loadPatterns()
 			if (spec.rules.count() > 0)
 				syntaxRules->append(spec);
 		}
+		for (HighlightingSpec & spec : *syntaxRules) {
+			QList<QRegularExpression> patterns;
+			for (const HighlightingRule & rule : spec.rules)
+				patterns << rule.pattern;
+			spec.matcher.compile(patterns);
+		}
 	}
 
 	if (!tagPatterns) {
@@ -275,6 +379,80 @@ void TeXHighlighter::loadPatterns()
 				}
 			}
 		}
+		tagMatcher = new CombinedMatcher;
+		QList<QRegularExpression> patterns;
+		for (const TagPattern & patt : *tagPatterns)
+			patterns << patt.pattern;
+		tagMatcher->compile(patterns);
+	}
+}
+
+void TeXHighlighter::SpellCheckThread::enqueue(const Job & job)
+{
+	QMutexLocker locker(&_mutex);
+	if (_stopped)
+		return;
+	_jobs.append(job);
+	if (!isRunning())
+		start(QThread::LowPriority);
+	_jobAvailable.wakeOne();
+}
+
+void TeXHighlighter::SpellCheckThread::cancel()
+{
+	QMutexLocker locker(&_mutex);
+	_jobs.clear();
+	while (_busy)
+		_jobFinished.wait(&_mutex);
+	_results.clear();
+}
+
+void TeXHighlighter::SpellCheckThread::stop()
+{
+	{
+		QMutexLocker locker(&_mutex);
+		_stopped = true;
+		_jobs.clear();
+		_jobAvailable.wakeAll();
+	}
+	wait();
+}
+
+QVector<TeXHighlighter::SpellCheckThread::Job> TeXHighlighter::SpellCheckThread::takeResults()
+{
+	QMutexLocker locker(&_mutex);
+	QVector<Job> results;
+	results.swap(_results);
+	return results;
+}
+
+void TeXHighlighter::SpellCheckThread::run()
+{
+	QMutexLocker locker(&_mutex);
+	while (!_stopped) {
+		if (_jobs.empty()) {
+			_jobAvailable.wait(&_mutex);
+			continue;
+		}
+		Job job = _jobs.takeFirst();
+		_busy = true;
+		locker.unlock();
+
+		// isWordCorrect() also fills the dictionary's verdict cache
+		QVector<Word> misspelled;
+		for (const Word & word : job.words) {
+			if (!job.dictionary->isWordCorrect(word.text))
+				misspelled << word;
+		}
+		job.words.swap(misspelled);
+
+		locker.relock();
+		_busy = false;
+		_jobFinished.wakeAll();
+		// Notify the highlighter only once for a batch of results
+		if (_results.empty())
+			QMetaObject::invokeMethod(_highlighter, "applySpellCheckResults", Qt::QueuedConnection);
+		_results.append(job);
 	}
 }
 
@@ -296,6 +474,33 @@ void NonblockingSyntaxHighlighter::setDocument(QTextDocument * doc)
 	}
 }
 
+void NonblockingSyntaxHighlighter::setVisibleRange(const int from, const int to)
+{
+	_visibleRange.from = from;
+	_visibleRange.to = to;
+	if (hasBlocksToHighlight())
+		processWhenIdle();
+}
+
+bool NonblockingSyntaxHighlighter::isBlockPending(const QTextBlock & block) const
+{
+	foreach(range r, _highlightRanges) {
+		if (r.from < block.position() + block.length() && r.to > block.position())
+			return true;
+	}
+	return false;
+}
+
+bool NonblockingSyntaxHighlighter::isBlockVisible(const QTextBlock & block) const
+{
+	return block.position() < _visibleRange.to && block.position() + block.length() > _visibleRange.from;
+}
+
+bool NonblockingSyntaxHighlighter::isBlockEdited(const QTextBlock & block) const
+{
+	return _lastEdit.from >= 0 && (block.contains(_lastEdit.from) || block.contains(_lastEdit.to));
+}
+
 void NonblockingSyntaxHighlighter::rehighlight()
 {
 	if (!_parent)
@@ -320,6 +525,9 @@ void NonblockingSyntaxHighlighter::maybeRehighlightText(int position, int charsR
 	if (!_parent)
 		return;
 
+	_lastEdit.from = position;
+	_lastEdit.to = position + charsAdded;
+
 	// Adjust ranges already present in _highlightRanges
 	for (int i = 0; i < _highlightRanges.size(); ++i) {
 		// Adjust front (if necessary)
@@ -387,9 +595,21 @@ void NonblockingSyntaxHighlighter::process()
 	if (!_parent)
 		return;
 
+	processPendingBlocks(MAX_TIME_MSECS);
+
+	// if there is more work, queue another round
+	if (hasBlocksToHighlight())
+		processWhenIdle();
+}
+
+void NonblockingSyntaxHighlighter::processPendingBlocks(const int maxTimeMsecs)
+{
+	if (!_parent)
+		return;
+
 	QTime start = QTime::currentTime();
 
-	while (start.msecsTo(QTime::currentTime()) < MAX_TIME_MSECS && hasBlocksToHighlight()) {
+	while ((maxTimeMsecs < 0 || start.msecsTo(QTime::currentTime()) < maxTimeMsecs) && hasBlocksToHighlight()) {
 		const QTextBlock & block = nextBlockToHighlight();
 		if (block.isValid()) {
 			int prevUserState = block.userState();
@@ -413,10 +633,6 @@ void NonblockingSyntaxHighlighter::process()
 
 	// Notify the document of our changes
 	markDirtyContent();
-
-	// if there is more work, queue another round
-	if (hasBlocksToHighlight())
-		processWhenIdle();
 }
 
 void NonblockingSyntaxHighlighter::pushHighlightBlock(const QTextBlock & block)
@@ -484,6 +700,12 @@ void NonblockingSyntaxHighlighter::blockHighlighted(const QTextBlock &block)
 const QTextBlock NonblockingSyntaxHighlighter::nextBlockToHighlight() const
 {
 	if (!_parent || _highlightRanges.empty()) return QTextBlock();
+	// Pending blocks that are on screen come first...
+	foreach(range r, _highlightRanges) {
+		if (r.from < _visibleRange.to && r.to > _visibleRange.from)
+			return _parent->findBlock(qMax(r.from, _visibleRange.from));
+	}
+	// ... all others are processed in the background in document order
 	return _parent->findBlock(_highlightRanges[0].from);
 }
 
@@ -528,6 +750,16 @@ void NonblockingSyntaxHighlighter::setFormat(const QString::size_type start, con
 	_currentFormatRanges << formatRange;
 }
 
+void NonblockingSyntaxHighlighter::addFormats(const QTextBlock & block, const QVector<QTextLayout::FormatRange> & formats)
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 6, 0)
+	block.layout()->setAdditionalFormats(block.layout()->additionalFormats() + formats.toList());
+#else
+	block.layout()->setFormats(block.layout()->formats() + formats);
+#endif
+	pushDirtyRange(block);
+}
+
 void NonblockingSyntaxHighlighter::processWhenIdle()
 {
 	if (!_processingPending) {
@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2007-2022  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
+	Copyright (C) 2007-2024  Jonathan Kew, Stefan Löffler, Charlie Sharpsteen
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -24,12 +24,15 @@
 
 #include "document/SpellChecker.h"
 
+#include <QMutex>
 #include <QRegularExpression>
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 #include <QTextDocument>
 #include <QTextLayout>
+#include <QThread>
 #include <QTimer>
+#include <QWaitCondition>
 
 namespace Tw {
 namespace Document {
@@ -55,6 +58,15 @@ public:
 	QTextDocument * document() const { return _parent; }
 	void setDocument(QTextDocument * doc);
 
+	// Blocks in the given character range (typically the part of the document
+	// that is currently on screen) are highlighted first; all other pending
+	// blocks are highlighted in the background afterwards
+	void setVisibleRange(const int from, const int to);
+
+	// Highlights all pending blocks right away instead of in small chunks
+	// from the event loop (used by the highlighter benchmark)
+	void highlightPendingBlocks() { processPendingBlocks(-1); }
+
 public slots:
 	void rehighlight();
 	void rehighlightBlock(const QTextBlock & block);
@@ -67,6 +79,11 @@ protected:
 	int previousBlockState() const { return _currentBlock.previous().userState(); }
 
 	bool hasBlocksToHighlight() const { return !_highlightRanges.empty(); }
+	bool isBlockPending(const QTextBlock & block) const;
+	bool isBlockVisible(const QTextBlock & block) const;
+	// Returns true if block contains the start or the end of the most recent
+	// change of the document
+	bool isBlockEdited(const QTextBlock & block) const;
 	const QTextBlock nextBlockToHighlight() const;
 	void pushHighlightBlock(const QTextBlock & block);
 	void pushHighlightRange(const int from, const int to);
@@ -76,6 +93,8 @@ protected:
 	void pushDirtyRange(const int from, const int length);
 	void markDirtyContent();
 	void sanitizeHighlightRanges();
+	// Adds formats to those of an already highlighted block
+	void addFormats(const QTextBlock & block, const QVector<QTextLayout::FormatRange> & formats);
 
 private slots:
 	void maybeRehighlightText(int position, int charsRemoved, int charsAdded);
@@ -84,6 +103,9 @@ private slots:
 	void unlinkFromDocument() { setDocument(nullptr); }
 
 private:
+	// Stops after maxTimeMsecs, unless maxTimeMsecs is negative
+	void processPendingBlocks(const int maxTimeMsecs);
+
 	bool _processingPending;
 	QTextDocument * _parent;
 	int MAX_TIME_MSECS;
@@ -94,6 +116,8 @@ private:
 	};
 	QVector<range> _highlightRanges;
 	QVector<range> _dirtyRanges;
+	range _visibleRange{0, 0};
+	range _lastEdit{-1, -1};
 
 	QTextBlock _currentBlock;
 	QVector<QTextLayout::FormatRange> _currentFormatRanges;
@@ -105,6 +129,7 @@ class TeXHighlighter : public NonblockingSyntaxHighlighter
 
 public:
 	explicit TeXHighlighter(Tw::Document::TeXDocument * parent);
+	~TeXHighlighter() override;
 	void setActiveIndex(int index);
 
 	void setSpellChecker(Tw::Document::SpellChecker::Dictionary * dictionary);
@@ -122,9 +147,89 @@ protected:
 
 	void spellCheckRange(const QString &text, QString::size_type index, QString::size_type limit, const QTextCharFormat &spellFormat);
 
+private slots:
+	void applySpellCheckResults();
+
 private:
 	static void loadPatterns();
 
+	// Checks the words of off-screen blocks whose verdicts are not cached by
+	// the dictionary, yet, so that loading or reflowing large documents
+	// doesn't block the GUI thread. Finished jobs only retain the misspelled
+	// words and are handed back to the highlighter (see
+	// applySpellCheckResults()).
+	class SpellCheckThread : public QThread {
+	public:
+		struct Word {
+			QString::size_type start, length;
+			QString text;
+			QTextCharFormat format;
+		};
+		struct Job {
+			Tw::Document::SpellChecker::Dictionary * dictionary{nullptr};
+			int generation{0};
+			int blockNumber{-1};
+			// used to detect blocks that have changed in the meantime
+			QString blockText;
+			QVector<Word> words;
+		};
+
+		explicit SpellCheckThread(TeXHighlighter * highlighter) : _highlighter(highlighter) { }
+
+		void enqueue(const Job & job);
+		// Drops all pending jobs and results and waits for the running job
+		// (if any) to finish; afterwards, no job refers to a dictionary
+		// anymore
+		void cancel();
+		void stop();
+		QVector<Job> takeResults();
+
+	protected:
+		void run() override;
+
+	private:
+		TeXHighlighter * _highlighter;
+		QMutex _mutex;
+		QWaitCondition _jobAvailable;
+		QWaitCondition _jobFinished;
+		QVector<Job> _jobs;
+		QVector<Job> _results;
+		bool _busy{false};
+		bool _stopped{false};
+	};
+
+	// Finds the earliest match of any of a list of patterns. Rather than
+	// running each pattern separately, the patterns are combined into a single
+	// alternation so the text is only scanned once. As the alternatives are
+	// tried in order at each position, the result is the same: the earliest
+	// match, and among patterns matching at the same position the first one.
+	// Patterns that refer to their own capture groups by number (e.g.,
+	// backreferences) can't be combined; in that case, each pattern is run
+	// separately.
+	class CombinedMatcher {
+	public:
+		struct Match {
+			int index{-1};
+			QRegularExpressionMatch match;
+			int groupOffset{0};
+
+			QString::size_type start() const { return match.capturedStart(); }
+			QString::size_type length() const { return match.capturedLength(); }
+			// Returns the nth capture group of the matching pattern
+			QString captured(const int nth) const { return match.captured(nth == 0 ? 0 : groupOffset + nth); }
+		};
+
+		void compile(const QList<QRegularExpression> & patterns);
+		bool match(const QString & text, const QString::size_type offset, Match & result) const;
+		bool isCombined() const { return !_groupOffsets.empty(); }
+
+	private:
+		QList<QRegularExpression> _patterns;
+		QRegularExpression _combined;
+		// Index of the group enclosing each pattern in _combined
+		QVector<int> _groupOffsets;
+	};
+
 	struct HighlightingRule {
 		QRegularExpression pattern;
 		QTextCharFormat format;
@@ -135,6 +240,7 @@ private:
 	struct HighlightingSpec {
 		QString				name;
 		HighlightingRules	rules;
+		CombinedMatcher		matcher;
 	};
 	static QList<HighlightingSpec> *syntaxRules;
 
@@ -145,12 +251,20 @@ private:
 		unsigned int level;
 	};
 	static QList<TagPattern> *tagPatterns;
+	static CombinedMatcher *tagMatcher;
 
 	int highlightIndex;
 	bool isTagging;
 
 	Tw::Document::SpellChecker::Dictionary * _dictionary;
 
+	// Blocks that are on screen or being edited are spell checked right away;
+	// for all others, only cached verdicts are used and the remaining words
+	// are deferred to _spellCheckThread
+	bool _checkSynchronously;
+	QVector<SpellCheckThread::Word> _deferredWords;
+	SpellCheckThread _spellCheckThread;
+
 	Tw::Document::TeXDocument * texDoc;
 };
 
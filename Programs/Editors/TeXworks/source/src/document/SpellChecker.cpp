@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2019-2020  Stefan Löffler
+	Copyright (C) 2019-2024  Stefan Löffler
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -115,7 +115,33 @@ SpellChecker::Dictionary::~Dictionary()
 
 bool SpellChecker::Dictionary::isWordCorrect(const QString & word) const
 {
-	return (Hunspell_spell(_hunhandle, _codec->fromUnicode(word).data()) != 0);
+	bool isCorrect{false};
+	if (cachedVerdict(word, isCorrect))
+		return isCorrect;
+
+	int generation{0};
+	{
+		QMutexLocker locker(&_hunspellMutex);
+		generation = _generation.loadAcquire();
+		isCorrect = (Hunspell_spell(_hunhandle, _codec->fromUnicode(word).data()) != 0);
+	}
+
+	QWriteLocker locker(&_verdictsLock);
+	// Don't cache verdicts that were invalidated by ignoreWord() while we
+	// were checking
+	if (generation == _generation.loadAcquire())
+		_verdicts.insert(word, isCorrect);
+	return isCorrect;
+}
+
+bool SpellChecker::Dictionary::cachedVerdict(const QString & word, bool & isCorrect) const
+{
+	QReadLocker locker(&_verdictsLock);
+	QHash<QString, bool>::const_iterator it = _verdicts.constFind(word);
+	if (it == _verdicts.constEnd())
+		return false;
+	isCorrect = it.value();
+	return true;
 }
 
 QList<QString> SpellChecker::Dictionary::suggestionsForWord(const QString & word) const
@@ -123,6 +149,7 @@ QList<QString> SpellChecker::Dictionary::suggestionsForWord(const QString & word
 	QList<QString> suggestions;
 	char ** suggestionList{nullptr};
 
+	QMutexLocker locker(&_hunspellMutex);
 	int numSuggestions = Hunspell_suggest(_hunhandle, &suggestionList, _codec->fromUnicode(word).data());
 	suggestions.reserve(numSuggestions);
 	for (int iSuggestion = 0; iSuggestion < numSuggestions; ++iSuggestion)
@@ -136,7 +163,15 @@ QList<QString> SpellChecker::Dictionary::suggestionsForWord(const QString & word
 void SpellChecker::Dictionary::ignoreWord(const QString & word)
 {
 	// note that this is not persistent after quitting TW
-	Hunspell_add(_hunhandle, _codec->fromUnicode(word).data());
+	{
+		QMutexLocker locker(&_hunspellMutex);
+		Hunspell_add(_hunhandle, _codec->fromUnicode(word).data());
+		_generation.ref();
+	}
+	// Adding a word can change the verdict for other words as well (e.g., for
+	// differently capitalized forms), so drop all cached verdicts
+	QWriteLocker locker(&_verdictsLock);
+	_verdicts.clear();
 }
 
 } // namespace Document
@@ -1,6 +1,6 @@
 /*
 	This is part of TeXworks, an environment for working with TeX documents
-	Copyright (C) 2019-2020  Stefan Löffler
+	Copyright (C) 2019-2024  Stefan Löffler
 
 	This program is free software; you can redistribute it and/or modify
 	it under the terms of the GNU General Public License as published by
@@ -21,8 +21,11 @@
 #ifndef SpellChecker_H
 #define SpellChecker_H
 
+#include <QAtomicInt>
 #include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QReadWriteLock>
 #include <QTextCodec>
 
 struct Hunhandle;
@@ -46,11 +49,26 @@ public:
 		Hunhandle * _hunhandle;
 		QTextCodec * _codec;
 
+		// Hunspell handles must not be used by several threads at once
+		mutable QMutex _hunspellMutex;
+		// Caches the verdicts of isWordCorrect(); the cache may be accessed
+		// from several threads (see TeXHighlighter)
+		mutable QReadWriteLock _verdictsLock;
+		mutable QHash<QString, bool> _verdicts;
+		QAtomicInt _generation;
+
 		Dictionary(const QString & language, Hunhandle * hunhandle);
 	public:
 		virtual ~Dictionary();
 		QString getLanguage() const { return _language; }
+		// thread-safe
 		bool isWordCorrect(const QString & word) const;
+		// Looks up the verdict for word in the cache (without consulting
+		// Hunspell); returns false if word has not been checked, yet
+		bool cachedVerdict(const QString & word, bool & isCorrect) const;
+		// Incremented whenever cached verdicts become invalid (e.g., by
+		// ignoreWord()); verdicts obtained for an older generation are stale
+		int generation() const { return _generation.loadAcquire(); }
 		QList<QString> suggestionsForWord(const QString & word) const;
 		// note that this is not persistent after quitting TW
 		void ignoreWord(const QString & word);
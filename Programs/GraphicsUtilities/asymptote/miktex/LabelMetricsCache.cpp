@@ -0,0 +1,298 @@
+/**
+ * @file miktex/LabelMetricsCache.cpp
+ * @author Christian Schenk
+ * @brief Label metrics cache
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include "asy-first.h"
+#include "config.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include <miktex/Core/CacheFile>
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+
+#include "LabelMetricsCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+MIKTEX_BEGIN_NS;
+
+const char* const CACHE_FILE_NAME = "labels.cache";
+
+// entries which have not been used for this long are removed
+constexpr time_t MAX_AGE = 30 * 24 * 60 * 60;
+
+// the least recently used entries are removed beyond this number
+constexpr size_t MAX_ENTRIES = 20000;
+
+// a found entry is written again (with the new time of use) at most once
+// per this period
+constexpr time_t USE_RESOLUTION = 24 * 60 * 60;
+
+LabelMetricsCache& LabelMetricsCache::GetInstance()
+{
+    static LabelMetricsCache instance;
+    return instance;
+}
+
+LabelMetricsCache::~LabelMetricsCache()
+{
+    Flush();
+}
+
+void LabelMetricsCache::SetDirectory(const PathName& directory)
+{
+    PathName newPath = directory / CACHE_FILE_NAME;
+    if (newPath == path)
+    {
+        return;
+    }
+    Flush();
+    path = newPath;
+    loaded = false;
+    entries.clear();
+}
+
+void LabelMetricsCache::ResetState()
+{
+    state.Init();
+    cacheable = true;
+}
+
+void LabelMetricsCache::UpdateState(const string& s)
+{
+    state.Update(s.c_str(), s.length() + 1);
+    if (ReadsFiles(s))
+    {
+        cacheable = false;
+    }
+}
+
+bool LabelMetricsCache::ReadsFiles(const string& s)
+{
+    // graphic() emits \includegraphics
+    static const char* const commands[] = {
+        "\\includegraphics",
+        "\\input",
+        "\\include",
+        "\\epsfbox",
+        "\\epsfig",
+        "\\lstinputlisting",
+        "\\verbatiminput",
+    };
+    for (const char* command : commands)
+    {
+        if (s.find(command) != string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+string LabelMetricsCache::MakeKey(const string& font, const string& label) const
+{
+    MD5Builder md5Builder = state;
+    md5Builder.Update(font.c_str(), font.length() + 1);
+    md5Builder.Update(label.c_str(), label.length() + 1);
+    return md5Builder.Final().ToString();
+}
+
+void LabelMetricsCache::Load()
+{
+    loaded = true;
+    if (path.Empty() || !File::Exists(path))
+    {
+        return;
+    }
+    size_t numLines = 0;
+    try
+    {
+        ifstream stream = File::CreateInputStream(path);
+        string line;
+        while (getline(stream, line))
+        {
+            numLines++;
+            istringstream fields(line);
+            string key;
+            Entry entry;
+            long long lastUsed;
+            if (fields >> key >> entry.metrics.width >> entry.metrics.height >> entry.metrics.depth >> lastUsed)
+            {
+                entry.lastUsed = static_cast<time_t>(lastUsed);
+                auto it = entries.find(key);
+                if (it == entries.end() || it->second.lastUsed <= entry.lastUsed)
+                {
+                    entries[key] = entry;
+                }
+            }
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+        entries.clear();
+        return;
+    }
+    Evict();
+    // concurrent runs append the same entries, found entries are appended
+    // again: rewrite the file when more than half of the lines are dead
+    if (numLines > 2 * entries.size() && writable)
+    {
+        Compact();
+    }
+}
+
+void LabelMetricsCache::Evict()
+{
+    time_t now = time(nullptr);
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (now - it->second.lastUsed > MAX_AGE)
+        {
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    if (entries.size() <= MAX_ENTRIES)
+    {
+        return;
+    }
+    vector<time_t> times;
+    times.reserve(entries.size());
+    for (const auto& kv : entries)
+    {
+        times.push_back(kv.second.lastUsed);
+    }
+    // keep the MAX_ENTRIES most recently used entries (and those used at the
+    // same time as the last of them)
+    nth_element(times.begin(), times.begin() + (times.size() - MAX_ENTRIES), times.end());
+    time_t oldest = times[times.size() - MAX_ENTRIES];
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (it->second.lastUsed < oldest)
+        {
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void LabelMetricsCache::Compact()
+{
+    try
+    {
+        CacheFile::Write(path, [this](ostream& stream)
+        {
+            stream << setprecision(numeric_limits<double>::max_digits10);
+            for (const auto& kv : entries)
+            {
+                WriteEntry(stream, kv.first, kv.second);
+            }
+        });
+    }
+    catch (const MiKTeXException&)
+    {
+        writable = false;
+    }
+}
+
+void LabelMetricsCache::WriteEntry(ostream& stream, const string& key, const Entry& entry)
+{
+    stream << key << " " << entry.metrics.width << " " << entry.metrics.height << " " << entry.metrics.depth << " " << static_cast<long long>(entry.lastUsed) << "\n";
+}
+
+void LabelMetricsCache::Append(const string& key, const Entry& entry)
+{
+    if (path.Empty() || !writable)
+    {
+        return;
+    }
+    pending << setprecision(numeric_limits<double>::max_digits10);
+    WriteEntry(pending, key, entry);
+}
+
+bool LabelMetricsCache::TryGet(const string& font, const string& label, Metrics& metrics)
+{
+    if (!cacheable || ReadsFiles(label))
+    {
+        return false;
+    }
+    if (!loaded)
+    {
+        Load();
+    }
+    auto it = entries.find(MakeKey(font, label));
+    if (it == entries.end())
+    {
+        return false;
+    }
+    metrics = it->second.metrics;
+    time_t now = time(nullptr);
+    if (now - it->second.lastUsed > USE_RESOLUTION)
+    {
+        // keep the entry from being evicted
+        it->second.lastUsed = now;
+        Append(it->first, it->second);
+    }
+    return true;
+}
+
+void LabelMetricsCache::Put(const string& font, const string& label, const Metrics& metrics)
+{
+    if (!cacheable || ReadsFiles(label))
+    {
+        return;
+    }
+    string key = MakeKey(font, label);
+    Entry& entry = entries[key];
+    entry.metrics = metrics;
+    entry.lastUsed = time(nullptr);
+    Append(key, entry);
+}
+
+void LabelMetricsCache::Flush()
+{
+    string lines = pending.str();
+    pending.str("");
+    if (lines.empty() || path.Empty() || !writable)
+    {
+        return;
+    }
+    try
+    {
+        // an append-only log: concurrent runs just add lines
+        Directory::Create(PathName(path).RemoveFileSpec());
+        ofstream stream = File::CreateOutputStream(path, ios_base::out | ios_base::app);
+        stream << lines;
+        stream.close();
+    }
+    catch (const MiKTeXException&)
+    {
+        writable = false;
+    }
+}
+
+MIKTEX_END_NS;
@@ -0,0 +1,102 @@
+/**
+ * @file miktex/LabelMetricsCache.h
+ * @author Christian Schenk
+ * @brief Label metrics cache
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include "asy-first.h"
+
+#include <ctime>
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include <miktex/Core/MD5>
+#include <miktex/Util/PathName>
+
+MIKTEX_BEGIN_NS;
+
+/// Remembers the dimensions of labels across runs.
+///
+/// A label is identified by its text, by the font settings and by everything
+/// which has been sent to the TeX pipe before (preamble, verbatim TeX).
+/// Labels which read files (e.g., `\includegraphics`) are not cached: the
+/// files may change between runs.
+class LabelMetricsCache
+{
+
+public:
+
+    struct Metrics
+    {
+        double width;
+        double height;
+        double depth;
+    };
+
+    ~LabelMetricsCache();
+
+    static LabelMetricsCache& GetInstance();
+
+    /// Sets the directory in which the cache file is kept.
+    void SetDirectory(const MiKTeX::Util::PathName& directory);
+
+    /// Forgets the TeX state (the TeX pipe has been (re-)opened).
+    void ResetState();
+
+    /// Contributes to the TeX state.
+    void UpdateState(const std::string& s);
+
+    bool TryGet(const std::string& font, const std::string& label, Metrics& metrics);
+
+    /// Remembers the dimensions of a label; the cache file is updated by
+    /// `Flush()`.
+    void Put(const std::string& font, const std::string& label, const Metrics& metrics);
+
+    /// Appends the new entries to the cache file (once per picture).
+    void Flush();
+
+private:
+
+    struct Entry
+    {
+        Metrics metrics;
+        /// When the entry has been stored or found.
+        std::time_t lastUsed;
+    };
+
+    static bool ReadsFiles(const std::string& s);
+
+    std::string MakeKey(const std::string& font, const std::string& label) const;
+
+    void Load();
+
+    void Evict();
+
+    void Compact();
+
+    void Append(const std::string& key, const Entry& entry);
+
+    static void WriteEntry(std::ostream& stream, const std::string& key, const Entry& entry);
+
+    MiKTeX::Core::MD5Builder state;
+    /// `false`, if the TeX state depends on files.
+    bool cacheable = true;
+    MiKTeX::Util::PathName path;
+    bool loaded = false;
+    bool writable = true;
+    std::unordered_map<std::string, Entry> entries;
+    std::ostringstream pending;
+};
+
+MIKTEX_END_NS;
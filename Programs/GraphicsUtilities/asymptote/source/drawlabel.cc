@@ -12,6 +12,10 @@
 #include "util.h"
 #include "lexical.h"
 
+#if defined(MIKTEX)
+#include <miktex/LabelMetricsCache.h>
+#endif
+
 using namespace settings;
 
 namespace camp {
@@ -92,9 +96,112 @@ void setpen(iopipestream& tex, const string& texengine, const pen& pentype)
   drawElement::lastpen=pentype;
 }
 
+#if defined(MIKTEX)
+// The pen settings which are sent to the tex engine by setpen.
+string fontkey(const string& texengine, const pen& pentype)
+{
+  ostringstream buf;
+  buf << texengine << newl << pentype.Font() << newl << pentype.size()
+      << newl << pentype.Lineskip();
+  return buf.str();
+}
+
+string metricskey(const string& label, const string& size)
+{
+  return label+'\0'+size;
+}
+
+// Bounds the amount of tex output which is not read while labels are sent.
+const size_t maxbatch=64;
+
+void drawLabel::getbounds(iopipestream& tex, const string& texengine,
+                          const mem::vector<drawLabel*>& labels)
+{
+  typedef MiKTeX::Aymptote::LabelMetricsCache LabelMetricsCache;
+  LabelMetricsCache& cache=LabelMetricsCache::GetInstance();
+  bool Latex=latex(texengine);
+  string start(">dim(");
+  string stop(")dim");
+  mem::vector<drawLabel*> pending;
+  size_t n=labels.size();
+  for(size_t i=0; i < n; ++i) {
+    drawLabel *L=labels[i];
+    if(!L->havebounds) {
+      L->havebounds=true;
+      LabelMetricsCache::Metrics metrics;
+      if(cache.TryGet(fontkey(texengine,L->pentype),
+                      metricskey(L->label,L->size),metrics)) {
+        L->width=metrics.width;
+        L->height=metrics.height;
+        L->depth=metrics.depth;
+        L->alignbounds();
+      } else {
+        if(Latex) setlatexfont(tex,L->pentype,drawElement::lastpen);
+        settexfont(tex,L->pentype,drawElement::lastpen,Latex);
+        drawElement::lastpen=L->pentype;
+        tex << "\\setbox\\ASYbox=\\hbox{" << stripblanklines(L->label) << "}\n"
+            << "\\immediate\\write16{" << start
+            << "\\the\\wd\\ASYbox,\\the\\ht\\ASYbox,\\the\\dp\\ASYbox" << stop
+            << "}\n";
+        pending.push_back(L);
+      }
+    }
+    if(pending.empty() || (pending.size() < maxbatch && i+1 < n)) continue;
+
+    // An empty line makes the tex engine prompt for more input.
+    tex << "\n";
+    tex.wait(texready.c_str());
+    string buffer=tex.getbuffer();
+    size_t pos=0;
+    for(size_t j=0; j < pending.size(); ++j) {
+      drawLabel *L=pending[j];
+      size_t dim1=buffer.find(start,pos);
+      size_t dim2=dim1 == string::npos ? dim1 : buffer.find(stop,dim1);
+      if(dim2 == string::npos)
+        camp::reportError("Cannot read label dimensions");
+      double *dims[]={&L->width,&L->height,&L->depth};
+      istringstream dimensions(buffer.substr(dim1+start.size(),
+                                             dim2-dim1-start.size()));
+      for(size_t k=0; k < 3; ++k) {
+        string d;
+        getline(dimensions,d,',');
+        if(d.size() < 2 || d.substr(d.size()-2) != "pt")
+          camp::reportError("Cannot read label dimensions");
+        try {
+          *dims[k]=lexical::cast<double>(d.substr(0,d.size()-2),true)*tex2ps;
+        } catch(lexical::bad_cast&) {
+          camp::reportError("Cannot read label dimensions");
+        }
+      }
+      pos=dim2;
+    }
+    for(size_t j=0; j < pending.size(); ++j) {
+      drawLabel *L=pending[j];
+      if(L->width == 0.0 && L->height == 0.0 && L->depth == 0.0 &&
+         !L->size.empty()) {
+        setpen(tex,texengine,L->pentype);
+        texbounds(L->width,L->height,L->depth,tex,L->size);
+      }
+      LabelMetricsCache::Metrics metrics={L->width,L->height,L->depth};
+      cache.Put(fontkey(texengine,L->pentype),metricskey(L->label,L->size),
+                metrics);
+      L->alignbounds();
+    }
+    pending.clear();
+  }
+}
+#endif
+
 void drawLabel::getbounds(iopipestream& tex, const string& texengine)
 {
   if(havebounds) return;
+#if defined(MIKTEX)
+  getbounds(tex,texengine,mem::vector<drawLabel*>(1,this));
+}
+
+void drawLabel::alignbounds()
+{
+#else
   havebounds=true;
 
   setpen(tex,texengine,pentype);
@@ -102,6 +209,7 @@ void drawLabel::getbounds(iopipestream& tex, const string& texengine)
 
   if(width == 0.0 && height == 0.0 && depth == 0.0 && !size.empty())
     texbounds(width,height,depth,tex,size);
+#endif
 
   enabled=true;
 
@@ -43,6 +43,14 @@ public:
 
   void getbounds(iopipestream& tex, const string& texengine);
 
+#if defined(MIKTEX)
+  // Measures several labels with a single request to the tex engine.
+  static void getbounds(iopipestream& tex, const string& texengine,
+                        const mem::vector<drawLabel*>& labels);
+
+  void alignbounds();
+#endif
+
   void checkbounds();
 
   void bounds(bbox& b, iopipestream&, boxvector&, bboxlist&);
@@ -10,6 +10,10 @@
 
 #include "drawelement.h"
 
+#if defined(MIKTEX)
+#include <miktex/LabelMetricsCache.h>
+#endif
+
 namespace camp {
 
 enum Language {PostScript,TeX};
@@ -35,8 +39,12 @@ public:
   void bounds(bbox& b, iopipestream& tex, boxvector&, bboxlist&) {
     if(havebounds) return;
     havebounds=true;
-    if(language == TeX)
+    if(language == TeX) {
+#if defined(MIKTEX)
+      MiKTeX::Aymptote::LabelMetricsCache::GetInstance().UpdateState(text);
+#endif
       tex << text << "%" << newl;
+    }
     if(userbounds) {
       b += min;
       b += max;
@@ -15,6 +15,7 @@
 #endif
 #include <miktex/Core/Directory>
 #include <miktex/Core/TemporaryDirectory>
+#include <miktex/LabelMetricsCache.h>
 
 #endif
 #include "errormsg.h"
@@ -292,8 +293,27 @@ bbox picture::bounds()
   processDataStruct& pd=processData();
 
   for(size_t i=0; i < lastnumber; ++i) ++p;
+#if defined(MIKTEX)
+  string texengine=getSetting<string>("tex");
+  nodelist::iterator measured=texengine == "none" ? nodes.end() : p;
+#endif
   for(; p != nodes.end(); ++p) {
     assert(*p);
+#if defined(MIKTEX)
+    // Measure the labels up to the next verbatim TeX code in one go.
+    if(p == measured) {
+      if((*p)->islabel() && !dynamic_cast<drawLabel *>(*p)) ++measured;
+      else {
+        mem::vector<drawLabel*> labels;
+        for(; measured != nodes.end(); ++measured) {
+          drawLabel *L=dynamic_cast<drawLabel *>(*measured);
+          if(L) labels.push_back(L);
+          else if((*measured)->islabel()) break;
+        }
+        drawLabel::getbounds(pd.tex,texengine,labels);
+      }
+    }
+#endif
     (*p)->bounds(b_cached,pd.tex,labelbounds,bboxstack);
 
     // Optimization for interpreters with fixed stack limits.
@@ -307,6 +327,9 @@ bbox picture::bounds()
       }
     }
   }
+#if defined(MIKTEX)
+  MiKTeX::Aymptote::LabelMetricsCache::GetInstance().Flush();
+#endif
 
   lastnumber=n;
   return b_cached;
@@ -361,6 +384,11 @@ void texinit()
   // Output any new texpreamble commands
   if(pd.tex.isopen()) {
     if(pd.TeXpipepreamble.empty()) return;
+#if defined(MIKTEX)
+    for(mem::list<string>::iterator p=pd.TeXpipepreamble.begin();
+        p != pd.TeXpipepreamble.end(); ++p)
+      MiKTeX::Aymptote::LabelMetricsCache::GetInstance().UpdateState(*p);
+#endif
     texpreamble(pd.tex,pd.TeXpipepreamble,true);
     pd.TeXpipepreamble.clear();
     return;
@@ -423,6 +451,28 @@ void texinit()
 
   texdefines(pd.tex,pd.TeXpreamble,true);
   pd.TeXpipepreamble.clear();
+
+#if defined(MIKTEX)
+  // Label dimensions depend on the engine, the preamble and the aux file.
+  MiKTeX::Aymptote::LabelMetricsCache& cache=
+    MiKTeX::Aymptote::LabelMetricsCache::GetInstance();
+  cache.SetDirectory(MiKTeX::Util::PathName(initdir));
+  cache.ResetState();
+  cache.UpdateState(getSetting<string>("tex"));
+  for(mem::list<string>::iterator p=pd.TeXpreamble.begin();
+      p != pd.TeXpreamble.end(); ++p)
+    cache.UpdateState(*p);
+#if defined(MIKTEX_WINDOWS)
+  ifstream aux(UW_(auxname(outname(),"aux").c_str()));
+#else
+  ifstream aux(auxname(outname(),"aux").c_str());
+#endif
+  if(aux) {
+    std::ostringstream buf;
+    buf << aux.rdbuf();
+    cache.UpdateState(buf.str());
+  }
+#endif
 }
 
 int opentex(const string& texname, const string& prefix, bool dvi)
@@ -74,6 +74,9 @@ extern const string guisuffix;
 extern const string standardprefix;
 
 extern string historyname;
+#if defined(MIKTEX)
+extern string initdir;
+#endif
 
 void SetPageDimensions();
 
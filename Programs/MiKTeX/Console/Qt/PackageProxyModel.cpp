@@ -1,6 +1,6 @@
 /* PackageProxyModel.cpp:
 
-   Copyright (C) 2018-2021 Christian Schenk
+   Copyright (C) 2018-2024 Christian Schenk
 
    This file is part of MiKTeX Console.
 
@@ -39,9 +39,17 @@ PackageProxyModel::PackageProxyModel(QObject* parent) :
 void PackageProxyModel::SetFilter(const string& filter)
 {
   this->filterText = filter;
+  haveAcceptedPackages = false;
   invalidateFilter();
 }
 
+void PackageProxyModel::setSourceModel(QAbstractItemModel* sourceModel)
+{
+  QSortFilterProxyModel::setSourceModel(sourceModel);
+  // the package database might have changed
+  (void)connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, [this]() { haveAcceptedPackages = false; });
+}
+
 bool PackageProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
   if (filterText.empty())
@@ -50,32 +58,15 @@ bool PackageProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourc
   }
   PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
   MIKTEX_ASSERT(packageTableModel != nullptr);
-  PackageInfo packageInfo;
-  if (!packageTableModel->TryGetPackageInfo(sourceModel()->index(sourceRow, 0, sourceParent), packageInfo))
+  if (!haveAcceptedPackages)
   {
-    return false;
-  }
-  bool accept = false;
-  if (!accept)
-  {
-    accept = packageInfo.id.find(filterText) != string::npos;
-  }
-  if (!accept)
-  {
-    accept = packageInfo.title.find(filterText) != string::npos;
-  }
-  if (!accept)
-  {
-    for (const string& f : packageInfo.runFiles)
-    {
-      accept = PathName::Match(filterText.c_str(), PathName(f).RemoveDirectorySpec());
-      if (accept)
-      {
-        break;
-      }
-    }
+    vector<string> packageIds = packageTableModel->GetPackageManager()->SearchPackages(filterText, { PackageSearchField::Id, PackageSearchField::Title, PackageSearchField::FileName });
+    acceptedPackages = unordered_set<string>(packageIds.begin(), packageIds.end());
+    haveAcceptedPackages = true;
   }
-  return accept;
+  const map<int, PackageInfo>& packages = packageTableModel->GetData();
+  map<int, PackageInfo>::const_iterator it = packages.find(sourceRow);
+  return it != packages.end() && acceptedPackages.find(it->second.id) != acceptedPackages.end();
 }
 
 bool PackageProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const
@@ -1,6 +1,6 @@
 /* PackageProxyModel.h:                                 -*- C++ -*-
 
-   Copyright (C) 2018 Christian Schenk
+   Copyright (C) 2018-2024 Christian Schenk
 
    This file is part of MiKTeX Console.
 
@@ -24,6 +24,9 @@
 #if !defined(E7AF14B9D04F41D48C47DDB1A55839A8)
 #define E7AF14B9D04F41D48C47DDB1A55839A8
 
+#include <string>
+#include <unordered_set>
+
 #include <QSortFilterProxyModel>
 
 class PackageProxyModel :
@@ -38,6 +41,9 @@ public:
 public:
   void SetFilter(const std::string& filter);
 
+public:
+  void setSourceModel(QAbstractItemModel* sourceModel) override;
+
 protected:
   bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
 
@@ -46,6 +52,12 @@ protected:
   
 private:
   std::string filterText;
+
+private:
+  mutable std::unordered_set<std::string> acceptedPackages;
+
+private:
+  mutable bool haveAcceptedPackages = false;
 };
 
 #endif
@@ -1,6 +1,6 @@
 /* PackageTableModel.h:                                 -*- C++ -*-
 
-   Copyright (C) 2018-2019 Christian Schenk
+   Copyright (C) 2018-2024 Christian Schenk
 
    This file is part of MiKTeX Console.
 
@@ -68,6 +68,12 @@ public:
     return packages;
   }
 
+public:
+  std::shared_ptr<MiKTeX::Packages::PackageManager> GetPackageManager() const
+  {
+    return packageManager;
+  }
+
 private:
   std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
 };
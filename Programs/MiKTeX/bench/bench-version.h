@@ -0,0 +1,20 @@
+/**
+ * @file bench-version.h
+ * @author Christian Schenk
+ * @brief Version number
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Benchmark Utility.
+ *
+ * MiKTeX Benchmark Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#define MIKTEX_COMP_MAJOR_VERSION 1
+#define MIKTEX_COMP_MINOR_VERSION 0
+#define MIKTEX_COMP_PATCH_VERSION 0
+
+#define MIKTEX_COMP_COPYRIGHT_STR "© 2024 Christian Schenk"
+
+#include <miktex/Version>
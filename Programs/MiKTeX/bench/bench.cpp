@@ -0,0 +1,692 @@
+/**
+ * @file bench.cpp
+ * @author Christian Schenk
+ * @brief MiKTeX benchmarks
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Benchmark Utility.
+ *
+ * MiKTeX Benchmark Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <cmath>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <nlohmann/json.hpp>
+
+#include "bench-version.h"
+
+#include <miktex/App/Application>
+#include <miktex/Core/Cfg>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/FileType>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Process>
+#include <miktex/Core/Quoter>
+#include <miktex/Core/Session>
+#include <miktex/Core/TemporaryDirectory>
+#include <miktex/Core/Utils>
+#include <miktex/Core/VersionNumber>
+#include <miktex/Util/StringUtil>
+#include <miktex/Wrappers/PoptWrapper>
+
+#if defined(MIKTEX_WINDOWS)
+#include <miktex/Core/win/ConsoleCodePageSwitcher>
+#endif
+
+#include "workloads.h"
+
+using namespace std;
+
+using namespace MiKTeX::App;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+using json = nlohmann::json;
+
+#define T_(x) MIKTEXTEXT(x)
+#define Q_(x) MiKTeX::Core::Quoter<char>(x).GetData()
+
+const char* const TheNameOfTheGame = T_("MiKTeX Benchmark Utility");
+
+// increment whenever the meaning of the numbers changes
+constexpr int REPORT_VERSION = 1;
+
+struct Benchmark
+{
+    /// Unique name; used to match results against the baseline.
+    string name;
+    /// `micro` (in-process) or `macro` (runs a program).
+    string kind;
+    /// Number of operations per sample.
+    int operations = 1;
+    /// Prepares the benchmark; returns a non-empty string, if the benchmark
+    /// must be skipped.
+    function<string()> prepare;
+    /// Runs `operations` operations.
+    function<void()> run;
+    /// Releases what has been acquired by `prepare`.
+    function<void()> cleanup;
+};
+
+struct Result
+{
+    string name;
+    string kind;
+    int operations;
+    vector<double> samples;
+    double min;
+    double median;
+    double mean;
+    double stddev;
+};
+
+/// Calls a function when the scope is left, also by an exception.
+struct ScopeGuard
+{
+    function<void()> onExit;
+    ~ScopeGuard()
+    {
+        if (onExit)
+        {
+            onExit();
+        }
+    }
+};
+
+/// Parses a whole string as a number.
+template<typename T> static bool ParseNumber(const string& s, T& number)
+{
+    istringstream stream(s);
+    stream >> number;
+    return !stream.fail() && stream.eof();
+}
+
+class BenchmarkUtility :
+    public Application
+{
+public:
+
+    int Run(int argc, const char** argv);
+
+private:
+
+    void AddBenchmarks();
+    void Macro(const string& name, const string& program, const vector<string>& arguments, function<string()> prepareInput);
+    Result Measure(Benchmark& benchmark);
+    void RunProgram(const PathName& program, const vector<string>& arguments);
+    void ShowVersion();
+
+    vector<Benchmark> benchmarks;
+    int repetitions = 5;
+    shared_ptr<Session> session;
+    unique_ptr<TemporaryDirectory> workDir;
+};
+
+enum Option
+{
+    OPT_AAA = 1000,
+    OPT_BASELINE,
+    OPT_FILTER,
+    OPT_KEEP,
+    OPT_LIST,
+    OPT_OUTPUT,
+    OPT_PROBE,
+    OPT_REPETITIONS,
+    OPT_THRESHOLD,
+    OPT_VERSION,
+};
+
+static const struct poptOption aoption[] = {
+    {
+        "baseline", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_BASELINE,
+        T_("Compare the results with a previous report."),
+        T_("FILE")
+    },
+    {
+        "filter", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_FILTER,
+        T_("Run only benchmarks whose name contains STRING."),
+        T_("STRING")
+    },
+    {
+        "keep", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_KEEP,
+        T_("Keep the working directory."),
+        nullptr
+    },
+    {
+        "list", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_LIST,
+        T_("List the benchmarks."),
+        nullptr
+    },
+    {
+        "output", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_OUTPUT,
+        T_("Write the JSON report to FILE instead of standard output."),
+        T_("FILE")
+    },
+    {
+        "probe", 0,
+        POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN, nullptr,
+        OPT_PROBE,
+        T_("Initialize and exit (used to measure the startup time)."),
+        nullptr
+    },
+    {
+        "repetitions", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_REPETITIONS,
+        T_("Take N samples per benchmark (default: 5)."),
+        T_("N")
+    },
+    {
+        "threshold", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_THRESHOLD,
+        T_("Report a regression, if a median is more than PERCENT slower than the baseline (default: 10)."),
+        T_("PERCENT")
+    },
+    {
+        "version", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_VERSION,
+        T_("Show version information and exit."),
+        nullptr
+    },
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+void BenchmarkUtility::ShowVersion()
+{
+    cout
+        << Utils::MakeProgramVersionString(TheNameOfTheGame, VersionNumber(MIKTEX_COMPONENT_VERSION_STR)) << endl
+        << endl
+        << MIKTEX_COMP_COPYRIGHT_STR << endl
+        << endl
+        << "This is free software; see the source for copying conditions.  There is NO" << endl
+        << "warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE." << endl;
+}
+
+void BenchmarkUtility::RunProgram(const PathName& program, const vector<string>& arguments)
+{
+    int exitCode;
+    MiKTeXException miktexException;
+    auto discard = [](const void*, size_t) { return true; };
+    if (!Process::Run(program, arguments, discard, &exitCode, &miktexException, workDir->GetPathName().GetData()))
+    {
+        throw miktexException;
+    }
+    if (exitCode != 0)
+    {
+        FatalError(fmt::format(T_("{0} failed with exit code {1}."), Q_(program), exitCode));
+    }
+}
+
+void BenchmarkUtility::Macro(const string& name, const string& program, const vector<string>& arguments, function<string()> prepareInput)
+{
+    auto programPath = make_shared<PathName>();
+    Benchmark benchmark;
+    benchmark.name = name;
+    benchmark.kind = "macro";
+    benchmark.prepare = [this, program, programPath, prepareInput]() -> string
+    {
+        if (!session->FindFile(program, FileType::EXE, *programPath))
+        {
+            return fmt::format(T_("{0} not found"), program);
+        }
+        return prepareInput ? prepareInput() : "";
+    };
+    benchmark.run = [this, program, programPath, arguments]()
+    {
+        vector<string> args{ program };
+        args.insert(args.end(), arguments.begin(), arguments.end());
+        RunProgram(*programPath, args);
+    };
+    benchmarks.push_back(benchmark);
+}
+
+void BenchmarkUtility::AddBenchmarks()
+{
+    PathName dir = workDir->GetPathName();
+
+    // in-process benchmarks
+    //
+    // Qt-based components are not covered: miktex-bench must run without
+    // Qt; the TeXworks syntax highlighter has its own benchmark
+    // (texworks-highlight-bench).
+
+    benchmarks.push_back(Benchmark{
+        "findfile-hit", "micro", 10000,
+        [this]() -> string
+        {
+            PathName path;
+            return session->FindFile("plain.tex", FileType::TEX, path) ? "" : T_("plain.tex not found");
+        },
+        [this]()
+        {
+            PathName path;
+            for (int n = 0; n < 10000; ++n)
+            {
+                session->FindFile("plain.tex", FileType::TEX, path);
+            }
+        }
+    });
+
+    benchmarks.push_back(Benchmark{
+        "findfile-miss", "micro", 1000,
+        nullptr,
+        [this]()
+        {
+            PathName path;
+            for (int n = 0; n < 1000; ++n)
+            {
+                session->FindFile(fmt::format("miktex-bench-{0}.sty", n), FileType::TEX, path);
+            }
+        }
+    });
+
+    benchmarks.push_back(Benchmark{
+        "fndb-load", "micro", 10,
+        nullptr,
+        [this]()
+        {
+            PathName path;
+            for (int n = 0; n < 10; ++n)
+            {
+                session->UnloadFilenameDatabase();
+                session->FindFile("plain.tex", FileType::TEX, path);
+            }
+        }
+    });
+
+    benchmarks.push_back(Benchmark{
+        "fndb-build", "micro", 1,
+        [dir]() -> string
+        {
+            Workloads::CreateFileTree(dir / "tree", 1000, 50);
+            return "";
+        },
+        [dir]()
+        {
+            Fndb::Create(dir / "tree.fndb", dir / "tree", nullptr);
+        }
+    });
+
+    benchmarks.push_back(Benchmark{
+        "cfg-read", "micro", 1,
+        [dir]() -> string
+        {
+            Workloads::WriteCfg(dir / "bench.ini", 5000, 10);
+            return "";
+        },
+        [dir]()
+        {
+            unique_ptr<Cfg> cfg = Cfg::Create();
+            cfg->Read(dir / "bench.ini");
+        }
+    });
+
+    // starting a child process from a parent with a large resident set
+    auto ballast = make_shared<vector<char>>();
+    benchmarks.push_back(Benchmark{
+        "spawn-large-parent", "micro", 20,
+        [ballast]() -> string
+        {
+            try
+            {
+                // resize() writes every byte: the pages become resident
+                ballast->resize(size_t(2048) * 1024 * 1024);
+            }
+            catch (const bad_alloc&)
+            {
+                return T_("not enough memory");
+            }
+            return "";
+        },
+        []()
+        {
+            for (int n = 0; n < 20; ++n)
+            {
+                Process::ExecuteSystemCommand("exit 0");
+            }
+        },
+        [ballast]()
+        {
+            vector<char>().swap(*ballast);
+        }
+    });
+
+    // programs
+
+    benchmarks.push_back(Benchmark{
+        "session-startup", "macro", 1,
+        nullptr,
+        [this]()
+        {
+            PathName myself = session->GetMyProgramFile(true);
+            RunProgram(myself, { myself.GetFileNameWithoutExtension().ToString(), "--probe" });
+        }
+    });
+
+    Macro("format-undump-plain", "tex", { "-interaction=batchmode", "\\end" }, nullptr);
+    Macro("format-undump-latex", "pdflatex", { "-interaction=batchmode", "\\stop" }, nullptr);
+    Macro("lualatex-empty", "lualatex", { "-interaction=batchmode", "\\documentclass{article}\\begin{document}\\end{document}" }, nullptr);
+    Macro("inputline", "tex", { "-interaction=batchmode", "lines.tex" }, [dir]() { Workloads::WriteLines(dir / "lines.tex", 200000); return ""; });
+    Macro("bibtex", "bibtex", { "-terse", "refs" }, [dir]() { Workloads::WriteBibliography(dir, "refs", 5000); return ""; });
+    Macro("makeindex", "makeindex", { "-q", "big.idx" }, [dir]() { Workloads::WriteIndex(dir / "big.idx", 100000); return ""; });
+    Macro("xetex-novel", "xetex", { "-interaction=batchmode", "-no-pdf", "novel.tex" }, [dir]() { Workloads::WriteNovel(dir / "novel.tex", 40); return ""; });
+
+    // the DVI file is created once by the preparation step
+    auto makeDvi = [this, dir]() -> string
+    {
+        Workloads::WritePages(dir / "pages.tex", 400);
+        PathName tex;
+        if (!session->FindFile("tex", FileType::EXE, tex))
+        {
+            return T_("tex not found");
+        }
+        RunProgram(tex, { "tex", "-interaction=batchmode", "pages.tex" });
+        return "";
+    };
+    Macro("dvipdfmx", "dvipdfmx", { "-q", "-o", "pages.pdf", "pages.dvi" }, makeDvi);
+    Macro("dvisvgm", "dvisvgm", { "--page=1-", "--no-fonts", "--output=pages-%p.svg", "pages.dvi" }, makeDvi);
+}
+
+Result BenchmarkUtility::Measure(Benchmark& benchmark)
+{
+    Result result;
+    result.name = benchmark.name;
+    result.kind = benchmark.kind;
+    result.operations = benchmark.operations;
+    // warm up caches
+    benchmark.run();
+    for (int n = 0; n < repetitions; ++n)
+    {
+        auto start = chrono::steady_clock::now();
+        benchmark.run();
+        chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        result.samples.push_back(elapsed.count() / benchmark.operations);
+    }
+    vector<double> sorted = result.samples;
+    sort(sorted.begin(), sorted.end());
+    result.min = sorted.front();
+    size_t mid = sorted.size() / 2;
+    result.median = sorted.size() % 2 == 1 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+    double sum = 0;
+    for (double x : sorted)
+    {
+        sum += x;
+    }
+    result.mean = sum / sorted.size();
+    double sumSquares = 0;
+    for (double x : sorted)
+    {
+        sumSquares += (x - result.mean) * (x - result.mean);
+    }
+    result.stddev = sorted.size() > 1 ? sqrt(sumSquares / (sorted.size() - 1)) : 0;
+    return result;
+}
+
+int BenchmarkUtility::Run(int argc, const char** argv)
+{
+    session = GetSession();
+
+    PathName baselinePath;
+    string filter;
+    bool keep = false;
+    bool list = false;
+    PathName outputPath;
+    double threshold = 10.0;
+
+    PoptWrapper popt(argc, argv, aoption);
+    int option;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+        string optArg = popt.GetOptArg();
+        switch (option)
+        {
+        case OPT_BASELINE:
+            baselinePath = optArg;
+            break;
+        case OPT_FILTER:
+            filter = optArg;
+            break;
+        case OPT_KEEP:
+            keep = true;
+            break;
+        case OPT_LIST:
+            list = true;
+            break;
+        case OPT_OUTPUT:
+            outputPath = optArg;
+            break;
+        case OPT_PROBE:
+            return EXIT_SUCCESS;
+        case OPT_REPETITIONS:
+            if (!ParseNumber(optArg, repetitions))
+            {
+                FatalError(fmt::format(T_("--repetitions: invalid argument: {0}"), optArg));
+            }
+            if (repetitions < 1)
+            {
+                FatalError(T_("The number of repetitions must be positive."));
+            }
+            break;
+        case OPT_THRESHOLD:
+            if (!ParseNumber(optArg, threshold))
+            {
+                FatalError(fmt::format(T_("--threshold: invalid argument: {0}"), optArg));
+            }
+            break;
+        case OPT_VERSION:
+            ShowVersion();
+            throw 0;
+        }
+    }
+    if (option != -1)
+    {
+        string msg = popt.BadOption(POPT_BADOPTION_NOALIAS);
+        msg += ": ";
+        msg += popt.Strerror(option);
+        FatalError(msg);
+    }
+
+    workDir = TemporaryDirectory::Create();
+    if (keep)
+    {
+        workDir->Keep();
+    }
+
+    AddBenchmarks();
+
+    if (list)
+    {
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            cout << benchmark.kind << "\t" << benchmark.name << endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    json baseline;
+    if (!baselinePath.Empty())
+    {
+        ifstream stream = File::CreateInputStream(baselinePath);
+        baseline = json::parse(stream);
+        if (baseline.value("version", 0) != REPORT_VERSION)
+        {
+            FatalError(fmt::format(T_("{0} is not a compatible report."), Q_(baselinePath)));
+        }
+    }
+
+    json report;
+    report["version"] = REPORT_VERSION;
+    report["miktex"] = Utils::GetMiKTeXVersionString();
+    report["system"] = Utils::GetOSVersionString();
+    report["repetitions"] = repetitions;
+    report["unit"] = "ns";
+    report["benchmarks"] = json::array();
+    report["skipped"] = json::array();
+
+    int numRegressions = 0;
+
+    for (Benchmark& benchmark : benchmarks)
+    {
+        if (!filter.empty() && benchmark.name.find(filter) == string::npos)
+        {
+            continue;
+        }
+        string skipReason = benchmark.prepare ? benchmark.prepare() : "";
+        if (!skipReason.empty())
+        {
+            cerr << fmt::format(T_("{0}: skipped ({1})"), benchmark.name, skipReason) << endl;
+            report["skipped"].push_back({ { "name", benchmark.name }, { "reason", skipReason } });
+            continue;
+        }
+        Result result;
+        {
+            ScopeGuard cleanup{ benchmark.cleanup };
+            result = Measure(benchmark);
+        }
+        json entry = {
+            { "name", result.name },
+            { "kind", result.kind },
+            { "operations", result.operations },
+            { "min", result.min },
+            { "median", result.median },
+            { "mean", result.mean },
+            { "stddev", result.stddev },
+            { "samples", result.samples },
+        };
+        string comparison;
+        if (baseline.contains("benchmarks"))
+        {
+            for (const json& old : baseline["benchmarks"])
+            {
+                if (old.value("name", "") != result.name || old.value("median", 0.0) <= 0)
+                {
+                    continue;
+                }
+                double ratio = result.median / old["median"].get<double>();
+                bool regression = ratio > 1.0 + threshold / 100.0;
+                entry["baseline"] = {
+                    { "median", old["median"] },
+                    { "ratio", ratio },
+                    { "regression", regression },
+                };
+                comparison = fmt::format(" ({0:+.1f}%{1})", (ratio - 1.0) * 100.0, regression ? T_(", REGRESSION") : "");
+                if (regression)
+                {
+                    numRegressions++;
+                }
+            }
+        }
+        cerr << fmt::format("{0}: {1:.0f} ns/op{2}", result.name, result.median, comparison) << endl;
+        report["benchmarks"].push_back(entry);
+    }
+
+    report["regressions"] = numRegressions;
+
+    if (outputPath.Empty())
+    {
+        cout << setw(2) << report << endl;
+    }
+    else
+    {
+        ofstream stream = File::CreateOutputStream(outputPath);
+        stream << setw(2) << report << endl;
+        stream.close();
+    }
+
+    if (keep)
+    {
+        cerr << fmt::format(T_("working directory: {0}"), workDir->GetPathName().ToDisplayString()) << endl;
+    }
+
+    return numRegressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#if defined(_UNICODE)
+#define MAIN wmain
+#define MAINCHAR wchar_t
+#else
+#define MAIN main
+#define MAINCHAR char
+#endif
+
+int MAIN(int argc, MAINCHAR** argv)
+{
+#if defined(MIKTEX_WINDOWS)
+    ConsoleCodePageSwitcher cpSwitcher;
+#endif
+    BenchmarkUtility app;
+    try
+    {
+        vector<string> utf8args;
+        utf8args.reserve(argc);
+        vector<char*> newargv;
+        newargv.reserve(argc + 1);
+        for (int idx = 0; idx < argc; ++idx)
+        {
+#if defined(_UNICODE)
+            utf8args.push_back(StringUtil::WideCharToUTF8(argv[idx]));
+#elif defined(MIKTEX_WINDOWS)
+            utf8args.push_back(StringUtil::AnsiToUTF8(argv[idx]));
+#else
+            utf8args.push_back(argv[idx]);
+#endif
+            newargv.push_back(const_cast<char*>(utf8args[idx].c_str()));
+        }
+        newargv.push_back(nullptr);
+        app.Init(newargv);
+        int exitCode = app.Run(newargv.size() - 1, const_cast<const char**>(&newargv[0]));
+        app.Finalize2(exitCode);
+        return exitCode;
+    }
+    catch (const MiKTeXException& ex)
+    {
+        app.Sorry(TheNameOfTheGame, ex);
+        app.Finalize2(EXIT_FAILURE);
+        ex.Save();
+        return EXIT_FAILURE;
+    }
+    catch (const exception& ex)
+    {
+        app.Sorry(TheNameOfTheGame, ex);
+        app.Finalize2(EXIT_FAILURE);
+        return EXIT_FAILURE;
+    }
+    catch (int exitCode)
+    {
+        app.Finalize2(exitCode);
+        return exitCode;
+    }
+}
@@ -0,0 +1,191 @@
+/**
+ * @file workloads.cpp
+ * @author Christian Schenk
+ * @brief Benchmark input files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Benchmark Utility.
+ *
+ * MiKTeX Benchmark Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <cctype>
+#include <cstdint>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+
+#include "workloads.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    /// A tiny linear congruential generator: good enough to vary the input,
+    /// and it yields the same sequence on every platform.
+    class Random
+    {
+    public:
+        unsigned Next(unsigned bound)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<unsigned>(state >> 33) % bound;
+        }
+    private:
+        uint64_t state = 0x4d694b54655842ULL;
+    };
+
+    const vector<string> words = {
+        "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta",
+        "iota", "kappa", "lambda", "mu", "nu", "xi", "omicron", "pi", "rho",
+        "sigma", "tau", "upsilon", "phi", "chi", "psi", "omega"
+    };
+
+    string Words(Random& random, int count)
+    {
+        string result;
+        for (int n = 0; n < count; ++n)
+        {
+            if (n > 0)
+            {
+                result += ' ';
+            }
+            result += words[random.Next(static_cast<unsigned>(words.size()))];
+        }
+        return result;
+    }
+}
+
+void Workloads::WriteCfg(const PathName& path, int numSections, int numKeys)
+{
+    Random random;
+    ofstream stream = File::CreateOutputStream(path);
+    for (int section = 0; section < numSections; ++section)
+    {
+        stream << fmt::format("[section{0}]\n", section);
+        for (int key = 0; key < numKeys; ++key)
+        {
+            stream << fmt::format("key{0}={1}\n", key, Words(random, 4));
+        }
+        stream << "list[]=" << Words(random, 1) << "\n";
+        stream << "list[]=" << Words(random, 1) << "\n";
+    }
+    stream.close();
+}
+
+void Workloads::CreateFileTree(const PathName& root, int numDirectories, int numFiles)
+{
+    for (int dir = 0; dir < numDirectories; ++dir)
+    {
+        PathName directory = root / fmt::format("d{0}", dir % 16) / fmt::format("d{0}", dir);
+        Directory::Create(directory);
+        for (int file = 0; file < numFiles; ++file)
+        {
+            ofstream stream = File::CreateOutputStream(directory / fmt::format("f{0}-{1}.tex", dir, file));
+            stream.close();
+        }
+    }
+}
+
+void Workloads::WriteLines(const PathName& path, int numLines)
+{
+    Random random;
+    ofstream stream = File::CreateOutputStream(path);
+    for (int line = 0; line < numLines; ++line)
+    {
+        stream << "% " << Words(random, 10) << "\n";
+    }
+    stream << "\\end\n";
+    stream.close();
+}
+
+void Workloads::WritePages(const PathName& path, int numPages)
+{
+    Random random;
+    ofstream stream = File::CreateOutputStream(path);
+    stream << "\\hsize=6.5in \\vsize=9in \\parindent=0pt\n";
+    for (int page = 0; page < numPages; ++page)
+    {
+        stream << fmt::format("{{\\bf Page {0}}}\\par\n", page + 1);
+        for (int par = 0; par < 8; ++par)
+        {
+            stream << Words(random, 60) << "\\par\n";
+        }
+        stream << "$$\\sum_{i=1}^n i = {n(n+1)\\over 2}$$\n";
+        stream << "\\vfill\\eject\n";
+    }
+    stream << "\\end\n";
+    stream.close();
+}
+
+void Workloads::WriteNovel(const PathName& path, int numChapters)
+{
+    Random random;
+    ofstream stream = File::CreateOutputStream(path);
+    stream << "\\font\\body=\"[lmroman10-regular.otf]\" at 11pt\n";
+    stream << "\\font\\heading=\"[lmroman10-bold.otf]\" at 14pt\n";
+    stream << "\\hsize=5in \\vsize=8in \\parindent=1.5em \\baselineskip=13.5pt\n";
+    stream << "\\body\n";
+    for (int chapter = 0; chapter < numChapters; ++chapter)
+    {
+        stream << fmt::format("{{\\heading Chapter {0}}}\\par\\bigskip\n", chapter + 1);
+        for (int par = 0; par < 30; ++par)
+        {
+            for (int sentence = 0; sentence < 6; ++sentence)
+            {
+                string text = Words(random, 8 + random.Next(12));
+                text[0] = static_cast<char>(toupper(text[0]));
+                stream << text << (random.Next(4) == 0 ? ", " + Words(random, 3) : "") << ". ";
+            }
+            stream << "\\par\n";
+        }
+        stream << "\\vfill\\eject\n";
+    }
+    stream << "\\end\n";
+    stream.close();
+}
+
+void Workloads::WriteBibliography(const PathName& directory, const string& name, int numEntries)
+{
+    Random random;
+    ofstream bib = File::CreateOutputStream(directory / (name + ".bib"));
+    for (int entry = 0; entry < numEntries; ++entry)
+    {
+        bib << fmt::format("@article{{key{0},\n", entry);
+        bib << fmt::format("  author = {{{0} {1} and {2} {3}}},\n", Words(random, 1), Words(random, 1), Words(random, 1), Words(random, 1));
+        bib << fmt::format("  title = {{{0}}},\n", Words(random, 8));
+        bib << fmt::format("  journal = {{{0}}},\n", Words(random, 3));
+        bib << fmt::format("  year = {0},\n", 1950 + random.Next(75));
+        bib << fmt::format("  volume = {0},\n", 1 + random.Next(50));
+        bib << fmt::format("  pages = {{{0}--{1}}}\n", 1 + random.Next(100), 101 + random.Next(100));
+        bib << "}\n\n";
+    }
+    bib.close();
+    ofstream aux = File::CreateOutputStream(directory / (name + ".aux"));
+    aux << "\\citation{*}\n";
+    aux << "\\bibstyle{plain}\n";
+    aux << "\\bibdata{" << name << "}\n";
+    aux.close();
+}
+
+void Workloads::WriteIndex(const PathName& path, int numEntries)
+{
+    Random random;
+    ofstream stream = File::CreateOutputStream(path);
+    for (int entry = 0; entry < numEntries; ++entry)
+    {
+        stream << fmt::format("\\indexentry{{{0}!{1}}}{{{2}}}\n", Words(random, 1), Words(random, 2), 1 + random.Next(1000));
+    }
+    stream.close();
+}
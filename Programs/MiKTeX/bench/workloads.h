@@ -0,0 +1,49 @@
+/**
+ * @file workloads.h
+ * @author Christian Schenk
+ * @brief Benchmark input files
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Benchmark Utility.
+ *
+ * MiKTeX Benchmark Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <miktex/Util/PathName>
+
+/// Generators for the benchmark input files.
+///
+/// All generators are deterministic: the same parameters always produce
+/// byte-identical files, so that results of different runs can be compared.
+namespace Workloads
+{
+    /// Writes an INI file with `numSections` sections of `numKeys` keys each.
+    void WriteCfg(const MiKTeX::Util::PathName& path, int numSections, int numKeys);
+
+    /// Creates a directory tree with `numDirectories` directories of
+    /// `numFiles` (empty) files each.
+    void CreateFileTree(const MiKTeX::Util::PathName& root, int numDirectories, int numFiles);
+
+    /// Writes a plain TeX file which consists of `numLines` comment lines.
+    void WriteLines(const MiKTeX::Util::PathName& path, int numLines);
+
+    /// Writes a plain TeX file which typesets `numPages` pages.
+    void WritePages(const MiKTeX::Util::PathName& path, int numPages);
+
+    /// Writes a XeTeX file which typesets a novel-style document: `numChapters`
+    /// chapters of running text in an OpenType font.
+    void WriteNovel(const MiKTeX::Util::PathName& path, int numChapters);
+
+    /// Writes `NAME.bib` with `numEntries` entries and an `NAME.aux` file
+    /// which cites all of them.
+    void WriteBibliography(const MiKTeX::Util::PathName& directory, const std::string& name, int numEntries);
+
+    /// Writes an index file with `numEntries` entries.
+    void WriteIndex(const MiKTeX::Util::PathName& path, int numEntries);
+}
@@ -15,13 +15,17 @@
 
 #include "makepk-version.h"
 
+#include <chrono>
+
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/LockFile>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Util/Tokenizer>
 
 #include "MakeUtility.h"
 
 using namespace std;
+using namespace std::chrono_literals;
 
 using namespace MiKTeX::App;
 using namespace MiKTeX::Core;
@@ -97,6 +101,9 @@ void MakePk::Usage()
 }
 
 namespace {
+    // METAFONT usually needs a few seconds
+    constexpr auto LOCK_TIMEOUT = 5min;
+
     const struct option aLongOptions[] =
     {
       COMMON_OPTIONS,
@@ -424,6 +431,39 @@ void MakePk::Run(int argc, const char** argv)
     // validate command-line arguments
     CheckOptions(&bdpi, dpi, mfMode);
 
+    // create destination directory
+    CreateDestinationDirectory();
+
+    // make PK file name
+    PathName pkName;
+    MakePKFilename(name.c_str(), bdpi, dpi, pkName);
+
+    // make fully qualified destination file name
+    PathName pathDest(destinationDirectory / pkName.ToString());
+
+    // concurrent requests for the same PK font wait for the first one;
+    // take the lock before any source (MF, TTF, HBF) is generated
+    unique_ptr<LockFile> lockFile;
+    if (!printOnly)
+    {
+        lockFile = LockFile::Create(PathName(pathDest).AppendExtension(".lck"));
+        if (!lockFile->TryLock(LOCK_TIMEOUT))
+        {
+            Verbose(fmt::format(T_("Could not lock {0}."), Q_(pathDest)));
+            lockFile = nullptr;
+        }
+    }
+
+    // quit, if destination file already exists
+    if (File::Exists(pathDest))
+    {
+        Message(fmt::format(T_("The PK font file {0} already exists."), Q_(pathDest)));
+        if (!overwriteExisting)
+        {
+            return;
+        }
+    }
+
     // create a temporary working directory
     unique_ptr<TemporaryDirectory> wrkDir = TemporaryDirectory::Create();
 
@@ -520,26 +560,6 @@ void MakePk::Run(int argc, const char** argv)
         FatalError(fmt::format(T_("PK font {0} could not be created."), Q_(name)));
     }
 
-    // create destination directory
-    CreateDestinationDirectory();
-
-    // make PK file name
-    PathName pkName;
-    MakePKFilename(name.c_str(), bdpi, dpi, pkName);
-
-    // make fully qualified destination file name
-    PathName pathDest(destinationDirectory / pkName.ToString());
-
-    // quit, if destination file already exists
-    if (File::Exists(pathDest))
-    {
-        Message(fmt::format(T_("The PK font file {0} already exists."), Q_(pathDest)));
-        if (!overwriteExisting)
-        {
-            return;
-        }
-    }
-
     Verbose(fmt::format(T_("Creating {0}..."), Q_(pkName)));
 
     // now make the font
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief fndb commands
  *
- * @copyright Copyright © 2021-2022 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -13,6 +13,8 @@
 
 #include <memory>
 
+#include <miktex/Util/PathName>
+
 #include "internal.h"
 
 #include "topics/Command.h"
@@ -21,4 +23,7 @@ namespace OneMiKTeXUtility::Topics::FNDB::Commands
 {
     std::unique_ptr<OneMiKTeXUtility::Topics::Command> Refresh();
     std::unique_ptr<OneMiKTeXUtility::Topics::Command> Remove();
+    std::unique_ptr<OneMiKTeXUtility::Topics::Command> Watch();
 }
+
+void RefreshFilenameDatabase(OneMiKTeXUtility::ApplicationContext& ctx, const MiKTeX::Util::PathName& root);
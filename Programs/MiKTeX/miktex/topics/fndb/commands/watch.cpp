@@ -0,0 +1,441 @@
+/**
+ * @file topics/fndb/commands/watch.cpp
+ * @author Christian Schenk
+ * @brief fndb watch
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/FileSystemWatcher>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/Core/Utils>
+#include <miktex/Util/PathName>
+#include <miktex/Wrappers/PoptWrapper>
+
+#include "internal.h"
+
+#include "commands.h"
+
+namespace
+{
+    class WatchCommand :
+        public OneMiKTeXUtility::Topics::Command
+    {
+        std::string Description() override
+        {
+            return T_("Keep the file name database up-to-date");
+        }
+
+        int MIKTEXTHISCALL Execute(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& arguments) override;
+
+        std::string Name() override
+        {
+            return "watch";
+        }
+
+        std::string Synopsis() override
+        {
+            return "watch [--latency <milliseconds>]";
+        }
+    };
+
+    /// Turns file system events into FNDB change file records.
+    ///
+    /// Events are collected on the notification thread. Bursts of events are
+    /// coalesced: a batch is written when no event has arrived for `latency`,
+    /// or when the oldest pending event is older than four times `latency`.
+    /// If events have been lost, the affected FNDBs are refreshed. Roots
+    /// containing directories which cannot be watched (e.g. because the
+    /// system limit of watches has been reached) are refreshed periodically.
+    class FndbMaintainer :
+        public MiKTeX::Core::FileSystemWatcherCallback
+    {
+    public:
+
+        FndbMaintainer(OneMiKTeXUtility::ApplicationContext& ctx, std::chrono::milliseconds latency) :
+            ctx(ctx),
+            latency(latency)
+        {
+        }
+
+        void AddRoot(const MiKTeX::Util::PathName& root);
+
+        void Run();
+
+    private:
+
+        void MIKTEXTHISCALL OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override;
+
+        void Flush(const std::set<MiKTeX::Util::PathName>& paths, bool overflow);
+
+        void RefreshUnwatched();
+
+        void WatchDirectoryTree(const MiKTeX::Util::PathName& dir, std::vector<MiKTeX::Util::PathName>& files);
+
+        bool TryGetRoot(const MiKTeX::Util::PathName& path, MiKTeX::Util::PathName& root) const;
+
+        OneMiKTeXUtility::ApplicationContext& ctx;
+        std::unique_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher = MiKTeX::Core::FileSystemWatcher::Create();
+        std::chrono::milliseconds latency;
+        std::vector<MiKTeX::Util::PathName> roots;
+        std::set<MiKTeX::Util::PathName> watchedDirectories;
+
+        // shared with the notification thread
+        std::mutex mutex;
+        std::set<MiKTeX::Util::PathName> pendingPaths;
+        bool overflow = false;
+        std::set<MiKTeX::Util::PathName> unwatchedDirectories;
+        std::chrono::steady_clock::time_point firstEventTime;
+        std::chrono::steady_clock::time_point lastEventTime;
+    };
+}
+
+using namespace std;
+using namespace std::chrono;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+using namespace OneMiKTeXUtility;
+using namespace OneMiKTeXUtility::Topics;
+using namespace OneMiKTeXUtility::Topics::FNDB;
+
+unique_ptr<Command> Commands::Watch()
+{
+    return make_unique<WatchCommand>();
+}
+
+void FndbMaintainer::OnChange(const FileSystemChangeEvent& ev)
+{
+    if (ev.action == FileSystemChangeAction::Modified)
+    {
+        // the FNDB does not care about file contents
+        return;
+    }
+    lock_guard<std::mutex> l(mutex);
+    if (ev.action == FileSystemChangeAction::Overflow && !ev.fileName.Empty())
+    {
+        unwatchedDirectories.insert(ev.fileName);
+        return;
+    }
+    auto now = steady_clock::now();
+    if (pendingPaths.empty() && !overflow)
+    {
+        firstEventTime = now;
+    }
+    lastEventTime = now;
+    if (ev.action == FileSystemChangeAction::Overflow)
+    {
+        overflow = true;
+    }
+    else
+    {
+        pendingPaths.insert(ev.fileName);
+    }
+}
+
+void FndbMaintainer::AddRoot(const PathName& root)
+{
+    ctx.ui->Verbose(1, fmt::format(T_("Watching root directory {0}..."), Q_(root.ToDisplayString())));
+    roots.push_back(root);
+    vector<PathName> files;
+    WatchDirectoryTree(root, files);
+}
+
+void FndbMaintainer::WatchDirectoryTree(const PathName& dir, vector<PathName>& files)
+{
+    vector<PathName> directories;
+    vector<PathName> todo{ dir };
+    while (!todo.empty())
+    {
+        PathName path = todo.back();
+        todo.pop_back();
+        // descend into watched directories too: new subdirectories may have
+        // been missed
+        if (watchedDirectories.insert(path).second)
+        {
+            directories.push_back(path);
+        }
+        unique_ptr<DirectoryLister> lister = DirectoryLister::Open(path);
+        DirectoryEntry entry;
+        while (lister->GetNext(entry))
+        {
+            if (entry.isDirectory)
+            {
+                todo.push_back(path / entry.name);
+            }
+            else
+            {
+                files.push_back(path / entry.name);
+            }
+        }
+        lister->Close();
+    }
+    if (!directories.empty())
+    {
+        fsWatcher->AddDirectories(directories);
+    }
+}
+
+bool FndbMaintainer::TryGetRoot(const PathName& path, PathName& root) const
+{
+    for (const PathName& r : roots)
+    {
+        if (Utils::IsParentDirectoryOf(r, path))
+        {
+            root = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+void FndbMaintainer::Flush(const set<PathName>& paths, bool overflow)
+{
+    set<PathName> rootsToBeRefreshed;
+    if (overflow)
+    {
+        ctx.ui->Verbose(1, T_("File system events have been lost."));
+        rootsToBeRefreshed.insert(roots.begin(), roots.end());
+    }
+    map<PathName, vector<Fndb::Record>> toBeAdded;
+    map<PathName, vector<PathName>> toBeRemoved;
+    for (const PathName& path : paths)
+    {
+        PathName root;
+        if (!TryGetRoot(path, root) || rootsToBeRefreshed.find(root) != rootsToBeRefreshed.end())
+        {
+            continue;
+        }
+        if (Directory::Exists(path))
+        {
+            // a new directory: watch it and add its files
+            vector<PathName> files;
+            WatchDirectoryTree(path, files);
+            for (const PathName& file : files)
+            {
+                if (!Fndb::FileExists(file))
+                {
+                    toBeAdded[root].push_back({ file, "" });
+                }
+            }
+        }
+        else if (File::Exists(path))
+        {
+            if (!Fndb::FileExists(path))
+            {
+                toBeAdded[root].push_back({ path, "" });
+            }
+        }
+        else if (watchedDirectories.find(path) != watchedDirectories.end())
+        {
+            // a removed directory: we don't know which files are gone
+            for (auto it = watchedDirectories.begin(); it != watchedDirectories.end();)
+            {
+                if (*it == path || Utils::IsParentDirectoryOf(path, *it))
+                {
+                    it = watchedDirectories.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            rootsToBeRefreshed.insert(root);
+        }
+        else if (Fndb::FileExists(path))
+        {
+            toBeRemoved[root].push_back(path);
+        }
+    }
+    for (const PathName& root : rootsToBeRefreshed)
+    {
+        RefreshFilenameDatabase(ctx, root);
+        // pick up directories created while events were lost
+        vector<PathName> files;
+        WatchDirectoryTree(root, files);
+    }
+    for (const auto& kv : toBeRemoved)
+    {
+        if (rootsToBeRefreshed.find(kv.first) == rootsToBeRefreshed.end())
+        {
+            ctx.ui->Verbose(1, fmt::format(T_("Removing {0} FNDB record(s) from {1}..."), kv.second.size(), Q_(kv.first.ToDisplayString())));
+            Fndb::Remove(kv.second);
+        }
+    }
+    for (const auto& kv : toBeAdded)
+    {
+        if (rootsToBeRefreshed.find(kv.first) == rootsToBeRefreshed.end())
+        {
+            ctx.ui->Verbose(1, fmt::format(T_("Adding {0} FNDB record(s) to {1}..."), kv.second.size(), Q_(kv.first.ToDisplayString())));
+            Fndb::Add(kv.second);
+        }
+    }
+}
+
+void FndbMaintainer::RefreshUnwatched()
+{
+    set<PathName> directories;
+    {
+        lock_guard<std::mutex> l(mutex);
+        swap(directories, unwatchedDirectories);
+    }
+    set<PathName> rootsToBeRefreshed;
+    for (const PathName& dir : directories)
+    {
+        // try again to watch it
+        watchedDirectories.erase(dir);
+        PathName root;
+        if (TryGetRoot(dir, root))
+        {
+            rootsToBeRefreshed.insert(root);
+        }
+    }
+    for (const PathName& root : rootsToBeRefreshed)
+    {
+        ctx.ui->Verbose(1, fmt::format(T_("Some directories in {0} cannot be watched."), Q_(root.ToDisplayString())));
+        RefreshFilenameDatabase(ctx, root);
+        vector<PathName> files;
+        WatchDirectoryTree(root, files);
+    }
+}
+
+void FndbMaintainer::Run()
+{
+    // how often roots with unwatched directories are refreshed
+    constexpr auto REFRESH_INTERVAL = 5min;
+    fsWatcher->Subscribe(this);
+    fsWatcher->Start();
+    auto lastRefreshTime = steady_clock::now();
+    while (!ctx.program->Canceled())
+    {
+        this_thread::sleep_for(min(latency, milliseconds(200)));
+        if (steady_clock::now() - lastRefreshTime >= REFRESH_INTERVAL)
+        {
+            RefreshUnwatched();
+            lastRefreshTime = steady_clock::now();
+        }
+        set<PathName> paths;
+        bool lostEvents;
+        {
+            lock_guard<std::mutex> l(mutex);
+            if (pendingPaths.empty() && !overflow)
+            {
+                continue;
+            }
+            auto now = steady_clock::now();
+            if (now - lastEventTime < latency && now - firstEventTime < 4 * latency)
+            {
+                continue;
+            }
+            swap(paths, pendingPaths);
+            lostEvents = overflow;
+            overflow = false;
+        }
+        Flush(paths, lostEvents);
+    }
+    fsWatcher->Stop();
+    fsWatcher->Unsubscribe(this);
+}
+
+enum Option
+{
+    OPT_AAA = 1,
+    OPT_LATENCY,
+};
+
+static const struct poptOption options[] =
+{
+    {
+        "latency", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_LATENCY,
+        T_("Wait until no more file system events arrive for the specified time (default: 500 milliseconds)."),
+        "MILLISECONDS"
+    },
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+int WatchCommand::Execute(ApplicationContext& ctx, const vector<string>& arguments)
+{
+    auto argv = MakeArgv(arguments);
+    PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
+    int option;
+    milliseconds latency = 500ms;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+        switch (option)
+        {
+        case OPT_LATENCY:
+        {
+            string arg = popt.GetOptArg();
+            size_t end = 0;
+            try
+            {
+                latency = milliseconds(std::stoi(arg, &end));
+            }
+            catch (const exception&)
+            {
+            }
+            if (end == 0 || end != arg.length())
+            {
+                ctx.ui->IncorrectUsage(fmt::format(T_("invalid latency: {0}"), arg));
+            }
+            break;
+        }
+        }
+    }
+    if (option != -1)
+    {
+        ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
+    }
+    if (!popt.GetLeftovers().empty())
+    {
+        ctx.ui->IncorrectUsage(T_("unexpected command arguments"));
+    }
+    if (latency <= 0ms)
+    {
+        ctx.ui->IncorrectUsage(T_("the latency must be positive"));
+    }
+    FndbMaintainer maintainer(ctx, latency);
+    unsigned nRoots = ctx.session->GetNumberOfTEXMFRoots();
+    for (unsigned r = 0; r < nRoots; ++r)
+    {
+        // same selection as in `fndb refresh`
+        bool selected = ctx.session->IsAdminMode()
+            ? ctx.session->IsCommonRootDirectory(r)
+            : !ctx.session->IsCommonRootDirectory(r) || ctx.session->IsMiKTeXPortable();
+        if (selected)
+        {
+            maintainer.AddRoot(ctx.session->GetRootDirectoryPath(r));
+        }
+    }
+    maintainer.Run();
+    return 0;
+}
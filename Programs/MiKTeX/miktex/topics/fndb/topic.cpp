@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief dnsb topic
  *
- * @copyright Copyright © 2021-2022 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -41,6 +41,7 @@ namespace
         {
             this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Refresh());
             this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Remove());
+            this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Watch());
         }
     };
 }
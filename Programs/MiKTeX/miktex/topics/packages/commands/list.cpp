@@ -51,7 +51,7 @@ namespace
 
         std::string Synopsis() override
         {
-            return "list [--template <template>]";
+            return "list [--search <text>] [--template <template>]";
         }
 
         const std::string defaultTemplate = "{id}";
@@ -86,11 +86,19 @@ unique_ptr<Command> Commands::List()
 enum Option
 {
     OPT_AAA = 1,
+    OPT_SEARCH,
     OPT_TEMPLATE,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "search", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_SEARCH,
+        T_("List only packages whose ID, title or description contains TEXT, or which contain a run-time file matching TEXT."),
+        "TEXT"
+    },
     {
         "template", 0,
         POPT_ARG_STRING, nullptr,
@@ -108,10 +116,16 @@ int ListCommand::Execute(ApplicationContext& ctx, const vector<string>& argument
     PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
     int option;
     string outputTemplate = this->defaultTemplate;
+    bool search = false;
+    string searchText;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
         {
+        case OPT_SEARCH:
+            search = true;
+            searchText = popt.GetOptArg();
+            break;
         case OPT_TEMPLATE:
             outputTemplate = Unescape(popt.GetOptArg());
             break;
@@ -125,20 +139,35 @@ int ListCommand::Execute(ApplicationContext& ctx, const vector<string>& argument
     {
         ctx.ui->IncorrectUsage(T_("unexpected command arguments"));
     }
-    auto packageIterator = ctx.packageManager->CreateIterator();
-    PackageInfo packageInfo;
     set<PackageInfo, PackageInfoComparer> setPi;
-    while (packageIterator->GetNext(packageInfo))
+    if (search)
     {
-        if (packageInfo.IsPureContainer())
+        for (const string& packageId : ctx.packageManager->SearchPackages(searchText, { PackageSearchField::Id, PackageSearchField::Title, PackageSearchField::Description, PackageSearchField::FileName }))
         {
-            continue;
+            PackageInfo packageInfo = ctx.packageManager->GetPackageInfo(packageId);
+            if (packageInfo.IsPureContainer())
+            {
+                continue;
+            }
+            setPi.insert(packageInfo);
         }
-        setPi.insert(packageInfo);
     }
-    if (setPi.empty())
+    else
     {
-        ctx.ui->FatalError(T_("The package database files have not been installed."));
+        auto packageIterator = ctx.packageManager->CreateIterator();
+        PackageInfo packageInfo;
+        while (packageIterator->GetNext(packageInfo))
+        {
+            if (packageInfo.IsPureContainer())
+            {
+                continue;
+            }
+            setPi.insert(packageInfo);
+        }
+        if (setPi.empty())
+        {
+            ctx.ui->FatalError(T_("The package database files have not been installed."));
+        }
     }
     for (set<PackageInfo, PackageInfoComparer>::const_iterator it = setPi.begin(); it != setPi.end(); ++it)
     {
@@ -13,6 +13,7 @@
 
 #include <config.h>
 
+#include <fstream>
 #include <memory>
 #include <set>
 #include <string>
@@ -21,6 +22,7 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/File>
 #include <miktex/Core/Session>
 #include <miktex/PackageManager/PackageManager>
 #include <miktex/Util/PathName>
@@ -51,10 +53,10 @@ namespace
 
         std::string Synopsis() override
         {
-            return "verify [--package-id-file=FILE] [<package-id>...]";
+            return "verify [--fast] [--package-id-file=FILE] [--report=FILE] [<package-id>...]";
         }
 
-        void Verify(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& toBeVerified);
+        void Verify(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& toBeVerified, MiKTeX::Packages::VerificationOptionSet options, const MiKTeX::Util::PathName& reportPath);
     };
 }
 
@@ -77,11 +79,20 @@ unique_ptr<Command> Commands::Verify()
 enum Option
 {
     OPT_AAA = 1,
+    OPT_FAST,
     OPT_PACKAGE_ID_FILE,
+    OPT_REPORT,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "fast", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_FAST,
+        T_("Only rehash files whose size or modification time changed since the last verification."),
+        nullptr
+    },
     {
         "package-id-file", 0,
         POPT_ARG_STRING, nullptr,
@@ -89,6 +100,13 @@ static const struct poptOption options[] =
         T_("Read package IDs from file."),
         "FILE"
     },
+    {
+        "report", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_REPORT,
+        T_("Write a tab-separated list of problems to FILE."),
+        "FILE"
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -100,13 +118,21 @@ int VerifyCommand::Execute(ApplicationContext& ctx, const vector<string>& argume
     int option;
     string repository;
     vector<string> toBeVerified;
+    VerificationOptionSet verificationOptions;
+    PathName reportPath;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
         {
+        case OPT_FAST:
+            verificationOptions += VerificationOption::UseFileTimes;
+            break;
         case OPT_PACKAGE_ID_FILE:
             ReadNames(PathName(popt.GetOptArg()), toBeVerified);
             break;
+        case OPT_REPORT:
+            reportPath = PathName(popt.GetOptArg());
+            break;
         }
     }
     if (option != -1)
@@ -115,11 +141,11 @@ int VerifyCommand::Execute(ApplicationContext& ctx, const vector<string>& argume
     }
     auto leftOvers = popt.GetLeftovers();
     toBeVerified.insert(toBeVerified.end(), leftOvers.begin(), leftOvers.end());
-    Verify(ctx, toBeVerified);
+    Verify(ctx, toBeVerified, verificationOptions, reportPath);
     return 0;
 }
 
-void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVerifiedArg)
+void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVerifiedArg, VerificationOptionSet options, const PathName& reportPath)
 {
     vector<string> toBeVerified = toBeVerifiedArg;
     bool verifyAll = toBeVerified.empty();
@@ -136,13 +162,41 @@ void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVe
         }
     }
     bool ok = true;
-    for (const string& packageID : toBeVerified)
+    vector<PackageVerificationResult> results = ctx.packageManager->VerifyInstalledPackages(toBeVerified, options);
+    ofstream report;
+    if (!reportPath.Empty())
+    {
+        report = File::CreateOutputStream(reportPath);
+    }
+    for (const PackageVerificationResult& result : results)
     {
-        if (!ctx.packageManager->TryVerifyInstalledPackage(packageID))
+        if (result.ok)
         {
-            ctx.ui->Verbose(0, fmt::format(T_("{0}: this package needs to be reinstalled."), packageID));
-            ok = false;
+            continue;
         }
+        ctx.ui->Verbose(0, fmt::format(T_("{0}: this package needs to be reinstalled."), result.packageId));
+        ok = false;
+        if (!report.is_open())
+        {
+            continue;
+        }
+        // PACKAGE TAB PROBLEM TAB FILE
+        for (const string& fileName : result.missingFiles)
+        {
+            report << result.packageId << "\tmissing\t" << fileName << "\n";
+        }
+        for (const string& fileName : result.modifiedFiles)
+        {
+            report << result.packageId << "\tmodified\t" << fileName << "\n";
+        }
+        if (result.missingFiles.empty() && result.modifiedFiles.empty())
+        {
+            report << result.packageId << "\tdigest-mismatch\t\n";
+        }
+    }
+    if (report.is_open())
+    {
+        report.close();
     }
     if (ok)
     {
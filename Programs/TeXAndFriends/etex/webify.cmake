@@ -1,6 +1,6 @@
 ## webify.cmake: create final eTeX web file
 ##
-## Copyright (C) 2021 Christian Schenk
+## Copyright (C) 2021-2024 Christian Schenk
 ## 
 ## This file is free software; you can redistribute it and/or modify
 ## it under the terms of the GNU General Public License as published
@@ -26,6 +26,7 @@ set(miktex_tex_change_files
     ${MIKTEX_TEX_POOL_CH}
     ${MIKTEX_TEX_QUIET_CH}
     ${MIKTEX_TEX_SRC_CH}
+    ${MIKTEX_TEX_PROFILE_CH}
     ${MIKTEX_TEX_STAT_CH}
     ${MIKTEX_TEX_WRITE18_CH}
     ${TRACINGSTACKLEVELS_CH}
@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX LuaTeX helpers
  *
- * @copyright Copyright © 2016-2023 Christian Schenk
+ * @copyright Copyright © 2016-2024 Christian Schenk
  *
  * This file is free software; the copyright holder gives unlimited permission
  * to copy and/or distribute it, with or without modifications, as long as this
@@ -36,6 +36,9 @@ int miktex_is_fully_qualified_path(const char* path);
 int miktex_hack__is_luaotfload_file(const char* path);
 int miktex_is_output_file(const char* path);
 int miktex_is_pipe(FILE* file);
+void* miktex_lua_bytecode_cache_get(const char* sourcePath, const char* vmId, size_t* sizeRet);
+int miktex_lua_bytecode_cache_is_enabled();
+void miktex_lua_bytecode_cache_put(const char* sourcePath, const char* vmId, const void* bytecode, size_t size);
 int miktex_open_format_file(const char* fileName, FILE** ppFile, int renew);
 FILE* miktex_open_output_file(const char* fileName);
 void miktex_print_banner(FILE* file, const char* name, const char* version);
@@ -10,16 +10,24 @@
  * notice is preserved.
  */
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
 #include <string>
+#include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/App/Application>
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/CacheFile>
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Directory>
+#include <miktex/Core/File>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
 #include <miktex/KPSE/Emulation>
@@ -418,3 +426,116 @@ int miktex_hack__is_luaotfload_file(const char* path)
     }
     return 0;
 }
+
+int miktex_lua_bytecode_cache_is_enabled()
+{
+    static int enabled = -1;
+    if (enabled < 0)
+    {
+        shared_ptr<Session> session = Application::GetApplication()->GetSession();
+        enabled = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_LUA_BYTECODE_CACHE, ConfigValue(false)).GetBool() ? 1 : 0;
+    }
+    return enabled;
+}
+
+// a cache entry consists of the header, the source path and the byte code
+struct LuaBytecodeCacheHeader
+{
+    char signature[8];
+    uint32_t version;
+    uint32_t pathSize;
+    uint64_t sourceSize;
+    int64_t sourceLastWriteTime;
+    uint64_t bytecodeSize;
+};
+
+constexpr char LUA_BYTECODE_CACHE_SIGNATURE[8] = { 'M', 'i', 'K', 'T', 'e', 'X', 'L', 'B' };
+
+constexpr uint32_t LUA_BYTECODE_CACHE_VERSION = 1;
+
+// the VM identifier is part of the key: different Lua versions can share
+// one cache directory
+static PathName GetLuaBytecodeCacheFile(const PathName& sourcePath, const char* vmId)
+{
+    MD5Builder md5Builder;
+    md5Builder.Update(vmId, strlen(vmId) + 1);
+    md5Builder.Update(sourcePath.GetData(), sourcePath.GetLength());
+    shared_ptr<Session> session = Application::GetApplication()->GetSession();
+    return session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_LUA_BYTECODE_CACHE_DIR) / (md5Builder.Final().ToString() + ".luc");
+}
+
+void* miktex_lua_bytecode_cache_get(const char* sourcePathArg, const char* vmId, size_t* sizeRet)
+{
+    MIKTEX_ASSERT_STRING(sourcePathArg);
+    MIKTEX_ASSERT_STRING(vmId);
+    try
+    {
+        PathName sourcePath = PathName(sourcePathArg).Clean();
+        PathName cacheFile = GetLuaBytecodeCacheFile(sourcePath, vmId);
+        if (!File::Exists(cacheFile))
+        {
+            return nullptr;
+        }
+        vector<unsigned char> bytes = File::ReadAllBytes(cacheFile);
+        LuaBytecodeCacheHeader header;
+        if (bytes.size() < sizeof(header))
+        {
+            return nullptr;
+        }
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (memcmp(header.signature, LUA_BYTECODE_CACHE_SIGNATURE, sizeof(header.signature)) != 0
+            || header.version != LUA_BYTECODE_CACHE_VERSION
+            || bytes.size() != sizeof(header) + header.pathSize + header.bytecodeSize
+            || header.bytecodeSize == 0
+            || string(reinterpret_cast<const char*>(bytes.data()) + sizeof(header), header.pathSize) != sourcePath.ToString()
+            || !CacheFile::IsUnchanged(sourcePath, header.sourceSize, header.sourceLastWriteTime))
+        {
+            return nullptr;
+        }
+        void* bytecode = malloc(header.bytecodeSize);
+        if (bytecode == nullptr)
+        {
+            return nullptr;
+        }
+        memcpy(bytecode, bytes.data() + sizeof(header) + header.pathSize, header.bytecodeSize);
+        *sizeRet = header.bytecodeSize;
+        return bytecode;
+    }
+    catch (const exception&)
+    {
+        // the source will be compiled
+        return nullptr;
+    }
+}
+
+void miktex_lua_bytecode_cache_put(const char* sourcePathArg, const char* vmId, const void* bytecode, size_t size)
+{
+    MIKTEX_ASSERT_STRING(sourcePathArg);
+    MIKTEX_ASSERT_STRING(vmId);
+    try
+    {
+        PathName sourcePath = PathName(sourcePathArg).Clean();
+        string path = sourcePath.ToString();
+        LuaBytecodeCacheHeader header{};
+        memcpy(header.signature, LUA_BYTECODE_CACHE_SIGNATURE, sizeof(header.signature));
+        header.version = LUA_BYTECODE_CACHE_VERSION;
+        header.pathSize = static_cast<uint32_t>(path.length());
+        header.sourceSize = File::GetSize(sourcePath);
+        header.sourceLastWriteTime = File::GetLastWriteTime(sourcePath);
+        if (!CacheFile::IsSettled(header.sourceLastWriteTime))
+        {
+            return;
+        }
+        header.bytecodeSize = size;
+        vector<unsigned char> bytes;
+        bytes.reserve(sizeof(header) + path.length() + size);
+        bytes.insert(bytes.end(), reinterpret_cast<const unsigned char*>(&header), reinterpret_cast<const unsigned char*>(&header) + sizeof(header));
+        bytes.insert(bytes.end(), path.begin(), path.end());
+        bytes.insert(bytes.end(), reinterpret_cast<const unsigned char*>(bytecode), reinterpret_cast<const unsigned char*>(bytecode) + size);
+        CacheFile::Write(GetLuaBytecodeCacheFile(sourcePath, vmId), bytes);
+    }
+    catch (const exception&)
+    {
+        // the cache is an optimization only
+    }
+}
@@ -850,6 +850,87 @@ static const char *luatex_kpse_find_aux(lua_State *L, const char *name,
 
 static int lua_loader_function = 0;
 
+#if defined(MIKTEX)
+/*tex
+
+    Modules found by kpathsea can be loaded from a byte code cache. The cache
+    entries are written by |lua_dump| and are valid for one virtual machine
+    only.
+
+*/
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} miktex_bytecode_buffer;
+
+static int miktex_bytecode_writer(lua_State * L, const void *p, size_t sz, void *ud)
+{
+    miktex_bytecode_buffer *b = (miktex_bytecode_buffer *) ud;
+    (void) L;
+    if (b->size + sz > b->capacity) {
+        b->capacity = (b->size + sz) * 2;
+        b->data = (char *) xrealloc(b->data, b->capacity);
+    }
+    memcpy(b->data + b->size, p, sz);
+    b->size += sz;
+    return 0;
+}
+
+static const char *miktex_lua_vm_id(void)
+{
+    static char vm_id[128] = "";
+    if (vm_id[0] == 0) {
+#ifdef LuajitTeX
+        snprintf(vm_id, sizeof(vm_id), "%s-%d", LUAJIT_VERSION, (int) sizeof(void *));
+#else
+        snprintf(vm_id, sizeof(vm_id), "%s-%d-%d-%d", LUA_RELEASE, (int) sizeof(void *), (int) sizeof(lua_Integer), (int) sizeof(lua_Number));
+#endif
+    }
+    return vm_id;
+}
+
+static int miktex_luaL_loadfile_cached(lua_State * L, const char *filename)
+{
+    int status;
+    size_t size = 0;
+    char *bytecode;
+    char *chunkname;
+    miktex_bytecode_buffer b = { NULL, 0, 0 };
+    if (!miktex_lua_bytecode_cache_is_enabled()) {
+        return luaL_loadfile(L, filename);
+    }
+    bytecode = (char *) miktex_lua_bytecode_cache_get(filename, miktex_lua_vm_id(), &size);
+    if (bytecode != NULL) {
+        /*tex the same chunk name as |luaL_loadfile| */
+        chunkname = (char *) xmalloc(strlen(filename) + 2);
+        chunkname[0] = '@';
+        strcpy(chunkname + 1, filename);
+        status = luaL_loadbufferx(L, bytecode, size, chunkname, "b");
+        free(chunkname);
+        free(bytecode);
+        if (status == LUA_OK) {
+            return status;
+        }
+        /*tex not loadable by this virtual machine: compile the source */
+        lua_pop(L, 1);
+    }
+    status = luaL_loadfile(L, filename);
+    if (status == LUA_OK) {
+#ifdef LuajitTeX
+        if (lua_dump(L, miktex_bytecode_writer, &b) == 0) {
+#else
+        if (lua_dump(L, miktex_bytecode_writer, &b, 0) == 0) {
+#endif
+            miktex_lua_bytecode_cache_put(filename, miktex_lua_vm_id(), b.data, b.size);
+        }
+        free(b.data);
+    }
+    return status;
+}
+#endif
+
 static int luatex_kpse_lua_find(lua_State * L)
 {
     const char *filename;
@@ -867,7 +948,11 @@ static int luatex_kpse_lua_find(lua_State * L)
         return 1;
     }
     recorder_record_input(filename);
+#if defined(MIKTEX)
+    if (miktex_luaL_loadfile_cached(L, filename) != 0) {
+#else
     if (luaL_loadfile(L, filename) != 0) {
+#endif
         luaL_error(L, "error loading module %s from file %s:\n\t%s",
             lua_tostring(L, 1), filename, lua_tostring(L, -1));
     }
@@ -1,6 +1,6 @@
 ## webify.cmake
 ##
-## Copyright (C) 2021-2022 Christian Schenk
+## Copyright (C) 2021-2024 Christian Schenk
 ## 
 ## This file is free software; the copyright holder gives
 ## unlimited permission to copy and/or distribute it, with or
@@ -30,6 +30,7 @@ set(miktex_tex_change_files
     ${MIKTEX_TEX_POOL_CH}
     ${MIKTEX_TEX_QUIET_CH}
     ${MIKTEX_TEX_SRC_CH}
+    ${MIKTEX_TEX_PROFILE_CH}
     ${miktex_synctex_changefiles}
     ${MIKTEX_TEX_STAT_CH}
     ${MIKTEX_TEX_WRITE18_CH}
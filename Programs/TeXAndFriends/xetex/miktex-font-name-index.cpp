@@ -0,0 +1,497 @@
+/**
+ * @file miktex-font-name-index.cpp
+ * @author Christian Schenk
+ * @brief Persistent font name index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ */
+
+#include "miktex-first.h"
+
+#include <cstring>
+
+#include <unordered_map>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/Process>
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+#include "miktex-font-name-index.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+constexpr char SIGNATURE[8] = { 'M', 'i', 'K', 'T', 'e', 'X', 'F', 'N' };
+
+// increment whenever the layout changes
+constexpr uint32_t VERSION = 1;
+
+// separates the names of a name list
+constexpr char NAME_SEPARATOR = '\x1f';
+
+struct FontNameIndex::Header
+{
+    char signature[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint64_t fingerprint;
+    uint32_t numRecords;
+    uint32_t recordsOffset;
+    uint32_t stringsSize;
+    uint32_t stringsOffset;
+};
+
+struct FontNameIndex::Record
+{
+    // sort key: file name, face index
+    uint32_t file;
+    int32_t faceIndex;
+    uint64_t size;
+    int64_t lastWriteTime;
+    // string pool offsets; name lists are separated by NAME_SEPARATOR
+    uint32_t psName;
+    uint32_t familyNames;
+    uint32_t styleNames;
+    uint32_t fullNames;
+    double designSize;
+    double minSize;
+    double maxSize;
+    uint32_t subFamilyID;
+    uint32_t nameCode;
+    uint16_t weight;
+    uint16_t width;
+    int16_t slant;
+    uint8_t flags;
+    uint8_t reserved;
+};
+
+enum RecordFlags : uint8_t
+{
+    HaveStyle = 1,
+    IsReg = 2,
+    IsBold = 4,
+    IsItalic = 8
+};
+
+namespace
+{
+    string Join(const vector<string>& names)
+    {
+        string result;
+        for (const string& name : names)
+        {
+            if (!result.empty())
+            {
+                result += NAME_SEPARATOR;
+            }
+            result += name;
+        }
+        return result;
+    }
+
+    vector<string> Split(const char* names)
+    {
+        vector<string> result;
+        if (*names == 0)
+        {
+            return result;
+        }
+        const char* start = names;
+        for (const char* p = names; ; ++p)
+        {
+            if (*p == NAME_SEPARATOR || *p == 0)
+            {
+                result.push_back(string(start, p - start));
+                if (*p == 0)
+                {
+                    break;
+                }
+                start = p + 1;
+            }
+        }
+        return result;
+    }
+
+    bool TryGetFileInfo(const string& file, uint64_t& size, int64_t& lastWriteTime)
+    {
+        try
+        {
+            PathName path(file);
+            if (!File::Exists(path))
+            {
+                return false;
+            }
+            size = File::GetSize(path);
+            lastWriteTime = static_cast<int64_t>(File::GetLastWriteTime(path));
+            return true;
+        }
+        catch (const MiKTeXException&)
+        {
+            return false;
+        }
+    }
+
+    class StringPool
+    {
+    public:
+        uint32_t Add(const string& s)
+        {
+            if (s.empty())
+            {
+                return 0;
+            }
+            auto it = index.find(s);
+            if (it != index.end())
+            {
+                return it->second;
+            }
+            uint32_t offset = static_cast<uint32_t>(data.size());
+            data.insert(data.end(), s.begin(), s.end());
+            data.push_back(0);
+            index.emplace(s, offset);
+            return offset;
+        }
+        // offset 0 is the empty string
+        vector<char> data = { 0 };
+    private:
+        unordered_map<string, uint32_t> index;
+    };
+
+    template<typename T> uint32_t Append(vector<unsigned char>& buf, const T* data, size_t count)
+    {
+        // keep all sections 8-byte aligned
+        buf.resize((buf.size() + 7) & ~static_cast<size_t>(7));
+        uint32_t offset = static_cast<uint32_t>(buf.size());
+        if (count > 0)
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+            buf.insert(buf.end(), bytes, bytes + count * sizeof(T));
+        }
+        return offset;
+    }
+}
+
+FontNameIndex::~FontNameIndex()
+{
+    try
+    {
+        Close();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+void FontNameIndex::Open(const PathName& path, uint64_t fingerprint)
+{
+    Close();
+    this->path = path;
+    this->fingerprint = fingerprint;
+    pendingRecords.clear();
+    modified = false;
+    try
+    {
+        if (!File::Exists(path) || File::GetSize(path) < sizeof(Header))
+        {
+            return;
+        }
+        mmap.reset(MemoryMappedFile::Create());
+        const Header* hdr = reinterpret_cast<const Header*>(mmap->Open(path, false));
+        if (memcmp(hdr->signature, SIGNATURE, sizeof(hdr->signature)) != 0
+            || hdr->version != VERSION
+            || hdr->headerSize != sizeof(Header)
+            || hdr->fileSize != mmap->GetSize())
+        {
+            Close();
+            return;
+        }
+        header = hdr;
+    }
+    catch (const MiKTeXException&)
+    {
+        // not fatal: the index will be recreated
+        Close();
+    }
+}
+
+void FontNameIndex::Close()
+{
+    header = nullptr;
+    if (mmap != nullptr)
+    {
+        mmap->Close();
+        mmap = nullptr;
+    }
+}
+
+const char* FontNameIndex::GetString(uint32_t offset) const
+{
+    MIKTEX_ASSERT(offset < header->stringsSize);
+    return reinterpret_cast<const char*>(header) + header->stringsOffset + offset;
+}
+
+const FontNameIndex::Record* FontNameIndex::Find(const string& file, int faceIndex) const
+{
+    if (header == nullptr)
+    {
+        return nullptr;
+    }
+    const Record* records = reinterpret_cast<const Record*>(reinterpret_cast<const char*>(header) + header->recordsOffset);
+    const Record* begin = records;
+    const Record* end = records + header->numRecords;
+    // binary search; records are sorted by (file, faceIndex)
+    while (begin < end)
+    {
+        const Record* mid = begin + (end - begin) / 2;
+        int cmp = strcmp(GetString(mid->file), file.c_str());
+        if (cmp == 0)
+        {
+            cmp = mid->faceIndex < faceIndex ? -1 : mid->faceIndex > faceIndex ? 1 : 0;
+        }
+        if (cmp == 0)
+        {
+            return mid;
+        }
+        else if (cmp < 0)
+        {
+            begin = mid + 1;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+    return nullptr;
+}
+
+FontNameIndex::Entry FontNameIndex::MakeEntry(const Record& record) const
+{
+    Entry entry;
+    entry.psName = GetString(record.psName);
+    entry.familyNames = Split(GetString(record.familyNames));
+    entry.styleNames = Split(GetString(record.styleNames));
+    entry.fullNames = Split(GetString(record.fullNames));
+    entry.haveStyle = (record.flags & HaveStyle) != 0;
+    entry.designSize = record.designSize;
+    entry.minSize = record.minSize;
+    entry.maxSize = record.maxSize;
+    entry.subFamilyID = record.subFamilyID;
+    entry.nameCode = record.nameCode;
+    entry.weight = record.weight;
+    entry.width = record.width;
+    entry.slant = record.slant;
+    entry.isReg = (record.flags & IsReg) != 0;
+    entry.isBold = (record.flags & IsBold) != 0;
+    entry.isItalic = (record.flags & IsItalic) != 0;
+    return entry;
+}
+
+bool FontNameIndex::TryGet(const string& file, int faceIndex, Entry& entry)
+{
+    auto it = pendingRecords.find(Key(file, faceIndex));
+    if (it != pendingRecords.end())
+    {
+        if (!it->second.haveNames)
+        {
+            return false;
+        }
+        entry = it->second.entry;
+        return true;
+    }
+    const Record* record = Find(file, faceIndex);
+    uint64_t size;
+    int64_t lastWriteTime;
+    if (record == nullptr || !TryGetFileInfo(file, size, lastWriteTime) || record->size != size || record->lastWriteTime != lastWriteTime)
+    {
+        return false;
+    }
+    entry = MakeEntry(*record);
+    return true;
+}
+
+FontNameIndex::PendingRecord& FontNameIndex::GetPendingRecord(const string& file, int faceIndex)
+{
+    Key key(file, faceIndex);
+    auto it = pendingRecords.find(key);
+    if (it != pendingRecords.end())
+    {
+        return it->second;
+    }
+    PendingRecord& pending = pendingRecords[key];
+    if (!TryGetFileInfo(file, pending.size, pending.lastWriteTime))
+    {
+        // will not be saved
+        return pending;
+    }
+    const Record* record = Find(file, faceIndex);
+    if (record != nullptr && record->size == pending.size && record->lastWriteTime == pending.lastWriteTime)
+    {
+        pending.entry = MakeEntry(*record);
+        pending.haveNames = true;
+    }
+    return pending;
+}
+
+void FontNameIndex::PutNames(const string& file, int faceIndex, const Entry& entry)
+{
+    PendingRecord& pending = GetPendingRecord(file, faceIndex);
+    pending.entry.psName = entry.psName;
+    pending.entry.familyNames = entry.familyNames;
+    pending.entry.styleNames = entry.styleNames;
+    pending.entry.fullNames = entry.fullNames;
+    pending.haveNames = true;
+    modified = true;
+}
+
+void FontNameIndex::PutStyle(const string& file, int faceIndex, const Entry& entry)
+{
+    PendingRecord& pending = GetPendingRecord(file, faceIndex);
+    if (!pending.haveNames)
+    {
+        // style properties are always looked at after the names
+        return;
+    }
+    Entry& e = pending.entry;
+    e.haveStyle = true;
+    e.designSize = entry.designSize;
+    e.minSize = entry.minSize;
+    e.maxSize = entry.maxSize;
+    e.subFamilyID = entry.subFamilyID;
+    e.nameCode = entry.nameCode;
+    e.weight = entry.weight;
+    e.width = entry.width;
+    e.slant = entry.slant;
+    e.isReg = entry.isReg;
+    e.isBold = entry.isBold;
+    e.isItalic = entry.isItalic;
+    modified = true;
+}
+
+void FontNameIndex::Save()
+{
+    bool fontsChanged = header != nullptr && header->fingerprint != fingerprint;
+    if (path.Empty() || !modified && !fontsChanged)
+    {
+        return;
+    }
+
+    // merge the records of the index file with the new records
+    map<Key, PendingRecord> records;
+    if (header != nullptr)
+    {
+        const Record* oldRecords = reinterpret_cast<const Record*>(reinterpret_cast<const char*>(header) + header->recordsOffset);
+        for (uint32_t idx = 0; idx < header->numRecords; ++idx)
+        {
+            const Record& rec = oldRecords[idx];
+            Key key(GetString(rec.file), rec.faceIndex);
+            if (pendingRecords.find(key) != pendingRecords.end())
+            {
+                continue;
+            }
+            PendingRecord pending;
+            if (fontsChanged)
+            {
+                // drop records of removed fonts
+                if (!TryGetFileInfo(key.first, pending.size, pending.lastWriteTime) || pending.size != rec.size || pending.lastWriteTime != rec.lastWriteTime)
+                {
+                    continue;
+                }
+            }
+            pending.size = rec.size;
+            pending.lastWriteTime = rec.lastWriteTime;
+            pending.entry = MakeEntry(rec);
+            pending.haveNames = true;
+            records.emplace(key, std::move(pending));
+        }
+    }
+    for (const auto& p : pendingRecords)
+    {
+        if (p.second.haveNames)
+        {
+            records.emplace(p.first, p.second);
+        }
+    }
+
+    StringPool strings;
+    vector<Record> recordTable;
+    recordTable.reserve(records.size());
+    for (const auto& p : records)
+    {
+        const Entry& e = p.second.entry;
+        Record rec{};
+        rec.file = strings.Add(p.first.first);
+        rec.faceIndex = p.first.second;
+        rec.size = p.second.size;
+        rec.lastWriteTime = p.second.lastWriteTime;
+        rec.psName = strings.Add(e.psName);
+        rec.familyNames = strings.Add(Join(e.familyNames));
+        rec.styleNames = strings.Add(Join(e.styleNames));
+        rec.fullNames = strings.Add(Join(e.fullNames));
+        rec.designSize = e.designSize;
+        rec.minSize = e.minSize;
+        rec.maxSize = e.maxSize;
+        rec.subFamilyID = e.subFamilyID;
+        rec.nameCode = e.nameCode;
+        rec.weight = e.weight;
+        rec.width = e.width;
+        rec.slant = e.slant;
+        rec.flags = (e.haveStyle ? HaveStyle : 0) | (e.isReg ? IsReg : 0) | (e.isBold ? IsBold : 0) | (e.isItalic ? IsItalic : 0);
+        recordTable.push_back(rec);
+    }
+
+    Header hdr{};
+    memcpy(hdr.signature, SIGNATURE, sizeof(hdr.signature));
+    hdr.version = VERSION;
+    hdr.headerSize = sizeof(Header);
+    hdr.fingerprint = fingerprint;
+    vector<unsigned char> buf;
+    Append(buf, &hdr, 1);
+    hdr.numRecords = static_cast<uint32_t>(recordTable.size());
+    hdr.recordsOffset = Append(buf, recordTable.data(), recordTable.size());
+    hdr.stringsSize = static_cast<uint32_t>(strings.data.size());
+    hdr.stringsOffset = Append(buf, strings.data.data(), strings.data.size());
+    hdr.fileSize = buf.size();
+    memcpy(buf.data(), &hdr, sizeof(hdr));
+
+    // the file will be replaced
+    Close();
+
+    try
+    {
+        Directory::Create(path.GetDirectoryName());
+        PathName tempPath = path;
+        tempPath.AppendExtension("." + std::to_string(Process::GetCurrentProcess()->GetSystemId()) + ".tmp");
+        File::WriteBytes(tempPath, buf);
+        try
+        {
+            File::Move(tempPath, path, { FileMoveOption::ReplaceExisting });
+        }
+        catch (const MiKTeXException&)
+        {
+            File::Delete(tempPath);
+            throw;
+        }
+    }
+    catch (const MiKTeXException& e)
+    {
+        // for example: the data directory is read-only
+        unique_ptr<TraceStream> trace_fontinfo = TraceStream::Open(MIKTEX_TRACE_FONTINFO);
+        trace_fontinfo->WriteLine("xetex", TraceLevel::Warning, "font name index " + path.ToString() + " cannot be written: " + e.GetErrorMessage());
+        trace_fontinfo->Close();
+    }
+    pendingRecords.clear();
+    modified = false;
+}
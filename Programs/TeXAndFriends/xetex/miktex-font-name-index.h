@@ -0,0 +1,123 @@
+/**
+ * @file miktex-font-name-index.h
+ * @author Christian Schenk
+ * @brief Persistent font name index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Util/PathName>
+
+/// The names and style properties of fonts, as found in the name, OS/2, head,
+/// post and GPOS tables.
+///
+/// Reading these tables means opening the font file. The index remembers the
+/// results across runs: it is a memory-mapped file in the MiKTeX data
+/// directory. A record is used only if size and modification time of the
+/// font file are unchanged. New records are added as fonts are looked at, and
+/// the file is rewritten on `Save()`.
+class FontNameIndex
+{
+public:
+
+    struct Entry
+    {
+        std::string psName;
+        std::vector<std::string> familyNames;
+        std::vector<std::string> styleNames;
+        std::vector<std::string> fullNames;
+        // the following members are valid if `haveStyle` is `true`
+        bool haveStyle = false;
+        double designSize = 10.0;
+        double minSize = 0.0;
+        double maxSize = 0.0;
+        unsigned subFamilyID = 0;
+        unsigned nameCode = 0;
+        uint16_t weight = 0;
+        uint16_t width = 0;
+        int16_t slant = 0;
+        bool isReg = false;
+        bool isBold = false;
+        bool isItalic = false;
+    };
+
+    FontNameIndex() = default;
+
+    FontNameIndex(const FontNameIndex& other) = delete;
+
+    FontNameIndex& operator=(const FontNameIndex& other) = delete;
+
+    ~FontNameIndex();
+
+    /// Maps the index file into memory.
+    /// @param path Path to the index file.
+    /// @param fingerprint Identifies the list of available fonts; if it
+    /// differs, records of removed fonts will be dropped on `Save()`.
+    void Open(const MiKTeX::Util::PathName& path, uint64_t fingerprint);
+
+    /// Looks up the record of a font.
+    /// @param file The font file.
+    /// @param faceIndex The face index.
+    /// @param[out] entry The record.
+    /// @return Returns `false`, if there is no valid record.
+    bool TryGet(const std::string& file, int faceIndex, Entry& entry);
+
+    /// Stores the names of a font.
+    void PutNames(const std::string& file, int faceIndex, const Entry& entry);
+
+    /// Stores the style properties of a font.
+    void PutStyle(const std::string& file, int faceIndex, const Entry& entry);
+
+    /// Rewrites the index file, if records have been added.
+    void Save();
+
+public:
+
+    struct Header;
+    struct Record;
+
+private:
+
+    typedef std::pair<std::string, int> Key;
+
+    struct PendingRecord
+    {
+        Entry entry;
+        uint64_t size = 0;
+        int64_t lastWriteTime = 0;
+        bool haveNames = false;
+    };
+
+    void Close();
+
+    const Record* Find(const std::string& file, int faceIndex) const;
+
+    Entry MakeEntry(const Record& record) const;
+
+    const char* GetString(uint32_t offset) const;
+
+    PendingRecord& GetPendingRecord(const std::string& file, int faceIndex);
+
+    MiKTeX::Util::PathName path;
+    uint64_t fingerprint = 0;
+    bool modified = false;
+    std::map<Key, PendingRecord> pendingRecords;
+    const Header* header = nullptr;
+    std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mmap;
+};
@@ -47,6 +47,11 @@ authorization from the copyright holders.
 
 #include <unicode/ucnv.h>
 
+#if defined(MIKTEX)
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#endif
+
 #define kFontFamilyName 1
 #define kFontStyleName  2
 #define kFontFullName   4
@@ -83,8 +88,96 @@ convertToUtf8(UConverter* conv, const unsigned char* name, int len)
     return buffer2;
 }
 
+#if defined(MIKTEX)
+static bool
+getFontFile(FcPattern* pat, std::string& file, int& index)
+{
+    char* pathname;
+    if (FcPatternGetString(pat, FC_FILE, 0, (FcChar8**)&pathname) != FcResultMatch)
+        return false;
+    if (FcPatternGetInteger(pat, FC_INDEX, 0, &index) != FcResultMatch)
+        return false;
+    file = pathname;
+    return true;
+}
+
+// reading the names means opening the font file: look into the font name
+// index first
+XeTeXFontMgr::NameCollection*
+XeTeXFontMgr_FC::readNames(FcPattern* pat)
+{
+    std::string file;
+    int index;
+    if (!getFontFile(pat, file, index))
+        return readNamesFromFontFile(pat);
+
+    FontNameIndex::Entry entry;
+    if (fontNameIndex.TryGet(file, index, entry)) {
+        NameCollection* names = new NameCollection;
+        names->m_psName = entry.psName;
+        names->m_familyNames.assign(entry.familyNames.begin(), entry.familyNames.end());
+        names->m_styleNames.assign(entry.styleNames.begin(), entry.styleNames.end());
+        names->m_fullNames.assign(entry.fullNames.begin(), entry.fullNames.end());
+        return names;
+    }
+
+    NameCollection* names = readNamesFromFontFile(pat);
+    entry.psName = names->m_psName;
+    entry.familyNames.assign(names->m_familyNames.begin(), names->m_familyNames.end());
+    entry.styleNames.assign(names->m_styleNames.begin(), names->m_styleNames.end());
+    entry.fullNames.assign(names->m_fullNames.begin(), names->m_fullNames.end());
+    fontNameIndex.PutNames(file, index, entry);
+    return names;
+}
+
+void
+XeTeXFontMgr_FC::getOpSizeRecAndStyleFlags(Font* theFont)
+{
+    std::string file;
+    int index;
+    if (!getFontFile(theFont->fontRef, file, index)) {
+        getOpSizeRecAndStyleFlagsFromFontFile(theFont);
+        return;
+    }
+
+    FontNameIndex::Entry entry;
+    if (fontNameIndex.TryGet(file, index, entry) && entry.haveStyle) {
+        theFont->opSizeInfo.designSize = entry.designSize;
+        theFont->opSizeInfo.minSize = entry.minSize;
+        theFont->opSizeInfo.maxSize = entry.maxSize;
+        theFont->opSizeInfo.subFamilyID = entry.subFamilyID;
+        theFont->opSizeInfo.nameCode = entry.nameCode;
+        theFont->weight = entry.weight;
+        theFont->width = entry.width;
+        theFont->slant = entry.slant;
+        theFont->isReg = entry.isReg;
+        theFont->isBold = entry.isBold;
+        theFont->isItalic = entry.isItalic;
+        return;
+    }
+
+    getOpSizeRecAndStyleFlagsFromFontFile(theFont);
+    entry.designSize = theFont->opSizeInfo.designSize;
+    entry.minSize = theFont->opSizeInfo.minSize;
+    entry.maxSize = theFont->opSizeInfo.maxSize;
+    entry.subFamilyID = theFont->opSizeInfo.subFamilyID;
+    entry.nameCode = theFont->opSizeInfo.nameCode;
+    entry.weight = theFont->weight;
+    entry.width = theFont->width;
+    entry.slant = theFont->slant;
+    entry.isReg = theFont->isReg;
+    entry.isBold = theFont->isBold;
+    entry.isItalic = theFont->isItalic;
+    fontNameIndex.PutStyle(file, index, entry);
+}
+#endif
+
 XeTeXFontMgr::NameCollection*
+#if defined(MIKTEX)
+XeTeXFontMgr_FC::readNamesFromFontFile(FcPattern* pat)
+#else
 XeTeXFontMgr_FC::readNames(FcPattern* pat)
+#endif
 {
     NameCollection* names = new NameCollection;
 
@@ -190,7 +283,11 @@ XeTeXFontMgr_FC::readNames(FcPattern* pat)
 }
 
 void
+#if defined(MIKTEX)
+XeTeXFontMgr_FC::getOpSizeRecAndStyleFlagsFromFontFile(Font* theFont)
+#else
 XeTeXFontMgr_FC::getOpSizeRecAndStyleFlags(Font* theFont)
+#endif
 {
     XeTeXFontMgr::getOpSizeRecAndStyleFlags(theFont);
 
@@ -338,11 +435,34 @@ XeTeXFontMgr_FC::initialize()
     FcPatternDestroy(pat);
 
     cachedAll = false;
+
+#if defined(MIKTEX)
+    // the fingerprint of the font list (FNV-1a)
+    uint64_t fingerprint = 0xcbf29ce484222325ULL;
+    for (int f = 0; f < allFonts->nfont; ++f) {
+        std::string file;
+        int index;
+        if (!getFontFile(allFonts->fonts[f], file, index))
+            continue;
+        file += '\0';
+        file += std::to_string(index);
+        for (unsigned char ch : file) {
+            fingerprint ^= ch;
+            fingerprint *= 0x100000001b3ULL;
+        }
+    }
+    MiKTeX::Util::PathName indexFile = MIKTEX_SESSION()->GetSpecialPath(MiKTeX::Core::SpecialPath::DataRoot)
+        / MiKTeX::Util::PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / "xetex-font-names.idx";
+    fontNameIndex.Open(indexFile, fingerprint);
+#endif
 }
 
 void
 XeTeXFontMgr_FC::terminate()
 {
+#if defined(MIKTEX)
+    fontNameIndex.Save();
+#endif
     if (macRomanConv != NULL)
         ucnv_close(macRomanConv);
     if (utf16beConv != NULL)
@@ -35,6 +35,10 @@ authorization from the copyright holders.
 
 #include "XeTeXFontMgr.h"
 
+#if defined(MIKTEX)
+#include "miktex-font-name-index.h"
+#endif
+
 class XeTeXFontMgr_FC
     : public XeTeXFontMgr
 {
@@ -58,6 +62,13 @@ protected:
 
     void                            cacheFamilyMembers(const std::list<std::string>& familyNames);
 
+#if defined(MIKTEX)
+    NameCollection*                 readNamesFromFontFile(FcPattern* pat);
+    void                            getOpSizeRecAndStyleFlagsFromFontFile(Font* theFont);
+
+    FontNameIndex                   fontNameIndex;
+#endif
+
     FcFontSet*  allFonts;
     bool        cachedAll;
 };
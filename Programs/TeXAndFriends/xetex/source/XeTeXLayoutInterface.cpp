@@ -58,6 +58,19 @@ authorization from the copyright holders.
 #endif
 #include "XeTeXFontMgr.h"
 
+#if defined(MIKTEX)
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+struct ShapedRun;
+#endif
+
 struct XeTeXLayoutEngine_rec
 {
     XeTeXFontInst*  font;
@@ -73,6 +86,9 @@ struct XeTeXLayoutEngine_rec
     float           slant;
     float           embolden;
     hb_buffer_t*    hbBuffer;
+#if defined(MIKTEX)
+    std::shared_ptr<const ShapedRun> run; // the result of the last layoutChars() call
+#endif
 };
 
 /*******************************************************************/
@@ -104,9 +120,119 @@ cacheGlyphBBox(uint16_t fontID, uint16_t glyphID, const GlyphBBox* bbox)
 }
 /*******************************************************************/
 
+#if defined(MIKTEX)
+/*******************************************************************/
+/* Shaped-run cache: running text repeats the same words in the    */
+/* same font; each of them is shaped only once                     */
+/*******************************************************************/
+struct ShapedRun
+{
+    hb_script_t script;
+    const char* shaper;
+    std::vector<hb_codepoint_t> glyphs;
+    std::vector<hb_glyph_position_t> positions;
+};
+
+struct ShapedRunKey
+{
+    // the engine determines font instance, features, script, language and
+    // shapers
+    XeTeXLayoutEngine engine;
+    hb_direction_t direction;
+    int32_t offset;
+    int32_t count;
+    // the complete text: HarfBuzz looks at the context of the run
+    std::u16string text;
+    bool operator==(const ShapedRunKey& other) const
+    {
+        return engine == other.engine && direction == other.direction && offset == other.offset && count == other.count && text == other.text;
+    }
+};
+
+struct ShapedRunKeyHash
+{
+    size_t operator()(const ShapedRunKey& key) const
+    {
+        size_t h = std::hash<std::u16string>()(key.text);
+        h ^= std::hash<const void*>()(key.engine) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= std::hash<int32_t>()((key.offset << 16) ^ key.count ^ ((int32_t)key.direction << 28)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+class ShapedRunCache
+{
+public:
+    // words and short phrases repeat; long runs (complete paragraphs) do not
+    static constexpr int32_t MAX_TEXT_LENGTH = 256;
+    static constexpr size_t MAX_ENTRIES = 16384;
+
+    std::shared_ptr<const ShapedRun> Lookup(const ShapedRunKey& key)
+    {
+        lookups++;
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return nullptr;
+        }
+        hits++;
+        // most recently used entries come first
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    void Insert(ShapedRunKey&& key, std::shared_ptr<const ShapedRun> run)
+    {
+        if (entries.size() >= MAX_ENTRIES) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, run);
+        index.emplace(std::move(key), entries.begin());
+    }
+
+    void Purge(XeTeXLayoutEngine engine)
+    {
+        for (auto it = entries.begin(); it != entries.end(); ) {
+            if (it->first.engine == engine) {
+                index.erase(it->first);
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void TraceStatistics()
+    {
+        if (lookups == 0) {
+            return;
+        }
+        char msg[200];
+        snprintf(msg, sizeof(msg), "shaped-run cache: %lu lookups, %lu hits (%.1f%%), %lu entries",
+            lookups, hits, 100.0 * hits / lookups, (unsigned long)entries.size());
+        std::unique_ptr<MiKTeX::Trace::TraceStream> trace_shaping = MiKTeX::Trace::TraceStream::Open(MIKTEX_TRACE_SHAPING);
+        trace_shaping->WriteLine("xetex", msg);
+        trace_shaping->Close();
+    }
+
+private:
+    typedef std::list<std::pair<ShapedRunKey, std::shared_ptr<const ShapedRun>>> EntryList;
+    EntryList entries;
+    std::unordered_map<ShapedRunKey, EntryList::iterator, ShapedRunKeyHash> index;
+    unsigned long lookups = 0;
+    unsigned long hits = 0;
+};
+
+static ShapedRunCache sShapedRuns;
+/*******************************************************************/
+#endif
+
 void
 terminatefontmanager()
 {
+#if defined(MIKTEX)
+    sShapedRuns.TraceStatistics();
+#endif
     XeTeXFontMgr::Terminate();
 }
 
@@ -662,6 +788,10 @@ createLayoutEngine(PlatformFontRef fontRef, XeTeXFont font, hb_tag_t script, cha
 void
 deleteLayoutEngine(XeTeXLayoutEngine engine)
 {
+#if defined(MIKTEX)
+    sShapedRuns.Purge(engine);
+    engine->run = nullptr;
+#endif
     hb_buffer_destroy(engine->hbBuffer);
     delete engine->font;
     free(engine->shaper);
@@ -705,6 +835,29 @@ layoutChars(XeTeXLayoutEngine engine, uint16_t chars[], int32_t offset, int32_t
 
     script = hb_ot_tag_to_script (engine->script);
 
+#if defined(MIKTEX)
+    ShapedRunKey key;
+    bool cacheable = max <= ShapedRunCache::MAX_TEXT_LENGTH;
+    if (cacheable) {
+        key.engine = engine;
+        key.direction = direction;
+        key.offset = offset;
+        key.count = count;
+        key.text.assign((const char16_t*)chars, max);
+        engine->run = sShapedRuns.Lookup(key);
+        if (engine->run != nullptr) {
+            // getDefaultDirection() looks at the buffer's script
+            hb_buffer_reset(engine->hbBuffer);
+            hb_buffer_set_script(engine->hbBuffer, engine->run->script);
+            if (engine->shaper == NULL || strcmp(engine->shaper, engine->run->shaper) != 0) {
+                free(engine->shaper);
+                engine->shaper = strdup(engine->run->shaper);
+            }
+            return (int)engine->run->glyphs.size();
+        }
+    }
+#endif
+
     hb_buffer_reset(engine->hbBuffer);
 
 #if !HB_VERSION_ATLEAST(2,5,0)
@@ -755,10 +908,29 @@ layoutChars(XeTeXLayoutEngine engine, uint16_t chars[], int32_t offset, int32_t
         }
     }
 
+#if defined(MIKTEX)
+    const char* shaper = hb_shape_plan_get_shaper(shape_plan);
+#endif
+
     hb_shape_plan_destroy(shape_plan);
 
     int glyphCount = hb_buffer_get_length(engine->hbBuffer);
 
+#if defined(MIKTEX)
+    std::shared_ptr<ShapedRun> run = std::make_shared<ShapedRun>();
+    run->script = hb_buffer_get_script(engine->hbBuffer);
+    run->shaper = shaper;
+    hb_glyph_info_t* hbGlyphs = hb_buffer_get_glyph_infos(engine->hbBuffer, NULL);
+    hb_glyph_position_t* hbPositions = hb_buffer_get_glyph_positions(engine->hbBuffer, NULL);
+    run->glyphs.reserve(glyphCount);
+    for (int i = 0; i < glyphCount; i++)
+        run->glyphs.push_back(hbGlyphs[i].codepoint);
+    run->positions.assign(hbPositions, hbPositions + glyphCount);
+    engine->run = run;
+    if (cacheable)
+        sShapedRuns.Insert(std::move(key), run);
+#endif
+
 #ifdef DEBUG
     char buf[1024];
     unsigned int consumed;
@@ -779,18 +951,31 @@ layoutChars(XeTeXLayoutEngine engine, uint16_t chars[], int32_t offset, int32_t
 void
 getGlyphs(XeTeXLayoutEngine engine, uint32_t glyphs[])
 {
+#if defined(MIKTEX)
+    int glyphCount = (int)engine->run->glyphs.size();
+    const hb_codepoint_t *hbGlyphs = engine->run->glyphs.data();
+
+    for (int i = 0; i < glyphCount; i++)
+        glyphs[i] = hbGlyphs[i];
+#else
     int glyphCount = hb_buffer_get_length(engine->hbBuffer);
     hb_glyph_info_t *hbGlyphs = hb_buffer_get_glyph_infos(engine->hbBuffer, NULL);
 
     for (int i = 0; i < glyphCount; i++)
         glyphs[i] = hbGlyphs[i].codepoint;
+#endif
 }
 
 void
 getGlyphAdvances(XeTeXLayoutEngine engine, float advances[])
 {
+#if defined(MIKTEX)
+    int glyphCount = (int)engine->run->positions.size();
+    const hb_glyph_position_t *hbPositions = engine->run->positions.data();
+#else
     int glyphCount = hb_buffer_get_length(engine->hbBuffer);
     hb_glyph_position_t *hbPositions = hb_buffer_get_glyph_positions(engine->hbBuffer, NULL);
+#endif
 
     for (int i = 0; i < glyphCount; i++) {
         if (engine->font->getLayoutDirVertical())
@@ -803,8 +988,13 @@ getGlyphAdvances(XeTeXLayoutEngine engine, float advances[])
 void
 getGlyphPositions(XeTeXLayoutEngine engine, FloatPoint positions[])
 {
+#if defined(MIKTEX)
+    int glyphCount = (int)engine->run->positions.size();
+    const hb_glyph_position_t *hbPositions = engine->run->positions.data();
+#else
     int glyphCount = hb_buffer_get_length(engine->hbBuffer);
     hb_glyph_position_t *hbPositions = hb_buffer_get_glyph_positions(engine->hbBuffer, NULL);
+#endif
 
     float x = 0, y = 0;
 
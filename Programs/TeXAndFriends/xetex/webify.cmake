@@ -1,6 +1,6 @@
 ## webify.cmake: create final XeTeX web file
 ##
-## Copyright (C) 2021 Christian Schenk
+## Copyright (C) 2021-2024 Christian Schenk
 ## 
 ## This file is free software; you can redistribute it and/or modify
 ## it under the terms of the GNU General Public License as published
@@ -34,6 +34,7 @@ set(miktex_tex_change_files
     ${MIKTEX_TEX_HYPH_CH}
     ${MIKTEX_TEX_QUIET_CH}
     ${MIKTEX_TEX_SRC_CH}
+    ${MIKTEX_TEX_PROFILE_CH}
     ${TEX_MIKTEX_SYNCTEX_CH}
     ${MIKTEX_TEX_STAT_CH}
     ${MIKTEX_TEX_WRITE18_CH}
@@ -0,0 +1,413 @@
+/**
+ * @file miktex/chktex.cpp
+ * @author Christian Schenk
+ * @brief MiKTeX ChkTeX extensions
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Core/Utils>
+#include <miktex/Util/PathName>
+
+#include "chktex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    /// Finds all registered literals in a single pass (Aho-Corasick). All
+    /// literals must be added before the first scan.
+    class LiteralMatcher
+    {
+    public:
+
+        void Add(const string& literal, int id)
+        {
+            if (nodes.empty())
+            {
+                nodes.emplace_back();
+            }
+            int state = 0;
+            for (unsigned char ch : literal)
+            {
+                if (nodes[state].next[ch] <= 0)
+                {
+                    nodes[state].next[ch] = static_cast<int>(nodes.size());
+                    nodes.emplace_back();
+                }
+                state = nodes[state].next[ch];
+            }
+            nodes[state].ids.push_back(id);
+        }
+
+        void Build()
+        {
+            if (nodes.empty())
+            {
+                nodes.emplace_back();
+            }
+            // breadth-first: the failure state is shallower than the state
+            deque<int> todo;
+            for (int& next : nodes[0].next)
+            {
+                if (next > 0)
+                {
+                    nodes[next].fail = 0;
+                    todo.push_back(next);
+                }
+                else
+                {
+                    next = 0;
+                }
+            }
+            while (!todo.empty())
+            {
+                int state = todo.front();
+                todo.pop_front();
+                const Node& fail = nodes[nodes[state].fail];
+                nodes[state].ids.insert(nodes[state].ids.end(), fail.ids.begin(), fail.ids.end());
+                for (size_t ch = 0; ch < nodes[state].next.size(); ++ch)
+                {
+                    int next = nodes[state].next[ch];
+                    if (next > 0)
+                    {
+                        nodes[next].fail = nodes[nodes[state].fail].next[ch];
+                        todo.push_back(next);
+                    }
+                    else
+                    {
+                        nodes[state].next[ch] = nodes[nodes[state].fail].next[ch];
+                    }
+                }
+            }
+            built = true;
+        }
+
+        void Scan(const char* text, vector<char>& found)
+        {
+            if (!built)
+            {
+                Build();
+            }
+            int state = 0;
+            for (const unsigned char* p = reinterpret_cast<const unsigned char*>(text); *p != 0; ++p)
+            {
+                state = nodes[state].next[*p];
+                for (int id : nodes[state].ids)
+                {
+                    found[id] = 1;
+                }
+            }
+        }
+
+    private:
+
+        struct Node
+        {
+            Node()
+            {
+                next.fill(-1);
+            }
+            array<int, 256> next;
+            int fail = 0;
+            vector<int> ids;
+        };
+
+        vector<Node> nodes;
+        bool built = false;
+    };
+
+    /// Gets the index of the `]` which closes a bracket expression.
+    size_t FindEndOfBracketExpression(const string& pattern, size_t idx)
+    {
+        ++idx;
+        if (idx < pattern.length() && pattern[idx] == '^')
+        {
+            ++idx;
+        }
+        if (idx < pattern.length() && pattern[idx] == ']')
+        {
+            ++idx;
+        }
+        for (; idx < pattern.length() && pattern[idx] != ']'; ++idx)
+        {
+            if (pattern[idx] == '[' && idx + 1 < pattern.length() && (pattern[idx + 1] == ':' || pattern[idx + 1] == '.' || pattern[idx + 1] == '='))
+            {
+                size_t end = pattern.find(string(1, pattern[idx + 1]) + "]", idx + 2);
+                if (end == string::npos)
+                {
+                    return end;
+                }
+                idx = end + 1;
+            }
+        }
+        return idx < pattern.length() ? idx : string::npos;
+    }
+
+    /// Gets the longest string which every match of an extended regular
+    /// expression contains. Returns an empty string, if no such string can be
+    /// found.
+    string GetRequiredLiteral(const string& pattern)
+    {
+        string longest;
+        string run;
+        auto endRun = [&]()
+        {
+            if (run.length() > longest.length())
+            {
+                longest = run;
+            }
+            run.clear();
+        };
+        for (size_t idx = 0; idx < pattern.length(); ++idx)
+        {
+            char ch = pattern[idx];
+            switch (ch)
+            {
+            case '|':
+                // alternatives: give up
+                return "";
+            case '(':
+            {
+                if (idx + 1 < pattern.length() && pattern[idx + 1] == '?')
+                {
+                    // PCRE options and assertions
+                    return "";
+                }
+                endRun();
+                int depth = 1;
+                for (++idx; idx < pattern.length() && depth > 0; ++idx)
+                {
+                    if (pattern[idx] == '\\')
+                    {
+                        ++idx;
+                    }
+                    else if (pattern[idx] == '[')
+                    {
+                        idx = FindEndOfBracketExpression(pattern, idx);
+                        if (idx == string::npos)
+                        {
+                            return "";
+                        }
+                    }
+                    else if (pattern[idx] == '(')
+                    {
+                        ++depth;
+                    }
+                    else if (pattern[idx] == ')')
+                    {
+                        --depth;
+                    }
+                }
+                --idx;
+                break;
+            }
+            case '[':
+                endRun();
+                idx = FindEndOfBracketExpression(pattern, idx);
+                if (idx == string::npos)
+                {
+                    return "";
+                }
+                break;
+            case '*':
+            case '?':
+            case '{':
+                // the preceding atom is optional
+                if (!run.empty())
+                {
+                    run.pop_back();
+                }
+                endRun();
+                if (ch == '{')
+                {
+                    idx = pattern.find('}', idx);
+                    if (idx == string::npos)
+                    {
+                        return "";
+                    }
+                }
+                break;
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+                endRun();
+                break;
+            case '\\':
+                if (idx + 1 == pattern.length())
+                {
+                    return "";
+                }
+                ++idx;
+                if (strchr("\\.*+?()[]{}|^$", pattern[idx]) != nullptr)
+                {
+                    // an escaped metacharacter
+                    run += pattern[idx];
+                }
+                else
+                {
+                    // classes, anchors (e.g. \< and \`), back references
+                    endRun();
+                }
+                break;
+            default:
+                run += ch;
+                break;
+            }
+        }
+        endRun();
+        return longest;
+    }
+
+    LiteralMatcher matcher;
+    vector<int> alwaysCandidates;
+    vector<char> candidates;
+    vector<string> patterns;
+    map<const char*, const char*> omittedArguments;
+}
+
+void miktex_add_user_regex(int id, const char* pattern)
+{
+    string literal = GetRequiredLiteral(pattern);
+    if (literal.empty())
+    {
+        alwaysCandidates.push_back(id);
+    }
+    else
+    {
+        matcher.Add(literal, id);
+    }
+    if (static_cast<size_t>(id) >= candidates.size())
+    {
+        candidates.resize(id + 1);
+        patterns.resize(id + 1);
+    }
+    patterns[id] = pattern;
+}
+
+const char* miktex_scan_user_regexes(const char* line)
+{
+    fill(candidates.begin(), candidates.end(), 0);
+    for (int id : alwaysCandidates)
+    {
+        candidates[id] = 1;
+    }
+    matcher.Scan(line, candidates);
+    return candidates.data();
+}
+
+int miktex_verify_user_regexes()
+{
+    static int verify = -1;
+    if (verify < 0)
+    {
+        string value;
+        verify = Utils::GetEnvironmentString("MIKTEX_CHKTEX_VERIFY_PREFILTER", value) && !value.empty() && value != "0" ? 1 : 0;
+    }
+    return verify;
+}
+
+void miktex_report_prefilter_miss(int id, const char* line)
+{
+    fprintf(stderr, "chktex: the prefilter rejected a line which matches `%s': %s\n", patterns[id].c_str(), line);
+}
+
+void miktex_omit_argument(const char* arg, const char* replacement)
+{
+    omittedArguments[arg] = replacement;
+}
+
+int miktex_check_files_concurrently(int argc, char** argv, int firstFile, long maxJobs, const char* outputFormat, FILE* outputFile)
+{
+    try
+    {
+        PathName me = MIKTEX_SESSION()->GetMyProgramFile(true);
+        vector<string> options{ me.ToString(), "-q" };
+        for (int idx = 1; idx < firstFile; ++idx)
+        {
+            auto it = omittedArguments.find(argv[idx]);
+            if (it == omittedArguments.end())
+            {
+                if (string(argv[idx]) != "--")
+                {
+                    options.push_back(argv[idx]);
+                }
+            }
+            else if (it->second != nullptr)
+            {
+                options.push_back(it->second);
+            }
+        }
+        options.push_back("-f");
+        options.push_back(outputFormat);
+        options.push_back("--");
+        vector<ProcessJob> jobs(argc - firstFile);
+        vector<string> outputs(jobs.size());
+        vector<string> errors(jobs.size());
+        for (size_t idx = 0; idx < jobs.size(); ++idx)
+        {
+            jobs[idx].FileName = me;
+            jobs[idx].Arguments = options;
+            jobs[idx].Arguments.push_back(argv[firstFile + idx]);
+            jobs[idx].OnOutput = [&outputs, idx](const void* output, size_t n)
+            {
+                outputs[idx].append(reinterpret_cast<const char*>(output), n);
+                return true;
+            };
+            // keep warnings and errors out of the -o file
+            jobs[idx].OnError = [&errors, idx](const void* output, size_t n)
+            {
+                errors[idx].append(reinterpret_cast<const char*>(output), n);
+                return true;
+            };
+        }
+        Process::RunAll(jobs, maxJobs > 0 ? static_cast<unsigned>(maxJobs) : thread::hardware_concurrency());
+        int exitCode = 0;
+        for (size_t idx = 0; idx < jobs.size(); ++idx)
+        {
+            fputs(outputs[idx].c_str(), outputFile);
+            if (!errors[idx].empty())
+            {
+                // stay in order when both go to the terminal
+                fflush(outputFile);
+                fputs(errors[idx].c_str(), stderr);
+            }
+            if (jobs[idx].ExitCode != 0)
+            {
+                exitCode = jobs[idx].ExitCode;
+            }
+        }
+        fflush(outputFile);
+        fflush(stderr);
+        return exitCode;
+    }
+    catch (const MiKTeXException& e)
+    {
+        fprintf(stderr, "%s\n", e.GetErrorMessage().c_str());
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,62 @@
+/**
+ * @file miktex/chktex.h
+ * @author Christian Schenk
+ * @brief MiKTeX ChkTeX extensions
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/// Registers a compiled user warning regex.
+/// @param id The index of the regex in `RegexArray`.
+/// @param pattern The extended regular expression.
+void miktex_add_user_regex(int id, const char* pattern);
+
+/// Scans a line once for the literals required by the registered regexes.
+/// @param line The line to be checked.
+/// @return Returns flags (indexed by regex id): zero, if the regex cannot
+/// match.
+const char* miktex_scan_user_regexes(const char* line);
+
+/// Tests whether the regexes rejected by the prefilter shall be executed
+/// anyway (environment variable `MIKTEX_CHKTEX_VERIFY_PREFILTER`).
+/// @return Returns non-zero, if the prefilter is to be verified.
+int miktex_verify_user_regexes();
+
+/// Reports a regex which matches a line rejected by the prefilter.
+/// @param id The index of the regex in `RegexArray`.
+/// @param line The line.
+void miktex_report_prefilter_miss(int id, const char* line);
+
+/// Excludes a command-line argument from the command-lines of child
+/// processes.
+/// @param arg The argument (an element of `argv`).
+/// @param replacement The replacement or `NULL`, if the argument shall be
+/// dropped.
+void miktex_omit_argument(const char* arg, const char* replacement);
+
+/// Checks files concurrently in child processes.
+/// @param argc The number of command-line arguments.
+/// @param argv The command-line arguments.
+/// @param firstFile The index of the first file name in `argv`.
+/// @param maxJobs The maximum number of files checked at the same time (0
+/// means: number of processors).
+/// @param outputFormat The output format to be used by child processes.
+/// @param outputFile Receives the reports in command-line order.
+/// @return Returns the exit code of the last failed check, or 0.
+int miktex_check_files_concurrently(int argc, char** argv, int firstFile, long maxJobs, const char* outputFormat, FILE* outputFile);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -38,6 +38,9 @@
 #include "FindErrs.h"
 #include "Resource.h"
 #include <string.h>
+#if defined(MIKTEX)
+#include <miktex/chktex.h>
+#endif
 
 #undef MSG
 #define MSG(num, type, inuse, ctxt, text) {(enum ErrNum)num, type, inuse, ctxt, text},
@@ -179,6 +182,10 @@ static const char *HelpText =
     "Miscellaneous switches:\n"
     "~~~~~~~~~~~~~~~~~~~~~~~\n"
     "    -W  --version   : Version information\n"
+#if defined(MIKTEX)
+    "    -j  --jobs      : Check files concurrently. Default: number of\n"
+    "                      processors.\n"
+#endif
     "\n"
     "----------------------------------------------------------------------\n"
     "If no LaTeX files are specified on the command line, we will read from\n"
@@ -219,11 +226,18 @@ char *PrgName;
 
 int StdInTTY, StdOutTTY;
 
+#if defined(MIKTEX)
+static long Jobs = 1;
+#endif
+
 /*
  * End of config params.
  */
 
 static int ParseArgs(int argc, char **argv);
+#if defined(MIKTEX)
+static void OmitOption(char **argv, int c, char *arg);
+#endif
 static void ShowIntStatus(void);
 static int OpenOut(void);
 static int ShiftArg(char **Argument);
@@ -486,6 +500,17 @@ int main(int argc, char **argv)
 
             if (OpenOut())
             {
+#if defined(MIKTEX)
+                if (Jobs != 1 && !UsingStdIn && argc - CurArg > 1)
+                {
+                    ret = miktex_check_files_concurrently(argc, argv, CurArg, Jobs,
+                                                          OutputFormat, OutputFile);
+                    if ( ret != EXIT_SUCCESS ) {
+                        retval = ret;
+                    }
+                }
+                else
+#endif
                 for (;;)
                 {
                     for (Count = 0; Count < NUMBRACKETS; Count++)
@@ -855,6 +880,9 @@ static int ParseArgs(int argc, char **argv)
         {"tictoc", optional_argument, 0L, 't'},
         {"headererr", optional_argument, 0L, 'H'},
         {"version", no_argument, 0L, 'W'},
+#if defined(MIKTEX)
+        {"jobs", optional_argument, 0L, 'j'},
+#endif
 
         {0L, 0L, 0L, 0L}
     };
@@ -878,7 +906,11 @@ static int ParseArgs(int argc, char **argv)
 
     while (!ArgErr &&
            ((c = getopt_long((int) argc, argv,
+#if defined(MIKTEX)
+                             "b::d:e:f:g::hH::I::ij::l:m:n:Lo:p:qrs:S:t::v::V::w:Wx::",
+#else
                              "b::d:e:f:g::hH::I::il:m:n:Lo:p:qrs:S:t::v::V::w:Wx::",
+#endif
                              long_options, &option_index)) != EOF))
     {
         while (c)
@@ -1007,6 +1039,9 @@ static int ParseArgs(int argc, char **argv)
                 }
                 break;
             case 'V':
+#if defined(MIKTEX)
+                OmitOption(argv, c, optarg);
+#endif
                 nextc = ParseNumArg(&PipeVerb, 1, &optarg);
 
                 if (PipeVerb < (long) OutFormat.Stack.Used)
@@ -1019,6 +1054,9 @@ static int ParseArgs(int argc, char **argv)
                 break;
 
             case 'o':
+#if defined(MIKTEX)
+                OmitOption(argv, c, optarg);
+#endif
                 if (optarg)
                 {
                     if (*OutputName)
@@ -1056,6 +1094,12 @@ static int ParseArgs(int argc, char **argv)
             case 'W':
                 printf("%s", Banner);
                 exit(EXIT_SUCCESS);
+#if defined(MIKTEX)
+            case 'j':
+                OmitOption(argv, c, optarg);
+                nextc = ParseNumArg(&Jobs, 0, &optarg);
+                break;
+#endif
             case '?':
             default:
                 fputs(Banner, stderr);
@@ -1089,6 +1133,36 @@ static int ParseArgs(int argc, char **argv)
     return (Retval);
 }
 
+#if defined(MIKTEX)
+/*
+ * Child processes must neither write the output file nor start child
+ * processes themselves: removes the option from their command-lines.
+ */
+
+static void OmitOption(char **argv, int c, char *arg)
+{
+    char *Elem = argv[optind - 1];
+    char *Prefix;
+
+    if (arg && arg == Elem && optind > 1)
+    {
+        /* the argument is a separate element */
+        miktex_omit_argument(arg, NULL);
+        Elem = argv[optind - 2];
+    }
+
+    if (Elem[0] == '-' && Elem[1] != '-' && Elem[1] != c
+        && strchr(Elem + 1, c) && (Prefix = strdup(Elem)))
+    {
+        /* keep the options which precede it, e.g. -qo */
+        *strchr(Prefix + 1, c) = '\0';
+        miktex_omit_argument(Elem, Prefix);
+    }
+    else
+        miktex_omit_argument(Elem, NULL);
+}
+#endif
+
 /*
  * Outputs a program error.
  */
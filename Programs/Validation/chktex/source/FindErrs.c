@@ -33,6 +33,10 @@
 #include "Utility.h"
 #include "Resource.h"
 
+#if defined(MIKTEX)
+#include <miktex/chktex.h>
+#endif
+
 #if HAVE_PCRE || HAVE_POSIX_ERE
 
 #if HAVE_PCRE
@@ -850,6 +854,9 @@ static void CheckRest(void)
         static regmatch_t MatchVector[NUM_MATCHES];
         int rc;
         int len = strlen(TmpBuffer);
+#if defined(MIKTEX)
+        const char *Candidates;
+#endif
         strcpy(TmpBuffer, Buf);
 
         /* Compile all regular expressions if not already compiled. */
@@ -924,18 +931,38 @@ static void CheckRest(void)
                         {
                             ((char*)UserWarnRegex.Stack.Data[NumRegexes])[0] = '\0';
                         }
+#if defined(MIKTEX)
+                        miktex_add_user_regex(NumRegexes, pattern);
+#endif
                         ++NumRegexes;
                     }
                 }
             }
         }
 
+#if defined(MIKTEX)
+        /* Scan the line once for all regexes. */
+        Candidates = miktex_scan_user_regexes(TmpBuffer);
+#endif
         for (Count = 0; Count < NumRegexes; ++Count)
         {
             int offset = 0;
             char *ErrMessage = UserWarnRegex.Stack.Data[Count];
             const int NamedWarning = strlen(ErrMessage) > 0;
 
+#if defined(MIKTEX)
+            if (!Candidates[Count])
+            {
+                if (miktex_verify_user_regexes()
+                    && regexec((regex_t*)(&RegexArray[Count]), TmpBuffer, 0, NULL, 0) == 0)
+                {
+                    miktex_report_prefilter_miss(Count, TmpBuffer);
+                    FoundErr = max(FoundErr, EXIT_ERRORS);
+                }
+                continue;
+            }
+#endif
+
             while (offset < len)
             {
                 /* Check if this warning should be suppressed. */
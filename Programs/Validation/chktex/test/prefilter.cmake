@@ -0,0 +1,42 @@
+## prefilter.cmake
+##
+## Copyright (C) 2024 Christian Schenk
+## 
+## This file is free software; the copyright holder gives
+## unlimited permission to copy and/or distribute it, with or
+## without modifications, as long as this notice is preserved.
+
+## Checks prefilter.tex against the stock regexes (global resource file)
+## and the regexes of prefilter.chktexrc; the regexes rejected by the
+## prefilter are executed anyway and must not match.
+
+set(ENV{MIKTEX_CHKTEX_VERIFY_PREFILTER} 1)
+
+execute_process(
+    COMMAND ${CHKTEX} -q -l ${SOURCE_DIR}/prefilter.chktexrc ${SOURCE_DIR}/prefilter.tex
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors
+)
+
+string(FIND "${errors}" "prefilter rejected" pos)
+if(NOT pos EQUAL -1)
+    message(FATAL_ERROR "${errors}")
+endif()
+
+set(expected_matches
+    "\\documentclass"
+    "section~\\ref"
+    "widget"
+    "(sic)"
+    "\\begin{tabular}{l|r}"
+    "\\hline"
+    "a+b"
+    "3.14"
+)
+
+foreach(m ${expected_matches})
+    string(FIND "${output}" "User Regex: ${m}" pos)
+    if(pos EQUAL -1)
+        message(FATAL_ERROR "missing match: ${m}\n${output}")
+    endif()
+endforeach()
@@ -55,6 +55,7 @@ set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE "LastUserUpdate")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_CHECK "LastUserUpdateCheck")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_DB  "LastUserUpdateDb")
 set(MIKTEX_CONFIG_VALUE_LOCAL_REPOSITORY "LocalRepository")
+set(MIKTEX_CONFIG_VALUE_LUA_BYTECODE_CACHE "LuaBytecodeCache")
 set(MIKTEX_CONFIG_VALUE_MIKTEXDIRECT_ROOT "MiKTeXDirectRoot")
 set(MIKTEX_CONFIG_VALUE_NO_REGISTRY "NoRegistry")
 set(MIKTEX_CONFIG_VALUE_OTHER_COMMON_ROOTS "OtherCommonRoots")
@@ -1,6 +1,6 @@
 ## CreateWebApp.cmake
 ##
-## Copyright (C) 2006-2022 Christian Schenk
+## Copyright (C) 2006-2024 Christian Schenk
 ## 
 ## This file is free software; the copyright holder gives
 ## unlimited permission to copy and/or distribute it, with or
@@ -180,6 +180,12 @@ MIKTEX_DEFINE_WEBAPP(MiKTeX_${_name_u},
         set(_sed_script ${CMAKE_CURRENT_SOURCE_DIR}/dyn.sed)
     endif()
 
+    if(WITH_C4P_PROFILER)
+        set(_c4p_profile_flag --profile)
+    else()
+        set(_c4p_profile_flag)
+    endif()
+
     add_custom_command(
         OUTPUT
             ${${_short_name_l}_header_file}.intermediate
@@ -195,6 +201,7 @@ MIKTEX_DEFINE_WEBAPP(MiKTeX_${_name_u},
             --using-namespace=MiKTeX::TeXAndFriends
             -C
             --class=${_name}Program
+            ${_c4p_profile_flag}
             ${C4P_FLAGS}
             ${CMAKE_CURRENT_BINARY_DIR}/${_short_name_l}.p
         COMMAND
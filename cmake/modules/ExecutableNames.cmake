@@ -28,6 +28,7 @@ macro(define_executable _name)
 endmacro()
 
 define_executable(arctrl arctrl)
+define_executable(bench)
 define_executable(console)
 define_executable(epstopdf)
 define_executable(findtexmf findtexmf)
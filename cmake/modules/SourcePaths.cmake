@@ -1,6 +1,6 @@
 ## SourcePaths.cmake
 ##
-## Copyright (C) 2006-2022 Christian Schenk
+## Copyright (C) 2006-2024 Christian Schenk
 ## 
 ## This file is free software; the copyright holder gives
 ## unlimited permission to copy and/or distribute it, with or
@@ -14,6 +14,7 @@ set(MIKTEX_REL_ARCTRL_WIN_DIR           "Programs/MiKTeX/arctrl/win")
 set(MIKTEX_REL_ASYMPTOTE_DIR            "Programs/GraphicsUtilities/asymptote")
 set(MIKTEX_REL_AUTOSP_DIR               "Programs/Preprocessors/autosp")
 set(MIKTEX_REL_AXOHELP_DIR              "Programs/Converters/axohelp")
+set(MIKTEX_REL_BENCH_DIR                "Programs/MiKTeX/bench")
 set(MIKTEX_REL_BIBARTS_DIR              "Programs/Bibliography/bibarts")
 set(MIKTEX_REL_BIBTEX_DIR               "Programs/Bibliography/bibtex")
 set(MIKTEX_REL_BIBTEXX_DIR              "Programs/Bibliography/bibtex-x")
@@ -218,6 +219,7 @@ set(MIKTEX_TEX_HASH_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/mikte
 set(MIKTEX_TEX_HYPH_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-hyph.ch")
 set(MIKTEX_TEX_POOL_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-pool.ch")
 set(MIKTEX_TEX_QUIET_CH         "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-quiet.ch")
+set(MIKTEX_TEX_PROFILE_CH       "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-profile.ch")
 set(MIKTEX_TEX_SRC_CH           "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-src.ch")
 set(MIKTEX_TEX_STAT_CH          "${CMAKE_SOURCE_DIR}/${MIKTEX_REL_TEX_DIR}/miktex-tex-stat.ch")
 set(SHOWSTREAM_CH               "${CMAKE_SOURCE_DIR}/Programs/TeXAndFriends/web2c/source/showstream.ch")